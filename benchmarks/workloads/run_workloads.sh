@@ -0,0 +1,64 @@
+#!/usr/bin/env bash
+# run_workloads.sh -- std.bench workload suite (Linux/macOS).
+#
+# Builds each benchmarks/workloads/<suite>.tr with `tauraroc -O3`, runs it and
+# collects its results as results/<suite>.json. With --baseline DIR every
+# suite is compared against DIR/<suite>.json and the script exits 1 when any
+# benchmark's median got slower than the threshold (default 10%).
+#
+# Usage:
+#   bash benchmarks/workloads/run_workloads.sh                 # full run
+#   bash benchmarks/workloads/run_workloads.sh --quick dict    # short run, one suite
+#   bash benchmarks/workloads/run_workloads.sh --out base      # record a baseline
+#   bash benchmarks/workloads/run_workloads.sh --baseline base # compare against it
+set -u
+BENCH="$(cd "$(dirname "$0")" && pwd)"
+TAU="$BENCH/../../tauraroc"
+[ -x "$TAU" ] || TAU="$BENCH/../../tauraroc.exe"
+[ -x "$TAU" ] || TAU="tauraroc"
+
+OUT="$BENCH/results"
+BASE=""
+ARGS=()
+SUITES=()
+while [ "$#" -gt 0 ]; do
+    case "$1" in
+        --out)       OUT="$2"; shift 2 ;;
+        --baseline)  BASE="$2"; shift 2 ;;
+        --quick)     ARGS+=(--quick); shift ;;
+        --threshold) ARGS+=(--threshold "$2"); shift 2 ;;
+        --filter)    ARGS+=(--filter "$2"); shift 2 ;;
+        *)           SUITES+=("$1"); shift ;;
+    esac
+done
+[ "${#SUITES[@]}" -gt 0 ] || SUITES=(dict strings json channel coro http iter stats sort graph)
+mkdir -p "$OUT"
+OUT="$(cd "$OUT" && pwd)"
+[ -z "$BASE" ] || BASE="$(cd "$BASE" && pwd)"
+
+# tauraroc writes its intermediates to a CWD-relative build/ directory.
+cd "$BENCH" || exit 1
+regressed=0
+failed=0
+for s in "${SUITES[@]}"; do
+    if ! "$TAU" -O3 "$BENCH/$s.tr" -o "$BENCH/$s.bin" >/dev/null 2>&1; then
+        echo "$s: build failed"
+        failed=$((failed + 1))
+        continue
+    fi
+    run=("$BENCH/$s.bin" --json "$OUT/$s.json" "${ARGS[@]}")
+    [ -n "$BASE" ] && [ -f "$BASE/$s.json" ] && run+=(--baseline "$BASE/$s.json")
+    "${run[@]}"
+    case $? in
+        0) ;;
+        1) regressed=$((regressed + 1)) ;;
+        *) echo "$s: crashed"; failed=$((failed + 1)) ;;
+    esac
+    rm -f "$BENCH/$s.bin"
+done
+rm -rf "$BENCH/build"
+
+echo
+echo "Results in $OUT"
+[ "$failed" -eq 0 ] || { echo "$failed suite(s) failed to build or run"; exit 2; }
+[ "$regressed" -eq 0 ] || { echo "$regressed suite(s) regressed"; exit 1; }
@@ -792,27 +792,22 @@ void _tr_rt_list_clear(void* h) {
     _TrNList* l = (_TrNList*)h;
     if (l) l->len = 0;
 }
-/* in-place insertion sort; dir>0 ascending, dir<0 descending. */
+/* in-place sort (the runtime's radix / pdqsort); dir>0 ascending, dir<0 descending. */
 void _tr_rt_list_sort(void* h, long long dir) {
     _TrNList* l = (_TrNList*)h;
-    if (!l) return;
-    for (long long i = 1; i < l->len; i++) {
-        long long v = l->data[i], j = i - 1;
-        while (j >= 0 && (dir > 0 ? l->data[j] > v : l->data[j] < v)) { l->data[j + 1] = l->data[j]; j--; }
-        l->data[j + 1] = v;
-    }
-}
-/* in-place insertion sort for string lists (strcmp); dir>0 asc, dir<0 desc. */
+    if (!l || l->len < 2) return;
+    _tr_sort_i64(l->data, l->len);
+    if (dir < 0) _tr_sort_reverse(l->data, l->len, sizeof(long long));
+}
+/* String lists hold char* in long long slots: pdqsort them as such. */
+#define _TR_NSTR_LT(x, y) (strcmp((const char*)(x), (const char*)(y)) < 0)
+_TR_PDQ(_tr_pdq_nstr, long long, _TR_NSTR_LT)
+/* in-place sort for string lists (strcmp); dir>0 asc, dir<0 desc. */
 void _tr_rt_list_sort_str(void* h, long long dir) {
     _TrNList* l = (_TrNList*)h;
-    if (!l) return;
-    for (long long i = 1; i < l->len; i++) {
-        long long v = l->data[i], j = i - 1;
-        const char* vs = (const char*)v;
-        while (j >= 0 && (dir > 0 ? strcmp((const char*)l->data[j], vs) > 0
-                                  : strcmp((const char*)l->data[j], vs) < 0)) { l->data[j + 1] = l->data[j]; j--; }
-        l->data[j + 1] = v;
-    }
+    if (!l || l->len < 2) return;
+    _tr_pdq_nstr(l->data, l->len);
+    if (dir < 0) _tr_sort_reverse(l->data, l->len, sizeof(long long));
 }
 
 /* `x in xs` membership for List[int] / List[str]. */
@@ -0,0 +1,44 @@
+/* native_image.c — the prelinked runtime image behind --backend native's built-in
+ * linker (src/codegen/native/link.tr). native_abi.c + libc are linked ONCE by the
+ * system linker into a non-PIE executable (build/native_rt.img) that reserves three
+ * empty, fixed-address regions for a program: code (.tr_text), string literals
+ * (.tr_rodata) and globals (.tr_bss). Per build the compiler copies the image and
+ * writes the program into those regions, resolving its calls against the image's
+ * symbol table — no cc/ld in the edit-compile-run loop.
+ *
+ * main() enters the program through the first bytes of .tr_text, where the linker
+ * places a `jmp` to the program's own `main`. Region sizes are fixed here; a program
+ * that outgrows one is linked by the system linker instead.
+ */
+#include "native_abi.c"
+
+#define TR_IMG_TEXT_SIZE   1048576     /* 1 MiB of code (filled with int3) */
+#define TR_IMG_RODATA_SIZE 262144      /* 256 KiB of string literals */
+#define TR_IMG_BSS_SIZE    1048576     /* 1 MiB of globals (8-byte slots, NOBITS) */
+
+#define TR_IMG_STR_(x) #x
+#define TR_IMG_STR(x)  TR_IMG_STR_(x)
+
+__asm__(
+    ".section .tr_text,\"ax\",@progbits\n"
+    ".globl _tr_img_text\n"
+    ".p2align 12\n"
+    "_tr_img_text:\n"
+    ".fill " TR_IMG_STR(TR_IMG_TEXT_SIZE) ",1,0xcc\n"
+    ".section .tr_rodata,\"a\",@progbits\n"
+    ".globl _tr_img_rodata\n"
+    ".p2align 12\n"
+    "_tr_img_rodata:\n"
+    ".fill " TR_IMG_STR(TR_IMG_RODATA_SIZE) ",1,0\n"
+    ".section .tr_bss,\"aw\",@nobits\n"
+    ".globl _tr_img_bss\n"
+    ".p2align 12\n"
+    "_tr_img_bss:\n"
+    ".zero " TR_IMG_STR(TR_IMG_BSS_SIZE) "\n"
+    ".text\n");
+
+extern char _tr_img_text[];
+
+int main(void) {
+    return ((int (*)(void))(void*)_tr_img_text)();
+}
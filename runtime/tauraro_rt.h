@@ -19,6 +19,25 @@
 #  define TR_EXPORT __attribute__((visibility("default")))
 #endif
 
+/* _TR_COLD — linkage of the cold runtime sections: directory operations,
+ * datetime, regex, the hash/codec kernels, TLS and HTTP client connections,
+ * and zlib. They are called rarely and cost far more to compile than to call.
+ * A hosted build (TAURARO_RT_SPLIT, set by the generated tauraro_types.h)
+ * compiles their bodies once, with extern linkage, in the _TR_MAIN TU
+ * (build/tauraro_rt.c); every other TU sees only their prototypes. Single-TU
+ * builds (freestanding tiers, native_abi.c) keep them static inline. */
+#if defined(TAURARO_RT_SPLIT)
+#  define _TR_COLD
+#  ifdef _TR_MAIN
+#    define _TR_COLD_BODIES 1
+#  else
+#    define _TR_COLD_BODIES 0
+#  endif
+#else
+#  define _TR_COLD static inline
+#  define _TR_COLD_BODIES 1
+#endif
+
 /* Must be defined before any system header to expose full POSIX/platform extensions:
  * pthread_rwlock_t, setenv, strdup, struct addrinfo, NI_NAMEREQD, clock_gettime, etc. */
 #if defined(__linux__)
@@ -67,6 +86,7 @@
 #ifndef TAURARO_KERNEL
 #  include <stdio.h>
 #  include <stdlib.h>
+#  include <stddef.h>
 #  include <stdbool.h>
 #  include <stdint.h>
 #  include <string.h>
@@ -323,39 +343,103 @@ static int printf(const char* fmt,...){ char b[1024]; va_list ap; va_start(ap,fm
 #  endif
 #endif
 
+/* ── Live metrics (per-thread counters, merged on read) ───────────────────
+ * Every thread that touches a counter gets its own _TrMxBlock, linked into a
+ * process-wide registry on first use; the hot path is a plain add into the
+ * calling thread's block (no atomics, no shared cache lines), and a reader
+ * sums the blocks. Counters only ever grow, so a block stays valid when its
+ * thread exits: on POSIX it is handed to the next new thread rather than
+ * freed, and a sum over the registry is always the process total. Gauges are
+ * differences of two counters (live = created - freed) or are read from the
+ * live schedulers. Histograms (_tr_mx_observe) are log-linear, per thread
+ * too. -DTAURARO_NO_METRICS compiles the hooks out. The registry, readers
+ * and the Prometheus text rendering live after the scheduler. */
+enum {
+    _TR_MX_HEAP_ALLOC, _TR_MX_HEAP_FREE,     /* runtime heap blocks           */
+    _TR_MX_OBJ_NEW, _TR_MX_OBJ_FREE,         /* class instances (heap, not arena) */
+    _TR_MX_STR_NEW, _TR_MX_STR_FREE,         /* refcounted strings            */
+    _TR_MX_DICT_NEW, _TR_MX_DICT_FREE,
+    _TR_MX_LIST_NEW, _TR_MX_LIST_FREE,
+    _TR_MX_CO_SPAWN, _TR_MX_CO_DONE,         /* coroutines                    */
+    _TR_MX_CO_SWITCH,                        /* coroutine dispatches          */
+    _TR_MX_RQ_PUSH,                          /* ready-queue pushes            */
+    _TR_MX_POLL_WAITS, _TR_MX_POLL_WAKEUPS,  /* reactor waits / ones with events */
+    _TR_MX_POLL_EVENTS,                      /* readiness events delivered    */
+    _TR_MX_BLOCKING_JOBS,                    /* Coro.blocking offloads        */
+    _TR_MX_NBUILTIN
+};
+#define _TR_MX_MAX   256     /* counter slots: built-ins, then registered ones */
+#define _TR_MX_HMAX  128     /* histogram slots */
+#define _TR_MX_HB    160     /* buckets: 8 exact, then 4 per power of two */
+#if defined(TAURARO_BARE) || defined(TAURARO_KERNEL) || defined(TAURARO_NO_METRICS)
+#define _TR_MX_OFF 1
+static inline void _tr_mx_add(int id, long long n) { (void)id; (void)n; }
+#else
+typedef struct {
+    long long n, sum;
+    long long b[_TR_MX_HB];
+} _TrMxHist;
+typedef struct _TrMxBlock {
+    long long           c[_TR_MX_MAX];
+    _TrMxHist*          h[_TR_MX_HMAX];
+    void*               sched;     /* this thread's _TrSchedG once it schedules */
+    int                 busy;      /* owned by a live thread */
+    struct _TrMxBlock*  next;
+} _TrMxBlock;
+#if defined(_MSC_VER) && !defined(__clang__)
+#  define _TR_MX_TLS __declspec(thread)
+#else
+#  define _TR_MX_TLS __thread
+#endif
+#ifdef _TR_MAIN
+_TR_MX_TLS _TrMxBlock* _tr_mx_self = NULL;
+#else
+extern _TR_MX_TLS _TrMxBlock* _tr_mx_self;
+#endif
+static _TrMxBlock* _tr_mx_attach(void);
+static inline _TrMxBlock* _tr_mx_block(void) {
+    _TrMxBlock* b = _tr_mx_self;
+    return b ? b : _tr_mx_attach();
+}
+static inline void _tr_mx_add(int id, long long n) { _tr_mx_block()->c[id] += n; }
+#endif
+
 /* Opt-in live-allocation counter for leak bisection. Compile with
  * -DTAURARO_MEMCOUNT to enable; _tr_report_mem() then also prints the net
  * number of outstanding (alloc'd minus freed) heap blocks, so a steady
- * per-request delta localizes a leak by object count. Zero-cost otherwise. */
+ * per-request delta localizes a leak by object count. */
 #ifdef TAURARO_MEMCOUNT
 #ifdef _TR_MAIN
 long _tr_live_allocs = 0;
+long _tr_total_allocs = 0;   /* cumulative, never decremented (--time-passes) */
 long _tr_live_dicts = 0;
 long _tr_live_lists = 0;
 long _tr_live_strs = 0;
 #else
 extern long _tr_live_allocs;
+extern long _tr_total_allocs;
 extern long _tr_live_dicts;
 extern long _tr_live_lists;
 extern long _tr_live_strs;
 #endif
-#define _TR_MEMCOUNT_INC() (_tr_live_allocs++)
-#define _TR_MEMCOUNT_DEC() (_tr_live_allocs--)
-#define _TR_MEMCOUNT_DICT_INC() (_tr_live_dicts++)
-#define _TR_MEMCOUNT_DICT_DEC() (_tr_live_dicts--)
-#define _TR_MEMCOUNT_LIST_INC() (_tr_live_lists++)
-#define _TR_MEMCOUNT_LIST_DEC() (_tr_live_lists--)
-#define _TR_MEMCOUNT_STR_INC() (_tr_live_strs++)
-#define _TR_MEMCOUNT_STR_DEC() (_tr_live_strs--)
-#else
-#define _TR_MEMCOUNT_INC() ((void)0)
-#define _TR_MEMCOUNT_DEC() ((void)0)
-#define _TR_MEMCOUNT_DICT_INC() ((void)0)
-#define _TR_MEMCOUNT_DICT_DEC() ((void)0)
-#define _TR_MEMCOUNT_LIST_INC() ((void)0)
-#define _TR_MEMCOUNT_LIST_DEC() ((void)0)
-#define _TR_MEMCOUNT_STR_INC() ((void)0)
-#define _TR_MEMCOUNT_STR_DEC() ((void)0)
+#define _TR_MEMCOUNT_INC() (_tr_live_allocs++, _tr_total_allocs++, _tr_mx_add(_TR_MX_HEAP_ALLOC, 1))
+#define _TR_MEMCOUNT_DEC() (_tr_live_allocs--, _tr_mx_add(_TR_MX_HEAP_FREE, 1))
+#define _TR_MEMCOUNT_DICT_INC() (_tr_live_dicts++, _tr_mx_add(_TR_MX_DICT_NEW, 1))
+#define _TR_MEMCOUNT_DICT_DEC() (_tr_live_dicts--, _tr_mx_add(_TR_MX_DICT_FREE, 1))
+#define _TR_MEMCOUNT_LIST_INC() (_tr_live_lists++, _tr_mx_add(_TR_MX_LIST_NEW, 1))
+#define _TR_MEMCOUNT_LIST_DEC() (_tr_live_lists--, _tr_mx_add(_TR_MX_LIST_FREE, 1))
+#define _TR_MEMCOUNT_STR_INC() (_tr_live_strs++, _tr_mx_add(_TR_MX_STR_NEW, 1))
+#define _TR_MEMCOUNT_STR_DEC() (_tr_live_strs--, _tr_mx_add(_TR_MX_STR_FREE, 1))
+#else
+/* Without TAURARO_MEMCOUNT the same hooks feed the live metrics only. */
+#define _TR_MEMCOUNT_INC() _tr_mx_add(_TR_MX_HEAP_ALLOC, 1)
+#define _TR_MEMCOUNT_DEC() _tr_mx_add(_TR_MX_HEAP_FREE, 1)
+#define _TR_MEMCOUNT_DICT_INC() _tr_mx_add(_TR_MX_DICT_NEW, 1)
+#define _TR_MEMCOUNT_DICT_DEC() _tr_mx_add(_TR_MX_DICT_FREE, 1)
+#define _TR_MEMCOUNT_LIST_INC() _tr_mx_add(_TR_MX_LIST_NEW, 1)
+#define _TR_MEMCOUNT_LIST_DEC() _tr_mx_add(_TR_MX_LIST_FREE, 1)
+#define _TR_MEMCOUNT_STR_INC() _tr_mx_add(_TR_MX_STR_NEW, 1)
+#define _TR_MEMCOUNT_STR_DEC() _tr_mx_add(_TR_MX_STR_FREE, 1)
 #endif
 
 /* Net live heap allocations (alloc'd minus freed) under -DTAURARO_MEMCOUNT,
@@ -380,6 +464,128 @@ static inline long long _tr_mem_live_strs(void) {
 #endif
 }
 
+/* ── Arena (region) allocator ───────────────────────────────────────────────
+ * Bump allocation out of a chain of chunks. A new chunk doubles the previous
+ * one (capped at _TR_ARENA_MAX_CHUNK, or sized to fit an oversized request).
+ * _tr_arena_reset() keeps only the newest (largest) chunk and rewinds it, so
+ * a warmed-up per-request arena does no malloc/free at all.
+ *
+ * While an arena is entered (_tr_arena_enter), class instances
+ * (_tr_obj_alloc) and refcounted strings (_tr_str_new) are carved out of it.
+ * Their refcount carries _TR_RC_ARENA (the top bit), so it never reaches 0:
+ * a string release is a plain decrement, and an instance release runs the
+ * class's drop (owned non-arena fields are still freed) but never frees the
+ * instance itself. The whole region goes at reset/free. Nothing allocated in
+ * the region may be referenced after reset(). The current arena is
+ * per-thread and saved/restored per coroutine by the scheduler. */
+#define _TR_RC_ARENA        ((size_t)1 << (sizeof(size_t) * 8 - 1))
+#define _TR_ARENA_MIN_CHUNK ((size_t)4096)
+#define _TR_ARENA_MAX_CHUNK ((size_t)16 << 20)
+
+typedef struct _TrArenaChunk {
+    struct _TrArenaChunk* next;
+    size_t cap;        /* usable bytes after the header */
+    size_t used;
+    size_t _pad;       /* keeps the payload 16-byte aligned */
+} _TrArenaChunk;
+typedef struct _TrArena {
+    _TrArenaChunk*   head;     /* newest chunk first */
+    size_t           chunk;    /* first-chunk size */
+    size_t           used;     /* bytes handed out since the last reset */
+    struct _TrArena* prev;     /* enclosing region while entered */
+    int              active;
+} _TrArena;
+
+/* _tr_rc_self: the coroutine running on this thread (NULL outside one); the
+   biased refcount's owner identity, see _TR_THREAD_ID(). */
+#if defined(TAURARO_BARE) || defined(TAURARO_KERNEL)
+static _TrArena* _tr_arena_cur = NULL;
+static const void* _tr_rc_self = NULL;
+#elif defined(_TR_MAIN)
+#  if defined(_MSC_VER) && !defined(__clang__)
+__declspec(thread) _TrArena* _tr_arena_cur = NULL;
+__declspec(thread) const void* _tr_rc_self = NULL;
+#  else
+__thread _TrArena* _tr_arena_cur = NULL;
+__thread const void* _tr_rc_self = NULL;
+#  endif
+#else
+#  if defined(_MSC_VER) && !defined(__clang__)
+extern __declspec(thread) _TrArena* _tr_arena_cur;
+extern __declspec(thread) const void* _tr_rc_self;
+#  else
+extern __thread _TrArena* _tr_arena_cur;
+extern __thread const void* _tr_rc_self;
+#  endif
+#endif
+
+static inline void* _tr_arena_new(long long chunk_bytes) {
+    _TrArena* a = (_TrArena*)TAURARO_CALLOC(1, sizeof(_TrArena));
+    if (!a) { _TR_OOM_ABORT(); }
+    _TR_MEMCOUNT_INC();
+    a->chunk = chunk_bytes > 0 ? (size_t)chunk_bytes : (size_t)65536;
+    if (a->chunk < _TR_ARENA_MIN_CHUNK) a->chunk = _TR_ARENA_MIN_CHUNK;
+    return a;
+}
+static _TrArenaChunk* _tr_arena_grow(_TrArena* a, size_t need) {
+    size_t cap = a->head ? a->head->cap * 2 : a->chunk;
+    if (cap > _TR_ARENA_MAX_CHUNK) cap = _TR_ARENA_MAX_CHUNK;
+    if (cap < need) cap = need;
+    _TrArenaChunk* c = (_TrArenaChunk*)TAURARO_ALLOC(sizeof(_TrArenaChunk) + cap);
+    if (!c) { _TR_OOM_ABORT(); }
+    _TR_MEMCOUNT_INC();
+    c->cap = cap; c->used = 0; c->next = a->head;
+    a->head = c;
+    return c;
+}
+/* `n` uninitialised bytes, 16-byte aligned. */
+static inline void* _tr_arena_alloc(void* h, long long n) {
+    _TrArena* a = (_TrArena*)h;
+    size_t sz = ((size_t)(n > 0 ? n : 1) + 15) & ~(size_t)15;
+    _TrArenaChunk* c = a->head;
+    if (!c || c->cap - c->used < sz) c = _tr_arena_grow(a, sz);
+    void* p = (char*)(c + 1) + c->used;
+    c->used += sz; a->used += sz;
+    return p;
+}
+static inline void _tr_arena_reset(void* h) {
+    _TrArena* a = (_TrArena*)h;
+    if (!a || !a->head) return;
+    _TrArenaChunk* c = a->head->next;
+    while (c) { _TrArenaChunk* nx = c->next; _TR_MEMCOUNT_DEC(); TAURARO_FREE(c); c = nx; }
+    a->head->next = NULL; a->head->used = 0; a->used = 0;
+}
+/* Route instance/string allocations on this thread (coroutine) into `h`
+ * until the matching _tr_arena_leave(). Regions nest. */
+static inline void _tr_arena_enter(void* h) {
+    _TrArena* a = (_TrArena*)h;
+    if (!a || a->active) return;
+    a->prev = _tr_arena_cur; a->active = 1;
+    _tr_arena_cur = a;
+}
+static inline void _tr_arena_leave(void* h) {
+    _TrArena* a = (_TrArena*)h;
+    if (!a || !a->active) return;
+    if (_tr_arena_cur == a) _tr_arena_cur = a->prev;
+    a->prev = NULL; a->active = 0;
+}
+static inline void _tr_arena_free(void* h) {
+    _TrArena* a = (_TrArena*)h;
+    if (!a) return;
+    _tr_arena_leave(a);
+    _TrArenaChunk* c = a->head;
+    while (c) { _TrArenaChunk* nx = c->next; _TR_MEMCOUNT_DEC(); TAURARO_FREE(c); c = nx; }
+    _TR_MEMCOUNT_DEC(); TAURARO_FREE(a);
+}
+static inline long long _tr_arena_used(void* h) { return h ? (long long)((_TrArena*)h)->used : 0LL; }
+/* Bytes currently reserved in chunks (what reset() keeps or frees). */
+static inline long long _tr_arena_reserved(void* h) {
+    long long n = 0;
+    for (_TrArenaChunk* c = h ? ((_TrArena*)h)->head : NULL; c; c = c->next) n += (long long)c->cap;
+    return n;
+}
+static inline void* _tr_arena_current(void) { return _tr_arena_cur; }
+
 // Wrappers for core library to avoid signature conflicts
 static inline void* _tr_c_malloc(size_t size) {
     void* p = TAURARO_ALLOC(size);
@@ -432,24 +638,117 @@ static inline void* _tr_checked_alloc(size_t sz) {
  * aliasing (no ownership proof needed). Retain/release are elided by codegen
  * wherever the borrow checker proves a value is only borrowed (zero-cost). */
 static inline void* _tr_obj_alloc(size_t sz) {
+    if (_tr_arena_cur) {
+        void* q = _tr_arena_alloc(_tr_arena_cur, (long long)sz);
+        memset(q, 0, sz);
+        *(size_t*)q = _TR_RC_ARENA | 1;   /* region instance: rc = 1, never freed */
+        return q;
+    }
     void* p = TAURARO_CALLOC(1, sz);
     if (!p && sz > 0) { _TR_OOM_ABORT(); }
-    if (p) { *(size_t*)p = 1; _TR_MEMCOUNT_INC(); }   /* rc = 1 */
+    if (p) { *(size_t*)p = 1; _TR_MEMCOUNT_INC(); _tr_mx_add(_TR_MX_OBJ_NEW, 1); }   /* rc = 1 */
     return p;
 }
+/* ── Biased refcounting for instances shared across threads ──────────────────
+ * An instance starts thread-local: plain ++/-- on __rc. Before it escapes to
+ * another thread (a spawn argument, a Chan send) codegen calls
+ * _tr_obj_share() on the sending thread, which moves the count into a side
+ * block and leaves a tagged pointer to it in __rc (_TR_RC_BIASED):
+ *   - the sharing thread stays the owner and keeps a non-atomic biased count;
+ *   - every other thread updates the atomic shared count;
+ *   - when the biased count reaches 0 the owner merges (sets _TR_RC_MERGED in
+ *     the shared word) and from then on is just another thread; the release
+ *     that leaves a merged shared count at 0 frees the instance.
+ * The shared count can dip below 0 before the merge (another thread dropped
+ * a reference the owner took); only the sum matters, and by the merge it is
+ * back to >= 0. An unshared instance pays one extra bit test per op. */
+#define _TR_RC_BIASED  ((size_t)1 << (sizeof(size_t) * 8 - 2))
+#define _TR_RC_MERGED  ((intptr_t)1)
+/* The owner is whoever runs the code: a coroutine (which keeps its identity
+ * when another worker steals it), else the thread (any per-thread address). */
+#define _TR_THREAD_ID() (_tr_rc_self ? _tr_rc_self : (const void*)&_tr_arena_cur)
+typedef struct {
+    size_t      biased;   /* owner thread only */
+    intptr_t    shared;   /* atomic: count * 2 | _TR_RC_MERGED */
+    const void* owner;
+} _TrRcShared;
+#define _TR_RC_SIDE(w) ((_TrRcShared*)(uintptr_t)((w) & ~_TR_RC_BIASED))
+
+static void _tr_brc_retain(_TrRcShared* b) {
+    if (b->owner == _TR_THREAD_ID() && !(__atomic_load_n(&b->shared, __ATOMIC_RELAXED) & _TR_RC_MERGED))
+        b->biased++;
+    else
+        __atomic_fetch_add(&b->shared, 2, __ATOMIC_RELAXED);
+}
+/* True when this release dropped the last reference. */
+static bool _tr_brc_release(_TrRcShared* b) {
+    if (b->owner == _TR_THREAD_ID() && !(__atomic_load_n(&b->shared, __ATOMIC_RELAXED) & _TR_RC_MERGED)) {
+        if (--b->biased > 0) return false;
+        return __atomic_fetch_add(&b->shared, _TR_RC_MERGED, __ATOMIC_ACQ_REL) == 0;
+    }
+    return __atomic_sub_fetch(&b->shared, 2, __ATOMIC_ACQ_REL) == _TR_RC_MERGED;
+}
+
 static inline void* _tr_obj_retain(void* p) {
-    if (p) (*(size_t*)p)++;
+    if (p) {
+        size_t w = *(size_t*)p;
+        if (!(w & _TR_RC_BIASED)) *(size_t*)p = w + 1;
+        else _tr_brc_retain(_TR_RC_SIDE(w));
+    }
     return p;
 }
 /* `drop` releases the instance's owned fields (generated per class). NULL for a
- * class with no droppable fields — the struct is still freed. */
+ * class with no droppable fields — the struct is still freed. An arena
+ * instance runs its drop at the last release but keeps its memory. */
 static inline void _tr_obj_release(void* p, void (*drop)(void*)) {
-    if (p && --(*(size_t*)p) == 0) {
+    if (!p) return;
+    size_t w = *(size_t*)p;
+    if (w & _TR_RC_BIASED) {
+        if (_tr_brc_release(_TR_RC_SIDE(w))) {
+            if (drop) drop(p);
+            _tr_free(_TR_RC_SIDE(w));
+            _TR_MEMCOUNT_DEC();
+            _tr_mx_add(_TR_MX_OBJ_FREE, 1);
+            TAURARO_FREE(p);
+        }
+        return;
+    }
+    size_t rc = --(*(size_t*)p);
+    if (rc == 0) {
         if (drop) drop(p);
         _TR_MEMCOUNT_DEC();
+        _tr_mx_add(_TR_MX_OBJ_FREE, 1);
         TAURARO_FREE(p);
+    } else if (rc == _TR_RC_ARENA) {
+        if (drop) drop(p);
     }
 }
+/* Switch an instance to biased mode before it crosses to another thread; the
+ * calling thread becomes its owner. `share` (the class's generated
+ * _trshare_T) then does the same for the str/instance fields the other
+ * thread can reach. Already-shared and arena instances are left alone, which
+ * also stops the walk at cycles. */
+static inline void* _tr_obj_share(void* p, void (*share)(void*)) {
+    if (!p) return p;
+    size_t w = *(size_t*)p;
+    if (w & (_TR_RC_BIASED | _TR_RC_ARENA)) return p;
+    _TrRcShared* b = (_TrRcShared*)_tr_checked_alloc(sizeof(_TrRcShared));
+    b->biased = w;
+    b->shared = 0;
+    b->owner = _TR_THREAD_ID();
+    *(size_t*)p = _TR_RC_BIASED | (size_t)(uintptr_t)b;
+    if (share) share(p);
+    return p;
+}
+/* Raw free of a class instance (`_tr_c_free(obj as Pointer[char])`, rewritten
+ * by c.tr): a no-op for arena instances, whose memory belongs to the region. */
+static inline void _tr_obj_free_raw(void* p) {
+    if (!p) return;
+    size_t w = *(size_t*)p;
+    if (w & _TR_RC_ARENA) return;
+    if (w & _TR_RC_BIASED) _tr_free(_TR_RC_SIDE(w));
+    _TR_MEMCOUNT_DEC(); _tr_mx_add(_TR_MX_OBJ_FREE, 1); TAURARO_FREE(p);
+}
 /* Heap-allocated empty C string. Used by char*-returning helpers that need
  * an "empty result" fallback - returning a static string literal (`""`)
  * here would later be `_tr_str_wrap`'d (rc=1) and `_tr_str_release`'d,
@@ -498,16 +797,92 @@ static inline TrStr _tr_str_lit_passthrough(TrStr s) { return s; }
 /* Allocates a new heap string of `len` bytes (plus NUL terminator)
  * with refcount 1. Caller fills t.data[0..len-1].
  *
- * `data` and `rc` are SEPARATE allocations (not one combined block):
- * `_tr_strz(t)` returns `t.data` directly, and many call sites do
- * `_tr_c_free(_tr_strz(x))` (the `unsafe: _tr_c_free(x as Pointer[char])`
- * idiom in std/*.tr) - that free() must see a real malloc base pointer.
- * A combined allocation with `data = block + sizeof(long)` would make
- * that free() corrupt the heap (freeing a pointer 8 bytes past the
- * block start). Two allocations cost one extra malloc per _tr_str_new
- * call (concat/repeat/join/etc.) but keep `.data` independently valid. */
+ * By default `data` and `rc` are SEPARATE allocations (not one combined
+ * block): `_tr_strz(t)` returns `t.data` directly, and hand-written C (or
+ * an extern helper) may `free()` that pointer, which must then see a real
+ * malloc base. The `unsafe: _tr_c_free(x as Pointer[char])` idiom in
+ * std/*.tr is already rewritten to `_tr_str_release(x)` by c.tr, so
+ * generated code never does this.
+ *
+ * TAURARO_STR_ONEBLOCK (`tauraroc --str-oneblock`) drops that allowance:
+ * the refcount header and the bytes share one block (`data == rc + 1`),
+ * halving the mallocs of every concat/repeat/join/f-string/int-to-str.
+ * _tr_str_release() recognises the layout by that adjacency, so strings
+ * wrapped from a separately allocated `char*` (_tr_str_wrap) mix freely
+ * with one-block strings in either mode. */
+/* Inside an arena region the block comes from the arena (always one-block)
+ * and the refcount carries _TR_STR_RC_ARENA, so release never frees it. The
+ * count is a `long`, so the bit must sit below its top: _TR_RC_ARENA (top of
+ * size_t) is truncated away on LLP64. */
+#define _TR_STR_RC_ARENA ((long)1 << (sizeof(long) * 8 - 3))
+static inline TrStr _tr_str_new_arena(size_t len) {
+    TrStr t;
+    long* blk = (long*)_tr_arena_alloc(_tr_arena_cur, (long long)(sizeof(long) + len + 1));
+    *blk = _TR_STR_RC_ARENA | 1;
+    t.rc = blk;
+    t.data = (char*)(blk + 1);
+    t.data[len] = '\0';
+    return t;
+}
+#if defined(TAURARO_STR_ONEBLOCK)
+/* Small strings: up to _TR_STR_SMALL bytes get a fixed _TR_STR_SMALL_BLK
+ * block, and releasing a string whose bytes fit in one parks its block in a
+ * per-thread cache (chained through the first word) for the next small
+ * _tr_str_new. Short concat/to_str/f-string results then recycle blocks
+ * without malloc or free. The bytes cannot live in the TrStr itself: it is
+ * copied by value, and `.data` must stay a stable `char*` for _tr_strz and
+ * C callers. Every one-block heap block is at least _TR_STR_SMALL_BLK bytes,
+ * so any of them can be reused for a small string. A block counts as freed
+ * while cached, and a cross-thread release caches it on the releasing
+ * thread. */
+#define _TR_STR_SMALL     22
+#define _TR_STR_SMALL_BLK (sizeof(long) + _TR_STR_SMALL + 1)
+#define _TR_STR_CACHE_MAX 256
+typedef struct { void* head; int n; } _TrStrCache;
+#if defined(TAURARO_BARE) || defined(TAURARO_KERNEL)
+static _TrStrCache _tr_str_cache;
+#elif defined(_TR_MAIN)
+#  if defined(_MSC_VER) && !defined(__clang__)
+__declspec(thread) _TrStrCache _tr_str_cache;
+#  else
+__thread _TrStrCache _tr_str_cache;
+#  endif
+#else
+#  if defined(_MSC_VER) && !defined(__clang__)
+extern __declspec(thread) _TrStrCache _tr_str_cache;
+#  else
+extern __thread _TrStrCache _tr_str_cache;
+#  endif
+#endif
+static inline TrStr _tr_str_new(size_t len) {
+    TrStr t;
+    long* blk;
+    if (_tr_arena_cur) return _tr_str_new_arena(len);
+    if (len <= _TR_STR_SMALL) {
+        blk = (long*)_tr_str_cache.head;
+        if (blk) {
+            _tr_str_cache.head = *(void**)blk;
+            _tr_str_cache.n--;
+        } else {
+            blk = (long*)TAURARO_ALLOC(_TR_STR_SMALL_BLK);
+            if (!blk) { _TR_OOM_ABORT(); }
+        }
+    } else {
+        blk = (long*)TAURARO_ALLOC(sizeof(long) + len + 1);
+        if (!blk) { _TR_OOM_ABORT(); }
+    }
+    _TR_MEMCOUNT_INC();
+    *blk = 1;
+    t.rc = blk;
+    t.data = (char*)(blk + 1);
+    t.data[len] = '\0';
+    _TR_MEMCOUNT_STR_INC();
+    return t;
+}
+#else
 static inline TrStr _tr_str_new(size_t len) {
     TrStr t;
+    if (_tr_arena_cur) return _tr_str_new_arena(len);
     t.data = (char*)_tr_checked_alloc(len + 1);
     t.data[len] = '\0';
     t.rc = (long*)_tr_checked_alloc(sizeof(long));
@@ -515,17 +890,44 @@ static inline TrStr _tr_str_new(size_t len) {
     _TR_MEMCOUNT_STR_INC();
     return t;
 }
+#endif
+
+/* A string reachable from another thread (through _tr_str_share, called by
+ * the _trshare_T walkers) has _TR_STR_RC_SHARED set in its count and is
+ * counted atomically from then on. Strings keep a single atomic count rather
+ * than a biased pair: the count is a `long`, too narrow on LLP64 to hold a
+ * side-block pointer, and a shared string is immutable anyway. */
+#define _TR_STR_RC_SHARED ((long)1 << (sizeof(long) * 8 - 2))
+static inline void _tr_str_share(TrStr s) {
+    if (s.rc && !(*s.rc & (_TR_STR_RC_SHARED | _TR_STR_RC_ARENA))) *s.rc |= _TR_STR_RC_SHARED;
+}
 
 static inline TrStr _tr_str_retain(TrStr s) {
-    if (s.rc) { (*s.rc)++; }
+    if (s.rc) {
+        if (!(*s.rc & _TR_STR_RC_SHARED)) (*s.rc)++;
+        else __atomic_fetch_add(s.rc, 1, __ATOMIC_RELAXED);
+    }
     return s;
 }
 
 static inline void _tr_str_release(TrStr s) {
     if (s.rc) {
-        if (--(*s.rc) == 0) {
+        long left = (*s.rc & _TR_STR_RC_SHARED)
+            ? __atomic_sub_fetch(s.rc, 1, __ATOMIC_ACQ_REL) & ~_TR_STR_RC_SHARED
+            : --(*s.rc);
+        if (left == 0) {
             _TR_MEMCOUNT_STR_DEC();
-            _tr_free(s.data);
+            /* One-block strings (TAURARO_STR_ONEBLOCK) free with their header. */
+            if (s.data != (char*)(s.rc + 1)) _tr_free(s.data);
+#if defined(TAURARO_STR_ONEBLOCK)
+            else if (_tr_str_cache.n < _TR_STR_CACHE_MAX && memchr(s.data, 0, _TR_STR_SMALL + 1)) {
+                _TR_MEMCOUNT_DEC();
+                *(void**)s.rc = _tr_str_cache.head;
+                _tr_str_cache.head = (void*)s.rc;
+                _tr_str_cache.n++;
+                return;
+            }
+#endif
             _tr_free((void*)s.rc);
         }
     }
@@ -1117,6 +1519,24 @@ static long long _tr_chan_recv_ok(_TrChan* c, int* ok) {
     }
     LeaveCriticalSection(&c->mu); return v;
 }
+/* SPSC/MPSC variants and batch ops: the lock-free rings are POSIX-only, so
+ * Windows builds them on the mutex ring. */
+static _TrChan* _tr_chan_new_spsc(long long cap) { return _tr_chan_new(cap); }
+static _TrChan* _tr_chan_new_mpsc(long long cap) { return _tr_chan_new(cap); }
+static long long _tr_chan_send_many(_TrChan* c, const long long* v, long long n) {
+    long long i = 0;
+    for (; i < n && !_tr_chan_is_closed(c); i++) _tr_chan_send(c, v[i]);
+    return i;
+}
+static long long _tr_chan_recv_many(_TrChan* c, long long* out, long long max) {
+    if (max <= 0) return 0;
+    int ok = 0; long long got = 0;
+    out[got] = _tr_chan_recv_ok(c, &ok);
+    if (!ok) return 0;
+    got++;
+    while (got < max) { long long v = _tr_chan_try_recv_val(c); if (v == LLONG_MIN) break; out[got++] = v; }
+    return got;
+}
 
 /* ── Blocking task completion state ─────────────────────────────────── */
 /* refcount=2: one for caller (_tr_task_free), one for worker (_tr_task_complete).
@@ -1316,6 +1736,18 @@ static long long _tr_chan_recv_ok(_TrChan* c, int* ok) {
     }
     *ok = 0; return 0LL;
 }
+static _TrChan* _tr_chan_new_spsc(long long cap) { return _tr_chan_new(cap); }
+static _TrChan* _tr_chan_new_mpsc(long long cap) { return _tr_chan_new(cap); }
+static long long _tr_chan_send_many(_TrChan* c, const long long* v, long long n) {
+    long long i = 0;
+    while (i < n && _tr_chan_try_send(c, v[i])) i++;
+    return i;
+}
+static long long _tr_chan_recv_many(_TrChan* c, long long* out, long long max) {
+    long long got = 0;
+    while (got < max && c && c->count > 0) { out[got++] = c->buf[c->head]; c->head = (c->head+1)%c->cap; c->count--; }
+    return got;
+}
 
 typedef struct { volatile long long result; char* error; volatile int done, cancelled; } _TrTaskState;
 static _TrTaskState* _tr_task_new(void) {
@@ -1430,22 +1862,264 @@ static inline void _tr_threadpool_free(_TrThreadPool* p)      { if(p)TAURARO_FRE
 
 #else /* POSIX ─────────────────────────────────────────────────────────── */
 
+/* ── Lock-free SPSC / MPSC rings behind _TrChan ───────────────────────────
+ * _tr_chan_new_spsc / _tr_chan_new_mpsc build a _TrChan whose `lf` points at
+ * one of these rings. Every _tr_chan_* entry point checks `lf` first, so
+ * chan_select, timers and the handle API work unchanged. The capacity is
+ * rounded up to a power of two.
+ *
+ * The SPSC ring is Lamport's, with each side caching the other's cursor, so
+ * the shared line is re-read only when the cached view runs out. The MPSC
+ * ring is Vyukov's bounded queue: per-slot sequence numbers, producers claim
+ * slots with a CAS on tail, and the single consumer uses plain stores.
+ * Neither side takes a lock. A side that has to block spins, then parks on a
+ * futex word (Linux; short naps elsewhere). The other side bumps that word
+ * only after the waiter has announced itself. */
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+static inline void _tr_futex_wait(uint32_t* w, uint32_t val, long long ms) {
+    struct timespec ts, *tp = NULL;
+    if (ms >= 0) { ts.tv_sec = (time_t)(ms / 1000); ts.tv_nsec = (long)(ms % 1000) * 1000000L; tp = &ts; }
+    syscall(SYS_futex, w, FUTEX_WAIT_PRIVATE, val, tp, NULL, 0);
+}
+static inline void _tr_futex_wake(uint32_t* w) {
+    syscall(SYS_futex, w, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+#else
+/* No futex: nap and let the caller re-check (timeouts stay ms-accurate). */
+static inline void _tr_futex_wait(uint32_t* w, uint32_t val, long long ms) {
+    (void)w; (void)val;
+    struct timespec ts = {0, ms == 0 ? 0L : 50000L}; nanosleep(&ts, NULL);
+}
+static inline void _tr_futex_wake(uint32_t* w) { (void)w; }
+#endif
+
+/* Spin-wait hint for the busy-poll phases of lock-free waits. */
+static inline void _tr_cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+#define _TR_LF_SPIN 128
+typedef struct { long long seq; long long val; } _TrLfSlot;
+typedef struct _TrLfRing {
+    long long   head __attribute__((aligned(64)));   /* consumer cursor */
+    long long   tail_cache;                          /* consumer's view of tail (SPSC) */
+    long long   tail __attribute__((aligned(64)));   /* producer cursor */
+    long long   head_cache;                          /* producer's view of head (SPSC) */
+    uint32_t    rx_seq __attribute__((aligned(64))); /* futex: bumped when data arrives */
+    int         rx_wait;                             /* consumer is parking */
+    uint32_t    tx_seq __attribute__((aligned(64))); /* futex: bumped when space frees up */
+    int         tx_wait;                             /* producers parking (count) */
+    int         closed  __attribute__((aligned(64)));
+    int         mpsc;
+    long long   cap, mask;
+    long long*  buf;                                 /* SPSC values */
+    _TrLfSlot*  slots;                               /* MPSC slots */
+} _TrLfRing;
+
+static _TrLfRing* _tr_lf_new(long long cap, int mpsc) {
+    long long n = 2;
+    while (n < cap) n <<= 1;
+    _TrLfRing* r = (_TrLfRing*)TAURARO_CALLOC(1, sizeof(_TrLfRing));
+    if (!r) { _TR_OOM_ABORT(); }
+    r->cap = n; r->mask = n - 1; r->mpsc = mpsc;
+    if (mpsc) {
+        r->slots = (_TrLfSlot*)TAURARO_ALLOC((size_t)n * sizeof(_TrLfSlot));
+        if (!r->slots) { _TR_OOM_ABORT(); }
+        for (long long i = 0; i < n; i++) r->slots[i].seq = i;
+    } else {
+        r->buf = (long long*)TAURARO_CALLOC((size_t)n, sizeof(long long));
+        if (!r->buf) { _TR_OOM_ABORT(); }
+    }
+    return r;
+}
+static void _tr_lf_free(_TrLfRing* r) {
+    if (!r) return;
+    TAURARO_FREE(r->buf); TAURARO_FREE(r->slots); TAURARO_FREE(r);
+}
+
+/* Non-blocking batch push/pop of up to n values; return how many moved. */
+static long long _tr_lf_push_n(_TrLfRing* r, const long long* v, long long n) {
+    if (n <= 0) return 0;
+    if (!r->mpsc) {
+        long long t = r->tail;
+        long long room = r->cap - (t - r->head_cache);
+        if (room < n) {
+            r->head_cache = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+            room = r->cap - (t - r->head_cache);
+        }
+        if (room <= 0) return 0;
+        if (n > room) n = room;
+        for (long long i = 0; i < n; i++) r->buf[(t + i) & r->mask] = v[i];
+        __atomic_store_n(&r->tail, t + n, __ATOMIC_RELEASE);
+        return n;
+    }
+    long long done = 0;
+    while (done < n) {
+        long long pos = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+        _TrLfSlot* sl;
+        for (;;) {
+            sl = &r->slots[pos & r->mask];
+            long long diff = __atomic_load_n(&sl->seq, __ATOMIC_ACQUIRE) - pos;
+            if (diff == 0) {
+                if (__atomic_compare_exchange_n(&r->tail, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+            } else if (diff < 0) {
+                return done;                         /* full */
+            } else {
+                pos = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+            }
+        }
+        sl->val = v[done++];
+        __atomic_store_n(&sl->seq, pos + 1, __ATOMIC_RELEASE);
+    }
+    return done;
+}
+static long long _tr_lf_pop_n(_TrLfRing* r, long long* out, long long n) {
+    if (n <= 0) return 0;
+    long long h = r->head;
+    if (!r->mpsc) {
+        long long avail = r->tail_cache - h;
+        if (avail < n) {
+            r->tail_cache = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+            avail = r->tail_cache - h;
+        }
+        if (avail <= 0) return 0;
+        if (n > avail) n = avail;
+        for (long long i = 0; i < n; i++) out[i] = r->buf[(h + i) & r->mask];
+        __atomic_store_n(&r->head, h + n, __ATOMIC_RELEASE);
+        return n;
+    }
+    long long got = 0;
+    while (got < n) {
+        _TrLfSlot* sl = &r->slots[(h + got) & r->mask];
+        if (__atomic_load_n(&sl->seq, __ATOMIC_ACQUIRE) != h + got + 1) break;
+        out[got] = sl->val;
+        __atomic_store_n(&sl->seq, h + got + r->cap, __ATOMIC_RELEASE);
+        got++;
+    }
+    if (got) __atomic_store_n(&r->head, h + got, __ATOMIC_RELEASE);
+    return got;
+}
+/* Wake the other side if it has announced it is parking. The announcement
+ * is consumed by the first notifier, so a burst of pushes into a ring whose
+ * reader is asleep costs one wake syscall, not one per value. The seq_cst
+ * fence pairs with the one after the announcement in _tr_lf_park. */
+static inline void _tr_lf_notify(uint32_t* seq, int* waiting) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(waiting, __ATOMIC_RELAXED) &&
+        __atomic_exchange_n(waiting, 0, __ATOMIC_SEQ_CST)) {
+        __atomic_add_fetch(seq, 1, __ATOMIC_RELEASE);
+        _tr_futex_wake(seq);
+    }
+}
+/* One park attempt: announce, re-check `ready` (the op itself), then sleep
+ * on the futex word unless it moved. A stale announcement left behind by a
+ * waiter that did not sleep only costs one spurious wake. Returns the op's
+ * result. */
+#define _tr_lf_park(r, seqf, waitf, ready_expr, ms) ({                          \
+    uint32_t _ps = __atomic_load_n(&(r)->seqf, __ATOMIC_ACQUIRE);              \
+    __atomic_store_n(&(r)->waitf, 1, __ATOMIC_SEQ_CST);                        \
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);                                   \
+    long long _pr = (ready_expr);                                              \
+    if (!_pr && !__atomic_load_n(&(r)->closed, __ATOMIC_SEQ_CST))              \
+        _tr_futex_wait(&(r)->seqf, _ps, (ms));                                 \
+    _pr; })
+
+static inline long long _tr_lf_left_ms(long long deadline) {
+    if (deadline < 0) return -1;
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    long long now = (long long)ts.tv_sec * 1000LL + ts.tv_nsec / 1000000LL;
+    return deadline > now ? deadline - now : 0;
+}
+static inline long long _tr_lf_deadline(long long ms) {
+    if (ms < 0) return -1;
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000LL + ts.tv_nsec / 1000000LL + ms;
+}
+
+/* Blocking batch send: all n values unless the ring closes or `ms` (>= 0)
+ * runs out. Returns how many were sent. */
+static long long _tr_lf_send_n(_TrLfRing* r, const long long* v, long long n, long long ms) {
+    long long sent = 0, dl = _tr_lf_deadline(ms);
+    int spin = 0;
+    while (sent < n) {
+        if (__atomic_load_n(&r->closed, __ATOMIC_ACQUIRE)) break;
+        long long k = _tr_lf_push_n(r, v + sent, n - sent);
+        if (k > 0) { sent += k; spin = 0; _tr_lf_notify(&r->rx_seq, &r->rx_wait); continue; }
+        if (++spin < _TR_LF_SPIN) { _tr_cpu_relax(); continue; }
+        long long left = _tr_lf_left_ms(dl);
+        if (left == 0) break;
+        k = _tr_lf_park(r, tx_seq, tx_wait, _tr_lf_push_n(r, v + sent, n - sent), left);
+        if (k > 0) { sent += k; _tr_lf_notify(&r->rx_seq, &r->rx_wait); }
+    }
+    return sent;
+}
+/* Blocking batch recv: waits for at least one value (or close / timeout),
+ * then takes up to n. Returns how many were received (0 = closed and empty,
+ * or timed out). */
+static long long _tr_lf_recv_n(_TrLfRing* r, long long* out, long long n, long long ms) {
+    long long dl = _tr_lf_deadline(ms);
+    int spin = 0;
+    for (;;) {
+        long long k = _tr_lf_pop_n(r, out, n);
+        if (k > 0) { _tr_lf_notify(&r->tx_seq, &r->tx_wait); return k; }
+        if (__atomic_load_n(&r->closed, __ATOMIC_ACQUIRE)) {
+            k = _tr_lf_pop_n(r, out, n);             /* drain what raced the close */
+            if (k > 0) _tr_lf_notify(&r->tx_seq, &r->tx_wait);
+            return k;
+        }
+        if (++spin < _TR_LF_SPIN) { _tr_cpu_relax(); continue; }
+        long long left = _tr_lf_left_ms(dl);
+        if (left == 0) return 0;
+        k = _tr_lf_park(r, rx_seq, rx_wait, _tr_lf_pop_n(r, out, n), left);
+        if (k > 0) { _tr_lf_notify(&r->tx_seq, &r->tx_wait); return k; }
+    }
+}
+static void _tr_lf_close(_TrLfRing* r) {
+    __atomic_store_n(&r->closed, 1, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&r->rx_seq, 1, __ATOMIC_RELEASE); _tr_futex_wake(&r->rx_seq);
+    __atomic_add_fetch(&r->tx_seq, 1, __ATOMIC_RELEASE); _tr_futex_wake(&r->tx_seq);
+}
+static inline long long _tr_lf_len(_TrLfRing* r) {
+    long long n = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    return n < 0 ? 0 : (n > r->cap ? r->cap : n);
+}
+
 typedef struct {
     long long* buf; long long head,tail,count,cap; volatile int closed;
     pthread_mutex_t mu; pthread_cond_t not_empty, not_full;
+    _TrLfRing* lf;      /* non-NULL: lock-free SPSC/MPSC ring; the fields above are unused */
 } _TrChan;
 static _TrChan* _tr_chan_new(long long cap) {
     if(cap<1)cap=1; _TrChan* c=(_TrChan*)calloc(1,sizeof(_TrChan));
     c->buf=(long long*)TAURARO_CALLOC((size_t)cap,sizeof(long long)); c->cap=cap;
     pthread_mutex_init(&c->mu,NULL); pthread_cond_init(&c->not_empty,NULL); pthread_cond_init(&c->not_full,NULL); return c;
 }
+/* One producer / one consumer thread. */
+static _TrChan* _tr_chan_new_spsc(long long cap) {
+    _TrChan* c=(_TrChan*)calloc(1,sizeof(_TrChan));
+    c->lf=_tr_lf_new(cap<1?1:cap, 0); c->cap=c->lf->cap; return c;
+}
+/* Any number of producer threads, one consumer thread. */
+static _TrChan* _tr_chan_new_mpsc(long long cap) {
+    _TrChan* c=(_TrChan*)calloc(1,sizeof(_TrChan));
+    c->lf=_tr_lf_new(cap<1?1:cap, 1); c->cap=c->lf->cap; return c;
+}
 static void _tr_chan_send(_TrChan* c, long long val) {
+    if(c->lf){_tr_lf_send_n(c->lf,&val,1,-1);return;}
     pthread_mutex_lock(&c->mu);
     while(c->count>=c->cap&&!c->closed) pthread_cond_wait(&c->not_full,&c->mu);
     if(!c->closed){c->buf[c->tail]=val;c->tail=(c->tail+1)%c->cap;c->count++;pthread_cond_signal(&c->not_empty);}
     pthread_mutex_unlock(&c->mu);
 }
 static long long _tr_chan_recv(_TrChan* c) {
+    if(c->lf){long long v=0;_tr_lf_recv_n(c->lf,&v,1,-1);return v;}
     pthread_mutex_lock(&c->mu);
     while(c->count==0&&!c->closed) pthread_cond_wait(&c->not_empty,&c->mu);
     long long v=0;
@@ -1453,16 +2127,19 @@ static long long _tr_chan_recv(_TrChan* c) {
     pthread_mutex_unlock(&c->mu); return v;
 }
 static bool _tr_chan_try_send(_TrChan* c, long long val) {
+    if(c->lf){if(__atomic_load_n(&c->lf->closed,__ATOMIC_ACQUIRE)||!_tr_lf_push_n(c->lf,&val,1))return false;_tr_lf_notify(&c->lf->rx_seq,&c->lf->rx_wait);return true;}
     pthread_mutex_lock(&c->mu); bool ok=!c->closed&&c->count<c->cap;
     if(ok){c->buf[c->tail]=val;c->tail=(c->tail+1)%c->cap;c->count++;pthread_cond_signal(&c->not_empty);}
     pthread_mutex_unlock(&c->mu); return ok;
 }
 static long long _tr_chan_try_recv_val(_TrChan* c) {
+    if(c->lf){long long v=LLONG_MIN;if(_tr_lf_pop_n(c->lf,&v,1))_tr_lf_notify(&c->lf->tx_seq,&c->lf->tx_wait);return v;}
     pthread_mutex_lock(&c->mu); long long v=LLONG_MIN;
     if(c->count>0){v=c->buf[c->head];c->head=(c->head+1)%c->cap;c->count--;pthread_cond_signal(&c->not_full);}
     pthread_mutex_unlock(&c->mu); return v;
 }
 static bool _tr_chan_send_timeout(_TrChan* c, long long val, long long ms) {
+    if(c->lf) return _tr_lf_send_n(c->lf,&val,1,ms<0?0:ms)==1;
     struct timespec ts; clock_gettime(CLOCK_REALTIME,&ts);
     ts.tv_sec+=ms/1000; ts.tv_nsec+=(ms%1000)*1000000LL;
     if(ts.tv_nsec>=1000000000LL){ts.tv_sec++;ts.tv_nsec-=1000000000LL;}
@@ -1472,6 +2149,7 @@ static bool _tr_chan_send_timeout(_TrChan* c, long long val, long long ms) {
     pthread_mutex_unlock(&c->mu); return ok;
 }
 static long long _tr_chan_recv_timeout_val(_TrChan* c, long long ms) {
+    if(c->lf){long long v=LLONG_MIN;_tr_lf_recv_n(c->lf,&v,1,ms<0?0:ms);return v;}
     struct timespec ts; clock_gettime(CLOCK_REALTIME,&ts);
     ts.tv_sec+=ms/1000; ts.tv_nsec+=(ms%1000)*1000000LL;
     if(ts.tv_nsec>=1000000000LL){ts.tv_sec++;ts.tv_nsec-=1000000000LL;}
@@ -1482,14 +2160,16 @@ static long long _tr_chan_recv_timeout_val(_TrChan* c, long long ms) {
     pthread_mutex_unlock(&c->mu); return v;
 }
 static void _tr_chan_close(_TrChan* c) {
+    if(c->lf){_tr_lf_close(c->lf);return;}
     pthread_mutex_lock(&c->mu); c->closed=1;
     pthread_cond_broadcast(&c->not_empty); pthread_cond_broadcast(&c->not_full); pthread_mutex_unlock(&c->mu);
 }
-static bool   _tr_chan_is_closed(_TrChan* c) { pthread_mutex_lock(&c->mu); bool r=c->closed!=0; pthread_mutex_unlock(&c->mu); return r; }
-static long long _tr_chan_len(_TrChan* c)    { pthread_mutex_lock(&c->mu); long long n=c->count; pthread_mutex_unlock(&c->mu); return n; }
+static bool   _tr_chan_is_closed(_TrChan* c) { if(c->lf) return __atomic_load_n(&c->lf->closed,__ATOMIC_ACQUIRE)!=0; pthread_mutex_lock(&c->mu); bool r=c->closed!=0; pthread_mutex_unlock(&c->mu); return r; }
+static long long _tr_chan_len(_TrChan* c)    { if(c->lf) return _tr_lf_len(c->lf); pthread_mutex_lock(&c->mu); long long n=c->count; pthread_mutex_unlock(&c->mu); return n; }
 static long long _tr_chan_cap(_TrChan* c)    { return c?c->cap:0; }
-static void   _tr_chan_free(_TrChan* c)      { if(!c)return; pthread_mutex_destroy(&c->mu); pthread_cond_destroy(&c->not_empty); pthread_cond_destroy(&c->not_full); _tr_free(c->buf); _tr_free(c); }
+static void   _tr_chan_free(_TrChan* c)      { if(!c)return; if(c->lf){_tr_lf_free(c->lf);_tr_free(c);return;} pthread_mutex_destroy(&c->mu); pthread_cond_destroy(&c->not_empty); pthread_cond_destroy(&c->not_full); _tr_free(c->buf); _tr_free(c); }
 static long long _tr_chan_recv_ok(_TrChan* c, int* ok) {
+    if(c->lf){long long v=0;*ok=_tr_lf_recv_n(c->lf,&v,1,-1)==1;return v;}
     pthread_mutex_lock(&c->mu);
     while (c->count == 0 && !c->closed) pthread_cond_wait(&c->not_empty, &c->mu);
     long long v = 0; *ok = 0;
@@ -1500,6 +2180,31 @@ static long long _tr_chan_recv_ok(_TrChan* c, int* ok) {
     pthread_mutex_unlock(&c->mu); return v;
 }
 
+/* Batch ops: send all n values (blocking; stops early only on close) /
+ * receive 1..max values (blocking until at least one, 0 = closed and empty).
+ * The mutex ring moves the whole batch under one lock acquisition. */
+static long long _tr_chan_send_many(_TrChan* c, const long long* v, long long n) {
+    if(c->lf) return _tr_lf_send_n(c->lf,v,n,-1);
+    long long sent=0;
+    pthread_mutex_lock(&c->mu);
+    while(sent<n&&!c->closed){
+        while(c->count>=c->cap&&!c->closed) pthread_cond_wait(&c->not_full,&c->mu);
+        while(sent<n&&c->count<c->cap&&!c->closed){c->buf[c->tail]=v[sent++];c->tail=(c->tail+1)%c->cap;c->count++;}
+        pthread_cond_broadcast(&c->not_empty);
+    }
+    pthread_mutex_unlock(&c->mu); return sent;
+}
+static long long _tr_chan_recv_many(_TrChan* c, long long* out, long long max) {
+    if(max<=0) return 0;
+    if(c->lf) return _tr_lf_recv_n(c->lf,out,max,-1);
+    pthread_mutex_lock(&c->mu);
+    while(c->count==0&&!c->closed) pthread_cond_wait(&c->not_empty,&c->mu);
+    long long got=0;
+    while(got<max&&c->count>0){out[got++]=c->buf[c->head];c->head=(c->head+1)%c->cap;c->count--;}
+    if(got) pthread_cond_broadcast(&c->not_full);
+    pthread_mutex_unlock(&c->mu); return got;
+}
+
 /* refcount=2: one for caller (_tr_task_free), one for worker (_tr_task_complete). */
 typedef struct {
     volatile long long result; char* error; volatile int done, cancelled, refcount;
@@ -1741,9 +2446,24 @@ static inline void _tr_rwlbox_cleanup_w(_TrRWLBox** bp) {
     if (bp && *bp && _tr_lstack_pop(&_tr_tl_rwl_w_stk, *bp)) _tr_rwl_write_unlock((*bp)->rw);
 }
 
-/* ── ThreadPool: fixed-N worker pool with a channel work queue ────────── */
+/* ── ThreadPool: fixed-N worker pool ──────────────────────────────────── */
 /* BARE stub is defined inside the BARE platform block above. */
 #ifndef TAURARO_BARE
+static inline long long _tr_threadpool_auto_n(void) {
+#ifdef _WIN32
+    SYSTEM_INFO si; GetSystemInfo(&si); return (long long)si.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    /* _SC_NPROCESSORS_ONLN may not exist on all POSIX systems (Haiku, QNX, old BSDs) */
+    long n = sysconf(_SC_NPROCESSORS_ONLN); return n > 0 ? (long long)n : 1LL;
+#elif defined(HW_NCPU) /* BSD/macOS fallback via sysctl */
+    int mib[2] = {CTL_HW, HW_NCPU}; int ncpu = 1; size_t len = sizeof(ncpu);
+    sysctl(mib, 2, &ncpu, &len, NULL, 0); return (long long)(ncpu > 0 ? ncpu : 1);
+#else
+    return 1LL;
+#endif
+}
+#if defined(_WIN32)
+/* Windows: channel work queue (one lock shared by every worker). */
 typedef struct { void*(*fn)(void*); void* arg; } _TrPoolItem;
 typedef struct {
     _TrChan* queue; _TrThread* workers; int n_workers;
@@ -1763,19 +2483,6 @@ static void* _tr_pool_worker(void* arg) {
     }
     return NULL;
 }
-static inline long long _tr_threadpool_auto_n(void) {
-#ifdef _WIN32
-    SYSTEM_INFO si; GetSystemInfo(&si); return (long long)si.dwNumberOfProcessors;
-#elif defined(_SC_NPROCESSORS_ONLN)
-    /* _SC_NPROCESSORS_ONLN may not exist on all POSIX systems (Haiku, QNX, old BSDs) */
-    long n = sysconf(_SC_NPROCESSORS_ONLN); return n > 0 ? (long long)n : 1LL;
-#elif defined(HW_NCPU) /* BSD/macOS fallback via sysctl */
-    int mib[2] = {CTL_HW, HW_NCPU}; int ncpu = 1; size_t len = sizeof(ncpu);
-    sysctl(mib, 2, &ncpu, &len, NULL, 0); return (long long)(ncpu > 0 ? ncpu : 1);
-#else
-    return 1LL;
-#endif
-}
 static inline _TrThreadPool* _tr_threadpool_new(long long n) {
     if (n < 1) n = 1;
     _TrThreadPool* p = (_TrThreadPool*)TAURARO_CALLOC(1, sizeof(_TrThreadPool));
@@ -1805,6 +2512,294 @@ static inline void _tr_threadpool_free(_TrThreadPool* p) {
     _tr_chan_free(p->queue); _tr_wg_free(p->wg);
     TAURARO_FREE(p->workers); TAURARO_FREE(p);
 }
+#else
+/* POSIX: work-stealing pool. Every worker owns a Chase-Lev deque: the owner
+ * pushes and pops at the bottom (LIFO, so a job's nested spawns stay
+ * cache-warm), idle workers steal from the top. A spawn from outside the pool
+ * lands on a worker's lock-free inbox (round-robin), which its owner, or any
+ * idle thief, moves into a deque. Job nodes are intrusive and recycled through
+ * a process-wide freelist: finished nodes go back in batches, and a submitter
+ * takes the whole list in one exchange, so a warmed-up pool does no malloc
+ * per spawn. An idle worker spins, then yields, then parks on a condvar; a
+ * spawn only takes that lock when a worker is actually parked. wait() helps
+ * run queued jobs before it blocks. */
+#include <sched.h>
+#define _TR_POOL_DQ_CAP   4096     /* per-worker deque slots (power of two) */
+#define _TR_POOL_SPIN     256      /* idle polls before yielding */
+#define _TR_POOL_YIELDS   16       /* sched_yield()s before parking */
+#define _TR_POOL_RET_MAX  64       /* finished nodes batched per freelist push */
+
+typedef struct _TrPoolJob {
+    void*(*fn)(void*);
+    void*              arg;
+    struct _TrPoolJob* next;       /* inbox / overflow / freelist link */
+} _TrPoolJob;
+struct _TrThreadPool;
+typedef struct _TrPoolWorker {
+    long long        top __attribute__((aligned(64)));     /* thieves (CAS) */
+    long long        bottom __attribute__((aligned(64)));  /* owner only    */
+    _TrPoolJob*      dq[_TR_POOL_DQ_CAP];
+    _TrPoolJob*      inbox __attribute__((aligned(64)));   /* push: CAS; take: exchange */
+    _TrPoolJob*      ovf;          /* owner-private spill when the deque is full */
+    _TrPoolJob*      ret;          /* finished nodes not yet on the freelist */
+    _TrPoolJob*      ret_tail;
+    int              ret_n;
+    unsigned         rng;          /* victim-selection xorshift state */
+    struct _TrThreadPool* pool;
+} _TrPoolWorker;
+typedef struct _TrThreadPool {
+    _TrPoolWorker*   w;
+    _TrThread*       workers;
+    int              n_workers;
+    long long        pending __attribute__((aligned(64)));  /* spawned, not finished */
+    unsigned         rr;           /* round-robin inbox cursor for outside spawns */
+    int              sleepers;     /* workers parked on park_cv */
+    int              waiters;      /* threads blocked in wait() */
+    int              shutdown;
+    pthread_mutex_t  park_mu;
+    pthread_cond_t   park_cv;
+    pthread_cond_t   done_cv;
+} _TrThreadPool;
+
+#if defined(_TR_MAIN)
+_TrPoolJob*            _tr_pool_jfree = NULL;    /* shared freelist of job nodes */
+__thread _TrPoolJob*    _tr_pool_jcache = NULL;   /* this thread's share of it */
+__thread _TrPoolWorker* _tr_pool_self = NULL;     /* set on pool worker threads */
+#else
+extern _TrPoolJob*            _tr_pool_jfree;
+extern __thread _TrPoolJob*    _tr_pool_jcache;
+extern __thread _TrPoolWorker* _tr_pool_self;
+#endif
+
+static inline _TrPoolJob* _tr_pool_job_get(void) {
+    _TrPoolJob* j = _tr_pool_jcache;
+    if (!j) j = __atomic_exchange_n(&_tr_pool_jfree, NULL, __ATOMIC_ACQUIRE);
+    if (j) { _tr_pool_jcache = j->next; return j; }
+    j = (_TrPoolJob*)TAURARO_ALLOC(sizeof(_TrPoolJob));
+    if (!j) { _TR_OOM_ABORT(); }
+    return j;
+}
+/* Push the chain head..tail onto the freelist. Push-only CAS plus take-all
+ * exchange on the other side, so there is no ABA window. */
+static inline void _tr_pool_jfree_push(_TrPoolJob* head, _TrPoolJob* tail) {
+    _TrPoolJob* top = __atomic_load_n(&_tr_pool_jfree, __ATOMIC_RELAXED);
+    do { tail->next = top; }
+    while (!__atomic_compare_exchange_n(&_tr_pool_jfree, &top, head, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+static inline void _tr_pool_ret_flush(_TrPoolWorker* w) {
+    if (!w->ret) return;
+    _tr_pool_jfree_push(w->ret, w->ret_tail);
+    w->ret = w->ret_tail = NULL; w->ret_n = 0;
+}
+
+/* Chase-Lev deque (Lê et al., "Correct and Efficient Work-Stealing for Weak
+ * Memory Models"), fixed capacity: a full deque spills to `ovf`. */
+static inline int _tr_pool_dq_push(_TrPoolWorker* w, _TrPoolJob* j) {
+    long long b = __atomic_load_n(&w->bottom, __ATOMIC_RELAXED);
+    long long t = __atomic_load_n(&w->top, __ATOMIC_ACQUIRE);
+    if (b - t >= _TR_POOL_DQ_CAP) return 0;
+    __atomic_store_n(&w->dq[b & (_TR_POOL_DQ_CAP - 1)], j, __ATOMIC_RELAXED);
+    /* Release publishes the slot and the job's fields to a thief's acquire. */
+    __atomic_store_n(&w->bottom, b + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+static inline _TrPoolJob* _tr_pool_dq_take(_TrPoolWorker* w) {
+    long long b = __atomic_load_n(&w->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&w->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    long long t = __atomic_load_n(&w->top, __ATOMIC_RELAXED);
+    if (t > b) { __atomic_store_n(&w->bottom, b + 1, __ATOMIC_RELAXED); return NULL; }
+    _TrPoolJob* j = __atomic_load_n(&w->dq[b & (_TR_POOL_DQ_CAP - 1)], __ATOMIC_RELAXED);
+    if (t == b) {
+        /* Last element: race the thieves for it. */
+        if (!__atomic_compare_exchange_n(&w->top, &t, t + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) j = NULL;
+        __atomic_store_n(&w->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+    return j;
+}
+static inline _TrPoolJob* _tr_pool_dq_steal(_TrPoolWorker* w) {
+    long long t = __atomic_load_n(&w->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    long long b = __atomic_load_n(&w->bottom, __ATOMIC_ACQUIRE);
+    if (t >= b) return NULL;
+    _TrPoolJob* j = __atomic_load_n(&w->dq[t & (_TR_POOL_DQ_CAP - 1)], __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&w->top, &t, t + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) return NULL;
+    return j;
+}
+
+static inline void _tr_pool_inbox_push(_TrPoolWorker* w, _TrPoolJob* j) {
+    _TrPoolJob* top = __atomic_load_n(&w->inbox, __ATOMIC_RELAXED);
+    do { j->next = top; }
+    while (!__atomic_compare_exchange_n(&w->inbox, &top, j, 1, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+}
+/* Move a whole inbox (`from`, possibly another worker's) into `w`'s deque,
+ * oldest first; whatever does not fit spills to `w->ovf`. */
+static inline void _tr_pool_inbox_move(_TrPoolWorker* w, _TrPoolWorker* from) {
+    _TrPoolJob* j = __atomic_exchange_n(&from->inbox, NULL, __ATOMIC_ACQUIRE);
+    _TrPoolJob* fifo = NULL;
+    while (j) { _TrPoolJob* nx = j->next; j->next = fifo; fifo = j; j = nx; }
+    while (fifo) {
+        _TrPoolJob* nx = fifo->next;
+        if (!_tr_pool_dq_push(w, fifo)) { fifo->next = w->ovf; w->ovf = fifo; }
+        fifo = nx;
+    }
+}
+/* Steal one job: deque tops first, then (for a worker) a whole inbox.
+ * `self` is NULL for a non-worker helping in wait(); it only steals jobs. */
+static _TrPoolJob* _tr_pool_steal(_TrThreadPool* p, _TrPoolWorker* self) {
+    int n = p->n_workers;
+    unsigned r = self ? self->rng : (unsigned)(uintptr_t)&n;
+    r ^= r << 13; r ^= r >> 17; r ^= r << 5;
+    if (self) self->rng = r;
+    int start = (int)(r % (unsigned)n);
+    for (int i = 0; i < n; i++) {
+        _TrPoolWorker* v = &p->w[(start + i) % n];
+        if (v == self) continue;
+        _TrPoolJob* j = _tr_pool_dq_steal(v);
+        if (j) return j;
+    }
+    if (!self) return NULL;
+    for (int i = 0; i < n; i++) {
+        _TrPoolWorker* v = &p->w[(start + i) % n];
+        if (v == self || !__atomic_load_n(&v->inbox, __ATOMIC_RELAXED)) continue;
+        _tr_pool_inbox_move(self, v);
+        _TrPoolJob* j = _tr_pool_dq_take(self);
+        if (j) return j;
+    }
+    return NULL;
+}
+static inline _TrPoolJob* _tr_pool_find(_TrPoolWorker* w) {
+    _TrPoolJob* j = _tr_pool_dq_take(w);
+    if (j) return j;
+    if (w->ovf) { j = w->ovf; w->ovf = j->next; return j; }
+    if (__atomic_load_n(&w->inbox, __ATOMIC_RELAXED)) {
+        _tr_pool_inbox_move(w, w);
+        if ((j = _tr_pool_dq_take(w))) return j;
+    }
+    return _tr_pool_steal(w->pool, w);
+}
+static inline int _tr_pool_has_work(_TrThreadPool* p) {
+    for (int i = 0; i < p->n_workers; i++) {
+        _TrPoolWorker* v = &p->w[i];
+        if (__atomic_load_n(&v->inbox, __ATOMIC_SEQ_CST)) return 1;
+        if (__atomic_load_n(&v->bottom, __ATOMIC_SEQ_CST) - __atomic_load_n(&v->top, __ATOMIC_SEQ_CST) > 0) return 1;
+    }
+    return 0;
+}
+static inline void _tr_pool_wake(_TrThreadPool* p) {
+    pthread_mutex_lock(&p->park_mu);
+    pthread_cond_signal(&p->park_cv);
+    pthread_mutex_unlock(&p->park_mu);
+}
+/* Run one job and retire it. `w` is the running worker (NULL for a helper). */
+static inline void _tr_pool_run(_TrThreadPool* p, _TrPoolWorker* w, _TrPoolJob* j) {
+    j->fn(j->arg);
+    if (w) {
+        j->next = w->ret; w->ret = j;
+        if (!w->ret_tail) w->ret_tail = j;
+        if (++w->ret_n >= _TR_POOL_RET_MAX) _tr_pool_ret_flush(w);
+    } else {
+        _tr_pool_jfree_push(j, j);
+    }
+    /* Pairs with wait(): it bumps `waiters` before re-reading `pending`. */
+    if (__atomic_sub_fetch(&p->pending, 1, __ATOMIC_SEQ_CST) == 0 &&
+        __atomic_load_n(&p->waiters, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&p->park_mu);
+        pthread_cond_broadcast(&p->done_cv);
+        pthread_mutex_unlock(&p->park_mu);
+    }
+}
+static void* _tr_pool_worker(void* arg) {
+    _TrPoolWorker* w = (_TrPoolWorker*)arg;
+    _TrThreadPool* p = w->pool;
+    _tr_pool_self = w;
+    int idle = 0;
+    for (;;) {
+        _TrPoolJob* j = _tr_pool_find(w);
+        if (j) { idle = 0; _tr_pool_run(p, w, j); continue; }
+        if (__atomic_load_n(&p->shutdown, __ATOMIC_ACQUIRE)) break;
+        if (++idle < _TR_POOL_SPIN) { _tr_cpu_relax(); continue; }
+        if (idle < _TR_POOL_SPIN + _TR_POOL_YIELDS) { sched_yield(); continue; }
+        _tr_pool_ret_flush(w);
+        /* Park. `sleepers` is raised before the final re-check, and spawn
+         * reads it after publishing, so one of the two always sees the other. */
+        pthread_mutex_lock(&p->park_mu);
+        __atomic_add_fetch(&p->sleepers, 1, __ATOMIC_SEQ_CST);
+        if (!_tr_pool_has_work(p) && !__atomic_load_n(&p->shutdown, __ATOMIC_SEQ_CST))
+            pthread_cond_wait(&p->park_cv, &p->park_mu);
+        __atomic_sub_fetch(&p->sleepers, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&p->park_mu);
+        idle = 0;
+    }
+    _tr_pool_ret_flush(w);
+    _tr_pool_self = NULL;
+    return NULL;
+}
+static inline _TrThreadPool* _tr_threadpool_new(long long n) {
+    if (n < 1) n = 1;
+    _TrThreadPool* p = (_TrThreadPool*)TAURARO_CALLOC(1, sizeof(_TrThreadPool));
+    p->n_workers = (int)n;
+    p->w = (_TrPoolWorker*)TAURARO_CALLOC((size_t)n, sizeof(_TrPoolWorker));
+    p->workers = (_TrThread*)TAURARO_ALLOC((size_t)n * sizeof(_TrThread));
+    if (!p->w || !p->workers) { _TR_OOM_ABORT(); }
+    pthread_mutex_init(&p->park_mu, NULL);
+    pthread_cond_init(&p->park_cv, NULL);
+    pthread_cond_init(&p->done_cv, NULL);
+    for (int i = 0; i < (int)n; i++) {
+        p->w[i].pool = p;
+        p->w[i].rng = 0x9E3779B9u * (unsigned)(i + 1);
+    }
+    for (int i = 0; i < (int)n; i++)
+        p->workers[i] = _tr_thread_start(_tr_pool_worker, &p->w[i]);
+    return p;
+}
+static inline _TrThreadPool* _tr_threadpool_auto(void) {
+    return _tr_threadpool_new(_tr_threadpool_auto_n());
+}
+static inline void _tr_threadpool_spawn(_TrThreadPool* p, void*(*fn)(void*), void* arg) {
+    _TrPoolJob* j = _tr_pool_job_get();
+    j->fn = fn; j->arg = arg; j->next = NULL;
+    __atomic_add_fetch(&p->pending, 1, __ATOMIC_RELAXED);
+    _TrPoolWorker* self = _tr_pool_self;
+    if (!(self && self->pool == p && _tr_pool_dq_push(self, j))) {
+        unsigned k = __atomic_fetch_add(&p->rr, 1, __ATOMIC_RELAXED) % (unsigned)p->n_workers;
+        _tr_pool_inbox_push(&p->w[k], j);
+    }
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&p->sleepers, __ATOMIC_RELAXED) > 0) _tr_pool_wake(p);
+}
+/* Block until every spawned job has finished, running queued jobs meanwhile
+ * (a worker calling wait() from inside a job keeps draining its own deque). */
+static inline void _tr_threadpool_wait(_TrThreadPool* p) {
+    _TrPoolWorker* self = (_tr_pool_self && _tr_pool_self->pool == p) ? _tr_pool_self : NULL;
+    int idle = 0;
+    while (__atomic_load_n(&p->pending, __ATOMIC_ACQUIRE) > 0) {
+        _TrPoolJob* j = self ? _tr_pool_find(self) : _tr_pool_steal(p, NULL);
+        if (j) { idle = 0; _tr_pool_run(p, self, j); continue; }
+        if (++idle < _TR_POOL_SPIN) { _tr_cpu_relax(); continue; }
+        if (self) { sched_yield(); continue; }   /* a worker must keep helping */
+        pthread_mutex_lock(&p->park_mu);
+        __atomic_add_fetch(&p->waiters, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&p->pending, __ATOMIC_SEQ_CST) > 0)
+            pthread_cond_wait(&p->done_cv, &p->park_mu);
+        __atomic_sub_fetch(&p->waiters, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&p->park_mu);
+    }
+}
+static inline void _tr_threadpool_free(_TrThreadPool* p) {
+    if (!p) return;
+    _tr_threadpool_wait(p);
+    pthread_mutex_lock(&p->park_mu);
+    __atomic_store_n(&p->shutdown, 1, __ATOMIC_SEQ_CST);
+    pthread_cond_broadcast(&p->park_cv);
+    pthread_mutex_unlock(&p->park_mu);
+    for (int i = 0; i < p->n_workers; i++) _tr_thread_join_wait(p->workers[i]);
+    pthread_mutex_destroy(&p->park_mu);
+    pthread_cond_destroy(&p->park_cv);
+    pthread_cond_destroy(&p->done_cv);
+    TAURARO_FREE(p->w); TAURARO_FREE(p->workers); TAURARO_FREE(p);
+}
+#endif /* _WIN32 */
 #endif /* !TAURARO_BARE */
 
 /* Global async pool — submits work to the thread pool; falls back to sync if pool is NULL */
@@ -1944,6 +2939,10 @@ static inline bool  _tr_chan_is_closed_h(char* c)                              {
 static inline long long _tr_chan_len_h(char* c)                                { return _tr_chan_len((_TrChan*)c); }
 static inline long long _tr_chan_cap_h(char* c)                                { return _tr_chan_cap((_TrChan*)c); }
 static inline void  _tr_chan_free_h(char* c)                                   { _tr_chan_free((_TrChan*)c); }
+static inline char* _tr_chan_new_spsc_h(long long cap)                         { return (char*)_tr_chan_new_spsc(cap); }
+static inline char* _tr_chan_new_mpsc_h(long long cap)                         { return (char*)_tr_chan_new_mpsc(cap); }
+static inline long long _tr_chan_send_many_h(char* c, char* v, long long n)    { return _tr_chan_send_many((_TrChan*)c, (const long long*)(void*)v, n); }
+static inline long long _tr_chan_recv_many_h(char* c, char* out, long long max){ return _tr_chan_recv_many((_TrChan*)c, (long long*)(void*)out, max); }
 
 /* Task / Future */
 static inline char* _tr_task_new_h(void)                                       { return (char*)_tr_task_new(); }
@@ -2310,7 +3309,8 @@ static int64_t _tr_stdout_supports_ansi(void) {
  * _TrIOPoll — Async I/O readiness abstraction
  *
  * Unified API over platform-specific event demultiplexers:
- *   Linux:       epoll (default) + io_uring (opt-in: -DTAURARO_IO_URING)
+ *   Linux:       epoll (default) + io_uring completion ring (opt-in at run
+ *                time: Coro.use_io_uring() / TAURARO_IO_URING=1)
  *   Windows:     IOCP (I/O Completion Ports)
  *   macOS/BSD:   kqueue
  *   BARE/kernel: polling stub (returns immediately, no OS call)
@@ -2518,36 +3518,201 @@ static inline int _tr_iopoll_wait(_TrIOPoll* p, _TrIOEvent* out, int maxev, int
     return n;
 }
 
-#if defined(TAURARO_IO_URING)
-/* ── io_uring support (Linux ≥5.1, opt-in with -DTAURARO_IO_URING) ─── *
- * Provides zero-syscall-per-op submission/completion ring interface.   *
- * WARNING: incorrect ring usage can crash/oops the kernel. Only use   *
- * after thorough testing. The epoll backend is the safe default.       */
-#include <liburing.h>
-typedef struct { struct io_uring ring; } _TrIOUring;
-static inline _TrIOUring* _tr_iouring_create(unsigned entries) {
-    _TrIOUring* u = (_TrIOUring*)calloc(1, sizeof(_TrIOUring));
-    if (io_uring_queue_init(entries ? entries : 256u, &u->ring, 0) < 0) {
+/* ── io_uring completion ring (Linux ≥5.19) ─────────────────────────── *
+ * Raw-syscall ring (no liburing): the scheduler's completion reactor.   *
+ * Built whenever the kernel header is available; define                *
+ * TAURARO_NO_IO_URING to leave it out. Nothing uses it until a program *
+ * opts in (Coro.use_io_uring() or TAURARO_IO_URING=1 in the env); a    *
+ * kernel without the needed features falls back to the epoll path.    */
+#if !defined(TAURARO_NO_IO_URING) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#if defined(IORING_ACCEPT_MULTISHOT) && defined(IORING_FEAT_EXT_ARG)
+#define _TR_URING 1
+#endif
+#endif
+#endif
+
+#if defined(_TR_URING)
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup    425
+#define __NR_io_uring_enter    426
+#define __NR_io_uring_register 427
+#endif
+#define _TR_URING_ENTRIES 256u
+#define _TR_URING_BUFS    256u      /* provided-buffer ring: buffer count (power of 2) */
+#define _TR_URING_BUFSZ   16384u    /* ... and size of each buffer */
+#define _TR_URING_BGID    0
+
+typedef struct {
+    int                    fd;
+    unsigned               sq_entries, sq_mask, cq_mask;
+    unsigned*              sq_head;
+    unsigned*              sq_tail;
+    unsigned*              sq_array;
+    unsigned*              cq_head;
+    unsigned*              cq_tail;
+    struct io_uring_sqe*   sqes;
+    struct io_uring_cqe*   cqes;
+    void*                  sq_map;  size_t sq_map_sz;
+    void*                  cq_map;  size_t cq_map_sz;
+    size_t                 sqes_sz;
+    unsigned               sq_local; /* next SQE slot; published to *sq_tail on submit */
+    unsigned               pending;  /* SQEs filled since the last io_uring_enter     */
+    /* provided-buffer ring (group _TR_URING_BGID); br == NULL if unsupported */
+    struct io_uring_buf_ring* br;   size_t br_sz;
+    char*                  bufs;
+    unsigned short         br_tail;
+} _TrIOURing;
+
+static inline int _tr_uring_sys_enter(int fd, unsigned submit, unsigned min, unsigned flags, void* arg, size_t argsz) {
+    return (int)syscall(__NR_io_uring_enter, fd, submit, min, flags, arg, argsz);
+}
+
+/* Hand buffer `bid` back to the kernel's provided-buffer ring. */
+static inline void _tr_uring_buf_recycle(_TrIOURing* u, unsigned bid) {
+    struct io_uring_buf* b = &u->br->bufs[u->br_tail & (_TR_URING_BUFS - 1)];
+    b->addr = (unsigned long long)(uintptr_t)(u->bufs + (size_t)bid * _TR_URING_BUFSZ);
+    b->len  = _TR_URING_BUFSZ;
+    b->bid  = (unsigned short)bid;
+    u->br_tail++;
+    __atomic_store_n(&u->br->tail, u->br_tail, __ATOMIC_RELEASE);
+}
+
+/* Register the provided-buffer ring recv() picks buffers from, so an idle
+ * keep-alive connection holds no buffer of its own. Optional: leaves br NULL
+ * on a kernel without IORING_REGISTER_PBUF_RING. */
+static inline void _tr_uring_setup_bufs(_TrIOURing* u) {
+    u->br_sz = _TR_URING_BUFS * sizeof(struct io_uring_buf);
+    void* r = mmap(NULL, u->br_sz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (r == MAP_FAILED) return;
+    u->bufs = (char*)TAURARO_ALLOC((size_t)_TR_URING_BUFS * _TR_URING_BUFSZ);
+    if (!u->bufs) { munmap(r, u->br_sz); return; }
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr    = (unsigned long long)(uintptr_t)r;
+    reg.ring_entries = _TR_URING_BUFS;
+    reg.bgid         = _TR_URING_BGID;
+    if (syscall(__NR_io_uring_register, u->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        munmap(r, u->br_sz); TAURARO_FREE(u->bufs); u->bufs = NULL; return;
+    }
+    u->br = (struct io_uring_buf_ring*)r;
+    u->br_tail = 0;
+    for (unsigned i = 0; i < _TR_URING_BUFS; i++) _tr_uring_buf_recycle(u, i);
+}
+
+static inline void _tr_uring_destroy(_TrIOURing* u) {
+    if (!u) return;
+    if (u->br) munmap(u->br, u->br_sz);
+    if (u->bufs) TAURARO_FREE(u->bufs);
+    if (u->sqes) munmap(u->sqes, u->sqes_sz);
+    if (u->cq_map && u->cq_map != u->sq_map) munmap(u->cq_map, u->cq_map_sz);
+    if (u->sq_map) munmap(u->sq_map, u->sq_map_sz);
+    if (u->fd >= 0) close(u->fd);
+    free(u);
+}
+
+/* Set up a ring owned by the calling thread (one per scheduler worker).
+ * Returns NULL when io_uring is unavailable, disabled, or lacks EXT_ARG
+ * (timed waits). */
+static inline _TrIOURing* _tr_uring_create(void) {
+    _TrIOURing* u = (_TrIOURing*)calloc(1, sizeof(_TrIOURing));
+    if (!u) return NULL;
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    /* Only this thread submits, and completions are reaped at scheduler
+     * ticks anyway: skip the cross-thread wakeup IPIs where supported. */
+    p.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN;
+    u->fd = (int)syscall(__NR_io_uring_setup, _TR_URING_ENTRIES, &p);
+    if (u->fd < 0) {
+        memset(&p, 0, sizeof(p));
+        u->fd = (int)syscall(__NR_io_uring_setup, _TR_URING_ENTRIES, &p);
+    }
+    if (u->fd < 0 || !(p.features & IORING_FEAT_EXT_ARG)) {
+        if (u->fd >= 0) close(u->fd);
         free(u); return NULL;
     }
+    u->sq_map_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    u->cq_map_sz = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if ((p.features & IORING_FEAT_SINGLE_MMAP) && u->cq_map_sz > u->sq_map_sz) u->sq_map_sz = u->cq_map_sz;
+    u->sq_map = mmap(NULL, u->sq_map_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+    if (u->sq_map == MAP_FAILED) { u->sq_map = NULL; _tr_uring_destroy(u); return NULL; }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        u->cq_map = u->sq_map;
+    } else {
+        u->cq_map = mmap(NULL, u->cq_map_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_CQ_RING);
+        if (u->cq_map == MAP_FAILED) { u->cq_map = NULL; _tr_uring_destroy(u); return NULL; }
+    }
+    u->sqes_sz = p.sq_entries * sizeof(struct io_uring_sqe);
+    u->sqes = (struct io_uring_sqe*)mmap(NULL, u->sqes_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQES);
+    if (u->sqes == MAP_FAILED) { u->sqes = NULL; _tr_uring_destroy(u); return NULL; }
+    char* sq = (char*)u->sq_map;
+    char* cq = (char*)u->cq_map;
+    u->sq_head    = (unsigned*)(sq + p.sq_off.head);
+    u->sq_tail    = (unsigned*)(sq + p.sq_off.tail);
+    u->sq_array   = (unsigned*)(sq + p.sq_off.array);
+    u->sq_mask    = *(unsigned*)(sq + p.sq_off.ring_mask);
+    u->sq_entries = p.sq_entries;
+    u->cq_head    = (unsigned*)(cq + p.cq_off.head);
+    u->cq_tail    = (unsigned*)(cq + p.cq_off.tail);
+    u->cq_mask    = *(unsigned*)(cq + p.cq_off.ring_mask);
+    u->cqes       = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+    u->sq_local   = *u->sq_tail;
+    _tr_uring_setup_bufs(u);
     return u;
 }
-static inline void _tr_iouring_destroy(_TrIOUring* u) {
-    if (!u) return; io_uring_queue_exit(&u->ring); free(u);
-}
-static inline struct io_uring_sqe* _tr_iouring_get_sqe(_TrIOUring* u) {
-    return u ? io_uring_get_sqe(&u->ring) : NULL;
-}
-static inline int _tr_iouring_submit(_TrIOUring* u) {
-    return u ? io_uring_submit(&u->ring) : -1;
+
+/* Publish the filled SQEs and enter the kernel once. wait = 0: submit the
+ * batch and flush completed work without blocking; wait = 1: also block
+ * until at least one completion or timeout_ms passes (< 0 = no limit). */
+static inline int _tr_uring_enter(_TrIOURing* u, int wait, int timeout_ms) {
+    __atomic_store_n(u->sq_tail, u->sq_local, __ATOMIC_RELEASE);
+    unsigned submit = u->pending;
+    u->pending = 0;
+    if (!wait) return _tr_uring_sys_enter(u->fd, submit, 0, IORING_ENTER_GETEVENTS, NULL, 0);
+    if (timeout_ms < 0) return _tr_uring_sys_enter(u->fd, submit, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+    struct __kernel_timespec ts;
+    ts.tv_sec  = timeout_ms / 1000;
+    ts.tv_nsec = (long long)(timeout_ms % 1000) * 1000000;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.ts = (unsigned long long)(uintptr_t)&ts;
+    return _tr_uring_sys_enter(u->fd, submit, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+}
+
+/* Free SQE slots left before the ring must be flushed. */
+static inline unsigned _tr_uring_sq_space(_TrIOURing* u) {
+    return u->sq_entries - (u->sq_local - __atomic_load_n(u->sq_head, __ATOMIC_ACQUIRE));
+}
+
+/* Next free SQE (zeroed). Submission is batched: SQEs accumulate until the
+ * scheduler enters the kernel; a full ring is flushed early. */
+static inline struct io_uring_sqe* _tr_uring_sqe(_TrIOURing* u) {
+    if (_tr_uring_sq_space(u) == 0) {
+        _tr_uring_enter(u, 0, 0);
+        if (_tr_uring_sq_space(u) == 0) return NULL;
+    }
+    unsigned idx = u->sq_local & u->sq_mask;
+    struct io_uring_sqe* s = &u->sqes[idx];
+    memset(s, 0, sizeof(*s));
+    u->sq_array[idx] = idx;
+    u->sq_local++;
+    u->pending++;
+    return s;
 }
-static inline int _tr_iouring_wait_cqe(_TrIOUring* u, struct io_uring_cqe** cqe) {
-    return u ? io_uring_wait_cqe(&u->ring, cqe) : -1;
+
+/* Oldest unreaped completion, or NULL; release it with _tr_uring_cqe_seen. */
+static inline struct io_uring_cqe* _tr_uring_cqe_peek(_TrIOURing* u) {
+    unsigned h = *u->cq_head;
+    if (h == __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE)) return NULL;
+    return &u->cqes[h & u->cq_mask];
 }
-static inline void _tr_iouring_cqe_seen(_TrIOUring* u, struct io_uring_cqe* cqe) {
-    if (u) io_uring_cqe_seen(&u->ring, cqe);
+static inline void _tr_uring_cqe_seen(_TrIOURing* u) {
+    __atomic_store_n(u->cq_head, *u->cq_head + 1, __ATOMIC_RELEASE);
 }
-#endif /* TAURARO_IO_URING */
+#endif /* _TR_URING */
 
 #elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__)
 /* ── macOS/BSD: kqueue-backed _TrIOPoll ──────────────────────────────── */
@@ -2642,35 +3807,100 @@ static inline int   _tr_iopoll_mod_h(char* p, long long fd, long long ev, long l
 static inline int   _tr_iopoll_del_h(char* p, long long fd)
     { return _tr_iopoll_del((_TrIOPoll*)p,(int)fd); }
 
-/* =========================================================================
- * Green-thread scheduler - stackful coroutines + non-blocking reactor.
- *
- * This is Tauraro's async/await engine. Each `async`/`spawn` task is a
- * lightweight stackful coroutine (Windows Fiber / POSIX ucontext) with its
- * own small stack. `await` is a cheap context switch, NOT an OS thread
- * spawn - so a single OS thread cooperatively runs millions of tasks. An
- * `await` on a socket parks the task on fd-readiness via the _TrIOPoll
- * reactor (epoll/IOCP-select/kqueue) and yields, so no thread ever blocks on
- * I/O (Node.js / Redis single-reactor model; multicore = future work).
- * ========================================================================= */
-#if !defined(TAURARO_BARE) && !defined(TAURARO_WASM)
-
-#if defined(_WIN32)
-typedef LPVOID _tr_coctx_t;
+#ifdef _TR_MAIN
+  #define _TR_GLOBAL
 #else
-#include <ucontext.h>
-#include <sys/mman.h>
-typedef ucontext_t _tr_coctx_t;
+  #define _TR_GLOBAL extern
 #endif
 
-typedef void* (*_tr_coro_fn)(void*);
-typedef enum { _TRC_READY, _TRC_RUN, _TRC_SUSP, _TRC_DONE } _tr_costate;
-
-typedef struct _TrCoro {
-    _tr_coctx_t      ctx;
+/* Thread-local storage qualifier for per-thread exception stacks */
+#if defined(TAURARO_BARE) || defined(TAURARO_KERNEL)
+#  define _TR_THREAD_LOCAL
+#elif defined(_MSC_VER)
+#  define _TR_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__) || defined(__clang__)
+#  define _TR_THREAD_LOCAL __thread
+#else
+#  define _TR_THREAD_LOCAL _Thread_local
+#endif
+
+/* ── Per-thread panic state (storage definitions for _TR_MAIN TU) ─── */
+#if !defined(TAURARO_BARE) && !defined(TAURARO_KERNEL)
+_TR_GLOBAL _TR_THREAD_LOCAL int     _tr_thread_has_panic_buf;
+_TR_GLOBAL _TR_THREAD_LOCAL jmp_buf _tr_thread_panic_jmpbuf;
+_TR_GLOBAL _TR_THREAD_LOCAL char*   _tr_thread_panic_message;
+#endif
+
+/* ── Exception stack (setjmp/longjmp based, per-thread) ─────────────── */
+/* While a coroutine runs, its frames sit above _tr_exc_base; the ones below
+   belong to the scheduler's caller and are never a target of its raises
+   (see _tr_sched_step, which parks a suspended coroutine's frames). */
+
+#define _TR_MAX_EXC 64
+_TR_GLOBAL _TR_THREAD_LOCAL jmp_buf*  _tr_exc_bufs[_TR_MAX_EXC];
+_TR_GLOBAL _TR_THREAD_LOCAL char**    _tr_exc_msgs[_TR_MAX_EXC];
+_TR_GLOBAL _TR_THREAD_LOCAL int       _tr_exc_sp;
+_TR_GLOBAL _TR_THREAD_LOCAL int       _tr_exc_base;
+
+static void _tr_exc_push(jmp_buf* b, char** m) {
+    if (_tr_exc_sp < _TR_MAX_EXC) {
+        _tr_exc_bufs[_tr_exc_sp] = b;
+        _tr_exc_msgs[_tr_exc_sp] = m;
+        _tr_exc_sp++;
+    }
+}
+static void _tr_exc_pop(void)  { if (_tr_exc_sp > _tr_exc_base) _tr_exc_sp--; }
+static void _tr_exc_raise(char* msg) {
+    if (_tr_exc_sp > _tr_exc_base) {
+        _tr_exc_sp--;
+        *_tr_exc_msgs[_tr_exc_sp] = msg;
+        longjmp(*_tr_exc_bufs[_tr_exc_sp], 1);
+    }
+    /* No user try-handler: escalate to thread panic handler if in a spawned thread */
+    if (_tr_thread_has_panic_buf) {
+        _tr_thread_panic_message = msg;
+        longjmp(_tr_thread_panic_jmpbuf, 1);
+    }
+    _TR_DIAG("Unhandled exception: %s\n", msg ? msg : "(null)");
+    _TR_TRAP();
+}
+
+/* =========================================================================
+ * Green-thread scheduler - stackful coroutines + non-blocking reactor.
+ *
+ * This is Tauraro's async/await engine. Each `async`/`spawn` task is a
+ * lightweight stackful coroutine (Windows Fiber / POSIX ucontext) with its
+ * own small stack. `await` is a cheap context switch, NOT an OS thread
+ * spawn - so a single OS thread cooperatively runs millions of tasks. An
+ * `await` on a socket parks the task on fd-readiness via the _TrIOPoll
+ * reactor (epoll/IOCP-select/kqueue) and yields, so no thread ever blocks on
+ * I/O (Node.js / Redis single-reactor model by default; _tr_sched_run_workers
+ * spreads the same tasks over one scheduler per core with work stealing).
+ * ========================================================================= */
+#if !defined(TAURARO_BARE) && !defined(TAURARO_WASM)
+
+#if defined(_WIN32)
+typedef LPVOID _tr_coctx_t;
+#else
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <sched.h>
+typedef ucontext_t _tr_coctx_t;
+#endif
+
+typedef void* (*_tr_coro_fn)(void*);
+/* _TRC_EXIT: the body returned but the scheduler has not yet published the
+ * completion (joiner wake / DONE). Publishing only happens back on the
+ * scheduler stack, so an awaiter that frees the coro never unmaps the stack
+ * the finishing worker is still running on. */
+typedef enum { _TRC_READY, _TRC_RUN, _TRC_SUSP, _TRC_DONE, _TRC_EXIT } _tr_costate;
+
+typedef struct _TrCoro {
+    _tr_coctx_t      ctx;
 #if !defined(_WIN32)
-    char*            stack;
+    char*            stack;       /* usable stack (just above the guard page) */
 #endif
+    size_t           stack_sz;    /* usable bytes                           */
     _tr_coro_fn      fn;
     void*            arg;
     _tr_costate      state;
@@ -2683,21 +3913,128 @@ typedef struct _TrCoro {
                                    * registration); dropped when the coro is freed. */
     uint32_t         io_armed_ev; /* event mask registered for io_armed_fd  */
     int              detached;    /* 1 = scheduler frees it on completion   */
+    int              wid;         /* worker that owns it right now (multicore) */
+    int              pin;         /* affinity hint: worker index, -1 = any  */
     struct _TrCoro*  joiner;      /* coro waiting for this one to finish    */
     struct _TrCoro*  next;        /* ready-queue link                       */
-    struct _TrCoro*  snext;       /* sleep-list link                        */
+    struct _TrCoro*  tnext;       /* timer-wheel slot links                 */
+    struct _TrCoro** tpprev;
+    unsigned short   tslot;       /* wheel level * 64 + slot                */
+    unsigned char    timed_out;   /* last timed fd await hit its deadline   */
+    _TrArena*        arena;       /* region entered by this coro (NULL = heap) */
+    struct _TrCoExc* exc;         /* handler frames parked while suspended (lazy) */
 } _TrCoro;
 
+/* A suspended coroutine's try/with handler frames. The jmp_bufs live on the
+ * coroutine's own stack, so they stay valid wherever it resumes. */
+typedef struct _TrCoExc {
+    int      n;
+    jmp_buf* bufs[_TR_MAX_EXC];
+    char**   msgs[_TR_MAX_EXC];
+} _TrCoExc;
+
+/* ── Multicore: thread-per-core workers with work stealing ────────────────
+ * _tr_sched_run_workers(n) turns the calling thread into worker 0 and starts
+ * n-1 more OS threads, each with its OWN _tr_g (ready queue, timers, reactor).
+ * Every worker has a bounded lock-free run queue (single producer = the
+ * owner, multiple consumers = the owner + thieves, FIFO so yield stays fair);
+ * an idle worker steals a ready coro from a busy one. A coro that has armed an
+ * fd in its worker's reactor is pinned there (its registration lives in that
+ * epoll/kqueue set), so it only ever goes on the owner-private FIFO; so does a
+ * coro spawned with an affinity hint. Cross-worker wakeups (a joiner finishing
+ * on another worker, spawn_on(k)) go through a mutex-guarded inbox that the
+ * owner drains between dispatches. POSIX only: Windows fibers stay on the
+ * single-worker path. */
+#if !defined(_WIN32)
+#define _TR_MC 1
+#define _TR_RUNQ_CAP 256
+#ifndef _TR_MC_POLL_MS
+#define _TR_MC_POLL_MS 1        /* reactor wait cap while other workers run */
+#endif
+/* Marker stored in ->joiner once a coro's completion is published. */
+#define _TR_CO_JOIN_DONE ((_TrCoro*)(uintptr_t)1)
+
+struct _TrMC;
+typedef struct _TrMCWorker {
+    unsigned         rq_head __attribute__((aligned(64)));  /* owner + thieves (CAS) */
+    unsigned         rq_tail __attribute__((aligned(64)));  /* owner only            */
+    _TrCoro*         rq[_TR_RUNQ_CAP];
+    pthread_mutex_t  inbox_mu;
+    _TrCoro*         inbox_head;
+    _TrCoro*         inbox_tail;
+    int              inbox_n;     /* atomic hint: skip the lock when empty */
+    int              id;
+    unsigned         rng;         /* victim-selection xorshift state */
+    struct _TrMC*    mc;
+} _TrMCWorker;
+typedef struct _TrMC {
+    _TrMCWorker*     w;
+    int              n;
+    long long        live;        /* atomic: unfinished coros across all workers */
+} _TrMC;
+#endif
+
+#if defined(_TR_URING)
+/* One in-flight ring op. Lives on the parked coro's stack; the CQE's
+ * user_data points at it. `co` is NULL for an op nobody waits on (the send
+ * half of a linked send+recv). A provided-buffer recv is copied out and its
+ * buffer recycled by the reaping worker, which owns the buffer ring. */
+typedef struct {
+    struct _TrCoro*  co;
+    int              res;
+    unsigned         flags;
+    char*            data;     /* provided-buffer recv: copy of the bytes */
+} _TrURingOp;
+/* Multishot accept on one listener: the kernel keeps accepting and posts
+ * one CQE per connection; fds queue here until the accept loop takes them.
+ * Tagged user_data (ptr | 1). Freed once its last CQE has arrived after the
+ * listener was dropped (lfd = -1). */
+typedef struct _TrURingLsn {
+    int                  lfd;
+    int                  armed;    /* multishot SQE live in the kernel        */
+    int                  err;      /* last error CQE, 0 = none                */
+    int                  single;   /* kernel lacks multishot: one-shot accepts */
+    long long            n_ok;
+    int*                 q;        /* accepted fds (FIFO ring)                */
+    unsigned             qh, qn, qcap;
+    struct _TrCoro*      waiter;
+    struct _TrURingLsn*  next;
+} _TrURingLsn;
+#endif
+
 typedef struct {
     _tr_coctx_t  main_ctx;
     _TrCoro*     current;
     _TrCoro*     rhead;
     _TrCoro*     rtail;
-    _TrCoro*     shead;           /* timer-parked coros                     */
+    _TrCoro*     tw[4][64];       /* timer wheel (see _tr_tw_add)           */
+    uint64_t     tw_bits[4];      /* non-empty slots per level              */
+    long long    tw_cur;          /* next tick (ms) the wheel has to expire */
     _TrIOPoll*   reactor;
-    int          n_sleep;
+    int          n_sleep;         /* coros on the timer wheel               */
     int          n_io;
+    int          n_live;          /* unfinished coros spawned here (single-core) */
+    unsigned     tick;            /* alternates FIFO / run-queue dispatch   */
     int          inited;
+#if !defined(_WIN32)
+    char**       stk_pool;        /* idle stacks, all stk_sz bytes          */
+    size_t       stk_sz;
+    int          stk_n;
+    int          stk_cap;
+    int          blk_fd[8][2];    /* idle completion fds for _tr_co_blocking */
+    int          blk_n;
+#endif
+#if defined(_TR_MC)
+    _TrMCWorker* mc;              /* this thread's worker; NULL = single-core */
+#endif
+#if defined(_TR_URING)
+    _TrIOURing*  uring;           /* completion reactor; NULL = not in use  */
+    int          uring_state;     /* 0 = untried, 1 = live, -1 = unavailable */
+    int          n_uring;         /* coros parked on an in-flight ring op   */
+    int          uring_epoll;     /* POLL_ADD on the epoll fd in flight     */
+    unsigned     uring_tick;      /* dispatches since the last ring flush   */
+    _TrURingLsn* lsn;             /* multishot accept listeners (this worker) */
+#endif
 } _TrSchedG;
 /* Per-OS-thread scheduler (thread-per-core multicore = N worker threads, each
  * with its own independent scheduler + reactor). It MUST be a single shared
@@ -2711,6 +4048,37 @@ __thread _TrSchedG _tr_g = {0};
 #else
 extern __thread _TrSchedG _tr_g;
 #endif
+#if defined(_TR_URING)
+/* Process-wide io_uring opt-in: -1 = read TAURARO_IO_URING on first use,
+ * 0 = off, 1 = workers create a ring on their first socket op. */
+#ifdef _TR_MAIN
+int _tr_uring_want = -1;
+#else
+extern int _tr_uring_want;
+#endif
+#endif
+/* Process-wide default coroutine stack size (bytes, rounded up to pages by
+ * _tr_co_stack_get); 0 = _TR_CORO_STACK. */
+#ifdef _TR_MAIN
+size_t _tr_co_stack_want = 0;
+#else
+extern size_t _tr_co_stack_want;
+#endif
+
+/* The scheduler of the thread we are running on NOW. Coroutine-side code must
+ * use this instead of touching _tr_g directly: under the multicore scheduler a
+ * coro can resume on a different OS thread after any switch, and the compiler
+ * is free to cache the thread pointer (&_tr_g) across a call. Out-of-line and
+ * opaque (volatile asm) so every call re-reads it. */
+#if defined(__GNUC__) || defined(__clang__)
+static __attribute__((noinline)) _TrSchedG* _tr_sched_cur(void) {
+    _TrSchedG* g = &_tr_g;
+    __asm__ volatile("" : "+r"(g));
+    return g;
+}
+#else
+static _TrSchedG* _tr_sched_cur(void) { return &_tr_g; }
+#endif
 
 static long long _tr_mono_ms(void) {
 #if defined(_WIN32)
@@ -2722,46 +4090,275 @@ static long long _tr_mono_ms(void) {
 }
 
 static void _tr_sched_ensure(void) {
-    if (_tr_g.inited) return;
-    _tr_g.inited = 1;
-    _tr_g.current = NULL; _tr_g.rhead = _tr_g.rtail = NULL; _tr_g.shead = NULL;
-    _tr_g.reactor = NULL; _tr_g.n_sleep = 0; _tr_g.n_io = 0;
+    _TrSchedG* g = _tr_sched_cur();
+    if (g->inited) return;
+    g->inited = 1;
+    g->current = NULL; g->rhead = g->rtail = NULL;
+    g->reactor = NULL; g->n_sleep = 0; g->n_io = 0;
+#ifndef _TR_MX_OFF
+    _tr_mx_block()->sched = g;   /* its queue gauges are read from here */
+#endif
 #if defined(_WIN32)
-    _tr_g.main_ctx = ConvertThreadToFiber(NULL);
-    if (!_tr_g.main_ctx) {
+    g->main_ctx = ConvertThreadToFiber(NULL);
+    if (!g->main_ctx) {
         /* Thread was already a fiber (e.g. nested) - fetch the current one. */
-        _tr_g.main_ctx = GetCurrentFiber();
+        g->main_ctx = GetCurrentFiber();
     }
 #endif
 }
 
+#if defined(_TR_MC)
+/* Owner-side push; returns 0 when the ring is full (caller falls back to the
+ * private FIFO). The slot store happens before the release on rq_tail, so a
+ * thief that observes the new tail also observes the coro pointer. */
+static int _tr_runq_push(_TrMCWorker* w, _TrCoro* c) {
+    unsigned t = __atomic_load_n(&w->rq_tail, __ATOMIC_RELAXED);
+    unsigned h = __atomic_load_n(&w->rq_head, __ATOMIC_ACQUIRE);
+    if (t - h >= _TR_RUNQ_CAP) return 0;
+    __atomic_store_n(&w->rq[t % _TR_RUNQ_CAP], c, __ATOMIC_RELAXED);
+    __atomic_store_n(&w->rq_tail, t + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+/* Pop from the head - used by the owner and by thieves alike. A slot may be
+ * overwritten by the owner once the head has moved past it, but then our CAS
+ * on rq_head fails and we retry with the fresh head. */
+static _TrCoro* _tr_runq_pop(_TrMCWorker* w) {
+    unsigned h = __atomic_load_n(&w->rq_head, __ATOMIC_ACQUIRE);
+    for (;;) {
+        unsigned t = __atomic_load_n(&w->rq_tail, __ATOMIC_ACQUIRE);
+        if (h == t) return NULL;
+        _TrCoro* c = __atomic_load_n(&w->rq[h % _TR_RUNQ_CAP], __ATOMIC_RELAXED);
+        if (__atomic_compare_exchange_n(&w->rq_head, &h, h + 1, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            return c;
+    }
+}
+static void _tr_mc_inbox_push(_TrMCWorker* w, _TrCoro* c) {
+    c->next = NULL; c->wid = w->id;
+    pthread_mutex_lock(&w->inbox_mu);
+    if (w->inbox_tail) w->inbox_tail->next = c; else w->inbox_head = c;
+    w->inbox_tail = c;
+    __atomic_store_n(&w->inbox_n, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&w->inbox_mu);
+}
+#endif
+
 static void _tr_rpush(_TrCoro* c) {
-    c->next = NULL;
-    if (_tr_g.rtail) _tr_g.rtail->next = c; else _tr_g.rhead = c;
-    _tr_g.rtail = c;
+    _TrSchedG* g = _tr_sched_cur();
     c->state = _TRC_READY;
+    _tr_mx_add(_TR_MX_RQ_PUSH, 1);
+#if defined(_TR_MC)
+    /* Stealable only if nothing ties it to this worker's reactor. */
+    if (g->mc && c->pin < 0 && c->io_armed_fd < 0 && _tr_runq_push(g->mc, c)) return;
+#endif
+    c->next = NULL;
+    if (g->rtail) g->rtail->next = c; else g->rhead = c;
+    g->rtail = c;
 }
-static _TrCoro* _tr_rpop(void) {
-    _TrCoro* c = _tr_g.rhead;
+static _TrCoro* _tr_fifo_pop(_TrSchedG* g) {
+    _TrCoro* c = g->rhead;
     if (!c) return NULL;
-    _tr_g.rhead = c->next;
-    if (!_tr_g.rhead) _tr_g.rtail = NULL;
+    g->rhead = c->next;
+    if (!g->rhead) g->rtail = NULL;
     c->next = NULL;
     return c;
 }
 
+#if defined(_TR_MC)
+static void _tr_mc_drain_inbox(_TrMCWorker* w) {
+    pthread_mutex_lock(&w->inbox_mu);
+    _TrCoro* c = w->inbox_head;
+    w->inbox_head = w->inbox_tail = NULL;
+    __atomic_store_n(&w->inbox_n, 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&w->inbox_mu);
+    while (c) { _TrCoro* nx = c->next; _tr_rpush(c); c = nx; }
+}
+/* Try every other worker once, starting at a random victim. */
+static _TrCoro* _tr_mc_steal(_TrMCWorker* self) {
+    _TrMC* mc = self->mc;
+    if (mc->n < 2) return NULL;
+    self->rng ^= self->rng << 13; self->rng ^= self->rng >> 17; self->rng ^= self->rng << 5;
+    int start = (int)(self->rng % (unsigned)mc->n);
+    for (int i = 0; i < mc->n; i++) {
+        _TrMCWorker* v = &mc->w[(start + i) % mc->n];
+        if (v == self) continue;
+        _TrCoro* c = _tr_runq_pop(v);
+        if (c) return c;
+    }
+    return NULL;
+}
+#endif
+
+static _TrCoro* _tr_rpop(void) {
+    _TrSchedG* g = _tr_sched_cur();
+#if defined(_TR_MC)
+    _TrMCWorker* w = g->mc;
+    if (w) {
+        if (__atomic_load_n(&w->inbox_n, __ATOMIC_ACQUIRE)) _tr_mc_drain_inbox(w);
+        /* Alternate between the pinned FIFO and the run queue so neither
+         * starves the other (a pinned accept loop vs. a burst of handlers). */
+        _TrCoro* c;
+        if (g->tick++ & 1) { c = _tr_fifo_pop(g); if (!c) c = _tr_runq_pop(w); }
+        else               { c = _tr_runq_pop(w); if (!c) c = _tr_fifo_pop(g); }
+        if (!c) c = _tr_mc_steal(w);
+        return c;
+    }
+#endif
+    return _tr_fifo_pop(g);
+}
+
+/* ── Timer wheel ──────────────────────────────────────────────────────────
+ * Timer-parked coros (sleep_ms, fd awaits with a timeout) sit on a
+ * four-level hierarchical wheel per scheduler, 64 slots a level: level 0 has
+ * 1 ms slots (64 ms span), level 1 64 ms slots (4 s), level 2 4 s slots
+ * (4.4 min), level 3 4.4 min slots (4.7 h; later deadlines park in its
+ * furthest slot and are re-filed when it comes round). A coro is linked into
+ * the slot for its deadline in the finest level that covers it, so insert
+ * and cancel are O(1) and nothing is ever scanned per timer. As the wheel
+ * reaches the start of a coarser slot, that slot is re-filed one level down
+ * (a cascade); level-0 slots expire outright. The per-level occupancy bitmap
+ * lets the wheel skip empty stretches and gives the next instant anything
+ * can happen for the poll timeout, so N idle timers cost nothing per tick.
+ *
+ * Coarse timers (idle/read timeouts) round their deadline up to a 64 ms
+ * boundary: they never need per-millisecond expiry, and connections that
+ * went idle together share a slot and expire in one batch. */
+#define _TR_TW_BITS   6
+#define _TR_TW_SLOTS  64
+#define _TR_TW_LEVELS 4
+#define _TR_TW_COARSE 64
+
+static void _tr_tw_link(_TrSchedG* g, _TrCoro* c) {
+    long long d = c->wake_at - g->tw_cur;
+    long long at = c->wake_at;
+    if (d < 0) { d = 0; at = g->tw_cur; }
+    int lv = 0;
+    while (lv < _TR_TW_LEVELS - 1 && d >= (1LL << (_TR_TW_BITS * (lv + 1)))) lv++;
+    if (d >= (1LL << (_TR_TW_BITS * _TR_TW_LEVELS)))
+        at = g->tw_cur + (1LL << (_TR_TW_BITS * _TR_TW_LEVELS)) - 1;
+    int slot = (int)((at >> (_TR_TW_BITS * lv)) & (_TR_TW_SLOTS - 1));
+    _TrCoro** head = &g->tw[lv][slot];
+    c->tnext = *head;
+    if (*head) (*head)->tpprev = &c->tnext;
+    *head = c;
+    c->tpprev = head;
+    c->tslot = (unsigned short)(lv * _TR_TW_SLOTS + slot);
+    g->tw_bits[lv] |= 1ULL << slot;
+}
+static void _tr_tw_unlink(_TrSchedG* g, _TrCoro* c) {
+    *c->tpprev = c->tnext;
+    if (c->tnext) c->tnext->tpprev = c->tpprev;
+    int lv = c->tslot / _TR_TW_SLOTS, slot = c->tslot % _TR_TW_SLOTS;
+    if (!g->tw[lv][slot]) g->tw_bits[lv] &= ~(1ULL << slot);
+    c->tnext = NULL; c->tpprev = NULL;
+}
+/* Park c until c->wake_at (ms, _tr_mono_ms clock). */
+static void _tr_tw_add(_TrSchedG* g, _TrCoro* c) {
+    if (g->n_sleep == 0) g->tw_cur = _tr_mono_ms();   /* empty wheel: rebase */
+    _tr_tw_link(g, c);
+    g->n_sleep++;
+}
+/* Take c off the wheel before its deadline. */
+static void _tr_tw_del(_TrSchedG* g, _TrCoro* c) {
+    if (!c->tpprev) return;
+    _tr_tw_unlink(g, c);
+    c->wake_at = 0;
+    g->n_sleep--;
+}
+/* Move one slot's coros down to where their deadlines now belong. */
+static void _tr_tw_cascade(_TrSchedG* g, int lv, int slot) {
+    _TrCoro* c = g->tw[lv][slot];
+    g->tw[lv][slot] = NULL;
+    g->tw_bits[lv] &= ~(1ULL << slot);
+    while (c) { _TrCoro* nx = c->tnext; _tr_tw_link(g, c); c = nx; }
+}
+/* Wake every coro whose deadline is <= now. A coro also parked on an fd is
+ * taken off the reactor's count and told it timed out. */
+static void _tr_tw_expire(_TrSchedG* g, long long now) {
+    while (g->n_sleep > 0 && g->tw_cur <= now) {
+        long long t = g->tw_cur;
+        int s0 = (int)(t & (_TR_TW_SLOTS - 1));
+        if (s0 == 0) {
+            for (int lv = 1; lv < _TR_TW_LEVELS; lv++) {
+                int sl = (int)((t >> (_TR_TW_BITS * lv)) & (_TR_TW_SLOTS - 1));
+                if (g->tw_bits[lv] & (1ULL << sl)) _tr_tw_cascade(g, lv, sl);
+                if (sl != 0) break;
+            }
+        }
+        _TrCoro* c = g->tw[0][s0];
+        if (c) {
+            g->tw[0][s0] = NULL;
+            g->tw_bits[0] &= ~(1ULL << s0);
+            while (c) {
+                _TrCoro* nx = c->tnext;
+                c->tnext = NULL; c->tpprev = NULL; c->wake_at = 0; g->n_sleep--;
+                if (c->io_fd >= 0) { c->io_fd = -1; g->n_io--; c->timed_out = 1; }
+                _tr_rpush(c);
+                c = nx;
+            }
+        }
+        /* Skip to the next occupied level-0 slot, or to the next 64 ms
+         * boundary (where a cascade may refill level 0). */
+        uint64_t ahead = s0 == _TR_TW_SLOTS - 1 ? 0 : g->tw_bits[0] >> (s0 + 1);
+        if (ahead) g->tw_cur = t + 1 + __builtin_ctzll(ahead);
+        else       g->tw_cur = (t | (_TR_TW_SLOTS - 1)) + 1;
+    }
+    if (g->n_sleep == 0) g->tw_cur = now + 1;
+}
+/* Earliest tick at which the wheel has work (an expiry or a cascade), or -1
+ * when it is empty. */
+static long long _tr_tw_next(_TrSchedG* g) {
+    if (g->n_sleep == 0) return -1;
+    long long t = g->tw_cur;
+    int s0 = (int)(t & (_TR_TW_SLOTS - 1));
+    uint64_t ahead = g->tw_bits[0] >> s0;
+    if (ahead) return t + __builtin_ctzll(ahead);
+    long long best = -1;
+    for (int lv = 1; lv < _TR_TW_LEVELS; lv++) {
+        if (!g->tw_bits[lv]) continue;
+        int sh = _TR_TW_BITS * lv;
+        long long span = 1LL << sh;
+        long long t0 = (t + span - 1) & ~(span - 1);    /* next slot start */
+        int i0 = (int)((t0 >> sh) & (_TR_TW_SLOTS - 1));
+        uint64_t rot = (g->tw_bits[lv] >> i0) | (i0 ? g->tw_bits[lv] << (_TR_TW_SLOTS - i0) : 0);
+        long long at = t0 + (long long)__builtin_ctzll(rot) * span;
+        if (best < 0 || at < best) best = at;
+    }
+    /* Occupied level-0 slots behind s0 belong to the next rotation; they are
+     * reached through the boundary at the end of this one. */
+    if (g->tw_bits[0]) {
+        long long edge = (t | (_TR_TW_SLOTS - 1)) + 1;
+        if (best < 0 || edge < best) best = edge;
+    }
+    return best;
+}
+static long long _tr_tw_coarse(long long at) {
+    return (at + _TR_TW_COARSE - 1) & ~(long long)(_TR_TW_COARSE - 1);
+}
+
+/* Make a suspended coro runnable again on the worker that owns it. */
+static void _tr_co_wake(_TrCoro* c) {
+#if defined(_TR_MC)
+    _TrSchedG* g = _tr_sched_cur();
+    if (g->mc && c->wid != g->mc->id) { _tr_mc_inbox_push(&g->mc->mc->w[c->wid], c); return; }
+#endif
+    _tr_rpush(c);
+}
+
 static void _tr_co_to_sched(_TrCoro* from) {
+    _TrSchedG* g = _tr_sched_cur();
 #if defined(_WIN32)
-    (void)from; SwitchToFiber(_tr_g.main_ctx);
+    (void)from; SwitchToFiber(g->main_ctx);
 #else
-    swapcontext(&from->ctx, &_tr_g.main_ctx);
+    swapcontext(&from->ctx, &g->main_ctx);
 #endif
 }
 static void _tr_co_to_coro(_TrCoro* to) {
+    _TrSchedG* g = _tr_sched_cur();
 #if defined(_WIN32)
     SwitchToFiber(to->ctx);
 #else
-    swapcontext(&_tr_g.main_ctx, &to->ctx);
+    swapcontext(&g->main_ctx, &to->ctx);
 #endif
 }
 
@@ -2769,49 +4366,143 @@ static void _tr_co_to_coro(_TrCoro* to) {
 static void CALLBACK _tr_co_entry(LPVOID p) {
     _TrCoro* c = (_TrCoro*)p;
     c->result = (long long)(uintptr_t)c->fn(c->arg);
-    c->state = _TRC_DONE;
-    if (c->joiner) { _TrCoro* j = c->joiner; c->joiner = NULL; _tr_rpush(j); }
-    SwitchToFiber(_tr_g.main_ctx);   /* control returns to the scheduler */
+    c->state = _TRC_EXIT;
+    SwitchToFiber(_tr_sched_cur()->main_ctx);   /* control returns to the scheduler */
 }
 #else
 static void _tr_co_entry(void) {
-    _TrCoro* c = _tr_g.current;
+    _TrCoro* c = _tr_sched_cur()->current;
     c->result = (long long)(uintptr_t)c->fn(c->arg);
-    c->state = _TRC_DONE;
-    if (c->joiner) { _TrCoro* j = c->joiner; c->joiner = NULL; _tr_rpush(j); }
-    /* uc_link returns us to main_ctx automatically. */
+    c->state = _TRC_EXIT;
+    /* Return to the scheduler of the thread we finished on - not uc_link,
+     * which names the main_ctx of the thread that CREATED this coro. */
+    setcontext(&_tr_sched_cur()->main_ctx);
 }
 #endif
 
 #define _TR_CORO_STACK (256 * 1024)
+#define _TR_CORO_PAGE  4096
+/* Idle default-size stacks each scheduler keeps for reuse; the rest unmap. */
+#ifndef _TR_CORO_POOL_MAX
+#define _TR_CORO_POOL_MAX 1024
+#endif
+/* Top of a pooled stack left resident (the frames every handler touches);
+ * everything below it is handed back to the kernel on release. */
+#define _TR_CORO_STACK_KEEP (16 * 1024)
+
+/* Default stack size for the next spawn, page-rounded. */
+static size_t _tr_co_stack_get(void) {
+    size_t sz = __atomic_load_n(&_tr_co_stack_want, __ATOMIC_RELAXED);
+    if (sz == 0) return _TR_CORO_STACK;
+    return (sz + _TR_CORO_PAGE - 1) & ~(size_t)(_TR_CORO_PAGE - 1);
+}
+/* Set the default stack size for later spawns (bytes; <= 0 restores the
+ * built-in 256 KiB). Each scheduler unmaps the stacks it pooled at the old
+ * size the first time it releases one of the new size. */
+static void _tr_co_set_stack_size(long long bytes) {
+    size_t sz = bytes <= 0 ? 0 : (size_t)bytes;
+    if (sz && sz < 4 * _TR_CORO_PAGE) sz = 4 * _TR_CORO_PAGE;
+    __atomic_store_n(&_tr_co_stack_want, sz, __ATOMIC_RELAXED);
+}
+
+#if !defined(_WIN32)
+#if !defined(MAP_STACK)
+#define MAP_STACK 0
+#endif
+/* Coroutine stacks are mmap'd, not malloc'd: anonymous pages are
+ * zero-fill-on-demand, so only the pages a handler actually touches become
+ * resident. A 256 KiB stack that uses ~16 KiB costs ~16 KiB RSS, not 256 KiB.
+ * Under N concurrent keep-alive connections (one stackful coro each) this is
+ * the difference between ~N*256KiB and ~N*16KiB of resident memory - the main
+ * reason a stackful green-thread server's RSS otherwise dwarfs a stackless
+ * one (tokio/asyncio). One PROT_NONE page sits below each stack, so an
+ * overflow faults instead of running into the neighbouring mapping.
+ *
+ * A stack of the default size comes from (and returns to) the scheduler's
+ * pool instead of costing an mmap + mprotect + munmap per coroutine. On
+ * return the pages below the hot top are released with MADV_FREE (lazy: the
+ * kernel reclaims them only under memory pressure) or MADV_DONTNEED, so a
+ * pooled stack holds at most _TR_CORO_STACK_KEEP of RSS. The pool is per
+ * worker thread and unlocked; a coro freed on another worker just feeds that
+ * worker's pool. */
+/* Unmap a scheduler's idle stacks (default size changed, worker exit). */
+static void _tr_co_stack_drain(_TrSchedG* g) {
+    while (g->stk_n > 0) munmap(g->stk_pool[--g->stk_n] - _TR_CORO_PAGE, g->stk_sz + _TR_CORO_PAGE);
+}
+static char* _tr_co_stack_alloc(_TrSchedG* g, size_t sz) {
+    if (g->stk_n > 0 && sz == g->stk_sz) return g->stk_pool[--g->stk_n];
+    char* base = (char*)mmap(NULL, sz + _TR_CORO_PAGE, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (base == MAP_FAILED) { _TR_OOM_ABORT(); }
+    mprotect(base, _TR_CORO_PAGE, PROT_NONE);
+    return base + _TR_CORO_PAGE;
+}
+static void _tr_co_stack_release(_TrSchedG* g, char* stack, size_t sz) {
+    if (sz == _tr_co_stack_get() && sz != g->stk_sz) { _tr_co_stack_drain(g); g->stk_sz = sz; }
+    if (sz == g->stk_sz && g->stk_n < _TR_CORO_POOL_MAX) {
+        if (g->stk_n == g->stk_cap) {
+            int cap = g->stk_cap ? g->stk_cap * 2 : 16;
+            char** np = (char**)realloc(g->stk_pool, (size_t)cap * sizeof(char*));
+            if (!np) { munmap(stack - _TR_CORO_PAGE, sz + _TR_CORO_PAGE); return; }
+            g->stk_pool = np; g->stk_cap = cap;
+        }
+#if defined(MADV_FREE)
+        if (madvise(stack, sz - _TR_CORO_STACK_KEEP, MADV_FREE) != 0)
+#endif
+            madvise(stack, sz - _TR_CORO_STACK_KEEP, MADV_DONTNEED);
+        g->stk_pool[g->stk_n++] = stack;
+        return;
+    }
+    munmap(stack - _TR_CORO_PAGE, sz + _TR_CORO_PAGE);
+}
+#endif
 
-/* Spawn a coroutine running fn(arg); returns its handle. */
-static _TrCoro* _tr_co_go(_tr_coro_fn fn, void* arg) {
+/* Spawn a coroutine running fn(arg) on a stack of `stack_sz` bytes (0 = the
+ * default); returns its handle. `pin` is an affinity hint (worker index, -1 =
+ * any) that only matters under the multicore scheduler. `detached` is set
+ * before the coro is published, so a worker that steals and finishes it at
+ * once still frees it. */
+static _TrCoro* _tr_co_go_sz(_tr_coro_fn fn, void* arg, int detached, int pin, size_t stack_sz) {
     _tr_sched_ensure();
+    _TrSchedG* g = _tr_sched_cur();
     _TrCoro* c = (_TrCoro*)calloc(1, sizeof(_TrCoro));
+    _tr_mx_add(_TR_MX_CO_SPAWN, 1);
     c->fn = fn; c->arg = arg; c->io_fd = -1; c->io_armed_fd = -1;
+    c->detached = detached; c->pin = pin < 0 ? -1 : pin;
+    c->stack_sz = stack_sz ? (stack_sz + _TR_CORO_PAGE - 1) & ~(size_t)(_TR_CORO_PAGE - 1)
+                           : _tr_co_stack_get();
+    if (c->stack_sz < 4 * _TR_CORO_PAGE) c->stack_sz = 4 * _TR_CORO_PAGE;
 #if defined(_WIN32)
-    c->ctx = CreateFiber(_TR_CORO_STACK, _tr_co_entry, c);
-#else
-    /* mmap the coroutine stack instead of malloc: anonymous pages are
-     * zero-fill-on-demand, so only the pages a handler actually touches become
-     * resident. A 256 KiB stack that uses ~16 KiB costs ~16 KiB RSS, not 256 KiB.
-     * Under N concurrent keep-alive connections (one stackful coro each) this is
-     * the difference between ~N*256KiB and ~N*16KiB of resident memory - the main
-     * reason a stackful green-thread server's RSS otherwise dwarfs a stackless
-     * one (tokio/asyncio). Falls back to malloc if mmap is unavailable. */
-    c->stack = (char*)mmap(NULL, _TR_CORO_STACK, PROT_READ | PROT_WRITE,
-                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-    if (c->stack == MAP_FAILED) { _TR_OOM_ABORT(); }
+    c->ctx = CreateFiber(c->stack_sz, _tr_co_entry, c);
+#else
+    c->stack = _tr_co_stack_alloc(g, c->stack_sz);
     getcontext(&c->ctx);
     c->ctx.uc_stack.ss_sp = c->stack;
-    c->ctx.uc_stack.ss_size = _TR_CORO_STACK;
-    c->ctx.uc_link = &_tr_g.main_ctx;
+    c->ctx.uc_stack.ss_size = c->stack_sz;
+    c->ctx.uc_link = &g->main_ctx;
     makecontext(&c->ctx, _tr_co_entry, 0);
 #endif
+#if defined(_TR_MC)
+    if (g->mc) {
+        _TrMC* mc = g->mc->mc;
+        __atomic_add_fetch(&mc->live, 1, __ATOMIC_RELAXED);
+        c->wid = g->mc->id;
+        if (c->pin >= 0) {
+            c->pin %= mc->n;
+            if (c->pin != g->mc->id) { _tr_mc_inbox_push(&mc->w[c->pin], c); return c; }
+        }
+        _tr_rpush(c);
+        return c;
+    }
+#endif
+    g->n_live++;
     _tr_rpush(c);
     return c;
 }
+static _TrCoro* _tr_co_go_ex(_tr_coro_fn fn, void* arg, int detached, int pin) {
+    return _tr_co_go_sz(fn, arg, detached, pin, 0);
+}
+static _TrCoro* _tr_co_go(_tr_coro_fn fn, void* arg) { return _tr_co_go_ex(fn, arg, 0, -1); }
 
 static void _tr_co_free(_TrCoro* c) {
     if (!c) return;
@@ -2821,66 +4512,287 @@ static void _tr_co_free(_TrCoro* c) {
      * the handler has just closed the fd (epoll/kqueue auto-removed it, so the
      * del is a harmless no-op; WSAPoll still needs it), and the fd cannot have
      * been reused yet because no accept has run in between. */
-    if (c->io_armed_fd >= 0 && _tr_g.reactor) {
-        _tr_iopoll_del(_tr_g.reactor, c->io_armed_fd);
+    _TrSchedG* g = _tr_sched_cur();
+    if (c->io_armed_fd >= 0 && g->reactor) {
+        _tr_iopoll_del(g->reactor, c->io_armed_fd);
         c->io_armed_fd = -1;
     }
 #if defined(_WIN32)
     if (c->ctx) DeleteFiber(c->ctx);
 #else
-    if (c->stack) munmap(c->stack, _TR_CORO_STACK);
+    if (c->stack) _tr_co_stack_release(g, c->stack, c->stack_sz);
 #endif
+    if (c->exc) free(c->exc);
     free(c);
 }
 
+/* Publish a finished coro (state _TRC_EXIT) from the scheduler stack: drop its
+ * reactor registration on the worker that owns it, wake its joiner, and free
+ * it if detached. Under the multicore scheduler the joiner handoff is an
+ * atomic exchange against _tr_co_await's CAS; nothing touches `c` after the
+ * exchange unless it is detached (nobody else holds it). */
+static void _tr_co_finish(_TrSchedG* g, _TrCoro* c) {
+    int detached = c->detached;
+    _tr_mx_add(_TR_MX_CO_DONE, 1);
+    if (c->io_armed_fd >= 0 && g->reactor) {
+        _tr_iopoll_del(g->reactor, c->io_armed_fd);
+        c->io_armed_fd = -1;
+    }
+#if defined(_TR_MC)
+    if (g->mc) {
+        __atomic_sub_fetch(&g->mc->mc->live, 1, __ATOMIC_RELEASE);
+        __atomic_store_n(&c->state, _TRC_DONE, __ATOMIC_RELEASE);
+        _TrCoro* j = __atomic_exchange_n(&c->joiner, _TR_CO_JOIN_DONE, __ATOMIC_ACQ_REL);
+        if (j && j != _TR_CO_JOIN_DONE) _tr_co_wake(j);
+        /* A detached task (Coro.spawn / per-connection handler) has no joiner
+         * to free it - the scheduler reclaims it once it finishes. */
+        if (detached) _tr_co_free(c);
+        return;
+    }
+#endif
+    g->n_live--;
+    c->state = _TRC_DONE;
+    if (c->joiner) { _TrCoro* j = c->joiner; c->joiner = NULL; _tr_co_wake(j); }
+    if (detached) _tr_co_free(c);
+}
+
+#if defined(_TR_URING)
+#define _TR_URING_UD_EPOLL 2ull   /* user_data of the POLL_ADD on the epoll fd */
+#define _TR_URING_FLUSH    32u    /* busy workers flush the ring every N dispatches */
+
+/* This worker's ring, created on first use once the program has opted in.
+ * NULL = use the readiness (epoll) path. */
+static _TrIOURing* _tr_uring_get(_TrSchedG* g) {
+    if (g->uring_state) return g->uring;
+    int want = __atomic_load_n(&_tr_uring_want, __ATOMIC_RELAXED);
+    if (want < 0) {
+        const char* e = getenv("TAURARO_IO_URING");
+        want = (e && e[0] == '1') ? 1 : 0;
+        __atomic_store_n(&_tr_uring_want, want, __ATOMIC_RELAXED);
+    }
+    if (!want) return NULL;
+    g->uring = _tr_uring_create();
+    g->uring_state = g->uring ? 1 : -1;
+    return g->uring;
+}
+
+static void _tr_uring_lsn_push(_TrURingLsn* l, int fd) {
+    if (l->qn == l->qcap) {
+        unsigned ncap = l->qcap ? l->qcap * 2 : 16;
+        int* nq = (int*)TAURARO_ALLOC((size_t)ncap * sizeof(int));
+        if (!nq) { close(fd); return; }
+        for (unsigned i = 0; i < l->qn; i++) nq[i] = l->q[(l->qh + i) % l->qcap];
+        if (l->q) TAURARO_FREE(l->q);
+        l->q = nq; l->qh = 0; l->qcap = ncap;
+    }
+    l->q[(l->qh + l->qn) % l->qcap] = fd;
+    l->qn++;
+}
+static void _tr_uring_lsn_free(_TrSchedG* g, _TrURingLsn* l) {
+    for (_TrURingLsn** pp = &g->lsn; *pp; pp = &(*pp)->next) {
+        if (*pp == l) { *pp = l->next; break; }
+    }
+    while (l->qn > 0) { close(l->q[l->qh]); l->qh = (l->qh + 1) % l->qcap; l->qn--; }
+    if (l->q) TAURARO_FREE(l->q);
+    TAURARO_FREE(l);
+}
+
+/* Drain the completion queue: store each op's result and make its coro
+ * runnable; queue multishot-accepted fds for their listener's waiter. */
+static void _tr_uring_reap(_TrSchedG* g) {
+    _TrIOURing* u = g->uring;
+    struct io_uring_cqe* cq;
+    while ((cq = _tr_uring_cqe_peek(u)) != NULL) {
+        unsigned long long ud = cq->user_data;
+        int res = cq->res;
+        unsigned fl = cq->flags;
+        _tr_uring_cqe_seen(u);
+        if (ud == 0) continue;   /* ASYNC_CANCEL */
+        if (ud == _TR_URING_UD_EPOLL) { g->uring_epoll = 0; continue; }
+        if (ud & 1ull) {
+            _TrURingLsn* l = (_TrURingLsn*)(uintptr_t)(ud & ~1ull);
+            if (!(fl & IORING_CQE_F_MORE)) l->armed = 0;
+            if (l->lfd < 0) {
+                if (res >= 0) close(res);
+                if (!l->armed) _tr_uring_lsn_free(g, l);
+                continue;
+            }
+            if (res >= 0) { _tr_uring_lsn_push(l, res); l->n_ok++; }
+            else l->err = res;
+            if (l->waiter) { _TrCoro* w = l->waiter; l->waiter = NULL; g->n_uring--; _tr_rpush(w); }
+            continue;
+        }
+        _TrURingOp* op = (_TrURingOp*)(uintptr_t)ud;
+        op->res = res;
+        op->flags = fl;
+        if (fl & IORING_CQE_F_BUFFER) {
+            unsigned bid = fl >> IORING_CQE_BUFFER_SHIFT;
+            if (res > 0 && (op->data = (char*)_tr_c_malloc((size_t)res + 1)) != NULL) {
+                memcpy(op->data, u->bufs + (size_t)bid * _TR_URING_BUFSZ, (size_t)res);
+                op->data[res] = '\0';
+            }
+            _tr_uring_buf_recycle(u, bid);
+        }
+        if (op->co) { _TrCoro* c = op->co; op->co = NULL; g->n_uring--; _tr_rpush(c); }
+    }
+}
+
+/* Park the current coro until the op whose SQE was just filled completes.
+ * The SQE goes out with the tick's batch (one io_uring_enter per tick). */
+static int _tr_uring_park(_TrSchedG* g, _TrURingOp* op) {
+    _TrCoro* c = g->current;
+    op->co = c;
+    c->state = _TRC_SUSP;
+    g->n_uring++;
+    _tr_co_to_sched(c);
+    return op->res;
+}
+
+/* Drop this worker's ring at worker exit. */
+static void _tr_uring_teardown(_TrSchedG* g) {
+    while (g->lsn) _tr_uring_lsn_free(g, g->lsn);
+    if (g->uring) _tr_uring_destroy(g->uring);
+    g->uring = NULL; g->uring_state = 0; g->n_uring = 0; g->uring_epoll = 0;
+}
+#endif
+
+/* Wake the coros whose fds the readiness reactor reports ready. */
+static void _tr_sched_poll_fds(_TrSchedG* g, int timeout) {
+    /* Drain up to 256 ready connections per epoll/kqueue/WSAPoll wakeup
+     * (was 64): under 1000+ concurrent connections, readiness arrives in
+     * bursts, so a small batch means many syscalls to clear the ready set
+     * and head-of-line latency for the connections at the back. */
+    _TrIOEvent evs[256];
+    int n = _tr_iopoll_wait(g->reactor, evs, 256, timeout);
+    _tr_mx_add(_TR_MX_POLL_WAITS, 1);
+    if (n > 0) { _tr_mx_add(_TR_MX_POLL_WAKEUPS, 1); _tr_mx_add(_TR_MX_POLL_EVENTS, n); }
+    for (int i = 0; i < n; i++) {
+        _TrCoro* k = (_TrCoro*)evs[i].userdata;
+        if (k && k->state == _TRC_SUSP && k->io_fd >= 0) {
+            /* Persistent registration: do NOT _tr_iopoll_del here. The fd
+             * stays armed (k->io_armed_fd) so the next await on the same
+             * fd+events is a no-op instead of an ADD - saving 2 epoll_ctl
+             * syscalls per keep-alive request. The registration is dropped
+             * when the coro is freed (_tr_co_free). A registered fd that is
+             * level-readable while its coro is already runnable is returned
+             * again by epoll but skipped here (state != _TRC_SUSP); the
+             * scheduler drains the ready queue before polling, so this does
+             * not spin. */
+            k->io_fd = -1; g->n_io--;
+            if (k->tpprev) _tr_tw_del(g, k);   /* beat its timeout */
+            _tr_rpush(k);
+        }
+    }
+}
+
 /* Run one scheduler step: dispatch a ready coro, or block on the reactor /
  * timers until one becomes runnable. Returns 0 when nothing remains to do. */
 static int _tr_sched_step(void) {
+    _TrSchedG* g = _tr_sched_cur();
     _TrCoro* c = _tr_rpop();
     if (c) {
-        _tr_g.current = c;
+        g->current = c;
         c->state = _TRC_RUN;
+        _tr_mx_add(_TR_MX_CO_SWITCH, 1);
+#if defined(_TR_MC)
+        if (g->mc) c->wid = g->mc->id;
+#endif
+        /* The entered arena follows the coroutine, not the worker thread. */
+        _TrArena* sched_arena = _tr_arena_cur;
+        _tr_arena_cur = c->arena;
+        /* So do its handler frames: they go back on top of this worker's
+         * stack for the run and are parked again when it suspends. */
+        int sched_base = _tr_exc_base, sched_sp = _tr_exc_sp;
+        _tr_exc_base = sched_sp;
+        /* And its refcount owner identity (_TR_THREAD_ID). */
+        const void* sched_self = _tr_rc_self;
+        _tr_rc_self = c;
+        if (c->exc) {
+            for (int i = 0; i < c->exc->n && _tr_exc_sp < _TR_MAX_EXC; i++) {
+                _tr_exc_bufs[_tr_exc_sp] = c->exc->bufs[i];
+                _tr_exc_msgs[_tr_exc_sp] = c->exc->msgs[i];
+                _tr_exc_sp++;
+            }
+        }
         _tr_co_to_coro(c);
-        _tr_g.current = NULL;
-        /* A detached task (Coro.spawn / per-connection handler) has no joiner
-         * to free it - the scheduler reclaims it once it finishes. */
-        if (c->state == _TRC_DONE && c->detached) _tr_co_free(c);
+        c->arena = _tr_arena_cur;
+        _tr_arena_cur = sched_arena;
+        int n_exc = _tr_exc_sp - _tr_exc_base;
+        if (n_exc > 0 && !c->exc) {
+            c->exc = (_TrCoExc*)malloc(sizeof(_TrCoExc));
+            if (!c->exc) { _TR_OOM_ABORT(); }
+        }
+        if (c->exc) {
+            c->exc->n = n_exc;
+            for (int i = 0; i < n_exc; i++) {
+                c->exc->bufs[i] = _tr_exc_bufs[_tr_exc_base + i];
+                c->exc->msgs[i] = _tr_exc_msgs[_tr_exc_base + i];
+            }
+        }
+        _tr_exc_sp = sched_sp;
+        _tr_exc_base = sched_base;
+        _tr_rc_self = sched_self;
+        g->current = NULL;
+        /* A yield is requeued only now that its context is saved: under the
+         * multicore scheduler another worker may pick it up immediately. */
+        if (c->state == _TRC_READY) _tr_rpush(c);
+        else if (c->state == _TRC_EXIT) _tr_co_finish(g, c);
+#if defined(_TR_URING)
+        /* A busy worker never reaches the blocking wait below: flush the
+         * batch and reap completions every few dispatches instead. */
+        if (g->uring && ++g->uring_tick >= _TR_URING_FLUSH) {
+            g->uring_tick = 0;
+            if (g->n_uring > 0 || g->uring->pending) {
+                _tr_uring_enter(g->uring, 0, 0);
+                _tr_uring_reap(g);
+            }
+        }
+#endif
         return 1;
     }
-    if (_tr_g.n_sleep == 0 && _tr_g.n_io == 0) return 0;   /* fully idle */
+#if defined(_TR_URING)
+    if (g->n_sleep == 0 && g->n_io == 0 && g->n_uring == 0) return 0;   /* fully idle */
+#else
+    if (g->n_sleep == 0 && g->n_io == 0) return 0;   /* fully idle */
+#endif
 
-    /* Compute the next timer deadline. */
+    /* Block until the wheel's next expiry or cascade at the latest. */
     long long now = _tr_mono_ms();
-    long long earliest = -1;
-    for (_TrCoro* s = _tr_g.shead; s; s = s->snext) {
-        if (earliest < 0 || s->wake_at < earliest) earliest = s->wake_at;
-    }
+    long long earliest = _tr_tw_next(g);
     int timeout = -1;   /* block indefinitely if only I/O is pending */
     if (earliest >= 0) { timeout = (int)(earliest - now); if (timeout < 0) timeout = 0; }
+#if defined(_TR_MC)
+    /* Other workers may hand us work (inbox) or have work to steal: never
+     * block longer than the poll quantum while the run is multicore. */
+    if (g->mc && (timeout < 0 || timeout > _TR_MC_POLL_MS)) timeout = _TR_MC_POLL_MS;
+#endif
 
-    if (_tr_g.n_io > 0 && _tr_g.reactor) {
-        /* Drain up to 256 ready connections per epoll/kqueue/WSAPoll wakeup
-         * (was 64): under 1000+ concurrent connections, readiness arrives in
-         * bursts, so a small batch means many syscalls to clear the ready set
-         * and head-of-line latency for the connections at the back. */
-        _TrIOEvent evs[256];
-        int n = _tr_iopoll_wait(_tr_g.reactor, evs, 256, timeout);
-        for (int i = 0; i < n; i++) {
-            _TrCoro* k = (_TrCoro*)evs[i].userdata;
-            if (k && k->state == _TRC_SUSP && k->io_fd >= 0) {
-                /* Persistent registration: do NOT _tr_iopoll_del here. The fd
-                 * stays armed (k->io_armed_fd) so the next await on the same
-                 * fd+events is a no-op instead of an ADD - saving 2 epoll_ctl
-                 * syscalls per keep-alive request. The registration is dropped
-                 * when the coro is freed (_tr_co_free). A registered fd that is
-                 * level-readable while its coro is already runnable is returned
-                 * again by epoll but skipped here (state != _TRC_SUSP); the
-                 * scheduler drains the ready queue before polling, so this does
-                 * not spin. */
-                k->io_fd = -1; _tr_g.n_io--;
-                _tr_rpush(k);
+#if defined(_TR_URING)
+    if (g->uring && g->n_uring > 0) {
+        /* Completion reactor: one io_uring_enter submits this tick's batch
+         * and waits. Readiness waiters are folded in by a POLL_ADD on the
+         * epoll fd, so the worker still blocks in a single place. */
+        if (g->n_io > 0 && g->reactor && !g->uring_epoll) {
+            struct io_uring_sqe* s = _tr_uring_sqe(g->uring);
+            if (s) {
+                s->opcode = IORING_OP_POLL_ADD;
+                s->fd = g->reactor->epfd;
+                s->poll32_events = EPOLLIN;
+                s->user_data = _TR_URING_UD_EPOLL;
+                g->uring_epoll = 1;
             }
         }
+        int epoll_armed = g->uring_epoll;
+        _tr_uring_enter(g->uring, 1, timeout);
+        _tr_uring_reap(g);
+        if (epoll_armed && !g->uring_epoll && g->n_io > 0) _tr_sched_poll_fds(g, 0);
+    } else
+#endif
+    if (g->n_io > 0 && g->reactor) {
+#if defined(_TR_URING)
+        if (g->uring && g->uring->pending) _tr_uring_enter(g->uring, 0, 0);
+#endif
+        _tr_sched_poll_fds(g, timeout);
     } else if (timeout > 0) {
 #if defined(_WIN32)
         Sleep((DWORD)timeout);
@@ -2890,35 +4802,97 @@ static int _tr_sched_step(void) {
     }
 
     /* Wake any timers that are now due. */
-    now = _tr_mono_ms();
-    _TrCoro** pp = &_tr_g.shead;
-    while (*pp) {
-        _TrCoro* s = *pp;
-        if (s->wake_at <= now) {
-            *pp = s->snext; s->snext = NULL; s->wake_at = 0; _tr_g.n_sleep--;
-            _tr_rpush(s);
-        } else {
-            pp = &s->snext;
-        }
-    }
+    if (g->n_sleep > 0) _tr_tw_expire(g, _tr_mono_ms());
     return 1;
 }
 
 /* Drain the scheduler until every coroutine has finished. */
 static void _tr_sched_run(void) { while (_tr_sched_step()) {} }
 
-/* Cooperative yield: requeue the current coro behind the others. */
+#if defined(_TR_MC)
+/* One worker's loop: run until no coro is left anywhere. A worker with no
+ * local work and nothing to steal backs off (yield, then short sleeps). */
+static void _tr_mc_loop(_TrMCWorker* w) {
+    int idle = 0;
+    while (__atomic_load_n(&w->mc->live, __ATOMIC_ACQUIRE) > 0) {
+        if (_tr_sched_step()) { idle = 0; continue; }
+        if (++idle < 64) sched_yield();
+        else { struct timespec ts = {0, 500000}; nanosleep(&ts, NULL); }
+    }
+}
+static void* _tr_mc_worker_main(void* arg) {
+    _TrMCWorker* w = (_TrMCWorker*)arg;
+    _tr_sched_ensure();
+    _tr_g.mc = w;
+    _tr_mc_loop(w);
+    _tr_g.mc = NULL;
+    if (_tr_g.reactor) { _tr_iopoll_destroy(_tr_g.reactor); _tr_g.reactor = NULL; }
+#if defined(_TR_URING)
+    _tr_uring_teardown(&_tr_g);
+#endif
+    _tr_co_stack_drain(&_tr_g);
+    free(_tr_g.stk_pool);
+    return NULL;
+}
+#endif
+
+/* Drain the scheduler on `n` worker threads (n <= 0: one per CPU). The caller
+ * becomes worker 0 and keeps its reactor, timers and any coros spawned so
+ * far; unpinned ready coros become stealable, pinned ones move to their
+ * worker. Returns once every coroutine has finished. Falls back to
+ * _tr_sched_run() for n == 1 and on platforms without the multicore path. */
+static void _tr_sched_run_workers(long long n) {
+#if defined(_TR_MC)
+    if (n <= 0) n = _tr_threadpool_auto_n();
+    _tr_sched_ensure();
+    if (n <= 1 || _tr_g.mc || _tr_g.current) { _tr_sched_run(); return; }
+    _TrMC mc;
+    mc.n = (int)n;
+    mc.live = _tr_g.n_live;
+    mc.w = (_TrMCWorker*)TAURARO_CALLOC((size_t)n, sizeof(_TrMCWorker));
+    for (int i = 0; i < mc.n; i++) {
+        mc.w[i].id = i; mc.w[i].mc = &mc;
+        mc.w[i].rng = 2463534242u ^ (unsigned)(i * 2654435761u);
+        pthread_mutex_init(&mc.w[i].inbox_mu, NULL);
+    }
+    _tr_g.n_live = 0;
+    _tr_g.mc = &mc.w[0];
+    /* Re-home the coros already queued on this thread. */
+    _TrCoro* c = _tr_g.rhead;
+    _tr_g.rhead = _tr_g.rtail = NULL;
+    while (c) {
+        _TrCoro* nx = c->next;
+        c->wid = 0;
+        if (c->pin >= 0) c->pin %= mc.n;
+        if (c->pin > 0) _tr_mc_inbox_push(&mc.w[c->pin], c); else _tr_rpush(c);
+        c = nx;
+    }
+    _TrThread* th = (_TrThread*)TAURARO_ALLOC((size_t)(n - 1) * sizeof(_TrThread));
+    for (int i = 1; i < mc.n; i++) th[i - 1] = _tr_thread_start(_tr_mc_worker_main, &mc.w[i]);
+    _tr_mc_loop(&mc.w[0]);
+    for (int i = 1; i < mc.n; i++) _tr_thread_join_wait(th[i - 1]);
+    _tr_g.mc = NULL;
+    for (int i = 0; i < mc.n; i++) pthread_mutex_destroy(&mc.w[i].inbox_mu);
+    TAURARO_FREE(th); TAURARO_FREE(mc.w);
+#else
+    (void)n; _tr_sched_run();
+#endif
+}
+
+/* Cooperative yield: requeue the current coro behind the others. The
+ * scheduler does the requeue once this context is saved (see _tr_sched_step). */
 static void _tr_co_yield(void) {
-    _TrCoro* c = _tr_g.current;
+    _TrCoro* c = _tr_sched_cur()->current;
     if (!c) return;
-    _tr_rpush(c);
+    c->state = _TRC_READY;
     _tr_co_to_sched(c);
 }
 
 /* Suspend the current coro for `ms` milliseconds (timer-parked). Outside a
  * coroutine this is a plain sleep. */
 static void _tr_co_sleep_ms(long long ms) {
-    _TrCoro* c = _tr_g.current;
+    _TrSchedG* g = _tr_sched_cur();
+    _TrCoro* c = g->current;
     if (!c) {
 #if defined(_WIN32)
         Sleep((DWORD)ms);
@@ -2929,7 +4903,7 @@ static void _tr_co_sleep_ms(long long ms) {
     }
     c->wake_at = _tr_mono_ms() + ms;
     c->state = _TRC_SUSP;
-    c->snext = _tr_g.shead; _tr_g.shead = c; _tr_g.n_sleep++;
+    _tr_tw_add(g, c);
     _tr_co_to_sched(c);
 }
 
@@ -2963,9 +4937,10 @@ static void _tr_co_reclaim_stack(_TrCoro* c) {
 #endif
 
 static int _tr_co_await_fd(int fd, unsigned int events) {
-    _TrCoro* c = _tr_g.current;
+    _TrSchedG* g = _tr_sched_cur();
+    _TrCoro* c = g->current;
     if (!c) return 1;
-    if (!_tr_g.reactor) _tr_g.reactor = _tr_iopoll_create();
+    if (!g->reactor) g->reactor = _tr_iopoll_create();
     c->io_fd = fd;
     c->state = _TRC_SUSP;
     /* Persistent registration: keep the fd armed across awaits. The common
@@ -2975,20 +4950,21 @@ static int _tr_co_await_fd(int fd, unsigned int events) {
      * readable -> writable for a backpressured send). The DEL is deferred to
      * _tr_co_free. (epoll/kqueue: ADD/MOD/DEL are syscalls, so this saves two
      * per request; WSAPoll: they are cheap in-memory set ops, so it is a wash
-     * but still correct.) */
+     * but still correct.) An armed coro is pinned to this worker from here on:
+     * the registration lives in this worker's reactor. */
     if (c->io_armed_fd == fd) {
         if (c->io_armed_ev != (uint32_t)events) {
-            _tr_iopoll_mod(_tr_g.reactor, fd, events, (void*)c);
+            _tr_iopoll_mod(g->reactor, fd, events, (void*)c);
             c->io_armed_ev = (uint32_t)events;
         }
         /* else: already armed for this fd+events - no syscall */
     } else {
-        if (c->io_armed_fd >= 0) _tr_iopoll_del(_tr_g.reactor, c->io_armed_fd);
-        _tr_iopoll_add(_tr_g.reactor, fd, events, (void*)c);
+        if (c->io_armed_fd >= 0) _tr_iopoll_del(g->reactor, c->io_armed_fd);
+        _tr_iopoll_add(g->reactor, fd, events, (void*)c);
         c->io_armed_fd = fd;
         c->io_armed_ev = (uint32_t)events;
     }
-    _tr_g.n_io++;
+    g->n_io++;
 #if defined(__linux__) && !defined(_WIN32)
     _tr_co_reclaim_stack(c);
 #endif
@@ -2996,16 +4972,49 @@ static int _tr_co_await_fd(int fd, unsigned int events) {
     return 1;
 }
 
+/* Like _tr_co_await_fd, but give up after `ms` milliseconds (ms < 0: no
+ * limit). Returns 1 when the fd is ready, 0 on timeout. The deadline is a
+ * coarse one (_tr_tw_coarse): this is for idle and read timeouts, not for
+ * precise scheduling. The fd stays armed either way. */
+static int _tr_co_await_fd_timeout(int fd, unsigned int events, long long ms) {
+    _TrSchedG* g = _tr_sched_cur();
+    _TrCoro* c = g->current;
+    if (!c || ms < 0) return _tr_co_await_fd(fd, events);
+    c->timed_out = 0;
+    c->wake_at = _tr_tw_coarse(_tr_mono_ms() + ms);
+    _tr_tw_add(g, c);
+    _tr_co_await_fd(fd, events);
+    return c->timed_out ? 0 : 1;
+}
+
 /* Await another coroutine's completion and return its result. Works both
  * inside a coro (cooperative suspend) and from the top level (pumps the
  * scheduler until the target finishes). */
 static long long _tr_co_await(_TrCoro* target) {
     if (!target) return 0;
-    if (_tr_g.current) {
+    _TrSchedG* g = _tr_sched_cur();
+    _TrCoro* self = g->current;
+    if (self) {
+#if defined(_TR_MC)
+        if (g->mc) {
+            /* The target may be finishing on another worker right now: only
+             * suspend if we install ourselves as joiner before it publishes. */
+            if (__atomic_load_n(&target->state, __ATOMIC_ACQUIRE) != _TRC_DONE) {
+                _TrCoro* expect = NULL;
+                self->state = _TRC_SUSP;
+                if (__atomic_compare_exchange_n(&target->joiner, &expect, self, 0,
+                                                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                    _tr_co_to_sched(self);
+                else
+                    self->state = _TRC_RUN;
+            }
+            return target->result;
+        }
+#endif
         if (target->state != _TRC_DONE) {
-            target->joiner = _tr_g.current;
-            _tr_g.current->state = _TRC_SUSP;
-            _tr_co_to_sched(_tr_g.current);
+            target->joiner = self;
+            self->state = _TRC_SUSP;
+            _tr_co_to_sched(self);
         }
         return target->result;
     }
@@ -3020,9 +5029,46 @@ static long long  _tr_co_result(_TrCoro* c)       { return c ? c->result : 0; }
 
 /* Spawn a DETACHED task: runs fn(arg) as a green thread that the scheduler
  * frees on completion (no join). Used for per-connection handlers. */
-static void _tr_co_spawn(_tr_coro_fn fn, void* arg) {
-    _TrCoro* c = _tr_co_go(fn, arg);
-    c->detached = 1;
+static void _tr_co_spawn(_tr_coro_fn fn, void* arg) { _tr_co_go_ex(fn, arg, 1, -1); }
+/* Detached spawn with an affinity hint: under _tr_sched_run_workers the task
+ * is started on (and never stolen from) worker `worker % n`; -1 = any. */
+static void _tr_co_spawn_on(_tr_coro_fn fn, void* arg, int worker) { _tr_co_go_ex(fn, arg, 1, worker); }
+/* Detached spawn on a stack of `bytes` (page-rounded), for a handler that
+ * recurses deeper than the default allows. Only default-size stacks are
+ * pooled, so this pays an mmap/munmap per task. */
+static void _tr_co_spawn_sz(_tr_coro_fn fn, void* arg, size_t bytes) { _tr_co_go_sz(fn, arg, 1, -1, bytes); }
+
+/* Index of the worker running the caller (0 outside the multicore scheduler)
+ * and the number of workers in the current run (1 outside it). */
+static int _tr_co_worker_id(void) {
+#if defined(_TR_MC)
+    _TrSchedG* g = _tr_sched_cur();
+    return g->mc ? g->mc->id : 0;
+#else
+    return 0;
+#endif
+}
+static int _tr_co_num_workers(void) {
+#if defined(_TR_MC)
+    _TrSchedG* g = _tr_sched_cur();
+    return g->mc ? g->mc->mc->n : 1;
+#else
+    return 1;
+#endif
+}
+
+/* Opt the program into the io_uring completion reactor: from now on each
+ * worker serves coroutine socket ops (_tr_co_recv & co.) from its own ring.
+ * Returns 1 if the calling thread's ring is up, 0 if the kernel lacks
+ * io_uring (or it is compiled out) and the epoll path stays in use. */
+static int _tr_co_use_io_uring(void) {
+#if defined(_TR_URING)
+    __atomic_store_n(&_tr_uring_want, 1, __ATOMIC_RELAXED);
+    _tr_sched_ensure();
+    return _tr_uring_get(_tr_sched_cur()) != NULL;
+#else
+    return 0;
+#endif
 }
 
 /* Await with a millisecond deadline. Returns 1 if the target finished (out =
@@ -3031,7 +5077,7 @@ static void _tr_co_spawn(_tr_coro_fn fn, void* arg) {
  * target finishes or the deadline passes. */
 static int _tr_co_await_timeout(_TrCoro* target, long long ms, long long* out) {
     if (!target) { if (out) *out = 0; return 1; }
-    if (_tr_g.current) {
+    if (_tr_sched_cur()->current) {
         long long r = _tr_co_await(target);
         if (out) *out = r;
         return 1;
@@ -3048,26 +5094,660 @@ static int _tr_co_await_timeout(_TrCoro* target, long long ms, long long* out) {
 /* Tauraro-callable handle-based wrappers - extern "C" decls in std/async. */
 static char*     _tr_co_go_h(void* fn, void* arg) { return (char*)_tr_co_go((_tr_coro_fn)fn, arg); }
 static void       _tr_co_spawn_h(void* fn, void* arg) { _tr_co_spawn((_tr_coro_fn)fn, arg); }
+static void       _tr_co_spawn_on_h(void* fn, void* arg, long long w) { _tr_co_spawn_on((_tr_coro_fn)fn, arg, (int)w); }
+static void       _tr_co_spawn_sz_h(void* fn, void* arg, long long n) { _tr_co_spawn_sz((_tr_coro_fn)fn, arg, n > 0 ? (size_t)n : 0); }
+static void       _tr_co_set_stack_size_h(long long n) { _tr_co_set_stack_size(n); }
 static long long  _tr_co_await_h(char* c)          { return _tr_co_await((_TrCoro*)c); }
 static void       _tr_co_free_h(char* c)           { _tr_co_free((_TrCoro*)c); }
 static void       _tr_co_yield_h(void)             { _tr_co_yield(); }
 static void       _tr_co_sleep_h(long long ms)     { _tr_co_sleep_ms(ms); }
-static int        _tr_co_await_fd_h(long long fd, long long ev) { return _tr_co_await_fd((int)fd, (unsigned int)ev); }
-static void       _tr_co_run_h(void)               { _tr_sched_run(); }
-static int        _tr_co_done_h(char* c)           { return _tr_co_done((_TrCoro*)c); }
-
-#endif /* green-thread scheduler */
+/* Drop the running coroutine's reactor registration for `fd` before the fd
+ * is closed or handed to another coroutine (a pooled client connection):
+ * the registration is otherwise kept until the coroutine ends, and a reused
+ * fd number would look already armed. */
+static void _tr_co_fd_forget(int fd) {
+    _TrSchedG* g = _tr_sched_cur();
+    _TrCoro* c = g->current;
+    if (c && c->io_armed_fd == fd && g->reactor) {
+        _tr_iopoll_del(g->reactor, fd);
+        c->io_armed_fd = -1;
+    }
+}
 
-/* ── TCP socket helpers ─────────────────────────────────────────────── */
-#if defined(TAURARO_BARE) || defined(TAURARO_WASM)
-/* No networking on bare WASM or freestanding targets */
-static inline int _tr_net_init(void)                                              { return -1; }
-static inline int _tr_tcp_connect(const char* h, int p)                           { (void)h;(void)p; return -1; }
-static inline int _tr_tcp_send(int fd, const char* d, int l)                      { (void)fd;(void)d;(void)l; return -1; }
-static inline int _tr_tcp_recv(int fd, char* b, int c)                            { (void)fd;(void)b;(void)c; return -1; }
-static inline void _tr_tcp_close(int fd)                                           { (void)fd; }
-static inline int _tr_tcp_listen(const char* h, int p, int bl)                    { (void)h;(void)p;(void)bl; return -1; }
-static inline int _tr_tcp_accept(int s)                                            { (void)s; return -1; }
+/* Blocking-work offload. A coroutine that has to make a call which blocks
+ * its thread (a disk read, a big hash, a C library without a non-blocking
+ * API) hands it to a separate pool with _tr_co_blocking and parks on a
+ * completion fd in its reactor: the pool thread runs the job, stores the
+ * result and signals the fd, and the reactor wakes the coroutine, so the
+ * other tasks on its worker keep running meanwhile. The completion fd is an
+ * eventfd on Linux and a pipe elsewhere; each worker keeps a few idle ones so
+ * an offload costs no fd creation. The pool is process-wide, created on
+ * first use, and separate from the async compute pool so that jobs sleeping
+ * in the kernel never hold up compute tasks. Outside a coroutine (and on
+ * Windows) the job just runs on the calling thread. */
+#if !defined(_WIN32)
+#include <errno.h>
+#include <fcntl.h>
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
+#define _TR_BLK_MAX_THREADS 64
+typedef struct {
+    long long (*fn)(void*);
+    void*      arg;
+    long long  result;
+    int        wfd;
+} _TrBlkJob;
+#ifdef _TR_MAIN
+_TrThreadPool*  _tr_blk_pool = NULL;
+pthread_mutex_t _tr_blk_lk = PTHREAD_MUTEX_INITIALIZER;
+int             _tr_blk_threads = 0;   /* 0 = TAURARO_BLOCKING_THREADS or 2 per CPU */
+#else
+extern _TrThreadPool*  _tr_blk_pool;
+extern pthread_mutex_t _tr_blk_lk;
+extern int             _tr_blk_threads;
+#endif
+static _TrThreadPool* _tr_blk_pool_get(void) {
+    _TrThreadPool* p = __atomic_load_n(&_tr_blk_pool, __ATOMIC_ACQUIRE);
+    if (p) return p;
+    pthread_mutex_lock(&_tr_blk_lk);
+    if (!_tr_blk_pool) {
+        long long n = _tr_blk_threads;
+        if (n <= 0) {
+            const char* e = getenv("TAURARO_BLOCKING_THREADS");
+            n = e ? atoll(e) : 0;
+        }
+        if (n <= 0) n = 2 * _tr_threadpool_auto_n();
+        if (n < 4) n = 4;
+        if (n > _TR_BLK_MAX_THREADS) n = _TR_BLK_MAX_THREADS;
+        __atomic_store_n(&_tr_blk_pool, _tr_threadpool_new(n), __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&_tr_blk_lk);
+    return _tr_blk_pool;
+}
+static void* _tr_blk_run(void* a) {
+    _TrBlkJob* j = (_TrBlkJob*)a;
+    int wfd = j->wfd;
+    j->result = j->fn(j->arg);
+    /* The write publishes the result: once it lands the coroutine may run
+     * and j (on its stack) is gone, so nothing touches j after it. */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+#if defined(__linux__)
+    uint64_t one = 1;
+    while (write(wfd, &one, sizeof one) < 0 && errno == EINTR) {}
+#else
+    char one = 1;
+    while (write(wfd, &one, 1) < 0 && errno == EINTR) {}
+#endif
+    return NULL;
+}
+/* A completion fd pair {read end, write end} from this worker's cache. */
+static int _tr_blk_fd_get(_TrSchedG* g, int fd[2]) {
+    if (g->blk_n > 0) {
+        g->blk_n--;
+        fd[0] = g->blk_fd[g->blk_n][0];
+        fd[1] = g->blk_fd[g->blk_n][1];
+        return 0;
+    }
+#if defined(__linux__)
+    fd[0] = fd[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    return fd[0] >= 0 ? 0 : -1;
+#else
+    if (pipe(fd) != 0) return -1;
+    fcntl(fd[0], F_SETFL, fcntl(fd[0], F_GETFL) | O_NONBLOCK);
+    fcntl(fd[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fd[1], F_SETFD, FD_CLOEXEC);
+    return 0;
+#endif
+}
+static void _tr_blk_fd_put(_TrSchedG* g, int fd[2]) {
+    if (g->blk_n < 8) {
+        g->blk_fd[g->blk_n][0] = fd[0];
+        g->blk_fd[g->blk_n][1] = fd[1];
+        g->blk_n++;
+        return;
+    }
+    close(fd[0]);
+    if (fd[1] != fd[0]) close(fd[1]);
+}
+/* Run fn(arg) on the blocking pool and return its result, parking the
+ * calling coroutine until it is done. */
+static long long _tr_co_blocking(long long (*fn)(void*), void* arg) {
+    _TrSchedG* g = _tr_sched_cur();
+    int fd[2];
+    if (!g->current || _tr_blk_fd_get(g, fd) != 0) return fn(arg);
+    _TrBlkJob j;
+    j.fn = fn; j.arg = arg; j.result = 0; j.wfd = fd[1];
+    _tr_mx_add(_TR_MX_BLOCKING_JOBS, 1);
+    _tr_threadpool_spawn(_tr_blk_pool_get(), _tr_blk_run, &j);
+    for (;;) {
+#if defined(__linux__)
+        uint64_t v;
+        if (read(fd[0], &v, sizeof v) == (ssize_t)sizeof v) break;
+#else
+        char v;
+        if (read(fd[0], &v, 1) == 1) break;
+#endif
+        _tr_co_await_fd(fd[0], TAURARO_POLLIN);
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    g = _tr_sched_cur();
+    _tr_co_fd_forget(fd[0]);
+    _tr_blk_fd_put(g, fd);
+    return j.result;
+}
+/* Threads in the blocking pool (0 = default); only before its first use. */
+static void _tr_co_set_blocking_threads(long long n) {
+    pthread_mutex_lock(&_tr_blk_lk);
+    _tr_blk_threads = (int)(n > _TR_BLK_MAX_THREADS ? _TR_BLK_MAX_THREADS : n);
+    pthread_mutex_unlock(&_tr_blk_lk);
+}
+#else
+static long long _tr_co_blocking(long long (*fn)(void*), void* arg) { return fn(arg); }
+static void _tr_co_set_blocking_threads(long long n) { (void)n; }
+#endif
+static long long  _tr_co_blocking_h(void* fn, void* arg) { return _tr_co_blocking((long long (*)(void*))fn, arg); }
+static void       _tr_co_set_blocking_threads_h(long long n) { _tr_co_set_blocking_threads(n); }
+static int        _tr_co_await_fd_h(long long fd, long long ev) { return _tr_co_await_fd((int)fd, (unsigned int)ev); }
+static int        _tr_co_await_fd_timeout_h(long long fd, long long ev, long long ms) { return _tr_co_await_fd_timeout((int)fd, (unsigned int)ev, ms); }
+static void       _tr_co_run_h(void)               { _tr_sched_run(); }
+static void       _tr_co_run_workers_h(long long n) { _tr_sched_run_workers(n); }
+static long long  _tr_co_worker_id_h(void)         { return (long long)_tr_co_worker_id(); }
+static long long  _tr_co_num_workers_h(void)       { return (long long)_tr_co_num_workers(); }
+static int        _tr_co_use_io_uring_h(void)      { return _tr_co_use_io_uring(); }
+static int        _tr_co_done_h(char* c)           { return _tr_co_done((_TrCoro*)c); }
+
+#endif /* green-thread scheduler */
+#if defined(TAURARO_BARE) || defined(TAURARO_WASM)
+static long long _tr_co_blocking(long long (*fn)(void*), void* arg) { return fn(arg); }
+static long long _tr_co_blocking_h(void* fn, void* arg) { return ((long long (*)(void*))fn)(arg); }
+static void      _tr_co_set_blocking_threads_h(long long n) { (void)n; }
+#endif
+
+/* Whole-file helpers behind File.read_text / write_text / append_text. From
+ * a coroutine the fopen/fread/fwrite run on the blocking pool, so a cold
+ * disk read parks the task instead of stalling its worker. */
+#ifndef TAURARO_BARE
+typedef struct {
+    const char* path;
+    const char* mode;
+    const char* data;
+    char*       out;
+} _TrFileJob;
+static long long _tr_file_read_job(void* a) {
+    _TrFileJob* j = (_TrFileJob*)a;
+    FILE* fp = fopen(j->path, "rb");
+    if (!fp) return -1;
+    long size = (fseek(fp, 0, SEEK_END) == 0) ? ftell(fp) : -1;
+    if (size <= 0 || fseek(fp, 0, SEEK_SET) != 0) { fclose(fp); return -1; }
+    char* buf = (char*)TAURARO_ALLOC((size_t)size + 1);
+    if (!buf) { fclose(fp); return -1; }
+    size_t n = fread(buf, 1, (size_t)size, fp);
+    buf[n] = '\0';
+    fclose(fp);
+    j->out = buf;
+    return (long long)n;
+}
+static long long _tr_file_write_job(void* a) {
+    _TrFileJob* j = (_TrFileJob*)a;
+    FILE* fp = fopen(j->path, j->mode);
+    if (!fp) return -1;
+    size_t n = strlen(j->data);
+    size_t w = n ? fwrite(j->data, 1, n, fp) : 0;
+    return (fclose(fp) == 0 && w == n) ? 0 : -1;
+}
+/* The whole file as a new string; "" when it is missing or empty. */
+static inline char* _tr_file_read_all(const char* path) {
+    _TrFileJob j = { path, "rb", NULL, NULL };
+    if (!path || _tr_co_blocking(_tr_file_read_job, &j) < 0 || !j.out) return _tr_empty_heap_str();
+    return j.out;
+}
+/* Replace (append == 0) or extend the file with data; 0 on success. */
+static inline int _tr_file_write_all(const char* path, const char* data, long long append) {
+    _TrFileJob j = { path, append ? "ab" : "wb", data ? data : "", NULL };
+    if (!path) return -1;
+    return (int)_tr_co_blocking(_tr_file_write_job, &j);
+}
+#else
+static inline char* _tr_file_read_all(const char* path) { (void)path; return _tr_empty_heap_str(); }
+static inline int _tr_file_write_all(const char* path, const char* data, long long append) { (void)path; (void)data; (void)append; return -1; }
+#endif
+
+/* ── Metrics registry, readers and Prometheus text ───────────────────────
+ * See "Live metrics" near the top for the per-thread blocks. Registered
+ * counters take the slots after the built-ins; histograms have their own
+ * slots. Every histogram records microseconds and is rendered in seconds.
+ * A histogram registered with a count name also renders its sample count
+ * as that counter (the HTTP per-route request totals). Series names carry
+ * their labels: `family{label="v"}`. */
+#ifndef _TR_MX_OFF
+#if !defined(_WIN32) && !defined(TAURARO_WASM)
+#  define _TR_MX_RECYCLE 1
+#endif
+#ifdef _TR_MAIN
+_TrMxBlock*   _tr_mx_head = NULL;
+int           _tr_mx_lk = 0;
+int           _tr_mx_nctr = _TR_MX_NBUILTIN;
+int           _tr_mx_nhist = 0;
+char*         _tr_mx_cname[_TR_MX_MAX];
+char*         _tr_mx_chelp[_TR_MX_MAX];
+char*         _tr_mx_hname[_TR_MX_HMAX];
+char*         _tr_mx_hhelp[_TR_MX_HMAX];
+char*         _tr_mx_hcount[_TR_MX_HMAX];   /* counter rendered from the sample count, or NULL */
+#  ifdef _TR_MX_RECYCLE
+pthread_key_t _tr_mx_key;
+int           _tr_mx_key_ok = 0;
+#  endif
+#else
+extern _TrMxBlock*   _tr_mx_head;
+extern int           _tr_mx_lk;
+extern int           _tr_mx_nctr;
+extern int           _tr_mx_nhist;
+extern char*         _tr_mx_cname[_TR_MX_MAX];
+extern char*         _tr_mx_chelp[_TR_MX_MAX];
+extern char*         _tr_mx_hname[_TR_MX_HMAX];
+extern char*         _tr_mx_hhelp[_TR_MX_HMAX];
+extern char*         _tr_mx_hcount[_TR_MX_HMAX];
+#  ifdef _TR_MX_RECYCLE
+extern pthread_key_t _tr_mx_key;
+extern int           _tr_mx_key_ok;
+#  endif
+#endif
+
+/* Held only for attach/detach, registration and reads: a spinlock is enough.
+ * Callers attach (_tr_mx_block) BEFORE taking it, since attaching locks. */
+static void _tr_mx_lock(void) {
+    while (__atomic_exchange_n(&_tr_mx_lk, 1, __ATOMIC_ACQUIRE))
+        while (__atomic_load_n(&_tr_mx_lk, __ATOMIC_RELAXED)) {}
+}
+static void _tr_mx_unlock(void) { __atomic_store_n(&_tr_mx_lk, 0, __ATOMIC_RELEASE); }
+
+#ifdef _TR_MX_RECYCLE
+/* Thread exit: the block keeps its counts and waits for the next thread. */
+static void _tr_mx_detach(void* p) {
+    _TrMxBlock* b = (_TrMxBlock*)p;
+    _tr_mx_lock();
+    b->sched = NULL;
+    b->busy = 0;
+    _tr_mx_unlock();
+    _tr_mx_self = NULL;
+}
+#endif
+static _TrMxBlock* _tr_mx_attach(void) {
+    _TrMxBlock* b;
+    _tr_mx_lock();
+#ifdef _TR_MX_RECYCLE
+    if (!_tr_mx_key_ok) { pthread_key_create(&_tr_mx_key, _tr_mx_detach); _tr_mx_key_ok = 1; }
+#endif
+    for (b = _tr_mx_head; b && b->busy; b = b->next) {}
+    if (!b) {
+        b = (_TrMxBlock*)TAURARO_CALLOC(1, sizeof(_TrMxBlock));
+        if (!b) { _TR_OOM_ABORT(); }
+        b->next = _tr_mx_head;
+        _tr_mx_head = b;
+    }
+    b->busy = 1;
+    _tr_mx_unlock();
+#ifdef _TR_MX_RECYCLE
+    pthread_setspecific(_tr_mx_key, b);
+#endif
+    _tr_mx_self = b;
+    return b;
+}
+
+/* Bucket of v: exact below 8, then four per power of two (<= 25% wide). */
+static inline int _tr_mx_bucket(unsigned long long v) {
+    if (v < 8) return (int)v;
+    int e = 63 - __builtin_clzll(v);
+    int i = 8 + (e - 3) * 4 + (int)((v >> (e - 2)) & 3);
+    return i < _TR_MX_HB ? i : _TR_MX_HB - 1;
+}
+static unsigned long long _tr_mx_bucket_lo(int i) {
+    if (i < 8) return (unsigned long long)i;
+    return (unsigned long long)(4 + (i - 8) % 4) << ((i - 8) / 4 + 1);
+}
+static unsigned long long _tr_mx_bucket_hi(int i) {   /* exclusive */
+    if (i < 8) return (unsigned long long)i + 1;
+    if (i == _TR_MX_HB - 1) return ~0ULL;
+    return (unsigned long long)(5 + (i - 8) % 4) << ((i - 8) / 4 + 1);
+}
+static inline void _tr_mx_observe(long long id, long long v) {
+    if (id < 0 || id >= _TR_MX_HMAX) return;
+    _TrMxBlock* b = _tr_mx_block();
+    _TrMxHist* h = b->h[id];
+    if (!h) {
+        h = (_TrMxHist*)TAURARO_CALLOC(1, sizeof(_TrMxHist));
+        if (!h) return;
+        __atomic_store_n(&b->h[id], h, __ATOMIC_RELEASE);
+    }
+    if (v < 0) v = 0;
+    h->b[_tr_mx_bucket((unsigned long long)v)]++;
+    h->n++;
+    h->sum += v;
+}
+static inline void _tr_mx_counter_add(long long id, long long n) {
+    if (id >= _TR_MX_NBUILTIN && id < _TR_MX_MAX) _tr_mx_block()->c[id] += n;
+}
+
+static long long _tr_mx_find(char** names, int from, int to, const char* name) {
+    for (int i = from; i < to; i++) if (names[i] && strcmp(names[i], name) == 0) return i;
+    return -1;
+}
+/* Register a counter (hist = 0) or histogram by series name; registering the
+ * same name again returns the same id. -1 when the slots are used up. */
+static long long _tr_mx_register(int hist, const char* name, const char* help, const char* count_name) {
+    if (!name || !*name) return -1;
+    _tr_mx_block();
+    _tr_mx_lock();
+    long long id = hist ? _tr_mx_find(_tr_mx_hname, 0, _tr_mx_nhist, name)
+                        : _tr_mx_find(_tr_mx_cname, _TR_MX_NBUILTIN, _tr_mx_nctr, name);
+    if (id < 0 && (hist ? _tr_mx_nhist < _TR_MX_HMAX : _tr_mx_nctr < _TR_MX_MAX)) {
+        id = hist ? _tr_mx_nhist : _tr_mx_nctr;
+        char** nm = hist ? _tr_mx_hname : _tr_mx_cname;
+        char** hp = hist ? _tr_mx_hhelp : _tr_mx_chelp;
+        nm[id] = _tr_str_dup_owned(name);
+        hp[id] = _tr_str_dup_owned(help ? help : "");
+        if (hist) _tr_mx_hcount[id] = count_name ? _tr_str_dup_owned(count_name) : NULL;
+        /* Publish the slot only once its name is in place. */
+        if (hist) __atomic_store_n(&_tr_mx_nhist, (int)id + 1, __ATOMIC_RELEASE);
+        else      __atomic_store_n(&_tr_mx_nctr, (int)id + 1, __ATOMIC_RELEASE);
+    }
+    _tr_mx_unlock();
+    return id;
+}
+static inline long long _tr_mx_counter_new(const char* name, const char* help) { return _tr_mx_register(0, name, help, NULL); }
+static inline long long _tr_mx_hist_new(const char* name, const char* help)    { return _tr_mx_register(1, name, help, NULL); }
+
+/* Sums over every block; the caller holds the lock. */
+static long long _tr_mx_sum_locked(int id) {
+    long long v = 0;
+    for (_TrMxBlock* b = _tr_mx_head; b; b = b->next) v += __atomic_load_n(&b->c[id], __ATOMIC_RELAXED);
+    return v;
+}
+static void _tr_mx_hist_merge_locked(int id, _TrMxHist* out) {
+    memset(out, 0, sizeof *out);
+    for (_TrMxBlock* b = _tr_mx_head; b; b = b->next) {
+        _TrMxHist* h = __atomic_load_n(&b->h[id], __ATOMIC_ACQUIRE);
+        if (!h) continue;
+        out->n += __atomic_load_n(&h->n, __ATOMIC_RELAXED);
+        out->sum += __atomic_load_n(&h->sum, __ATOMIC_RELAXED);
+        for (int i = 0; i < _TR_MX_HB; i++) out->b[i] += __atomic_load_n(&h->b[i], __ATOMIC_RELAXED);
+    }
+}
+/* Queue gauges of the running schedulers: 0 = parked on I/O, 1 = on timers. */
+static long long _tr_mx_sched_sum_locked(int which) {
+    long long v = 0;
+#if !defined(TAURARO_WASM)
+    for (_TrMxBlock* b = _tr_mx_head; b; b = b->next) {
+        _TrSchedG* g = (_TrSchedG*)b->sched;
+        if (!g) continue;
+        if (which == 0) {
+            v += __atomic_load_n(&g->n_io, __ATOMIC_RELAXED);
+#if defined(_TR_URING)
+            v += __atomic_load_n(&g->n_uring, __ATOMIC_RELAXED);
+#endif
+        } else {
+            v += __atomic_load_n(&g->n_sleep, __ATOMIC_RELAXED);
+        }
+    }
+#else
+    (void)which;
+#endif
+    return v;
+}
+
+/* The built-in series: a counter (b < 0), a gauge a - b, or (a < 0) a
+ * scheduler gauge. */
+typedef struct { const char* name; const char* type; const char* help; int a, b; } _TrMxSeries;
+static const _TrMxSeries _tr_mx_builtin[] = {
+    { "tauraro_heap_allocations_total", "counter", "Runtime heap blocks allocated.", _TR_MX_HEAP_ALLOC, -1 },
+    { "tauraro_heap_live_blocks", "gauge", "Runtime heap blocks allocated and not yet freed.", _TR_MX_HEAP_ALLOC, _TR_MX_HEAP_FREE },
+    { "tauraro_objects_live", "gauge", "Heap class instances alive.", _TR_MX_OBJ_NEW, _TR_MX_OBJ_FREE },
+    { "tauraro_strings_live", "gauge", "Refcounted strings alive.", _TR_MX_STR_NEW, _TR_MX_STR_FREE },
+    { "tauraro_dicts_live", "gauge", "Dicts alive.", _TR_MX_DICT_NEW, _TR_MX_DICT_FREE },
+    { "tauraro_lists_live", "gauge", "Runtime lists alive.", _TR_MX_LIST_NEW, _TR_MX_LIST_FREE },
+    { "tauraro_coroutines_spawned_total", "counter", "Coroutines spawned.", _TR_MX_CO_SPAWN, -1 },
+    { "tauraro_coroutines_live", "gauge", "Coroutines spawned and not yet finished.", _TR_MX_CO_SPAWN, _TR_MX_CO_DONE },
+    { "tauraro_coroutine_switches_total", "counter", "Coroutine dispatches by the schedulers.", _TR_MX_CO_SWITCH, -1 },
+    { "tauraro_sched_ready", "gauge", "Coroutines queued ready to run.", _TR_MX_RQ_PUSH, _TR_MX_CO_SWITCH },
+    { "tauraro_sched_io_waiting", "gauge", "Coroutines parked on I/O.", -1, 0 },
+    { "tauraro_sched_sleeping", "gauge", "Coroutines parked on a timer.", -1, 1 },
+    { "tauraro_reactor_waits_total", "counter", "Reactor waits (epoll_wait / kevent / WSAPoll calls).", _TR_MX_POLL_WAITS, -1 },
+    { "tauraro_reactor_wakeups_total", "counter", "Reactor waits that returned events.", _TR_MX_POLL_WAKEUPS, -1 },
+    { "tauraro_reactor_events_total", "counter", "Readiness events delivered by the reactor.", _TR_MX_POLL_EVENTS, -1 },
+    { "tauraro_blocking_jobs_total", "counter", "Calls offloaded with Coro.blocking.", _TR_MX_BLOCKING_JOBS, -1 },
+};
+#define _TR_MX_NSERIES ((int)(sizeof(_tr_mx_builtin) / sizeof(_tr_mx_builtin[0])))
+static long long _tr_mx_series_locked(const _TrMxSeries* s) {
+    if (s->a < 0) return _tr_mx_sched_sum_locked(s->b);
+    long long v = _tr_mx_sum_locked(s->a);
+    return s->b < 0 ? v : v - _tr_mx_sum_locked(s->b);
+}
+
+/* Current value of a series by name: a built-in, a registered counter, or
+ * the sample count of a registered histogram. 0 when there is no such one. */
+static long long _tr_mx_value(const char* name) {
+    long long v = 0;
+    if (!name) return 0;
+    _tr_mx_block();
+    _tr_mx_lock();
+    long long id;
+    int i;
+    for (i = 0; i < _TR_MX_NSERIES; i++)
+        if (strcmp(_tr_mx_builtin[i].name, name) == 0) { v = _tr_mx_series_locked(&_tr_mx_builtin[i]); break; }
+    if (i == _TR_MX_NSERIES) {
+        if ((id = _tr_mx_find(_tr_mx_cname, _TR_MX_NBUILTIN, _tr_mx_nctr, name)) >= 0) v = _tr_mx_sum_locked((int)id);
+        else if ((id = _tr_mx_find(_tr_mx_hname, 0, _tr_mx_nhist, name)) >= 0 ||
+                 (id = _tr_mx_find(_tr_mx_hcount, 0, _tr_mx_nhist, name)) >= 0) {
+            _TrMxHist h;
+            _tr_mx_hist_merge_locked((int)id, &h);
+            v = h.n;
+        }
+    }
+    _tr_mx_unlock();
+    return v;
+}
+/* Histogram readers: sample count, sum, and the q-quantile (0..1) as the
+ * midpoint of the bucket it falls in. */
+static long long _tr_mx_hist_read(long long id, int what, double q) {
+    if (id < 0 || id >= _TR_MX_HMAX) return 0;
+    _TrMxHist h;
+    _tr_mx_block();
+    _tr_mx_lock();
+    _tr_mx_hist_merge_locked((int)id, &h);
+    _tr_mx_unlock();
+    if (what == 0) return h.n;
+    if (what == 1) return h.sum;
+    if (h.n == 0) return 0;
+    if (q < 0) q = 0;
+    if (q > 1) q = 1;
+    long long rank = (long long)(q * (double)h.n + 0.999999);
+    if (rank < 1) rank = 1;
+    long long seen = 0;
+    for (int i = 0; i < _TR_MX_HB; i++) {
+        seen += h.b[i];
+        if (seen >= rank) {
+            if (i < 8) return i;
+            unsigned long long lo = _tr_mx_bucket_lo(i);
+            unsigned long long hi = i == _TR_MX_HB - 1 ? lo * 2 : _tr_mx_bucket_hi(i);
+            return (long long)(lo + (hi - lo) / 2);
+        }
+    }
+    return 0;
+}
+static inline long long _tr_mx_hist_count(long long id) { return _tr_mx_hist_read(id, 0, 0); }
+static inline long long _tr_mx_hist_sum(long long id)   { return _tr_mx_hist_read(id, 1, 0); }
+static inline long long _tr_mx_hist_quantile(long long id, double q) { return _tr_mx_hist_read(id, 2, q); }
+
+/* Growable text for the exposition. */
+typedef struct { char* p; size_t n, cap; } _TrMxOut;
+static void _tr_mx_put(_TrMxOut* o, const char* fmt, ...) {
+    for (;;) {
+        va_list ap;
+        va_start(ap, fmt);
+        int k = vsnprintf(o->p + o->n, o->cap - o->n, fmt, ap);
+        va_end(ap);
+        if (k < 0) return;
+        if (o->n + (size_t)k < o->cap) { o->n += (size_t)k; return; }
+        size_t cap = o->cap * 2 + (size_t)k;
+        char* np = (char*)TAURARO_REALLOC(o->p, cap);
+        if (!np) return;
+        o->p = np; o->cap = cap;
+    }
+}
+/* `family{labels}` -> family length; *lab / *lablen = the labels inside. */
+static size_t _tr_mx_split(const char* name, const char** lab, size_t* lablen) {
+    const char* br = strchr(name, '{');
+    if (!br) { *lab = ""; *lablen = 0; return strlen(name); }
+    *lab = br + 1;
+    const char* end = strrchr(br, '}');
+    *lablen = end && end > br ? (size_t)(end - br - 1) : strlen(br + 1);
+    return (size_t)(br - name);
+}
+/* First series in names[from..i) of the same family as names[i]? */
+static int _tr_mx_family_seen(char** names, int from, int i) {
+    const char* l; size_t ll;
+    size_t fl = _tr_mx_split(names[i], &l, &ll);
+    for (int k = from; k < i; k++) {
+        if (!names[k]) continue;
+        size_t kl = _tr_mx_split(names[k], &l, &ll);
+        if (kl == fl && memcmp(names[k], names[i], fl) == 0) return 1;
+    }
+    return 0;
+}
+/* Every series, in the Prometheus text exposition format (version 0.0.4). */
+static char* _tr_mx_prometheus(void) {
+    static const long long le_us[] = { 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000,
+                                       100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000 };
+    _TrMxOut o;
+    o.cap = 8192; o.n = 0;
+    o.p = (char*)TAURARO_ALLOC(o.cap);
+    if (!o.p) return _tr_empty_heap_str();
+    o.p[0] = '\0';
+    _tr_mx_block();
+    _tr_mx_lock();
+    for (int i = 0; i < _TR_MX_NSERIES; i++) {
+        const _TrMxSeries* s = &_tr_mx_builtin[i];
+        _tr_mx_put(&o, "# HELP %s %s\n# TYPE %s %s\n%s %lld\n", s->name, s->help, s->name, s->type,
+                   s->name, _tr_mx_series_locked(s));
+    }
+    for (int i = _TR_MX_NBUILTIN; i < _tr_mx_nctr; i++) {
+        const char* l; size_t ll;
+        size_t fl = _tr_mx_split(_tr_mx_cname[i], &l, &ll);
+        if (!_tr_mx_family_seen(_tr_mx_cname, _TR_MX_NBUILTIN, i))
+            _tr_mx_put(&o, "# HELP %.*s %s\n# TYPE %.*s counter\n", (int)fl, _tr_mx_cname[i], _tr_mx_chelp[i], (int)fl, _tr_mx_cname[i]);
+        _tr_mx_put(&o, "%s %lld\n", _tr_mx_cname[i], _tr_mx_sum_locked(i));
+    }
+    _TrMxHist h;
+    for (int i = 0; i < _tr_mx_nhist; i++) {
+        if (!_tr_mx_hcount[i]) continue;
+        const char* l; size_t ll;
+        size_t fl = _tr_mx_split(_tr_mx_hcount[i], &l, &ll);
+        if (!_tr_mx_family_seen(_tr_mx_hcount, 0, i))
+            _tr_mx_put(&o, "# HELP %.*s Requests served.\n# TYPE %.*s counter\n", (int)fl, _tr_mx_hcount[i], (int)fl, _tr_mx_hcount[i]);
+        _tr_mx_hist_merge_locked(i, &h);
+        _tr_mx_put(&o, "%s %lld\n", _tr_mx_hcount[i], h.n);
+    }
+    for (int i = 0; i < _tr_mx_nhist; i++) {
+        const char* l; size_t ll;
+        const char* nm = _tr_mx_hname[i];
+        size_t fl = _tr_mx_split(nm, &l, &ll);
+        if (!_tr_mx_family_seen(_tr_mx_hname, 0, i))
+            _tr_mx_put(&o, "# HELP %.*s %s\n# TYPE %.*s histogram\n", (int)fl, nm, _tr_mx_hhelp[i], (int)fl, nm);
+        _tr_mx_hist_merge_locked(i, &h);
+        const char* sep = ll ? "," : "";
+        /* A bucket counts toward `le` only when all of it lies at or below
+         * it, so the counts are exact lower bounds. */
+        long long cum = 0;
+        int bi = 0;
+        for (size_t k = 0; k < sizeof le_us / sizeof le_us[0]; k++) {
+            while (bi < _TR_MX_HB - 1 && _tr_mx_bucket_hi(bi) - 1 <= (unsigned long long)le_us[k]) cum += h.b[bi++];
+            _tr_mx_put(&o, "%.*s_bucket{%.*s%sle=\"%g\"} %lld\n", (int)fl, nm, (int)ll, l, sep, (double)le_us[k] / 1e6, cum);
+        }
+        _tr_mx_put(&o, "%.*s_bucket{%.*s%sle=\"+Inf\"} %lld\n", (int)fl, nm, (int)ll, l, sep, h.n);
+        _tr_mx_put(&o, "%.*s_sum%s%.*s%s %.6f\n", (int)fl, nm, ll ? "{" : "", (int)ll, l, ll ? "}" : "", (double)h.sum / 1e6);
+        _tr_mx_put(&o, "%.*s_count%s%.*s%s %lld\n", (int)fl, nm, ll ? "{" : "", (int)ll, l, ll ? "}" : "", h.n);
+    }
+    _tr_mx_unlock();
+    return o.p;
+}
+
+/* Per-route HTTP series: a duration histogram whose count doubles as the
+ * route's request counter. Quotes and backslashes in the pattern are
+ * escaped for the label. */
+static long long _tr_mx_http_route(const char* method, const char* pattern) {
+    char lab[512];
+    size_t n = 0;
+    n += (size_t)snprintf(lab, sizeof lab, "method=\"%s\",route=\"", method ? method : "");
+    for (const char* p = pattern ? pattern : ""; *p && n + 4 < sizeof lab; p++) {
+        if (*p == '"' || *p == '\\') lab[n++] = '\\';
+        lab[n++] = *p;
+    }
+    lab[n++] = '"';
+    lab[n] = '\0';
+    char hname[640], cname[640];
+    snprintf(hname, sizeof hname, "tauraro_http_request_duration_seconds{%s}", lab);
+    snprintf(cname, sizeof cname, "tauraro_http_requests_total{%s}", lab);
+    return _tr_mx_register(1, hname, "Time from a parsed request to its handler returning.", cname);
+}
+#else
+static inline long long _tr_mx_counter_new(const char* name, const char* help) { (void)name; (void)help; return -1; }
+static inline void _tr_mx_counter_add(long long id, long long n) { (void)id; (void)n; }
+static inline long long _tr_mx_hist_new(const char* name, const char* help) { (void)name; (void)help; return -1; }
+static inline void _tr_mx_observe(long long id, long long v) { (void)id; (void)v; }
+static inline long long _tr_mx_value(const char* name) { (void)name; return 0; }
+static inline long long _tr_mx_hist_count(long long id) { (void)id; return 0; }
+static inline long long _tr_mx_hist_sum(long long id) { (void)id; return 0; }
+static inline long long _tr_mx_hist_quantile(long long id, double q) { (void)id; (void)q; return 0; }
+static inline char* _tr_mx_prometheus(void) { return _tr_empty_heap_str(); }
+static inline long long _tr_mx_http_route(const char* method, const char* pattern) { (void)method; (void)pattern; return -1; }
+#endif
+/* Monotonic microseconds, for latency observations. */
+static inline long long _tr_mx_now_us(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f); QueryPerformanceCounter(&c);
+    return (long long)(c.QuadPart / f.QuadPart * 1000000 + c.QuadPart % f.QuadPart * 1000000 / f.QuadPart);
+#elif defined(TAURARO_BARE)
+    return 0;
+#else
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+/* ── Benchmark sinks (std.bench) ───────────────────────────────────────
+ * Values a benchmark body computes and never reads again would be deleted
+ * by the C compiler. These hand them to code it cannot see through: an
+ * empty asm that claims to read the value (or to change it, for
+ * _tr_bench_opaque, which also stops constant folding of loop inputs).
+ * Without GNU asm a volatile store does the same job. */
+#if defined(__GNUC__) || defined(__clang__)
+static inline void _tr_bench_keep(long long v) { __asm__ volatile("" : : "r"(v) : "memory"); }
+static inline void _tr_bench_keep_ptr(const void* p) { __asm__ volatile("" : : "r"(p) : "memory"); }
+static inline long long _tr_bench_opaque(long long v) { __asm__ volatile("" : "+r"(v)); return v; }
+#else
+static volatile long long _tr_bench_sink_i;
+static const void* volatile _tr_bench_sink_p;
+static inline void _tr_bench_keep(long long v) { _tr_bench_sink_i = v; }
+static inline void _tr_bench_keep_ptr(const void* p) { _tr_bench_sink_p = p; }
+static inline long long _tr_bench_opaque(long long v) { _tr_bench_sink_i = v; return _tr_bench_sink_i; }
+#endif
+static volatile double _tr_bench_sink_f;
+static inline void _tr_bench_keep_float(double v) { _tr_bench_sink_f = v; }
+
+/* ── TCP socket helpers ─────────────────────────────────────────────── */
+#if defined(TAURARO_BARE) || defined(TAURARO_WASM)
+/* No networking on bare WASM or freestanding targets */
+static inline int _tr_net_init(void)                                              { return -1; }
+static inline int _tr_tcp_connect(const char* h, int p)                           { (void)h;(void)p; return -1; }
+static inline int _tr_tcp_send(int fd, const char* d, int l)                      { (void)fd;(void)d;(void)l; return -1; }
+static inline int _tr_tcp_recv(int fd, char* b, int c)                            { (void)fd;(void)b;(void)c; return -1; }
+static inline void _tr_tcp_close(int fd)                                           { (void)fd; }
+static inline void _tr_tcp_shutdown(int fd)                                        { (void)fd; }
+static inline int _tr_tcp_listen(const char* h, int p, int bl)                    { (void)h;(void)p;(void)bl; return -1; }
+static inline int _tr_tcp_listen_reuseport(const char* h, int p, int bl)          { (void)h;(void)p;(void)bl; return -1; }
+static inline int _tr_tcp_accept(int s)                                            { (void)s; return -1; }
 static inline char* _tr_tcp_peer_addr(int fd)                                      { (void)fd; return (char*)""; }
 static inline int _tr_udp_socket(void)                                             { return -1; }
 static inline int _tr_udp_bind(int fd, int p)                                      { (void)fd;(void)p; return -1; }
@@ -3076,6 +5756,12 @@ static inline int _tr_udp_recv_from(int fd, char* b, int c, char* src)
 static inline void _tr_udp_close(int fd)                                           { (void)fd; }
 static inline char* _tr_dns_resolve(const char* host)                              { (void)host; return (char*)""; }
 static inline char* _tr_dns_reverse(const char* ip)                                { (void)ip;  return (char*)""; }
+static inline char* _tr_dns_resolve6(const char* host)                             { (void)host; return (char*)""; }
+static inline char* _tr_dns_resolve_all(const char* host)                          { (void)host; return (char*)""; }
+static inline int  _tr_dns_use_nameserver(const char* ip, long long port)         { (void)ip;(void)port; return -1; }
+static inline void _tr_dns_set_timeout(long long ms, long long attempts)          { (void)ms;(void)attempts; }
+static inline void _tr_dns_cache_clear(void)                                       { }
+static inline long long _tr_dns_queries(void)                                      { return 0; }
 #elif defined(_WIN32)
 #ifndef _TR_NET_INCLUDED
 #define _TR_NET_INCLUDED
@@ -3106,6 +5792,7 @@ static inline int _tr_tcp_connect(const char* host, int port) {
 static inline int  _tr_tcp_send(int fd, const char* data, int len) { return send((SOCKET)fd, data, len, 0); }
 static inline int  _tr_tcp_recv(int fd, char* buf, int cap)        { return recv((SOCKET)fd, buf, cap, 0); }
 static inline void _tr_tcp_close(int fd)                           { closesocket((SOCKET)fd); }
+static inline void _tr_tcp_shutdown(int fd)                        { shutdown((SOCKET)fd, SD_BOTH); }
 
 #else  /* POSIX */
 
@@ -3115,25 +5802,534 @@ static inline void _tr_tcp_close(int fd)                           { closesocket
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
+#include <signal.h>
 
-static inline int _tr_net_init(void) { return 0; }
-static inline int _tr_tcp_connect(const char* host, int port) {
-    struct addrinfo hints = {0}, *res = NULL;
-    hints.ai_family   = AF_INET;
+/* A write to a connection the peer has closed raises SIGPIPE, which kills
+ * the process; sockets report EPIPE instead. Ignored once, when the first
+ * socket is made. */
+static inline int _tr_net_init(void) {
+    static _Atomic int once = 0;
+    if (!atomic_load_explicit(&once, memory_order_relaxed) && !atomic_exchange(&once, 1))
+        signal(SIGPIPE, SIG_IGN);
+    return 0;
+}
+
+/* ── Stub resolver (std.net.dns, TcpStream.connect) ─────────────────── *
+ * Names resolve from /etc/hosts, then from a process-wide cache, then by *
+ * UDP queries to the nameservers of /etc/resolv.conf (search list,       *
+ * ndots, timeout and attempts honoured; both files are re-read when they *
+ * change). In a coroutine the wait for a reply parks on the reactor, so  *
+ * a lookup never stalls the worker; outside one it polls. Answers are    *
+ * cached for their TTL (at most an hour), NXDOMAIN and no-data answers   *
+ * for the zone's SOA minimum (at most 5 minutes). A truncated reply      *
+ * falls back to getaddrinfo.                                             */
+#include <poll.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#define _TR_DNS_NS      3
+#define _TR_DNS_ADDRS   8
+#define _TR_DNS_SEARCH  6
+#define _TR_DNS_SLOTS   512      /* direct-mapped: a collision evicts */
+
+typedef struct { int fam; unsigned char a[16]; } _TrDnsAddr;    /* fam 4 or 6 */
+typedef struct { char* name; _TrDnsAddr addr; } _TrDnsHost;
+typedef struct {
+    char       name[256];
+    int        qtype;
+    long long  expires;             /* _tr_mono_ms deadline; 0 = empty slot */
+    int        n;                   /* 0 = negative answer */
+    _TrDnsAddr addr[_TR_DNS_ADDRS];
+} _TrDnsEntry;
+typedef struct {
+    struct sockaddr_storage ns[_TR_DNS_NS];
+    socklen_t   nslen[_TR_DNS_NS];
+    int         nns, fixed;         /* fixed: servers set by _tr_dns_use_nameserver */
+    int         timeout_ms, attempts, ndots, user_timeout;
+    char        search[_TR_DNS_SEARCH][256];
+    int         nsearch;
+    _TrDnsHost* hosts;
+    int         nhosts, loaded;
+    time_t      conf_mtime, hosts_mtime;
+    long long   checked;            /* last look at the files' mtimes */
+    _TrDnsEntry* cache;
+} _TrDnsState;
+
+/* One resolver state per process (defined in the _TR_MAIN TU, like _tr_g):
+ * a name looked up from any module is cached for all of them. */
+#ifdef _TR_MAIN
+_TrDnsState       _tr_dns;
+atomic_flag       _tr_dns_lk = ATOMIC_FLAG_INIT;
+_Atomic long long _tr_dns_nq = 0;            /* queries sent */
+#else
+extern _TrDnsState       _tr_dns;
+extern atomic_flag       _tr_dns_lk;
+extern _Atomic long long _tr_dns_nq;
+#endif
+static inline void _tr_dns_lock(void)   { while (atomic_flag_test_and_set_explicit(&_tr_dns_lk, memory_order_acquire)) {} }
+static inline void _tr_dns_unlock(void) { atomic_flag_clear_explicit(&_tr_dns_lk, memory_order_release); }
+
+static int _tr_dns_add_ns(_TrDnsState* d, const char* ip, int port) {
+    if (d->nns >= _TR_DNS_NS) return -1;
+    char buf[64];
+    snprintf(buf, sizeof buf, "%s", ip);
+    char* pct = strchr(buf, '%');            /* fe80::1%eth0: the scope is dropped */
+    if (pct) *pct = 0;
+    struct sockaddr_storage ss;
+    memset(&ss, 0, sizeof ss);
+    struct sockaddr_in* a4 = (struct sockaddr_in*)&ss;
+    struct sockaddr_in6* a6 = (struct sockaddr_in6*)&ss;
+    socklen_t len;
+    if (inet_pton(AF_INET, buf, &a4->sin_addr) == 1) {
+        a4->sin_family = AF_INET; a4->sin_port = htons((unsigned short)port);
+        len = (socklen_t)sizeof *a4;
+    } else if (inet_pton(AF_INET6, buf, &a6->sin6_addr) == 1) {
+        a6->sin6_family = AF_INET6; a6->sin6_port = htons((unsigned short)port);
+        len = (socklen_t)sizeof *a6;
+    } else return -1;
+    d->ns[d->nns] = ss;
+    d->nslen[d->nns++] = len;
+    return 0;
+}
+
+/* Split `line` on blanks into at most `max` tokens; returns the count. */
+static int _tr_dns_tokens(char* line, char** tok, int max) {
+    int n = 0;
+    char* p = line;
+    while (*p && n < max) {
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+        if (!*p || *p == '#' || *p == ';') break;
+        tok[n++] = p;
+        while (*p && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+        if (*p) *p++ = 0;
+    }
+    return n;
+}
+
+static void _tr_dns_load_conf(_TrDnsState* d) {
+    if (!d->user_timeout) { d->timeout_ms = 5000; d->attempts = 2; }
+    d->ndots = 1; d->nsearch = 0;
+    if (!d->fixed) d->nns = 0;
+    FILE* f = fopen("/etc/resolv.conf", "r");
+    if (f) {
+        char line[512]; char* tok[8];
+        while (fgets(line, sizeof line, f)) {
+            int nt = _tr_dns_tokens(line, tok, 8);
+            if (nt < 2) continue;
+            if (!strcmp(tok[0], "nameserver")) {
+                if (!d->fixed) _tr_dns_add_ns(d, tok[1], 53);
+            } else if (!strcmp(tok[0], "search") || !strcmp(tok[0], "domain")) {
+                d->nsearch = 0;
+                for (int i = 1; i < nt && d->nsearch < _TR_DNS_SEARCH; i++) {
+                    size_t l = strlen(tok[i]);
+                    if (l && tok[i][l - 1] == '.') tok[i][--l] = 0;
+                    if (l == 0 || l > 200) continue;
+                    for (size_t k = 0; k <= l; k++) d->search[d->nsearch][k] = (char)tolower((unsigned char)tok[i][k]);
+                    d->nsearch++;
+                }
+            } else if (!strcmp(tok[0], "options")) {
+                for (int i = 1; i < nt; i++) {
+                    if (!strncmp(tok[i], "ndots:", 6)) d->ndots = atoi(tok[i] + 6);
+                    else if (!d->user_timeout && !strncmp(tok[i], "timeout:", 8)) d->timeout_ms = atoi(tok[i] + 8) * 1000;
+                    else if (!d->user_timeout && !strncmp(tok[i], "attempts:", 9)) d->attempts = atoi(tok[i] + 9);
+                }
+            }
+        }
+        fclose(f);
+    }
+    if (d->timeout_ms <= 0) d->timeout_ms = 1000;
+    if (d->attempts <= 0) d->attempts = 1;
+    if (!d->fixed && d->nns == 0) _tr_dns_add_ns(d, "127.0.0.1", 53);
+}
+
+static void _tr_dns_load_hosts(_TrDnsState* d) {
+    for (int i = 0; i < d->nhosts; i++) TAURARO_FREE(d->hosts[i].name);
+    TAURARO_FREE(d->hosts);
+    d->hosts = NULL; d->nhosts = 0;
+    FILE* f = fopen("/etc/hosts", "r");
+    if (!f) return;
+    int cap = 0;
+    char line[1024]; char* tok[16];
+    while (fgets(line, sizeof line, f)) {
+        int nt = _tr_dns_tokens(line, tok, 16);
+        if (nt < 2) continue;
+        _TrDnsAddr a; memset(&a, 0, sizeof a);
+        if (inet_pton(AF_INET, tok[0], a.a) == 1) a.fam = 4;
+        else if (inet_pton(AF_INET6, tok[0], a.a) == 1) a.fam = 6;
+        else continue;
+        for (int i = 1; i < nt; i++) {
+            if (d->nhosts == cap) {
+                int ncap = cap ? cap * 2 : 16;
+                _TrDnsHost* nh = (_TrDnsHost*)TAURARO_ALLOC(sizeof(_TrDnsHost) * (size_t)ncap);
+                if (!nh) { fclose(f); return; }
+                if (d->nhosts) memcpy(nh, d->hosts, sizeof(_TrDnsHost) * (size_t)d->nhosts);
+                TAURARO_FREE(d->hosts);
+                d->hosts = nh; cap = ncap;
+            }
+            size_t l = strlen(tok[i]);
+            char* nm = (char*)TAURARO_ALLOC(l + 1);
+            if (!nm) break;
+            for (size_t k = 0; k <= l; k++) nm[k] = (char)tolower((unsigned char)tok[i][k]);
+            d->hosts[d->nhosts].name = nm;
+            d->hosts[d->nhosts].addr = a;
+            d->nhosts++;
+        }
+    }
+    fclose(f);
+}
+
+/* Re-read resolv.conf / hosts when they changed; looked at every 2 s at
+ * most. Called with the lock held. */
+static void _tr_dns_refresh(_TrDnsState* d) {
+    long long now = _tr_mono_ms();
+    if (d->loaded && now - d->checked < 2000) return;
+    d->checked = now;
+    struct stat st;
+    time_t cm = stat("/etc/resolv.conf", &st) == 0 ? st.st_mtime : 0;
+    time_t hm = stat("/etc/hosts", &st) == 0 ? st.st_mtime : 0;
+    if (!d->loaded || cm != d->conf_mtime)  { d->conf_mtime = cm;  _tr_dns_load_conf(d); }
+    if (!d->loaded || hm != d->hosts_mtime) { d->hosts_mtime = hm; _tr_dns_load_hosts(d); }
+    if (!d->cache) d->cache = (_TrDnsEntry*)calloc(_TR_DNS_SLOTS, sizeof(_TrDnsEntry));
+    d->loaded = 1;
+}
+
+static unsigned _tr_dns_slot(const char* name, int qtype) {
+    unsigned h = 2166136261u ^ (unsigned)qtype;
+    for (const char* p = name; *p; p++) { h ^= (unsigned char)*p; h *= 16777619u; }
+    return h % _TR_DNS_SLOTS;
+}
+
+static unsigned _tr_dns_id(void) {
+    static _Atomic unsigned long long seq = 0;
+    unsigned long long x = atomic_fetch_add(&seq, 0x9E3779B97F4A7C15ull)
+                         ^ ((unsigned long long)_tr_mono_ms() * 0xBF58476D1CE4E5B9ull)
+                         ^ (unsigned long long)(uintptr_t)&x;
+    x ^= x >> 31; x *= 0x94D049BB133111EBull; x ^= x >> 29;
+    return (unsigned)(x & 0xFFFFu);
+}
+
+/* A query for `name` (wire format, RD set) into q; returns its length or -1. */
+static int _tr_dns_build(unsigned char* q, const char* name, int qtype) {
+    unsigned id = _tr_dns_id();
+    memset(q, 0, 12);
+    q[0] = (unsigned char)(id >> 8); q[1] = (unsigned char)id;
+    q[2] = 0x01; q[5] = 1;
+    int p = 12;
+    const char* s = name;
+    while (*s) {
+        const char* dot = strchr(s, '.');
+        int l = dot ? (int)(dot - s) : (int)strlen(s);
+        if (l == 0 || l > 63 || p + l + 1 > 12 + 255) return -1;
+        q[p++] = (unsigned char)l;
+        memcpy(q + p, s, (size_t)l);
+        p += l; s += l;
+        if (*s == '.') s++;
+    }
+    q[p++] = 0;
+    q[p++] = (unsigned char)(qtype >> 8); q[p++] = (unsigned char)qtype;
+    q[p++] = 0; q[p++] = 1;
+    return p;
+}
+
+static int _tr_dns_skip(const unsigned char* m, int len, int p) {
+    while (p < len) {
+        unsigned l = m[p];
+        if (l == 0) return p + 1;
+        if ((l & 0xC0) == 0xC0) return p + 2 <= len ? p + 2 : -1;
+        if (l & 0xC0) return -1;
+        p += (int)l + 1;
+    }
+    return -1;
+}
+
+static long long _tr_dns_be32(const unsigned char* p) {
+    return (long long)(((unsigned long)p[0] << 24 | (unsigned long)p[1] << 16 | (unsigned long)p[2] << 8 | p[3]) & 0x7FFFFFFFul);
+}
+
+/* Parse reply m to query q. Returns 1 with the addresses of the query type
+ * in e (none: no data), 0 for NXDOMAIN, -1 when m is not the reply to q,
+ * -2 when the server failed or refused, -3 when it was truncated. e->expires
+ * gets the TTL to cache the answer for, in ms. */
+static int _tr_dns_parse(const unsigned char* m, int len, const unsigned char* q, int qlen, int qtype, _TrDnsEntry* e) {
+    if (len < qlen || m[0] != q[0] || m[1] != q[1] || !(m[2] & 0x80)) return -1;
+    if ((m[4] << 8 | m[5]) != 1) return -1;
+    for (int i = 12; i < qlen; i++)
+        if (tolower(m[i]) != tolower(q[i])) return -1;
+    if (m[2] & 0x02) return -3;
+    int rcode = m[3] & 0x0F;
+    if (rcode != 0 && rcode != 3) return -2;
+    int an = m[6] << 8 | m[7], ns = m[8] << 8 | m[9];
+    int want = qtype == 1 ? 4 : 16;
+    long long ttl = -1;
+    int p = qlen;
+    e->n = 0;
+    for (int i = 0; i < an + ns; i++) {
+        p = _tr_dns_skip(m, len, p);
+        if (p < 0 || p + 10 > len) break;
+        int type = m[p] << 8 | m[p + 1], cls = m[p + 2] << 8 | m[p + 3];
+        long long rttl = _tr_dns_be32(m + p + 4);
+        int rdlen = m[p + 8] << 8 | m[p + 9];
+        p += 10;
+        if (p + rdlen > len) break;
+        if (i < an && cls == 1 && type == qtype && rdlen == want) {
+            if (e->n < _TR_DNS_ADDRS) {
+                e->addr[e->n].fam = qtype == 1 ? 4 : 6;
+                memcpy(e->addr[e->n].a, m + p, (size_t)want);
+                e->n++;
+            }
+            if (ttl < 0 || rttl < ttl) ttl = rttl;
+        } else if (i >= an && type == 6 && e->n == 0) {
+            /* SOA in the authority section: the negative TTL is the lesser
+             * of its own TTL and its MINIMUM field (RFC 2308). */
+            int r = _tr_dns_skip(m, len, p);
+            if (r >= 0) r = _tr_dns_skip(m, len, r);
+            if (r >= 0 && r + 20 <= p + rdlen) {
+                long long mn = _tr_dns_be32(m + r + 16);
+                ttl = rttl < mn ? rttl : mn;
+            }
+        }
+        p += rdlen;
+    }
+    if (e->n > 0) ttl = ttl < 1 ? 1 : (ttl > 3600 ? 3600 : ttl);
+    else          ttl = ttl < 0 ? 30 : (ttl < 1 ? 1 : (ttl > 300 ? 300 : ttl));
+    e->expires = ttl * 1000;
+    return rcode == 3 ? 0 : 1;
+}
+
+/* Wait up to `ms` for fd to become readable: parked on the reactor in a
+ * coroutine, poll() outside one. */
+static int _tr_dns_wait(int fd, int ms) {
+    if (_tr_sched_cur()->current) return _tr_co_await_fd_timeout(fd, TAURARO_POLLIN, ms);
+    struct pollfd pf;
+    pf.fd = fd; pf.events = POLLIN; pf.revents = 0;
+    int r;
+    do r = poll(&pf, 1, ms); while (r < 0 && errno == EINTR);
+    return r > 0;
+}
+
+/* Send q to each nameserver in turn, `attempts` rounds, until one answers.
+ * Returns what _tr_dns_parse made of the answer, -2 when none came. */
+static int _tr_dns_exchange(const _TrDnsState* cf, const unsigned char* q, int qlen, int qtype, _TrDnsEntry* e) {
+    unsigned char m[1500];
+    for (int a = 0; a < cf->attempts; a++) {
+        for (int i = 0; i < cf->nns; i++) {
+            int fd = socket(cf->ns[i].ss_family, SOCK_DGRAM, 0);
+            if (fd < 0) continue;
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+            /* connect(): the kernel drops datagrams from other sources and
+             * reports ICMP port-unreachable as ECONNREFUSED. */
+            if (connect(fd, (const struct sockaddr*)&cf->ns[i], cf->nslen[i]) != 0
+                || send(fd, q, (size_t)qlen, 0) != qlen) {
+                close(fd);
+                continue;
+            }
+            atomic_fetch_add(&_tr_dns_nq, 1);
+            long long deadline = _tr_mono_ms() + cf->timeout_ms;
+            int r = -2;
+            for (;;) {
+                long long left = deadline - _tr_mono_ms();
+                if (left <= 0 || !_tr_dns_wait(fd, (int)left)) break;
+                int n = (int)recv(fd, m, sizeof m, 0);
+                if (n < 0) {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+                    break;
+                }
+                r = _tr_dns_parse(m, n, q, qlen, qtype, e);
+                if (r != -1) break;
+                r = -2;                      /* stray datagram: keep waiting */
+            }
+            _tr_co_fd_forget(fd);
+            close(fd);
+            if (r != -2) return r;
+        }
+    }
+    return -2;
+}
+
+/* Truncated reply: let the system resolver (which retries over TCP) answer. */
+static int _tr_dns_gai(const char* name, int qtype, _TrDnsEntry* e) {
+    struct addrinfo hints, *res = NULL;
+    memset(&hints, 0, sizeof hints);
+    hints.ai_family = qtype == 1 ? AF_INET : AF_INET6;
     hints.ai_socktype = SOCK_STREAM;
-    char port_buf[16]; snprintf(port_buf, sizeof(port_buf), "%d", port);
-    if (getaddrinfo(host, port_buf, &hints, &res) != 0) return -1;
-    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
-    if (fd < 0) { freeaddrinfo(res); return -1; }
-    if (connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
-        close(fd); freeaddrinfo(res); return -1;
+    e->n = 0;
+    e->expires = 30000;
+    if (getaddrinfo(name, NULL, &hints, &res) != 0) return -2;
+    for (struct addrinfo* r = res; r && e->n < _TR_DNS_ADDRS; r = r->ai_next) {
+        if (qtype == 1) { e->addr[e->n].fam = 4; memcpy(e->addr[e->n].a, &((struct sockaddr_in*)r->ai_addr)->sin_addr, 4); }
+        else            { e->addr[e->n].fam = 6; memcpy(e->addr[e->n].a, &((struct sockaddr_in6*)r->ai_addr)->sin6_addr, 16); }
+        e->n++;
     }
     freeaddrinfo(res);
+    return 1;
+}
+
+/* Addresses of `host` for qtype 1 (A) or 28 (AAAA) into out (room for
+ * _TR_DNS_ADDRS); returns how many, 0 when it has none. */
+static int _tr_dns_lookup(const char* host, int qtype, _TrDnsAddr* out) {
+    int fam = qtype == 1 ? 4 : 6;
+    memset(out, 0, sizeof(_TrDnsAddr));
+    if (inet_pton(fam == 4 ? AF_INET : AF_INET6, host, out[0].a) == 1) { out[0].fam = fam; return 1; }
+    char name[256];
+    size_t l = strlen(host);
+    int absolute = l > 0 && host[l - 1] == '.';
+    if (absolute) l--;
+    if (l == 0 || l > 253) return 0;
+    for (size_t k = 0; k < l; k++) name[k] = (char)tolower((unsigned char)host[k]);
+    name[l] = 0;
+
+    _TrDnsState* d = &_tr_dns;
+    _TrDnsState cf;
+    int n = 0;
+    _tr_dns_lock();
+    _tr_dns_refresh(d);
+    for (int i = 0; i < d->nhosts && n < _TR_DNS_ADDRS; i++)
+        if (d->hosts[i].addr.fam == fam && !strcmp(d->hosts[i].name, name)) out[n++] = d->hosts[i].addr;
+    _TrDnsEntry* c = d->cache ? &d->cache[_tr_dns_slot(name, qtype)] : NULL;
+    if (!n && c && c->expires && c->qtype == qtype && !strcmp(c->name, name) && _tr_mono_ms() < c->expires) {
+        n = c->n;
+        memcpy(out, c->addr, sizeof(_TrDnsAddr) * (size_t)n);
+        _tr_dns_unlock();
+        return n;
+    }
+    memcpy(&cf, d, sizeof cf);               /* servers, search list, timeouts */
+    _tr_dns_unlock();
+    if (n) return n;
+    /* RFC 6761: localhost is loopback even without a hosts entry. */
+    size_t ll = strlen(name);
+    if (!strcmp(name, "localhost") || (ll > 10 && !strcmp(name + ll - 10, ".localhost"))) {
+        out[0].fam = fam;
+        if (fam == 4) { out[0].a[0] = 127; out[0].a[3] = 1; }
+        else out[0].a[15] = 1;
+        return 1;
+    }
+
+    /* Candidates: a name with at least ndots dots is tried as given first,
+     * then with each search domain appended; a shorter one the other way
+     * round. An absolute name (trailing dot) is tried only as given. */
+    int dots = 0;
+    for (const char* p = name; *p; p++) dots += *p == '.';
+    _TrDnsEntry e;
+    memset(&e, 0, sizeof e);
+    int r = -2;
+    int ncand = absolute ? 1 : cf.nsearch + 1;
+    for (int k = 0; k < ncand; k++) {
+        char cand[512];
+        int as_is = absolute ? 1 : (dots >= cf.ndots ? k == 0 : k == cf.nsearch);
+        if (as_is) snprintf(cand, sizeof cand, "%s", name);
+        else snprintf(cand, sizeof cand, "%s.%s", name, cf.search[dots >= cf.ndots ? k - 1 : k]);
+        unsigned char q[300];
+        int qlen = _tr_dns_build(q, cand, qtype);
+        if (qlen < 0) continue;
+        int rk = _tr_dns_exchange(&cf, q, qlen, qtype, &e);
+        if (rk == -3) rk = _tr_dns_gai(cand, qtype, &e);
+        if (rk == 1 && e.n > 0) { r = 1; break; }
+        if (rk >= 0 || r < 0) r = rk;        /* remember a definite "none" */
+    }
+    if (r >= 0) {
+        _tr_dns_lock();
+        if (d->cache) {
+            c = &d->cache[_tr_dns_slot(name, qtype)];
+            snprintf(c->name, sizeof c->name, "%s", name);
+            c->qtype = qtype;
+            c->n = e.n;
+            memcpy(c->addr, e.addr, sizeof e.addr);
+            c->expires = _tr_mono_ms() + e.expires;
+        }
+        _tr_dns_unlock();
+    }
+    if (r < 0) return 0;
+    memcpy(out, e.addr, sizeof(_TrDnsAddr) * (size_t)e.n);
+    return e.n;
+}
+
+/* First IPv4 address of host, for the connect paths. 0 on success. */
+static int _tr_dns_addr4(const char* host, struct in_addr* out) {
+    _TrDnsAddr a[_TR_DNS_ADDRS];
+    if (_tr_dns_lookup(host, 1, a) == 0) return -1;
+    memcpy(out, a[0].a, 4);
+    return 0;
+}
+
+static char* _tr_dns_text(const _TrDnsAddr* a) {
+    char* s = (char*)_tr_c_malloc(64);
+    if (!s) return _tr_empty_heap_str();
+    inet_ntop(a->fam == 4 ? AF_INET : AF_INET6, a->a, s, 64);
+    return s;
+}
+static inline char* _tr_dns_resolve(const char* host) {
+    _TrDnsAddr a[_TR_DNS_ADDRS];
+    return _tr_dns_lookup(host, 1, a) ? _tr_dns_text(&a[0]) : _tr_empty_heap_str();
+}
+static inline char* _tr_dns_resolve6(const char* host) {
+    _TrDnsAddr a[_TR_DNS_ADDRS];
+    return _tr_dns_lookup(host, 28, a) ? _tr_dns_text(&a[0]) : _tr_empty_heap_str();
+}
+/* Every address of host, IPv4 first, one per line. */
+static inline char* _tr_dns_resolve_all(const char* host) {
+    _TrDnsAddr a[2 * _TR_DNS_ADDRS];
+    int n = _tr_dns_lookup(host, 1, a);
+    n += _tr_dns_lookup(host, 28, a + n);
+    char* s = (char*)_tr_c_malloc((size_t)n * 48 + 1);
+    if (!s) return _tr_empty_heap_str();
+    size_t p = 0;
+    for (int i = 0; i < n; i++) {
+        if (i) s[p++] = '\n';
+        inet_ntop(a[i].fam == 4 ? AF_INET : AF_INET6, a[i].a, s + p, 47);
+        p += strlen(s + p);
+    }
+    s[p] = 0;
+    return s;
+}
+/* Query only ip:port from now on instead of the resolv.conf servers. */
+static inline int _tr_dns_use_nameserver(const char* ip, long long port) {
+    _tr_dns_lock();
+    _tr_dns_refresh(&_tr_dns);
+    int saved = _tr_dns.nns;
+    _tr_dns.nns = 0;
+    int rc = _tr_dns_add_ns(&_tr_dns, ip, (int)port);
+    if (rc == 0) _tr_dns.fixed = 1;
+    else _tr_dns.nns = saved;
+    _tr_dns_unlock();
+    return rc;
+}
+static inline void _tr_dns_set_timeout(long long ms, long long attempts) {
+    _tr_dns_lock();
+    _tr_dns_refresh(&_tr_dns);
+    _tr_dns.timeout_ms   = ms > 0 ? (int)ms : 1;
+    _tr_dns.attempts     = attempts > 0 ? (int)attempts : 1;
+    _tr_dns.user_timeout = 1;
+    _tr_dns_unlock();
+}
+static inline void _tr_dns_cache_clear(void) {
+    _tr_dns_lock();
+    if (_tr_dns.cache) memset(_tr_dns.cache, 0, sizeof(_TrDnsEntry) * _TR_DNS_SLOTS);
+    _tr_dns_unlock();
+}
+static inline long long _tr_dns_queries(void) { return atomic_load(&_tr_dns_nq); }
+static inline int _tr_tcp_connect(const char* host, int port) {
+    _tr_net_init();
+    struct sockaddr_in a;
+    memset(&a, 0, sizeof a);
+    a.sin_family = AF_INET;
+    a.sin_port   = htons((unsigned short)port);
+    if (_tr_dns_addr4(host, &a.sin_addr) != 0) return -1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr*)&a, sizeof a) != 0) {
+        close(fd); return -1;
+    }
     return fd;
 }
 static inline int  _tr_tcp_send(int fd, const char* data, int len) { return (int)send(fd, data, (size_t)len, 0); }
 static inline int  _tr_tcp_recv(int fd, char* buf, int cap)        { return (int)recv(fd, buf, (size_t)cap, 0); }
 static inline void _tr_tcp_close(int fd)                           { close(fd); }
+/* shutdown() without close(): also wakes a coroutine parked on a listening
+ * socket (it becomes readable and accept() fails), so an accept loop running
+ * on another worker can observe a stop request and close its own fd. */
+static inline void _tr_tcp_shutdown(int fd)                        { shutdown(fd, SHUT_RDWR); }
 #endif
 
 /* ── Platform detection ──────────────────────────────────────────────── */
@@ -3141,99 +6337,701 @@ static inline bool _tr_is_windows(void) {
 #ifdef _WIN32
     return true;
 #else
-    return false;
+    return false;
+#endif
+}
+
+/* ── Directory operations (cross-platform) ──────────────────────────── */
+#if !(defined(TAURARO_BARE) && !defined(__wasi__)) && !defined(_WIN32)
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <dirent.h>
+#endif
+_TR_COLD int _tr_mkdir(const char* p);
+_TR_COLD int _tr_rmdir(const char* p);
+_TR_COLD bool _tr_dir_exists(const char* p);
+_TR_COLD bool _tr_is_dir(const char* p);
+_TR_COLD bool _tr_is_file(const char* p);
+_TR_COLD void* _tr_opendir(const char* p);
+_TR_COLD char* _tr_readdir(void* h);
+_TR_COLD void _tr_closedir(void* h);
+#if _TR_COLD_BODIES
+#if defined(TAURARO_BARE) && !defined(__wasi__)
+/* Bare targets with no filesystem */
+_TR_COLD int   _tr_mkdir(const char* p)     { (void)p; return -1; }
+_TR_COLD int   _tr_rmdir(const char* p)     { (void)p; return -1; }
+_TR_COLD bool  _tr_dir_exists(const char* p){ (void)p; return false; }
+_TR_COLD bool  _tr_is_dir(const char* p)    { (void)p; return false; }
+_TR_COLD bool  _tr_is_file(const char* p)   { (void)p; return false; }
+_TR_COLD void* _tr_opendir(const char* p)   { (void)p; return NULL; }
+_TR_COLD char* _tr_readdir(void* h)         { (void)h; return strdup(""); }
+_TR_COLD void  _tr_closedir(void* h)        { (void)h; }
+#elif defined(_WIN32)
+_TR_COLD int  _tr_mkdir(const char* path)     { return CreateDirectoryA(path, NULL) ? 0 : -1; }
+_TR_COLD int  _tr_rmdir(const char* path)     { return RemoveDirectoryA(path) ? 0 : -1; }
+_TR_COLD bool _tr_dir_exists(const char* path) {
+    if (!path) return false;
+    DWORD attr = GetFileAttributesA(path);
+    return (attr != INVALID_FILE_ATTRIBUTES && (attr & FILE_ATTRIBUTE_DIRECTORY));
+}
+_TR_COLD bool _tr_is_dir(const char* path)  { return _tr_dir_exists(path); }
+_TR_COLD bool _tr_is_file(const char* path) {
+    if (!path) return false;
+    DWORD attr = GetFileAttributesA(path);
+    return (attr != INVALID_FILE_ATTRIBUTES && !(attr & FILE_ATTRIBUTE_DIRECTORY));
+}
+typedef struct { HANDLE h; WIN32_FIND_DATAA ffd; int first; } _TrDir;
+_TR_COLD void* _tr_opendir(const char* path) {
+    if (!path) return NULL;
+    _TrDir* d = (_TrDir*)malloc(sizeof(_TrDir));
+    char pat[4096]; snprintf(pat, sizeof(pat), "%s\\*", path);
+    d->h = FindFirstFileA(pat, &d->ffd); d->first = 1;
+    if (d->h == INVALID_HANDLE_VALUE) { free(d); return NULL; }
+    return (void*)d;
+}
+_TR_COLD char* _tr_readdir(void* handle) {
+    _TrDir* d = (_TrDir*)handle;
+    /* Declared `-> str`, so codegen wraps the result as OWNED (rc=1) and will
+     * free it. Every path must therefore return heap memory — the end-of-dir
+     * sentinel returns strdup("") (NOT a string literal: freeing a literal
+     * corrupts the heap). */
+    if (!d || d->h == INVALID_HANDLE_VALUE) return strdup("");
+    if (d->first) { d->first = 0; return strdup(d->ffd.cFileName); }
+    if (FindNextFileA(d->h, &d->ffd)) return strdup(d->ffd.cFileName);
+    return strdup("");
+}
+_TR_COLD void _tr_closedir(void* handle) {
+    _TrDir* d = (_TrDir*)handle;
+    if (d) { if (d->h != INVALID_HANDLE_VALUE) FindClose(d->h); free(d); }
+}
+#else
+_TR_COLD int  _tr_mkdir(const char* path)     { return mkdir(path, 0755) == 0 ? 0 : -1; }
+_TR_COLD int  _tr_rmdir(const char* path)     { return rmdir(path) == 0 ? 0 : -1; }
+_TR_COLD bool _tr_dir_exists(const char* path) {
+    if (!path) return false;
+    struct stat st; return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+_TR_COLD bool _tr_is_dir(const char* path)  { return _tr_dir_exists(path); }
+_TR_COLD bool _tr_is_file(const char* path) {
+    if (!path) return false;
+    struct stat st; return stat(path, &st) == 0 && S_ISREG(st.st_mode);
+}
+_TR_COLD void* _tr_opendir(const char* path)  { return (void*)opendir(path); }
+_TR_COLD char* _tr_readdir(void* handle) {
+    DIR* d = (DIR*)handle;
+    /* Always return OWNED heap (codegen frees it); strdup("") at end-of-dir,
+     * never a string literal. */
+    if (!d) return strdup("");
+    struct dirent* e = readdir(d);
+    return e ? strdup(e->d_name) : strdup("");
+}
+_TR_COLD void _tr_closedir(void* handle)       { if (handle) closedir((DIR*)handle); }
+#endif
+#endif /* _TR_COLD_BODIES */
+
+/* ── File-system helpers ──────── std-tier only (remove/rename/FILE) ──── */
+#ifndef TAURARO_BARE
+static inline int  _tr_file_delete(const char* path)                     { return remove(path) == 0 ? 0 : -1; }
+static inline int  _tr_file_rename(const char* old_p, const char* new_p) { return rename(old_p, new_p) == 0 ? 0 : -1; }
+static inline long long _tr_file_size(const char* path) {
+    if (!path) return -1LL;
+    FILE* f = fopen(path, "rb"); if (!f) return -1LL;
+    fseek(f, 0, SEEK_END); long long sz = (long long)ftell(f); fclose(f); return sz;
+}
+/* Last-modified time in nanoseconds (whole seconds where the stat has no
+ * finer field), -1 when the path can't be stat'ed. The compiler's up-to-date
+ * check stamps its own binary and the output with it. */
+#include <sys/stat.h>
+static inline long long _tr_file_mtime(const char* path) {
+    struct stat st;
+    if (!path || stat(path, &st) != 0) return -1LL;
+#if defined(__linux__)
+    return (long long)st.st_mtim.tv_sec * 1000000000LL + (long long)st.st_mtim.tv_nsec;
+#else
+    return (long long)st.st_mtime * 1000000000LL;
+#endif
+}
+/* Set the permission bits (the native backend's built-in linker marks its output
+ * executable); 0 on success, -1 on failure, a no-op on Windows. */
+static inline int _tr_file_chmod(const char* path, long long mode) {
+#if defined(_WIN32)
+    (void)path; (void)mode; return 0;
+#else
+    return path && chmod(path, (mode_t)mode) == 0 ? 0 : -1;
+#endif
+}
+/* A read-only fd to send a file from (HttpConn.send_file). Its size is taken
+ * from the open fd, so it matches the bytes that follow the headers even if
+ * the path is replaced in between. _tr_fd_size is -1 for a non-regular file. */
+#if defined(_WIN32)
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+static inline long long _tr_file_open_ro(const char* path) { return path ? (long long)_open(path, _O_RDONLY | _O_BINARY) : -1LL; }
+static inline long long _tr_fd_size(long long fd) {
+    struct _stat64 st;
+    if (fd < 0 || _fstat64((int)fd, &st) != 0 || !(st.st_mode & _S_IFREG)) return -1LL;
+    return (long long)st.st_size;
+}
+static inline void _tr_fd_close(long long fd) { if (fd >= 0) _close((int)fd); }
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+static inline long long _tr_file_open_ro(const char* path) { return path ? (long long)open(path, O_RDONLY | O_CLOEXEC) : -1LL; }
+static inline long long _tr_fd_size(long long fd) {
+    struct stat st;
+    if (fd < 0 || fstat((int)fd, &st) != 0 || !S_ISREG(st.st_mode)) return -1LL;
+    return (long long)st.st_size;
+}
+static inline void _tr_fd_close(long long fd) { if (fd >= 0) close((int)fd); }
+#endif
+#else
+static inline int  _tr_file_delete(const char* path)                     { (void)path; return -1; }
+static inline int  _tr_file_rename(const char* old_p, const char* new_p) { (void)old_p; (void)new_p; return -1; }
+static inline long long _tr_file_size(const char* path)                  { (void)path; return -1LL; }
+static inline long long _tr_file_mtime(const char* path)                 { (void)path; return -1LL; }
+static inline int  _tr_file_chmod(const char* path, long long mode)     { (void)path; (void)mode; return -1; }
+static inline long long _tr_file_open_ro(const char* path)               { (void)path; return -1LL; }
+static inline long long _tr_fd_size(long long fd)                        { (void)fd; return -1LL; }
+static inline void _tr_fd_close(long long fd)                            { (void)fd; }
+#endif
+
+/* ── Memory-mapped files (std.io.mmap) ───────────────────────────────────
+ * A _TrMmap maps a whole file read-only or shared read-write. Tauraro code
+ * reads it through StrViews into `data`, so nothing is copied or allocated
+ * per line. `data` is not NUL-terminated: every consumer is length-bounded.
+ * An empty file maps to a zero-length view of a static "" (mmap rejects
+ * length 0). Open failures return NULL; every other call accepts NULL. */
+#ifndef TAURARO_BARE
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+typedef struct {
+    char*     data;
+    long long len;
+    int       writable;
+#if defined(_WIN32)
+    HANDLE    file, map;
+#else
+    int       fd;
+#endif
+} _TrMmap;
+
+/* mode: 0 = read-only, 1 = read-write (the file must exist), 2 = create or
+ * truncate to `size` bytes and map read-write. */
+static inline void* _tr_mmap_open(const char* path, long long mode, long long size) {
+    if (!path) return NULL;
+    _TrMmap* m = (_TrMmap*)calloc(1, sizeof(_TrMmap));
+    if (!m) return NULL;
+    m->writable = mode != 0;
+#if defined(_WIN32)
+    m->file = CreateFileA(path, m->writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                          FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                          mode == 2 ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (m->file == INVALID_HANDLE_VALUE) { free(m); return NULL; }
+    LARGE_INTEGER sz;
+    if (mode == 2) {
+        sz.QuadPart = size;
+        if (!SetFilePointerEx(m->file, sz, NULL, FILE_BEGIN) || !SetEndOfFile(m->file)) {
+            CloseHandle(m->file); free(m); return NULL;
+        }
+    } else if (!GetFileSizeEx(m->file, &sz)) { CloseHandle(m->file); free(m); return NULL; }
+    m->len = (long long)sz.QuadPart;
+    if (m->len == 0) { m->data = (char*)""; return m; }
+    m->map = CreateFileMappingA(m->file, NULL, m->writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, NULL);
+    if (!m->map) { CloseHandle(m->file); free(m); return NULL; }
+    m->data = (char*)MapViewOfFile(m->map, m->writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+    if (!m->data) { CloseHandle(m->map); CloseHandle(m->file); free(m); return NULL; }
+#else
+    int flags = mode == 0 ? O_RDONLY : mode == 1 ? O_RDWR : (O_RDWR | O_CREAT | O_TRUNC);
+    m->fd = open(path, flags | O_CLOEXEC, 0644);
+    if (m->fd < 0) { free(m); return NULL; }
+    if (mode == 2 && ftruncate(m->fd, (off_t)size) != 0) { close(m->fd); free(m); return NULL; }
+    struct stat st;
+    if (fstat(m->fd, &st) != 0) { close(m->fd); free(m); return NULL; }
+    m->len = (long long)st.st_size;
+    if (m->len == 0) { m->data = (char*)""; return m; }
+    void* p = mmap(NULL, (size_t)m->len, m->writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                   MAP_SHARED, m->fd, 0);
+    if (p == MAP_FAILED) { close(m->fd); free(m); return NULL; }
+    m->data = (char*)p;
+#endif
+    return m;
+}
+static inline char*     _tr_mmap_data(void* h) { return h ? ((_TrMmap*)h)->data : (char*)""; }
+static inline long long _tr_mmap_len(void* h)  { return h ? ((_TrMmap*)h)->len : 0; }
+
+/* Clamp [off, off+n) to the mapping; n < 0 means "to the end". Returns the
+ * clamped length (0 when the range is empty). */
+static inline long long _tr_mmap_range(_TrMmap* m, long long* off, long long n) {
+    if (*off < 0) *off = 0;
+    if (*off > m->len) *off = m->len;
+    if (n < 0 || n > m->len - *off) n = m->len - *off;
+    return n;
+}
+
+/* Access-pattern hint for [off, off+n): 0 normal, 1 sequential, 2 random,
+ * 3 willneed (start read-ahead now), 4 dontneed (drop cached pages),
+ * 5 hugepage. Returns 0, or -1 when the hint is unsupported here. Hints
+ * never change what the mapping reads back. */
+static inline int _tr_mmap_advise(void* h, long long off, long long n, long long advice) {
+    _TrMmap* m = (_TrMmap*)h;
+    if (!m || m->len == 0) return -1;
+    n = _tr_mmap_range(m, &off, n);
+    if (n == 0) return 0;
+#if defined(_WIN32)
+    if (advice == 3) {
+        WIN32_MEMORY_RANGE_ENTRY r; r.VirtualAddress = m->data + off; r.NumberOfBytes = (SIZE_T)n;
+        return PrefetchVirtualMemory(GetCurrentProcess(), 1, &r, 0) ? 0 : -1;
+    }
+    return advice == 0 ? 0 : -1;
+#else
+    /* madvise wants a page-aligned start. */
+    long long pg = (long long)sysconf(_SC_PAGESIZE);
+    long long a = off & ~(pg - 1);
+    int adv;
+    switch (advice) {
+    case 0: adv = MADV_NORMAL; break;
+    case 1: adv = MADV_SEQUENTIAL; break;
+    case 2: adv = MADV_RANDOM; break;
+    case 3: adv = MADV_WILLNEED; break;
+    case 4: adv = MADV_DONTNEED; break;
+#ifdef MADV_HUGEPAGE
+    case 5: adv = MADV_HUGEPAGE; break;
+#endif
+    default: return -1;
+    }
+    return madvise(m->data + a, (size_t)(n + (off - a)), adv) == 0 ? 0 : -1;
+#endif
+}
+
+/* Copy n bytes of src to offset off of a read-write mapping; never grows
+ * the file. Returns the count written (short at the end of the mapping),
+ * or -1 for a read-only one. */
+static inline long long _tr_mmap_write(void* h, long long off, const char* src, long long n) {
+    _TrMmap* m = (_TrMmap*)h;
+    if (!m || !m->writable || !src || off < 0) return -1;
+    if (n < 0) n = 0;
+    n = _tr_mmap_range(m, &off, n);
+    if (n > 0) memcpy(m->data + off, src, (size_t)n);
+    return n;
+}
+
+/* Write dirty pages of [off, off+n) back to the file and wait for it. */
+static inline int _tr_mmap_sync(void* h, long long off, long long n) {
+    _TrMmap* m = (_TrMmap*)h;
+    if (!m) return -1;
+    if (!m->writable || m->len == 0) return 0;
+    n = _tr_mmap_range(m, &off, n);
+    if (n == 0) return 0;
+#if defined(_WIN32)
+    if (!FlushViewOfFile(m->data + off, (SIZE_T)n)) return -1;
+    return FlushFileBuffers(m->file) ? 0 : -1;
+#else
+    long long pg = (long long)sysconf(_SC_PAGESIZE);
+    long long a = off & ~(pg - 1);
+    return msync(m->data + a, (size_t)(n + (off - a)), MS_SYNC) == 0 ? 0 : -1;
+#endif
+}
+
+static inline void _tr_mmap_close(void* h) {
+    _TrMmap* m = (_TrMmap*)h;
+    if (!m) return;
+#if defined(_WIN32)
+    if (m->len > 0) { UnmapViewOfFile(m->data); CloseHandle(m->map); }
+    CloseHandle(m->file);
+#else
+    if (m->len > 0) munmap(m->data, (size_t)m->len);
+    close(m->fd);
+#endif
+    free(m);
+}
+#endif /* !TAURARO_BARE */
+
+/* ── Buffered fd writer (std.io.bufio BufWriter) ─────────────────────────
+ * Writes go straight to the fd with write(2)/writev(2), never through
+ * stdio, so the only buffer is this one and flush() really reaches the
+ * kernel. A write that does not fit is sent together with what is already
+ * buffered in one writev instead of being copied in pieces; write_vectored
+ * stages several strings and does the same. `err` keeps the errno of the
+ * first failed write, after which the writer drops further output. */
+#ifndef TAURARO_BARE
+#if defined(_WIN32)
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <sys/uio.h>
+#include <errno.h>
+#endif
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+typedef struct { const char* p; long long n; } _TrBwPart;
+typedef struct {
+    int        fd, owns, err;
+    char*      buf;
+    long long  len, cap;
+    _TrBwPart* parts;      /* strings staged by write_vectored */
+    int        nparts, parts_cap;
+} _TrBufW;
+
+/* mode: 0 = create/truncate, 1 = append, 2 = wrap `fd` (not closed). */
+static inline void* _tr_bw_open(const char* path, long long mode, long long fd, long long cap) {
+    int f = (int)fd;
+    if (mode != 2) {
+        if (!path) return NULL;
+#if defined(_WIN32)
+        f = _open(path, _O_WRONLY | _O_CREAT | _O_BINARY | (mode == 1 ? _O_APPEND : _O_TRUNC), 0644);
+#else
+        f = open(path, O_WRONLY | O_CREAT | O_CLOEXEC | (mode == 1 ? O_APPEND : O_TRUNC), 0644);
+#endif
+    }
+    if (f < 0) return NULL;
+    _TrBufW* w = (_TrBufW*)calloc(1, sizeof(_TrBufW));
+    if (!w) return NULL;
+    w->fd = f; w->owns = mode != 2;
+    w->cap = cap > 0 ? cap : 65536;
+    w->buf = (char*)_tr_checked_alloc(w->cap);
+    return w;
+}
+
+/* Write every byte of the n parts, resuming after short writes. */
+static int _tr_bw_writev_all(_TrBufW* w, _TrBwPart* v, int n) {
+    int i = 0;
+    while (i < n) {
+#if defined(_WIN32)
+        int r = _write(w->fd, v[i].p, (unsigned)(v[i].n > 0x40000000 ? 0x40000000 : v[i].n));
+        if (r < 0) { w->err = errno ? errno : 5; return -1; }
+        v[i].p += r; v[i].n -= r;
+#else
+        struct iovec iov[64];
+        int k = 0;
+        for (int j = i; j < n && k < 64 && k < IOV_MAX; j++) {
+            if (v[j].n == 0) continue;
+            iov[k].iov_base = (void*)v[j].p; iov[k].iov_len = (size_t)v[j].n; k++;
+        }
+        if (k == 0) return 0;
+        ssize_t r = writev(w->fd, iov, k);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            w->err = errno; return -1;
+        }
+        for (int j = i; j < n && r > 0; j++) {
+            long long t = v[j].n < (long long)r ? v[j].n : (long long)r;
+            v[j].p += t; v[j].n -= t; r -= (ssize_t)t;
+        }
+#endif
+        while (i < n && v[i].n == 0) i++;
+    }
+    return 0;
+}
+
+static inline int _tr_bw_flush(void* h) {
+    _TrBufW* w = (_TrBufW*)h;
+    if (!w) return -1;
+    if (w->err) { w->len = 0; return -1; }
+    if (w->len == 0) return 0;
+    _TrBwPart v = { w->buf, w->len };
+    w->len = 0;
+    return _tr_bw_writev_all(w, &v, 1);
+}
+
+/* Append n bytes of p (n < 0: strlen). Returns n, or -1 after an error. */
+static inline long long _tr_bw_write(void* h, const char* p, long long n) {
+    _TrBufW* w = (_TrBufW*)h;
+    if (!w || w->err) return -1;
+    if (!p) return 0;
+    if (n < 0) n = (long long)strlen(p);
+    if (n <= w->cap - w->len) {
+        memcpy(w->buf + w->len, p, (size_t)n);
+        w->len += n;
+        return n;
+    }
+    if (n < w->cap) {   /* fill up, send the full buffer, keep the rest */
+        long long room = w->cap - w->len;
+        memcpy(w->buf + w->len, p, (size_t)room);
+        w->len = w->cap;
+        if (_tr_bw_flush(w) != 0) return -1;
+        memcpy(w->buf, p + room, (size_t)(n - room));
+        w->len = n - room;
+        return n;
+    }
+    /* At least a buffer's worth: one writev of the pending bytes and p. */
+    _TrBwPart v[2] = { { w->buf, w->len }, { p, n } };
+    w->len = 0;
+    return _tr_bw_writev_all(w, v, 2) == 0 ? n : -1;
+}
+
+/* write_vectored: stage strings, then commit them in order. */
+static inline void _tr_bw_stage(void* h, const char* p) {
+    _TrBufW* w = (_TrBufW*)h;
+    if (!w || !p) return;
+    if (w->nparts == w->parts_cap) {
+        w->parts_cap = w->parts_cap ? w->parts_cap * 2 : 16;
+        w->parts = (_TrBwPart*)_tr_c_realloc(w->parts, (size_t)w->parts_cap * sizeof(_TrBwPart));
+    }
+    w->parts[w->nparts].p = p;
+    w->parts[w->nparts].n = (long long)strlen(p);
+    w->nparts++;
+}
+/* Copy the staged strings into the buffer when they all fit; otherwise send
+ * the buffer and all of them in one writev. Returns the staged byte count,
+ * or -1 after an error. */
+static inline long long _tr_bw_commit(void* h) {
+    _TrBufW* w = (_TrBufW*)h;
+    if (!w) return -1;
+    int n = w->nparts;
+    w->nparts = 0;
+    if (w->err) return -1;
+    long long total = 0;
+    for (int i = 0; i < n; i++) total += w->parts[i].n;
+    if (total <= w->cap - w->len) {
+        for (int i = 0; i < n; i++) {
+            memcpy(w->buf + w->len, w->parts[i].p, (size_t)w->parts[i].n);
+            w->len += w->parts[i].n;
+        }
+        return total;
+    }
+    if (w->len > 0) {   /* the buffer goes first: make room for it in front */
+        if (n == w->parts_cap) {
+            w->parts_cap = w->parts_cap * 2;
+            w->parts = (_TrBwPart*)_tr_c_realloc(w->parts, (size_t)w->parts_cap * sizeof(_TrBwPart));
+        }
+        memmove(w->parts + 1, w->parts, (size_t)n * sizeof(_TrBwPart));
+        w->parts[0].p = w->buf; w->parts[0].n = w->len;
+        n++;
+        w->len = 0;
+    }
+    return _tr_bw_writev_all(w, w->parts, n) == 0 ? total : -1;
+}
+
+/* flush, then fsync (data_only: fdatasync where available). */
+static inline int _tr_bw_sync(void* h, long long data_only) {
+    _TrBufW* w = (_TrBufW*)h;
+    if (_tr_bw_flush(w) != 0) return -1;
+#if defined(_WIN32)
+    (void)data_only;
+    if (_commit(w->fd) != 0) { w->err = errno; return -1; }
+#else
+#if defined(__linux__)
+    int r = data_only ? fdatasync(w->fd) : fsync(w->fd);
+#else
+    (void)data_only;
+    int r = fsync(w->fd);
+#endif
+    if (r != 0) { w->err = errno; return -1; }
+#endif
+    return 0;
+}
+
+static inline long long _tr_bw_buffered(void* h) { return h ? ((_TrBufW*)h)->len : 0; }
+static inline long long _tr_bw_error(void* h)    { return h ? ((_TrBufW*)h)->err : 9; }
+
+/* Flush and release; closes the fd when the writer opened it. Returns 0, or
+ * -1 when the final flush or the close failed. */
+static inline int _tr_bw_close(void* h) {
+    _TrBufW* w = (_TrBufW*)h;
+    if (!w) return 0;
+    int r = _tr_bw_flush(w);
+#if defined(_WIN32)
+    if (w->owns && _close(w->fd) != 0) r = -1;
+#else
+    if (w->owns && close(w->fd) != 0) r = -1;
 #endif
+    free(w->buf); free(w->parts); free(w);
+    return r;
 }
+#endif /* !TAURARO_BARE */
 
-/* ── Directory operations (cross-platform) ──────────────────────────── */
-#if defined(TAURARO_BARE) && !defined(__wasi__)
-/* Bare targets with no filesystem */
-static inline int   _tr_mkdir(const char* p)     { (void)p; return -1; }
-static inline int   _tr_rmdir(const char* p)     { (void)p; return -1; }
-static inline bool  _tr_dir_exists(const char* p){ (void)p; return false; }
-static inline bool  _tr_is_dir(const char* p)    { (void)p; return false; }
-static inline bool  _tr_is_file(const char* p)   { (void)p; return false; }
-static inline void* _tr_opendir(const char* p)   { (void)p; return NULL; }
-static inline char* _tr_readdir(void* h)         { (void)h; return strdup(""); }
-static inline void  _tr_closedir(void* h)        { (void)h; }
-#elif defined(_WIN32)
-static inline int  _tr_mkdir(const char* path)     { return CreateDirectoryA(path, NULL) ? 0 : -1; }
-static inline int  _tr_rmdir(const char* path)     { return RemoveDirectoryA(path) ? 0 : -1; }
-static inline bool _tr_dir_exists(const char* path) {
-    if (!path) return false;
-    DWORD attr = GetFileAttributesA(path);
-    return (attr != INVALID_FILE_ATTRIBUTES && (attr & FILE_ATTRIBUTE_DIRECTORY));
+/* Offset of the first byte `b` in p[from, end), or -1. memchr is the
+ * vectorized scan in every libc we target, so this is the inner loop of
+ * the line and record iterators. */
+static inline long long _tr_mem_index_byte(const char* p, long long from, long long end, long long b) {
+    if (!p || from >= end) return -1;
+    const char* q = (const char*)memchr(p + from, (int)(unsigned char)b, (size_t)(end - from));
+    return q ? (long long)(q - p) : -1;
+}
+
+/* ── Object cache (tauraroc's content-addressed .o store) ────────────────
+ * Entries live at <dir>/<key[0..2]>/<key>.o. _tr_objcache_get copies an entry
+ * out and bumps its mtime (the eviction clock). A put copies the object in
+ * through a per-process temp file and a rename, so builds sharing the
+ * directory never see a torn entry. _tr_objcache_trim deletes the
+ * least-recently-used entries until the store is back under 90% of
+ * max_bytes. All of them return 0 / -1 and never abort the build: a broken
+ * cache just means a miss. */
+#ifndef TAURARO_BARE
+static inline char* _tr_hash128_hex(const char* s) {
+    size_t n = s ? strlen(s) : 0;
+    uint64_t h1 = 0x9E3779B97F4A7C15ULL ^ (uint64_t)n, h2 = 0xC2B2AE3D27D4EB4FULL ^ (uint64_t)n;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t w; memcpy(&w, s + i, 8);
+        h1 ^= w * 0x87C37B91114253D5ULL; h1 = ((h1 << 31) | (h1 >> 33)) * 0x4CF5AD432745937FULL;
+        h2 += w ^ h1;                    h2 = ((h2 << 27) | (h2 >> 37)) * 0x9E3779B97F4A7C15ULL + 0x52DCE729ULL;
+    }
+    uint64_t t = 0; if (n > i) memcpy(&t, s + i, n - i);
+    h1 ^= t * 0x87C37B91114253D5ULL; h2 += t ^ h1;
+#define _TR_FMIX64(x) ((x) ^= (x) >> 33, (x) *= 0xFF51AFD7ED558CCDULL, (x) ^= (x) >> 33, \
+                       (x) *= 0xC4CEB9FE1A85EC53ULL, (x) ^= (x) >> 33)
+    h1 += h2; h2 += h1; _TR_FMIX64(h1); _TR_FMIX64(h2); h1 += h2; h2 += h1;
+#undef _TR_FMIX64
+    char* out = (char*)malloc(33); if (!out) _TR_OOM_ABORT();
+    snprintf(out, 33, "%016llx%016llx", (unsigned long long)h1, (unsigned long long)h2);
+    return out;
 }
-static inline bool _tr_is_dir(const char* path)  { return _tr_dir_exists(path); }
-static inline bool _tr_is_file(const char* path) {
-    if (!path) return false;
-    DWORD attr = GetFileAttributesA(path);
-    return (attr != INVALID_FILE_ATTRIBUTES && !(attr & FILE_ATTRIBUTE_DIRECTORY));
+#ifdef _WIN32
+#include <sys/utime.h>
+#define _tr_oc_touch(p) _utime((p), NULL)
+#define _tr_oc_pid()    ((long)GetCurrentProcessId())
+#else
+#include <utime.h>
+#define _tr_oc_touch(p) utime((p), NULL)
+#define _tr_oc_pid()    ((long)getpid())
+#endif
+static inline int _tr_oc_copy(const char* src, const char* dst) {
+    FILE* in = fopen(src, "rb"); if (!in) return -1;
+    FILE* out = fopen(dst, "wb"); if (!out) { fclose(in); return -1; }
+    char buf[65536]; size_t k; int rc = 0;
+    while ((k = fread(buf, 1, sizeof(buf), in)) > 0)
+        if (fwrite(buf, 1, k, out) != k) { rc = -1; break; }
+    if (ferror(in)) rc = -1;
+    fclose(in); if (fclose(out) != 0) rc = -1;
+    if (rc != 0) remove(dst);
+    return rc;
+}
+static inline void _tr_oc_path(char* buf, size_t cap, const char* dir, const char* key, const char* ext) {
+    snprintf(buf, cap, "%s/%.2s/%s%s", dir, key, key, ext);
+}
+static inline int _tr_objcache_get(const char* dir, const char* key, const char* dst) {
+    char p[4096]; _tr_oc_path(p, sizeof(p), dir, key, ".o");
+    if (_tr_oc_copy(p, dst) != 0) return -1;
+    _tr_oc_touch(p);
+    return 0;
 }
-typedef struct { HANDLE h; WIN32_FIND_DATAA ffd; int first; } _TrDir;
-static inline void* _tr_opendir(const char* path) {
-    if (!path) return NULL;
-    _TrDir* d = (_TrDir*)malloc(sizeof(_TrDir));
-    char pat[4096]; snprintf(pat, sizeof(pat), "%s\\*", path);
-    d->h = FindFirstFileA(pat, &d->ffd); d->first = 1;
-    if (d->h == INVALID_HANDLE_VALUE) { free(d); return NULL; }
-    return (void*)d;
+static inline int _tr_objcache_put(const char* dir, const char* key, const char* src) {
+    char p[4096], tmp[4200];
+    /* mkdir -p <dir>/<key[0..2]> */
+    snprintf(p, sizeof(p), "%s/%.2s", dir, key);
+    for (char* q = p + 1; *q; q++)
+        if (*q == '/' || *q == '\\') { char c = *q; *q = '\0'; _tr_mkdir(p); *q = c; }
+    _tr_mkdir(p);
+    _tr_oc_path(p, sizeof(p), dir, key, ".o");
+    snprintf(tmp, sizeof(tmp), "%s.tmp%ld", p, _tr_oc_pid());
+    if (_tr_oc_copy(src, tmp) != 0) return -1;
+    if (rename(tmp, p) != 0) { remove(tmp); return _tr_is_file(p) ? 0 : -1; }
+    return 0;
 }
-static inline char* _tr_readdir(void* handle) {
-    _TrDir* d = (_TrDir*)handle;
-    /* Declared `-> str`, so codegen wraps the result as OWNED (rc=1) and will
-     * free it. Every path must therefore return heap memory — the end-of-dir
-     * sentinel returns strdup("") (NOT a string literal: freeing a literal
-     * corrupts the heap). */
-    if (!d || d->h == INVALID_HANDLE_VALUE) return strdup("");
-    if (d->first) { d->first = 0; return strdup(d->ffd.cFileName); }
-    if (FindNextFileA(d->h, &d->ffd)) return strdup(d->ffd.cFileName);
-    return strdup("");
+typedef struct { char* path; long long size; long long mtime; } _TrOcEnt;
+static int _tr_oc_cmp(const void* a, const void* b) {
+    long long x = ((const _TrOcEnt*)a)->mtime, y = ((const _TrOcEnt*)b)->mtime;
+    return x < y ? -1 : x > y;
 }
-static inline void _tr_closedir(void* handle) {
-    _TrDir* d = (_TrDir*)handle;
-    if (d) { if (d->h != INVALID_HANDLE_VALUE) FindClose(d->h); free(d); }
+static inline void _tr_oc_add(_TrOcEnt** v, long long* n, long long* cap, const char* path, long long size, long long mtime) {
+    if (*n == *cap) {
+        *cap = *cap ? *cap * 2 : 256;
+        _TrOcEnt* nv = (_TrOcEnt*)realloc(*v, (size_t)*cap * sizeof(_TrOcEnt)); if (!nv) _TR_OOM_ABORT();
+        *v = nv;
+    }
+    (*v)[*n].path = strdup(path); (*v)[*n].size = size; (*v)[*n].mtime = mtime; (*n)++;
 }
+/* Returns the number of entries removed, or -1 if the directory is unreadable. */
+static inline long long _tr_objcache_trim(const char* dir, long long max_bytes) {
+    _TrOcEnt* v = NULL; long long n = 0, cap = 0, total = 0, removed = 0;
+    char sub[4096], p[4096];
+#ifdef _WIN32
+    WIN32_FIND_DATAA fd, fe;
+    snprintf(p, sizeof(p), "%s\\*", dir);
+    HANDLE hd = FindFirstFileA(p, &fd); if (hd == INVALID_HANDLE_VALUE) return -1;
+    do {
+        if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) || strlen(fd.cFileName) != 2) continue;
+        snprintf(sub, sizeof(sub), "%s\\%s\\*.o", dir, fd.cFileName);
+        HANDLE he = FindFirstFileA(sub, &fe); if (he == INVALID_HANDLE_VALUE) continue;
+        do {
+            long long sz = ((long long)fe.nFileSizeHigh << 32) | fe.nFileSizeLow;
+            long long mt = ((long long)fe.ftLastWriteTime.dwHighDateTime << 32) | fe.ftLastWriteTime.dwLowDateTime;
+            snprintf(p, sizeof(p), "%s\\%s\\%s", dir, fd.cFileName, fe.cFileName);
+            _tr_oc_add(&v, &n, &cap, p, sz, mt); total += sz;
+        } while (FindNextFileA(he, &fe));
+        FindClose(he);
+    } while (FindNextFileA(hd, &fd));
+    FindClose(hd);
 #else
-#include <sys/stat.h>
-#include <sys/types.h>
-#include <dirent.h>
-static inline int  _tr_mkdir(const char* path)     { return mkdir(path, 0755) == 0 ? 0 : -1; }
-static inline int  _tr_rmdir(const char* path)     { return rmdir(path) == 0 ? 0 : -1; }
-static inline bool _tr_dir_exists(const char* path) {
-    if (!path) return false;
-    struct stat st; return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
-}
-static inline bool _tr_is_dir(const char* path)  { return _tr_dir_exists(path); }
-static inline bool _tr_is_file(const char* path) {
-    if (!path) return false;
-    struct stat st; return stat(path, &st) == 0 && S_ISREG(st.st_mode);
-}
-static inline void* _tr_opendir(const char* path)  { return (void*)opendir(path); }
-static inline char* _tr_readdir(void* handle) {
-    DIR* d = (DIR*)handle;
-    /* Always return OWNED heap (codegen frees it); strdup("") at end-of-dir,
-     * never a string literal. */
-    if (!d) return strdup("");
-    struct dirent* e = readdir(d);
-    return e ? strdup(e->d_name) : strdup("");
+    DIR* d = opendir(dir); if (!d) return -1;
+    struct dirent* e;
+    while ((e = readdir(d)) != NULL) {
+        if (strlen(e->d_name) != 2 || e->d_name[0] == '.') continue;
+        snprintf(sub, sizeof(sub), "%s/%s", dir, e->d_name);
+        DIR* d2 = opendir(sub); if (!d2) continue;
+        struct dirent* f;
+        while ((f = readdir(d2)) != NULL) {
+            size_t fl = strlen(f->d_name);
+            if (fl < 3 || strcmp(f->d_name + fl - 2, ".o") != 0) continue;
+            snprintf(p, sizeof(p), "%s/%s", sub, f->d_name);
+            struct stat st; if (stat(p, &st) != 0) continue;
+            _tr_oc_add(&v, &n, &cap, p, (long long)st.st_size, (long long)st.st_mtime);
+            total += (long long)st.st_size;
+        }
+        closedir(d2);
+    }
+    closedir(d);
+#endif
+    if (total > max_bytes) {
+        qsort(v, (size_t)n, sizeof(_TrOcEnt), _tr_oc_cmp);
+        long long goal = max_bytes / 10 * 9;
+        for (long long i = 0; i < n && total > goal; i++)
+            if (remove(v[i].path) == 0) { total -= v[i].size; removed++; }
+    }
+    for (long long i = 0; i < n; i++) free(v[i].path);
+    free(v);
+    return removed;
 }
-static inline void _tr_closedir(void* handle)       { if (handle) closedir((DIR*)handle); }
+#else
+static inline int _tr_objcache_get(const char* dir, const char* key, const char* dst) { (void)dir; (void)key; (void)dst; return -1; }
+static inline int _tr_objcache_put(const char* dir, const char* key, const char* src) { (void)dir; (void)key; (void)src; return -1; }
+static inline long long _tr_objcache_trim(const char* dir, long long max_bytes) { (void)dir; (void)max_bytes; return -1; }
 #endif
 
-/* ── File-system helpers ──────── std-tier only (remove/rename/FILE) ──── */
-#ifndef TAURARO_BARE
-static inline int  _tr_file_delete(const char* path)                     { return remove(path) == 0 ? 0 : -1; }
-static inline int  _tr_file_rename(const char* old_p, const char* new_p) { return rename(old_p, new_p) == 0 ? 0 : -1; }
-static inline long long _tr_file_size(const char* path) {
-    if (!path) return -1LL;
-    FILE* f = fopen(path, "rb"); if (!f) return -1LL;
-    fseek(f, 0, SEEK_END); long long sz = (long long)ftell(f); fclose(f); return sz;
+/* ── Process memory probes (tauraroc --time-passes) ─────────────────────
+ * _tr_mem_alloc_count: blocks allocated so far (needs -DTAURARO_MEMCOUNT).
+ * _tr_mem_heap_bytes:  bytes currently held by malloc (glibc only).
+ * _tr_mem_peak_rss:    the process's peak resident set so far.
+ * Each returns -1 where the platform or build can't tell. */
+static inline long long _tr_mem_alloc_count(void) {
+#ifdef TAURARO_MEMCOUNT
+    return (long long)_tr_total_allocs;
+#else
+    return -1;
+#endif
 }
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33)) && !defined(TAURARO_BARE)
+#include <malloc.h>
+static inline long long _tr_mem_heap_bytes(void) { struct mallinfo2 mi = mallinfo2(); return (long long)(mi.uordblks + mi.hblkhd); }
 #else
-static inline int  _tr_file_delete(const char* path)                     { (void)path; return -1; }
-static inline int  _tr_file_rename(const char* old_p, const char* new_p) { (void)old_p; (void)new_p; return -1; }
-static inline long long _tr_file_size(const char* path)                  { (void)path; return -1LL; }
+static inline long long _tr_mem_heap_bytes(void) { return -1; }
+#endif
+#if defined(TAURARO_BARE)
+static inline long long _tr_mem_peak_rss(void) { return -1; }
+#elif defined(_WIN32)
+static inline long long _tr_mem_peak_rss(void) {
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return -1;
+    return (long long)pmc.PeakWorkingSetSize;
+}
+#else
+#include <sys/resource.h>
+static inline long long _tr_mem_peak_rss(void) {
+    struct rusage ru; if (getrusage(RUSAGE_SELF, &ru) != 0) return -1;
+#ifdef __APPLE__
+    return (long long)ru.ru_maxrss;           /* bytes */
+#else
+    return (long long)ru.ru_maxrss * 1024LL;  /* KiB */
+#endif
+}
 #endif
 
 /* _tr_c_memset defined above */
@@ -3245,29 +7043,337 @@ static inline void _tr_bounds_check(long long i, size_t len) {
     }
 }
 
-#ifdef _TR_MAIN
-  #define _TR_GLOBAL
+/* Emitted instead of _tr_bounds_check at sites the compiler proved in range
+ * (mir_bce): no code, but it keeps the range fact the check used to give the
+ * C compiler, which -ftrapv loops otherwise lose (an overflow call per ++i). */
+static inline void _tr_assume_index(long long i, size_t len) {
+    if (i < 0 || (size_t)i >= len) __builtin_unreachable();
+}
+
+/* Simd[T, N]: fixed-width vectors, one C type per lane shape — tr_simd_<lane>x<N>
+ * for f64/i64 x 2/4/8 and f32/i32 x 4/8/16 (64 bytes max). Codegen only ever
+ * calls the _tr_simd_<op>_<shape> helpers below, so the emitted C is identical
+ * for both representations:
+ *   - hosted GCC/Clang: vector extensions — each op is one vector expression,
+ *     vectorized whether or not the optimizer would have found the loop;
+ *   - TAURARO_BARE, TAURARO_SIMD_SCALAR or any other compiler: a struct of N
+ *     scalars and lane loops (same results, no vector unit assumed).
+ * Compares yield a mask of the same-width integer shape (f64x4 -> i64x4), lanes
+ * all-ones (-1) for true and 0 for false; select() takes any nonzero as true. */
+#if !defined(TAURARO_BARE) && !defined(TAURARO_SIMD_SCALAR) && (defined(__GNUC__) || defined(__clang__))
+#  define _TR_SIMD_VEC 1
+#  if defined(__GNUC__) && !defined(__clang__)
+     /* Defining a helper that returns a vector wider than the enabled ISA draws
+      * a -Wpsabi note in every TU, used or not; tauraroc's own builds also pass
+      * -Wno-psabi for user functions taking Simd parameters. */
+#    pragma GCC diagnostic push
+#    pragma GCC diagnostic ignored "-Wpsabi"
+#  endif
+#  define _TR_SIMD_TYPE(NM, ET, N) typedef ET NM __attribute__((vector_size(sizeof(ET) * (N))));
+#  define _TR_SIMD_L(v, i) (v)[i]
 #else
-  #define _TR_GLOBAL extern
+#  define _TR_SIMD_TYPE(NM, ET, N) typedef struct { ET lane[N]; } NM;
+#  define _TR_SIMD_L(v, i) (v).lane[i]
 #endif
 
-/* Thread-local storage qualifier for per-thread exception stacks */
-#if defined(TAURARO_BARE) || defined(TAURARO_KERNEL)
-#  define _TR_THREAD_LOCAL
-#elif defined(_MSC_VER)
-#  define _TR_THREAD_LOCAL __declspec(thread)
-#elif defined(__GNUC__) || defined(__clang__)
-#  define _TR_THREAD_LOCAL __thread
+_TR_SIMD_TYPE(tr_simd_f64x2, double, 2)
+_TR_SIMD_TYPE(tr_simd_f64x4, double, 4)
+_TR_SIMD_TYPE(tr_simd_f64x8, double, 8)
+_TR_SIMD_TYPE(tr_simd_f32x4, float, 4)
+_TR_SIMD_TYPE(tr_simd_f32x8, float, 8)
+_TR_SIMD_TYPE(tr_simd_f32x16, float, 16)
+_TR_SIMD_TYPE(tr_simd_i64x2, long long, 2)
+_TR_SIMD_TYPE(tr_simd_i64x4, long long, 4)
+_TR_SIMD_TYPE(tr_simd_i64x8, long long, 8)
+_TR_SIMD_TYPE(tr_simd_i32x4, int, 4)
+_TR_SIMD_TYPE(tr_simd_i32x8, int, 8)
+_TR_SIMD_TYPE(tr_simd_i32x16, int, 16)
+
+/* Lane-wise binary op / compare / mask select: the only ops whose two
+ * representations differ. Everything else is written once over _TR_SIMD_L. */
+#ifdef _TR_SIMD_VEC
+#  define _TR_SIMD_BIN(S, N, NAME, OP) \
+    static inline tr_simd_##S _tr_simd_##NAME##_##S(tr_simd_##S a, tr_simd_##S b) { return a OP b; }
+#  define _TR_SIMD_CMP(S, M, N, NAME, OP) \
+    static inline tr_simd_##M _tr_simd_##NAME##_##S(tr_simd_##S a, tr_simd_##S b) { return (tr_simd_##M)(a OP b); }
+#  define _TR_SIMD_SELECT(S, M, N) \
+    static inline tr_simd_##S _tr_simd_select_##S(tr_simd_##M m, tr_simd_##S a, tr_simd_##S b) { \
+        tr_simd_##M z = {0}; tr_simd_##M k = (tr_simd_##M)(m != z); \
+        return (tr_simd_##S)(((tr_simd_##M)a & k) | ((tr_simd_##M)b & ~k)); }
+#  define _TR_SIMD_LOAD(S, ET, N) \
+    static inline tr_simd_##S _tr_simd_load_##S(const ET* p) { tr_simd_##S r; __builtin_memcpy(&r, p, sizeof r); return r; } \
+    static inline void _tr_simd_store_##S(tr_simd_##S v, ET* p) { __builtin_memcpy(p, &v, sizeof v); }
 #else
-#  define _TR_THREAD_LOCAL _Thread_local
+#  define _TR_SIMD_BIN(S, N, NAME, OP) \
+    static inline tr_simd_##S _tr_simd_##NAME##_##S(tr_simd_##S a, tr_simd_##S b) { \
+        tr_simd_##S r; for (int i = 0; i < (N); i++) { r.lane[i] = a.lane[i] OP b.lane[i]; } return r; }
+#  define _TR_SIMD_CMP(S, M, N, NAME, OP) \
+    static inline tr_simd_##M _tr_simd_##NAME##_##S(tr_simd_##S a, tr_simd_##S b) { \
+        tr_simd_##M r; for (int i = 0; i < (N); i++) { r.lane[i] = (a.lane[i] OP b.lane[i]) ? -1 : 0; } return r; }
+#  define _TR_SIMD_SELECT(S, M, N) \
+    static inline tr_simd_##S _tr_simd_select_##S(tr_simd_##M m, tr_simd_##S a, tr_simd_##S b) { \
+        tr_simd_##S r; for (int i = 0; i < (N); i++) { r.lane[i] = m.lane[i] ? a.lane[i] : b.lane[i]; } return r; }
+#  define _TR_SIMD_LOAD(S, ET, N) \
+    static inline tr_simd_##S _tr_simd_load_##S(const ET* p) { tr_simd_##S r; for (int i = 0; i < (N); i++) { r.lane[i] = p[i]; } return r; } \
+    static inline void _tr_simd_store_##S(tr_simd_##S v, ET* p) { for (int i = 0; i < (N); i++) { p[i] = v.lane[i]; } }
+#endif
+
+/* Ops shared by every shape. S = shape suffix, M = its mask shape. */
+#define _TR_SIMD_OPS(S, ET, N, M) \
+    _TR_SIMD_BIN(S, N, add, +) _TR_SIMD_BIN(S, N, sub, -) \
+    _TR_SIMD_BIN(S, N, mul, *) _TR_SIMD_BIN(S, N, div, /) \
+    _TR_SIMD_CMP(S, M, N, lt, <)  _TR_SIMD_CMP(S, M, N, le, <=) \
+    _TR_SIMD_CMP(S, M, N, gt, >)  _TR_SIMD_CMP(S, M, N, ge, >=) \
+    _TR_SIMD_CMP(S, M, N, eq, ==) _TR_SIMD_CMP(S, M, N, ne, !=) \
+    _TR_SIMD_SELECT(S, M, N) \
+    _TR_SIMD_LOAD(S, ET, N) \
+    static inline tr_simd_##S _tr_simd_splat_##S(ET x) { \
+        tr_simd_##S r; for (int i = 0; i < (N); i++) { _TR_SIMD_L(r, i) = x; } return r; } \
+    /* List[T] window [i, i+N): both ends bounds-checked, then one vector load. */ \
+    static inline tr_simd_##S _tr_simd_load_list_##S(const ET* data, size_t len, long long i) { \
+        _tr_bounds_check(i, len); _tr_bounds_check(i + (N) - 1, len); return _tr_simd_load_##S(data + i); } \
+    static inline void _tr_simd_store_list_##S(tr_simd_##S v, ET* data, size_t len, long long i) { \
+        _tr_bounds_check(i, len); _tr_bounds_check(i + (N) - 1, len); _tr_simd_store_##S(v, data + i); } \
+    static inline ET _tr_simd_get_##S(tr_simd_##S v, long long i) { _tr_bounds_check(i, (N)); return _TR_SIMD_L(v, i); } \
+    static inline tr_simd_##S _tr_simd_with_##S(tr_simd_##S v, long long i, ET x) { \
+        _tr_bounds_check(i, (N)); _TR_SIMD_L(v, i) = x; return v; } \
+    static inline tr_simd_##S _tr_simd_min_##S(tr_simd_##S a, tr_simd_##S b) { return _tr_simd_select_##S(_tr_simd_lt_##S(a, b), a, b); } \
+    static inline tr_simd_##S _tr_simd_max_##S(tr_simd_##S a, tr_simd_##S b) { return _tr_simd_select_##S(_tr_simd_gt_##S(a, b), a, b); } \
+    static inline tr_simd_##S _tr_simd_neg_##S(tr_simd_##S a) { return _tr_simd_sub_##S(_tr_simd_splat_##S(0), a); } \
+    static inline tr_simd_##S _tr_simd_abs_##S(tr_simd_##S a) { \
+        return _tr_simd_select_##S(_tr_simd_lt_##S(a, _tr_simd_splat_##S(0)), _tr_simd_neg_##S(a), a); } \
+    static inline tr_simd_##S _tr_simd_mul_add_##S(tr_simd_##S a, tr_simd_##S b, tr_simd_##S c) { \
+        return _tr_simd_add_##S(_tr_simd_mul_##S(a, b), c); } \
+    /* Horizontal reductions run in lane order, so they match the scalar loop bit-for-bit. */ \
+    static inline ET _tr_simd_sum_##S(tr_simd_##S v) { \
+        ET s = _TR_SIMD_L(v, 0); for (int i = 1; i < (N); i++) { s += _TR_SIMD_L(v, i); } return s; } \
+    static inline ET _tr_simd_reduce_min_##S(tr_simd_##S v) { \
+        ET s = _TR_SIMD_L(v, 0); for (int i = 1; i < (N); i++) { if (_TR_SIMD_L(v, i) < s) s = _TR_SIMD_L(v, i); } return s; } \
+    static inline ET _tr_simd_reduce_max_##S(tr_simd_##S v) { \
+        ET s = _TR_SIMD_L(v, 0); for (int i = 1; i < (N); i++) { if (_TR_SIMD_L(v, i) > s) s = _TR_SIMD_L(v, i); } return s; } \
+    /* Shuffles take a constant index list (codegen emits a compound literal), so \
+     * after inlining the lane moves fold to the target's permute instructions. */ \
+    static inline tr_simd_##S _tr_simd_shuffle_##S(tr_simd_##S v, const int* ix) { \
+        tr_simd_##S r; for (int i = 0; i < (N); i++) { _TR_SIMD_L(r, i) = _TR_SIMD_L(v, ix[i] & ((N) - 1)); } return r; } \
+    static inline tr_simd_##S _tr_simd_shuffle2_##S(tr_simd_##S a, tr_simd_##S b, const int* ix) { \
+        tr_simd_##S r; for (int i = 0; i < (N); i++) { int j = ix[i] & (2 * (N) - 1); \
+            _TR_SIMD_L(r, i) = j < (N) ? _TR_SIMD_L(a, j) : _TR_SIMD_L(b, j - (N)); } return r; }
+
+#define _TR_SIMD_FLOAT_OPS(S, ET, N, SQRT) \
+    static inline tr_simd_##S _tr_simd_sqrt_##S(tr_simd_##S v) { \
+        for (int i = 0; i < (N); i++) { _TR_SIMD_L(v, i) = SQRT(_TR_SIMD_L(v, i)); } return v; }
+
+#define _TR_SIMD_INT_OPS(S, N) \
+    _TR_SIMD_BIN(S, N, and, &) _TR_SIMD_BIN(S, N, or, |) _TR_SIMD_BIN(S, N, xor, ^) \
+    static inline bool _tr_simd_any_##S(tr_simd_##S m) { for (int i = 0; i < (N); i++) { if (_TR_SIMD_L(m, i)) return true; } return false; } \
+    static inline bool _tr_simd_all_##S(tr_simd_##S m) { for (int i = 0; i < (N); i++) { if (!_TR_SIMD_L(m, i)) return false; } return true; }
+
+/* Lane-count-preserving conversion, C cast semantics per lane. */
+#define _TR_SIMD_CVT(S, D, DET, N) \
+    static inline tr_simd_##D _tr_simd_cvt_##S##_##D(tr_simd_##S v) { \
+        tr_simd_##D r; for (int i = 0; i < (N); i++) { _TR_SIMD_L(r, i) = (DET)_TR_SIMD_L(v, i); } return r; }
+
+_TR_SIMD_OPS(i64x2, long long, 2, i64x2)  _TR_SIMD_INT_OPS(i64x2, 2)
+_TR_SIMD_OPS(i64x4, long long, 4, i64x4)  _TR_SIMD_INT_OPS(i64x4, 4)
+_TR_SIMD_OPS(i64x8, long long, 8, i64x8)  _TR_SIMD_INT_OPS(i64x8, 8)
+_TR_SIMD_OPS(i32x4, int, 4, i32x4)        _TR_SIMD_INT_OPS(i32x4, 4)
+_TR_SIMD_OPS(i32x8, int, 8, i32x8)        _TR_SIMD_INT_OPS(i32x8, 8)
+_TR_SIMD_OPS(i32x16, int, 16, i32x16)     _TR_SIMD_INT_OPS(i32x16, 16)
+_TR_SIMD_OPS(f64x2, double, 2, i64x2)     _TR_SIMD_FLOAT_OPS(f64x2, double, 2, __builtin_sqrt)
+_TR_SIMD_OPS(f64x4, double, 4, i64x4)     _TR_SIMD_FLOAT_OPS(f64x4, double, 4, __builtin_sqrt)
+_TR_SIMD_OPS(f64x8, double, 8, i64x8)     _TR_SIMD_FLOAT_OPS(f64x8, double, 8, __builtin_sqrt)
+_TR_SIMD_OPS(f32x4, float, 4, i32x4)      _TR_SIMD_FLOAT_OPS(f32x4, float, 4, __builtin_sqrtf)
+_TR_SIMD_OPS(f32x8, float, 8, i32x8)      _TR_SIMD_FLOAT_OPS(f32x8, float, 8, __builtin_sqrtf)
+_TR_SIMD_OPS(f32x16, float, 16, i32x16)   _TR_SIMD_FLOAT_OPS(f32x16, float, 16, __builtin_sqrtf)
+
+_TR_SIMD_CVT(f64x2, i64x2, long long, 2)  _TR_SIMD_CVT(i64x2, f64x2, double, 2)
+_TR_SIMD_CVT(f64x4, i64x4, long long, 4)  _TR_SIMD_CVT(i64x4, f64x4, double, 4)
+_TR_SIMD_CVT(f64x4, f32x4, float, 4)      _TR_SIMD_CVT(f32x4, f64x4, double, 4)
+_TR_SIMD_CVT(f64x4, i32x4, int, 4)        _TR_SIMD_CVT(i32x4, f64x4, double, 4)
+_TR_SIMD_CVT(f32x4, i32x4, int, 4)        _TR_SIMD_CVT(i32x4, f32x4, float, 4)
+_TR_SIMD_CVT(i64x4, i32x4, int, 4)        _TR_SIMD_CVT(i32x4, i64x4, long long, 4)
+_TR_SIMD_CVT(f32x4, i64x4, long long, 4)  _TR_SIMD_CVT(i64x4, f32x4, float, 4)
+_TR_SIMD_CVT(f64x8, i64x8, long long, 8)  _TR_SIMD_CVT(i64x8, f64x8, double, 8)
+_TR_SIMD_CVT(f64x8, f32x8, float, 8)      _TR_SIMD_CVT(f32x8, f64x8, double, 8)
+_TR_SIMD_CVT(f64x8, i32x8, int, 8)        _TR_SIMD_CVT(i32x8, f64x8, double, 8)
+_TR_SIMD_CVT(f32x8, i32x8, int, 8)        _TR_SIMD_CVT(i32x8, f32x8, float, 8)
+_TR_SIMD_CVT(i64x8, i32x8, int, 8)        _TR_SIMD_CVT(i32x8, i64x8, long long, 8)
+_TR_SIMD_CVT(f32x8, i64x8, long long, 8)  _TR_SIMD_CVT(i64x8, f32x8, float, 8)
+_TR_SIMD_CVT(f32x16, i32x16, int, 16)     _TR_SIMD_CVT(i32x16, f32x16, float, 16)
+
+#if defined(_TR_SIMD_VEC) && defined(__GNUC__) && !defined(__clang__)
+#  pragma GCC diagnostic pop
+#endif
+
+/* Packed bit sets (std.collections.bitset): kernels over a Vec[int] word
+ * buffer, bit i in word i >> 6 at position i & 63. BitSet keeps the bits past
+ * its length zero, so counts and scans never mask the last word. */
+static inline long long _tr_popcount64(long long x) { return __builtin_popcountll((unsigned long long)x); }
+static inline long long _tr_ctz64(long long x) { return x ? __builtin_ctzll((unsigned long long)x) : 64; }
+static inline long long _tr_clz64(long long x) { return x ? __builtin_clzll((unsigned long long)x) : 64; }
+
+static inline bool _tr_bits_test(const void* w, long long i) {
+    return (((const unsigned long long*)w)[i >> 6] >> (i & 63)) & 1;
+}
+static inline void _tr_bits_set(void* w, long long i)   { ((unsigned long long*)w)[i >> 6] |= 1ULL << (i & 63); }
+static inline void _tr_bits_clear(void* w, long long i) { ((unsigned long long*)w)[i >> 6] &= ~(1ULL << (i & 63)); }
+static inline void _tr_bits_flip(void* w, long long i)  { ((unsigned long long*)w)[i >> 6] ^= 1ULL << (i & 63); }
+
+/* Set bits in words [0, n). Without a popcnt instruction, __builtin_popcountll
+ * is a libgcc call per word; the vector path counts four words per step with
+ * the SWAR bit-sum instead. With popcnt (or AVX-512 VPOPCNTQ at -O3) the plain
+ * loop is already the fast one. */
+#if defined(_TR_SIMD_VEC) && !defined(__POPCNT__)
+typedef unsigned long long _tr_bits_u64x4 __attribute__((vector_size(32)));
+#endif
+static inline long long _tr_bits_popcount(const void* w, long long n) {
+    const unsigned long long* p = (const unsigned long long*)w;
+    long long i = 0, c = 0;
+#if defined(_TR_SIMD_VEC) && !defined(__POPCNT__)
+    _tr_bits_u64x4 acc = {0, 0, 0, 0};
+    for (; i + 4 <= n; i += 4) {
+        _tr_bits_u64x4 v;
+        __builtin_memcpy(&v, p + i, sizeof v);
+        v = v - ((v >> 1) & 0x5555555555555555ULL);
+        v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+        v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+        acc += (v * 0x0101010101010101ULL) >> 56;
+    }
+    c = (long long)(acc[0] + acc[1] + acc[2] + acc[3]);
 #endif
+    for (; i < n; i++) c += __builtin_popcountll(p[i]);
+    return c;
+}
+
+/* Set bits below bit i (i may be one past the last bit). */
+static inline long long _tr_bits_rank(const void* w, long long i) {
+    long long c = _tr_bits_popcount(w, i >> 6);
+    if (i & 63) c += __builtin_popcountll(((const unsigned long long*)w)[i >> 6] & ((1ULL << (i & 63)) - 1));
+    return c;
+}
+
+/* First set bit >= i within words [0, n), or -1. */
+static inline long long _tr_bits_next(const void* w, long long n, long long i) {
+    const unsigned long long* p = (const unsigned long long*)w;
+    if (i < 0) i = 0;
+    long long k = i >> 6;
+    if (k >= n) return -1;
+    unsigned long long x = p[k] & (~0ULL << (i & 63));
+    while (x == 0) {
+        if (++k >= n) return -1;
+        x = p[k];
+    }
+    return (k << 6) + __builtin_ctzll(x);
+}
+
+/* Bulk word ops, d op= s. `and` clears d's words past the end of s; or/xor
+ * expect d to be at least as long as s (BitSet grows it first). */
+static inline void _tr_bits_and(void* d, long long dn, const void* s, long long sn) {
+    unsigned long long* a = (unsigned long long*)d;
+    const unsigned long long* b = (const unsigned long long*)s;
+    long long n = dn < sn ? dn : sn;
+    for (long long i = 0; i < n; i++) a[i] &= b[i];
+    for (long long i = n; i < dn; i++) a[i] = 0;
+}
+static inline void _tr_bits_or(void* d, const void* s, long long n) {
+    unsigned long long* a = (unsigned long long*)d;
+    const unsigned long long* b = (const unsigned long long*)s;
+    for (long long i = 0; i < n; i++) a[i] |= b[i];
+}
+static inline void _tr_bits_xor(void* d, const void* s, long long n) {
+    unsigned long long* a = (unsigned long long*)d;
+    const unsigned long long* b = (const unsigned long long*)s;
+    for (long long i = 0; i < n; i++) a[i] ^= b[i];
+}
+static inline void _tr_bits_andnot(void* d, const void* s, long long n) {
+    unsigned long long* a = (unsigned long long*)d;
+    const unsigned long long* b = (const unsigned long long*)s;
+    for (long long i = 0; i < n; i++) a[i] &= ~b[i];
+}
+
+/* Words [0, n) to all-zero (on = false) or to the first nbits ones. */
+static inline void _tr_bits_fill(void* w, long long n, long long nbits, bool on) {
+    unsigned long long* p = (unsigned long long*)w;
+    for (long long i = 0; i < n; i++) p[i] = on ? ~0ULL : 0;
+    if (on && (nbits & 63) && n > 0) p[n - 1] = (1ULL << (nbits & 63)) - 1;
+}
 
 /* argc/argv made available to std.sys.env at runtime. */
 _TR_GLOBAL int    _tr_argc;
 _TR_GLOBAL char** _tr_argv;
 
 static inline long long _tr_get_argc(void)       { return (long long)_tr_argc; }
-static inline char*     _tr_get_arg(long long n) { return (_tr_argv && n >= 0 && (int)n < _tr_argc) ? _tr_argv[(int)n] : (char*)""; }
+/* Owned copy: the `-> str` extern result is released by its caller. */
+static inline char*     _tr_get_arg(long long n) { return _tr_str_dup_owned((_tr_argv && n >= 0 && (int)n < _tr_argc) ? _tr_argv[(int)n] : ""); }
+
+/* ── Symbol interner (tauraroc's identifier table) ──────────────────────
+ * Maps a byte string to a dense id, process-wide: id 0 is "", and the same
+ * spelling always gets the same id in every TU (the table is a _TR_GLOBAL).
+ * _tr_sym_intern_n hashes a slice in place, so the lexer can intern straight
+ * out of the source buffer without building a string per identifier.
+ * _tr_sym_name returns an owned copy (codegen frees every `-> str` result);
+ * callers that look names up repeatedly cache them by id. Not thread-safe. */
+typedef struct {
+    char**     names;   /* id -> NUL-terminated spelling */
+    long long* lens;
+    long long  count, cap;
+    long long* slots;   /* open addressing: id + 1, 0 = empty */
+    long long  nslots;  /* power of two */
+} _TrSymTab;
+_TR_GLOBAL _TrSymTab _tr_symtab;
+
+static inline unsigned long long _tr_sym_hash(const char* p, long long n) {
+    unsigned long long h = 0xCBF29CE484222325ULL;
+    for (long long i = 0; i < n; i++) { h ^= (unsigned char)p[i]; h *= 0x100000001B3ULL; }
+    return h;
+}
+static inline long long _tr_sym_add(const char* p, long long n) {
+    _TrSymTab* t = &_tr_symtab;
+    if (t->count == t->cap) {
+        t->cap = t->cap ? t->cap * 2 : 1024;
+        t->names = (char**)realloc(t->names, sizeof(char*) * (size_t)t->cap);
+        t->lens  = (long long*)realloc(t->lens, sizeof(long long) * (size_t)t->cap);
+        if (!t->names || !t->lens) _TR_OOM_ABORT();
+    }
+    char* s = (char*)malloc((size_t)n + 1); if (!s) _TR_OOM_ABORT();
+    memcpy(s, p, (size_t)n); s[n] = '\0';
+    t->names[t->count] = s; t->lens[t->count] = n;
+    return t->count++;
+}
+static inline void _tr_sym_rehash(void) {
+    _TrSymTab* t = &_tr_symtab;
+    long long ns = t->nslots ? t->nslots * 2 : 2048;
+    long long* slots = (long long*)calloc((size_t)ns, sizeof(long long)); if (!slots) _TR_OOM_ABORT();
+    for (long long id = 1; id < t->count; id++) {
+        unsigned long long i = _tr_sym_hash(t->names[id], t->lens[id]) & (unsigned long long)(ns - 1);
+        while (slots[i]) i = (i + 1) & (unsigned long long)(ns - 1);
+        slots[i] = id + 1;
+    }
+    free(t->slots); t->slots = slots; t->nslots = ns;
+}
+static inline long long _tr_sym_intern_n(const char* p, long long n) {
+    _TrSymTab* t = &_tr_symtab;
+    if (!p || n <= 0) return 0;
+    if (t->count == 0) _tr_sym_add("", 0);
+    if ((t->count + 1) * 2 > t->nslots) _tr_sym_rehash();
+    unsigned long long mask = (unsigned long long)(t->nslots - 1);
+    unsigned long long i = _tr_sym_hash(p, n) & mask;
+    for (;;) {
+        long long s = t->slots[i];
+        if (!s) break;
+        if (t->lens[s - 1] == n && memcmp(t->names[s - 1], p, (size_t)n) == 0) return s - 1;
+        i = (i + 1) & mask;
+    }
+    long long id = _tr_sym_add(p, n);
+    t->slots[i] = id + 1;
+    return id;
+}
+static inline long long _tr_sym_intern(const char* s) { return s ? _tr_sym_intern_n(s, (long long)strlen(s)) : 0; }
+static inline long long _tr_sym_count(void)         { return _tr_symtab.count; }
+static inline char* _tr_sym_name(long long id) {
+    if (id <= 0 || id >= _tr_symtab.count) return _tr_empty_heap_str();
+    return _tr_str_dup_owned(_tr_symtab.names[id]);
+}
 
 /* ── TaskGroup: spawn threads + join all (dynamic, unlimited) ────────── */
 typedef struct { _TrThread* ths; int count; int cap; } _TrTaskGroup;
@@ -3285,6 +7391,7 @@ static inline _TrThreadPool* _tr_async_pool(void) {
 static inline void _tr_async_pool_shutdown(void) {
     if (_tr_global_async_pool) { _tr_threadpool_free(_tr_global_async_pool); _tr_global_async_pool = NULL; }
 }
+
 static inline void _tr_tg_begin(void) {
     _tr_tg.cap = 16; _tr_tg.count = 0;
     _tr_tg.ths = (_TrThread*)TAURARO_ALLOC((size_t)_tr_tg.cap * sizeof(_TrThread));
@@ -3302,43 +7409,6 @@ static inline void _tr_taskgroup_wait(void) {
     _tr_tg.count = 0; _tr_tg.cap = 0;
 }
 
-/* ── Per-thread panic state (storage definitions for _TR_MAIN TU) ─── */
-#if !defined(TAURARO_BARE) && !defined(TAURARO_KERNEL)
-_TR_GLOBAL _TR_THREAD_LOCAL int     _tr_thread_has_panic_buf;
-_TR_GLOBAL _TR_THREAD_LOCAL jmp_buf _tr_thread_panic_jmpbuf;
-_TR_GLOBAL _TR_THREAD_LOCAL char*   _tr_thread_panic_message;
-#endif
-
-/* ── Exception stack (setjmp/longjmp based, per-thread) ─────────────── */
-
-#define _TR_MAX_EXC 64
-_TR_GLOBAL _TR_THREAD_LOCAL jmp_buf*  _tr_exc_bufs[_TR_MAX_EXC];
-_TR_GLOBAL _TR_THREAD_LOCAL char**    _tr_exc_msgs[_TR_MAX_EXC];
-_TR_GLOBAL _TR_THREAD_LOCAL int       _tr_exc_sp;
-
-static void _tr_exc_push(jmp_buf* b, char** m) {
-    if (_tr_exc_sp < _TR_MAX_EXC) {
-        _tr_exc_bufs[_tr_exc_sp] = b;
-        _tr_exc_msgs[_tr_exc_sp] = m;
-        _tr_exc_sp++;
-    }
-}
-static void _tr_exc_pop(void)  { if (_tr_exc_sp > 0) _tr_exc_sp--; }
-static void _tr_exc_raise(char* msg) {
-    if (_tr_exc_sp > 0) {
-        _tr_exc_sp--;
-        *_tr_exc_msgs[_tr_exc_sp] = msg;
-        longjmp(*_tr_exc_bufs[_tr_exc_sp], 1);
-    }
-    /* No user try-handler: escalate to thread panic handler if in a spawned thread */
-    if (_tr_thread_has_panic_buf) {
-        _tr_thread_panic_message = msg;
-        longjmp(_tr_thread_panic_jmpbuf, 1);
-    }
-    _TR_DIAG("Unhandled exception: %s\n", msg ? msg : "(null)");
-    _TR_TRAP();
-}
-
 /* ── String helpers ─────────────────────────────────────────────────── */
 
 static char* _tr_str_concat(const char* a, const char* b) {
@@ -3421,6 +7491,13 @@ static char* _tr_str_replace(const char* s, const char* old, const char* nw) {
     *dst='\0'; return r;
 }
 static char* _tr_int_to_str(long long n)   { char* b=(char*)TAURARO_ALLOC(32); snprintf(b,32,"%lld",n); return b; }
+/* TrStr-returning variant: same semantics, refcounted result (rc=1). */
+static inline TrStr _tr_strx_int_to_str(long long n) {
+    char b[24]; int k = snprintf(b, sizeof b, "%lld", n);
+    TrStr r = _tr_str_new((size_t)k);
+    memcpy(r.data, b, (size_t)k);
+    return r;
+}
 /* Thousands grouping for f"{n:,d}": 1234567 -> "1,234,567" (fresh heap C string). */
 static char* _tr_i64_grouped(long long v) {
     char t[24]; int n=0, neg=v<0;
@@ -3428,7 +7505,7 @@ static char* _tr_i64_grouped(long long v) {
     do { t[n++]=(char)('0'+(u%10)); u/=10; } while (u);
     char* b=(char*)TAURARO_ALLOC(40); int w=0;
     if (neg) b[w++]='-';
-    for (int i=n-1,c=0;i>=0;i--,c++) { if (c&&c%3==0) b[w++]=','; b[w++]=t[i]; }
+    for (int i=n-1;i>=0;i--) { if (i<n-1 && (i+1)%3==0) b[w++]=','; b[w++]=t[i]; }
     b[w]=0; return b;
 }
 static char* _tr_float_to_str(double n)    { char* b=(char*)TAURARO_ALLOC(32); snprintf(b,32,"%g",n);   return b; }
@@ -3449,6 +7526,121 @@ static char* _tr_float_to_c_lit(double n) {
 }
 static char* _tr_bool_to_str(bool b)       { return b ? "true" : "false"; }
 
+/* ── Typed f-string writers ─────────────────────────────────────────────────
+ * gen_fstring lowers f"..." to one _tr_str_new() sized from an upper bound
+ * (literal bytes plus a per-argument bound) and a run of these writers, so no
+ * format string is parsed at run time. Each writes at `p`, returns the number
+ * of bytes written and does not NUL-terminate. Bounds: _tr_fw_i64 20,
+ * _tr_fw_i64_grouped 27, _tr_fw_g 24, _tr_fw_fixed _tr_fw_fixed_max(). */
+static const char _tr_fw_dig2[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+static inline int _tr_fw_u64(char* p, unsigned long long u) {
+    char t[20]; int n = 20;
+    while (u >= 100) { unsigned d = (unsigned)(u % 100) * 2; u /= 100; t[--n] = _tr_fw_dig2[d + 1]; t[--n] = _tr_fw_dig2[d]; }
+    if (u >= 10) { unsigned d = (unsigned)u * 2; t[--n] = _tr_fw_dig2[d + 1]; t[--n] = _tr_fw_dig2[d]; }
+    else t[--n] = (char)('0' + u);
+    memcpy(p, t + n, (size_t)(20 - n));
+    return 20 - n;
+}
+static inline int _tr_fw_i64(char* p, long long v) {
+    if (v >= 0) return _tr_fw_u64(p, (unsigned long long)v);
+    *p = '-';
+    return 1 + _tr_fw_u64(p + 1, 0ull - (unsigned long long)v);
+}
+/* f"{n:,d}": 1234567 -> "1,234,567". */
+static inline int _tr_fw_i64_grouped(char* p, long long v) {
+    char t[20]; int w = 0;
+    if (v < 0) p[w++] = '-';
+    int n = _tr_fw_u64(t, v < 0 ? 0ull - (unsigned long long)v : (unsigned long long)v);
+    for (int i = 0; i < n; i++) {
+        if (i && (n - i) % 3 == 0) p[w++] = ',';
+        p[w++] = t[i];
+    }
+    return w;
+}
+static inline int _tr_fw_bool(char* p, bool b) {
+    if (b) { memcpy(p, "true", 4); return 4; }
+    memcpy(p, "false", 5); return 5;
+}
+static inline int _tr_fw_cstr(char* p, const char* s, size_t n) {
+    memcpy(p, s, n); return (int)n;
+}
+static const double _tr_fw_pow10[10] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+/* Digits of a value already scaled by 10^dec and rounded (r), with the point
+ * `dec` places from the right; `strip` drops trailing fractional zeros (%g). */
+static inline int _tr_fw_scaled(char* p, int neg, unsigned long long r, int dec, int strip) {
+    int w = 0;
+    if (neg) p[w++] = '-';
+    unsigned long long scale = (unsigned long long)_tr_fw_pow10[dec];
+    w += _tr_fw_u64(p + w, r / scale);
+    if (dec == 0) return w;
+    unsigned long long f = r % scale;
+    if (strip) {
+        if (f == 0) return w;
+        while (f % 10 == 0) { f /= 10; dec--; }
+    }
+    p[w++] = '.';
+    for (int i = dec - 1; i >= 0; i--) { p[w + i] = (char)('0' + f % 10); f /= 10; }
+    return w + dec;
+}
+/* Round |v| * 10^dec to an integer. Fails (returns 0) when the product is
+ * too large to be exact or too close to a half for the double product to
+ * settle the rounding; the caller then asks snprintf. */
+static inline int _tr_fw_round(double a, int dec, double limit, unsigned long long* out) {
+    double s = a * _tr_fw_pow10[dec];
+    if (!(s < limit)) return 0;
+    double fl = (double)(unsigned long long)s;
+    double fr = s - fl;
+    if (fr > 0.499 && fr < 0.501) return 0;
+    *out = (unsigned long long)fl + (fr > 0.5);
+    return 1;
+}
+/* "%g". */
+static inline int _tr_fw_g(char* p, double v) {
+    if (v == 0) { if (__builtin_signbit(v)) { memcpy(p, "-0", 2); return 2; } *p = '0'; return 1; }
+    double a = v < 0 ? -v : v;
+    if (a >= 1e-4 && a < 1e6) {
+        int x = 0;   /* decimal exponent: 10^x <= a < 10^(x+1) */
+        if (a >= 1) { while (x < 5 && a >= _tr_fw_pow10[x + 1]) x++; }
+        else { x = -1; while (x > -4 && a * _tr_fw_pow10[-x] < 1) x--; }
+        unsigned long long r;
+        /* six significant digits; a carry into a seventh changes the exponent */
+        if (_tr_fw_round(a, 5 - x, 1e12, &r) && r >= 100000ull && r < 1000000ull)
+            return _tr_fw_scaled(p, v < 0, r, 5 - x, 1);
+    }
+    char b[32];
+    int n = snprintf(b, sizeof b, "%g", v);
+    memcpy(p, b, (size_t)n);
+    return n;
+}
+static inline int _tr_fw_fixed_max(double v, int prec) {
+    return (v > -1e15 && v < 1e15 ? 20 : 330) + prec;
+}
+/* "%.<prec>f". */
+static inline int _tr_fw_fixed(char* p, double v, int prec) {
+    if (prec <= 9 && __builtin_isfinite(v)) {
+        unsigned long long r;
+        if (_tr_fw_round(v < 0 ? -v : v, prec, 1e12, &r))
+            return _tr_fw_scaled(p, __builtin_signbit(v) != 0, r, prec, 0);
+    }
+    return snprintf(p, (size_t)_tr_fw_fixed_max(v, prec) + 1, "%.*f", prec, v);
+}
+/* Pad the n bytes just written at p out to `width`: spaces after (left),
+ * zeros after any sign (zero, numbers only), else spaces before. */
+static inline int _tr_fw_pad(char* p, int n, int width, bool left, bool zero) {
+    if (n >= width) return n;
+    int pad = width - n;
+    if (left) { memset(p + n, ' ', (size_t)pad); return width; }
+    int s = (zero && n > 0 && (p[0] == '-' || p[0] == '+')) ? 1 : 0;
+    if (zero && (n == s || p[s] < '0' || p[s] > '9')) zero = false;   /* inf / nan pad with spaces */
+    if (!zero) s = 0;
+    memmove(p + s + pad, p + s, (size_t)(n - s));
+    memset(p + s, zero ? '0' : ' ', (size_t)pad);
+    return width;
+}
+
 /* _TR_AUTO_STR — convert any scalar to char* for f-string / print with unknown type.
  * Uses _Generic so __auto_type variables work without an explicit type annotation.
  * Each branch is a distinct typed helper to avoid cross-type implicit-cast errors. */
@@ -3510,6 +7702,17 @@ static inline char* _tr_str_slice(const char* s, long long start, long long end)
     return out;
 }
 
+/* Owned copy of the `n` bytes at p. Unlike _tr_str_slice it never strlen()s
+ * the source, so it is safe (and O(n)) on a view into a large or
+ * unterminated buffer such as a file mapping. */
+static inline char* _tr_str_from_view(const char* p, long long n) {
+    if (!p || n <= 0) return _tr_empty_heap_str();
+    char* out = (char*)_tr_checked_alloc(n + 1);
+    memcpy(out, p, (size_t)n);
+    out[n] = '\0';
+    return out;
+}
+
 /* ── Additional string helpers ───────────────────────────────────────── */
 static inline char* _tr_str_trim_left(const char* s) {
     if (!s) return _tr_empty_heap_str();
@@ -3676,6 +7879,57 @@ static inline int _tr_system(const char* cmd) { (void)cmd; return -1; }
 static inline int _tr_system(const char* cmd) { return system(cmd); }
 #endif
 
+/* ── Child processes (parallel build jobs) ───────────────────────────────
+ * _tr_proc_spawn starts `cmd` under the shell without waiting and returns a
+ * job id (> 0), or -1 if it could not be started. _tr_proc_wait_any blocks
+ * until one spawned job exits and returns its id, or -1 when none are left;
+ * the job's status, encoded like _tr_system's return, is then available from
+ * _tr_proc_last_status(). Without posix_spawn (Windows, bare) spawn runs the
+ * command to completion and wait_any hands the ids back in order: correct,
+ * just serial. */
+static int _tr_proc_status_last = 0;
+static inline int _tr_proc_last_status(void) { return _tr_proc_status_last; }
+#if defined(TAURARO_BARE) || defined(_WIN32)
+static long long* _tr_proc_done = NULL;   /* pairs of (id, status) */
+static long long  _tr_proc_done_n = 0, _tr_proc_done_head = 0, _tr_proc_done_cap = 0, _tr_proc_next_id = 0;
+static inline long long _tr_proc_spawn(const char* cmd) {
+    if (_tr_proc_done_n + 2 > _tr_proc_done_cap) {
+        long long nc = _tr_proc_done_cap ? _tr_proc_done_cap * 2 : 32;
+        long long* nb = (long long*)realloc(_tr_proc_done, (size_t)nc * sizeof(long long));
+        if (!nb) return -1;
+        _tr_proc_done = nb; _tr_proc_done_cap = nc;
+    }
+    long long id = ++_tr_proc_next_id;
+    _tr_proc_done[_tr_proc_done_n++] = id;
+    _tr_proc_done[_tr_proc_done_n++] = (long long)_tr_system(cmd);
+    return id;
+}
+static inline long long _tr_proc_wait_any(void) {
+    if (_tr_proc_done_head >= _tr_proc_done_n) { _tr_proc_done_head = _tr_proc_done_n = 0; return -1; }
+    long long id = _tr_proc_done[_tr_proc_done_head++];
+    _tr_proc_status_last = (int)_tr_proc_done[_tr_proc_done_head++];
+    return id;
+}
+#else
+#include <errno.h>
+#include <spawn.h>
+#include <sys/wait.h>
+extern char** environ;
+static inline long long _tr_proc_spawn(const char* cmd) {
+    pid_t pid;
+    char* argv[] = { (char*)"sh", (char*)"-c", (char*)cmd, NULL };
+    if (posix_spawn(&pid, "/bin/sh", NULL, NULL, argv, environ) != 0) return -1;
+    return (long long)pid;
+}
+static inline long long _tr_proc_wait_any(void) {
+    int st = 0; pid_t pid;
+    do { pid = waitpid(-1, &st, 0); } while (pid < 0 && errno == EINTR);
+    if (pid < 0) return -1;
+    _tr_proc_status_last = st;
+    return (long long)pid;
+}
+#endif
+
 /* ── Panic / error ───────────────────────────────────────────────────── */
 static inline void _tr_panic(const char* msg) {
     if (_tr_thread_has_panic_buf) {
@@ -3701,109 +7955,347 @@ static inline long long _tr_range(long long start, long long end, long long step
 }
 
 /* ── Dict (hash map: str → void*) ───────────────────────────────────── */
-
-typedef struct _DictNode { char* key; void* value; struct _DictNode* next; } _DictNode;
-typedef struct { _DictNode** buckets; size_t cap; size_t len; } Dict;
-
+/* Open-addressing "Swiss table". A single allocation holds `cap` control
+ * bytes, plus a mirror of the first group so a 16-byte load never wraps,
+ * followed by `cap` slots of {hash, key, value}. A control byte is EMPTY,
+ * DELETED, or H2 (the low 7 bits of a full slot's hash). A lookup compares a
+ * whole group of 16 control bytes against H2 at once (SSE2 / NEON, with a
+ * portable fallback) and only touches slots whose byte matches; the cached
+ * 64-bit hash filters the rest before strcmp. Groups are probed
+ * triangularly, starting at H1 (the hash masked to cap). Capacity is a power
+ * of two (>= 16), doubled at 7/8 load, and a rehash just moves slots by
+ * cached hash. Key bytes live in per-dict chunks (_TrDictKeys), so an insert
+ * allocates only when the current chunk is full. Keys never move: each is
+ * prefixed with its offset into its chunk, a remove drops the chunk's live
+ * count, and a chunk is freed once none of its keys are live. */
+
+#define _TR_DICT_EMPTY   ((int8_t)-128)
+#define _TR_DICT_DELETED ((int8_t)-2)
+#define _TR_DICT_GROUP   16
+
+typedef struct { uint64_t hash; char* key; void* value; } _DictSlot;
+/* A chunk of key bytes. Each key is stored as a uint32 offset back to the
+   chunk header followed by its NUL-terminated bytes. */
+typedef struct _TrDictKeys {
+    struct _TrDictKeys* prev;
+    struct _TrDictKeys* next;
+    size_t used, cap, live;
+    char   bytes[];
+} _TrDictKeys;
+typedef struct {
+    int8_t*    ctrl;    /* cap + _TR_DICT_GROUP control bytes (NULL while cap == 0) */
+    _DictSlot* slots;   /* cap slots, in the same block as ctrl */
+    size_t     cap;
+    size_t     len;
+    size_t     growth;  /* EMPTY slots that may still be filled before a rehash */
+    _TrDictKeys* keys;  /* chunk new keys are appended to; older chunks follow */
+} Dict;
+
+#define _TR_DICT_KEYS_MIN 256
+#define _TR_DICT_KEYS_MAX 4096
+/* Copy `key` (n bytes) into d's head chunk, starting a new chunk when it does
+   not fit. Chunks double from _TR_DICT_KEYS_MIN up to _TR_DICT_KEYS_MAX; a
+   longer key gets a chunk of its own. */
+static char* _tr_dict_key_put(Dict* d, const char* key, size_t n) {
+    size_t need = (sizeof(uint32_t) + n + 1 + 7) & ~(size_t)7;
+    _TrDictKeys* c = d->keys;
+    if (!c || c->cap - c->used < need) {
+        size_t cap = c ? c->cap * 2 : _TR_DICT_KEYS_MIN;
+        if (cap > _TR_DICT_KEYS_MAX) cap = _TR_DICT_KEYS_MAX;
+        if (cap < need) cap = need;
+        _TrDictKeys* nc = (_TrDictKeys*)TAURARO_ALLOC(sizeof(_TrDictKeys) + cap);
+        if (!nc) { _TR_OOM_ABORT(); }
+        _TR_MEMCOUNT_INC();
+        nc->prev = NULL; nc->next = c; nc->used = 0; nc->cap = cap; nc->live = 0;
+        if (c) {
+            c->prev = nc;
+            /* The old head only stayed alive for appends. */
+            if (c->live == 0) { nc->next = c->next; if (c->next) c->next->prev = nc; _tr_free(c); }
+        }
+        d->keys = c = nc;
+    }
+    char* at = c->bytes + c->used;
+    uint32_t off = (uint32_t)c->used;
+    memcpy(at, &off, sizeof off);
+    memcpy(at + sizeof off, key, n);
+    at[sizeof off + n] = 0;
+    c->used += need; c->live++;
+    return at + sizeof off;
+}
+/* Release one key stored by _tr_dict_key_put(). */
+static void _tr_dict_key_drop(Dict* d, char* key) {
+    uint32_t off; memcpy(&off, key - sizeof off, sizeof off);
+    _TrDictKeys* c = (_TrDictKeys*)(void*)(key - sizeof off - off - offsetof(_TrDictKeys, bytes));
+    if (--c->live) return;
+    if (c == d->keys) { c->used = 0; return; }
+    if (c->prev) c->prev->next = c->next;
+    if (c->next) c->next->prev = c->prev;
+    _tr_free(c);
+}
+static void _tr_dict_keys_free(Dict* d) {
+    for (_TrDictKeys* c = d->keys; c; ) { _TrDictKeys* n = c->next; _tr_free(c); c = n; }
+    d->keys = NULL;
+}
+
+/* 64-bit string hash, 8 bytes per step (multiply-xorshift mixing). */
+static inline uint64_t _tr_dict_hash64(const char* k, size_t n) {
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ ((uint64_t)n * 0xC2B2AE3D27D4EB4Full);
+    while (n >= 8) {
+        uint64_t w; memcpy(&w, k, 8);
+        h = (h ^ w) * 0xBF58476D1CE4E5B9ull; h ^= h >> 31;
+        k += 8; n -= 8;
+    }
+    if (n) {
+        uint64_t w = 0; memcpy(&w, k, n);
+        h = (h ^ w) * 0xBF58476D1CE4E5B9ull; h ^= h >> 31;
+    }
+    h *= 0x94D049BB133111EBull; h ^= h >> 29;
+    return h;
+}
+/* Bucket index for the codegen'd typed dicts (Dict_<k>_<V>), whose `cap` is
+   always a power of two. */
 static size_t _dict_hash(const char* k, size_t cap) {
-    size_t h=5381; unsigned char c;
-    while ((c=(unsigned char)*k++)) h=h*33+c;
-    return h%cap;
+    return (size_t)_tr_dict_hash64(k, strlen(k)) & (cap - 1);
+}
+
+/* Group match: a bitmask with one hit per matching control byte. Bit index
+   >> _TR_DICT_SHIFT is the byte offset within the group. */
+#if !defined(TAURARO_BARE) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+typedef uint32_t _TrDictMask;
+#define _TR_DICT_SHIFT 0
+static inline _TrDictMask _tr_dict_match(const int8_t* g, int8_t h2) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(const void*)g);
+    return (_TrDictMask)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(h2)));
+}
+/* EMPTY and DELETED are the only negative control bytes. */
+static inline _TrDictMask _tr_dict_match_free(const int8_t* g) {
+    return (_TrDictMask)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(const void*)g));
+}
+#elif !defined(TAURARO_BARE) && (defined(__ARM_NEON) || defined(__aarch64__))
+#include <arm_neon.h>
+typedef uint64_t _TrDictMask;
+#define _TR_DICT_SHIFT 2
+/* Narrow a byte-wise 0x00/0xFF compare to 4 bits per byte, keep one bit each. */
+static inline _TrDictMask _tr_dict_nibbles(uint8x16_t eq) {
+    uint8x8_t n = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(n), 0) & 0x8888888888888888ull;
+}
+static inline _TrDictMask _tr_dict_match(const int8_t* g, int8_t h2) {
+    return _tr_dict_nibbles(vceqq_s8(vld1q_s8(g), vdupq_n_s8(h2)));
+}
+static inline _TrDictMask _tr_dict_match_free(const int8_t* g) {
+    return _tr_dict_nibbles(vcltq_s8(vld1q_s8(g), vdupq_n_s8(0)));
+}
+#else
+typedef uint32_t _TrDictMask;
+#define _TR_DICT_SHIFT 0
+static inline _TrDictMask _tr_dict_match(const int8_t* g, int8_t h2) {
+    _TrDictMask m = 0;
+    for (int i = 0; i < _TR_DICT_GROUP; i++) if (g[i] == h2) m |= (_TrDictMask)1u << i;
+    return m;
+}
+static inline _TrDictMask _tr_dict_match_free(const int8_t* g) {
+    _TrDictMask m = 0;
+    for (int i = 0; i < _TR_DICT_GROUP; i++) if (g[i] < 0) m |= (_TrDictMask)1u << i;
+    return m;
+}
+#endif
+static inline _TrDictMask _tr_dict_match_empty(const int8_t* g) { return _tr_dict_match(g, _TR_DICT_EMPTY); }
+static inline unsigned _tr_dict_lowbit(_TrDictMask m) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctzll((unsigned long long)m) >> _TR_DICT_SHIFT;
+#else
+    unsigned i = 0; while (!(m & 1)) { m >>= 1; i++; } return i >> _TR_DICT_SHIFT;
+#endif
+}
+
+static inline int8_t _tr_dict_h2(uint64_t h) { return (int8_t)(h & 0x7F); }
+/* Set control byte i, keeping the mirrored tail in sync. */
+static inline void _tr_dict_set_ctrl(Dict* d, size_t i, int8_t c) {
+    d->ctrl[i] = c;
+    if (i < _TR_DICT_GROUP) d->ctrl[d->cap + i] = c;
+}
+/* Allocate the ctrl+slots block for `cap` (power of two, >= 16) slots. */
+static void _tr_dict_alloc(Dict* d, size_t cap) {
+    size_t cbytes = (cap + _TR_DICT_GROUP + 7) & ~(size_t)7;
+    char* blk = (char*)TAURARO_ALLOC(cbytes + cap * sizeof(_DictSlot));
+    if (!blk) { _TR_OOM_ABORT(); }
+    _TR_MEMCOUNT_INC();
+    memset(blk, (unsigned char)_TR_DICT_EMPTY, cap + _TR_DICT_GROUP);
+    d->ctrl = (int8_t*)blk;
+    d->slots = (_DictSlot*)(void*)(blk + cbytes);
+    d->cap = cap;
+    d->growth = cap - cap / 8;
+}
+/* First EMPTY/DELETED slot on h's probe sequence. */
+static size_t _tr_dict_find_free(Dict* d, uint64_t h) {
+    size_t mask = d->cap - 1, pos = (size_t)(h >> 7) & mask, step = 0;
+    for (;;) {
+        _TrDictMask m = _tr_dict_match_free(d->ctrl + pos);
+        if (m) return (pos + _tr_dict_lowbit(m)) & mask;
+        step += _TR_DICT_GROUP;
+        pos = (pos + step) & mask;
+    }
+}
+/* Resize to `cap` slots, moving every full slot by its cached hash. Also
+   used at the same size to purge DELETED markers. */
+static void _tr_dict_rehash(Dict* d, size_t cap) {
+    int8_t* octrl = d->ctrl; _DictSlot* oslots = d->slots; size_t ocap = d->cap;
+    _tr_dict_alloc(d, cap);
+    for (size_t i = 0; i < ocap; i++) {
+        if (octrl[i] < 0) continue;
+        size_t j = _tr_dict_find_free(d, oslots[i].hash);
+        _tr_dict_set_ctrl(d, j, octrl[i]);
+        d->slots[j] = oslots[i];
+    }
+    d->growth -= d->len;
+    _tr_free(octrl);
+}
+/* Slot index of `key` (hash h), or -1. */
+static inline long long _tr_dict_find(Dict* d, const char* key, uint64_t h) {
+    size_t mask = d->cap - 1, pos = (size_t)(h >> 7) & mask, step = 0;
+    int8_t h2 = _tr_dict_h2(h);
+    for (;;) {
+        const int8_t* g = d->ctrl + pos;
+        _TrDictMask m = _tr_dict_match(g, h2);
+        while (m) {
+            size_t i = (pos + _tr_dict_lowbit(m)) & mask;
+            if (d->slots[i].hash == h && strcmp(d->slots[i].key, key) == 0) return (long long)i;
+            m &= m - 1;
+        }
+        if (_tr_dict_match_empty(g)) return -1;
+        step += _TR_DICT_GROUP;
+        pos = (pos + step) & mask;
+    }
+}
+static size_t _tr_dict_cap_for(size_t n) {
+    size_t cap = 16;
+    while (cap - cap / 8 < n) cap <<= 1;
+    return cap;
 }
+
 static Dict* Dict_new(void) {
     Dict* d=(Dict*)malloc(sizeof(Dict)); _TR_MEMCOUNT_INC(); _TR_MEMCOUNT_DICT_INC();
-    /* Lazy buckets: an empty dict allocates no bucket array (cap=0). The 16-slot
-       array is created on first insert. Saves one alloc per dict that stays
-       empty - e.g. an HttpRequest's headers/params maps when a handler reads no
+    /* Lazy table: an empty dict allocates no ctrl/slot block (cap=0). It is
+       created on first insert. Saves one alloc per dict that stays empty -
+       e.g. an HttpRequest's headers/params maps when a handler reads no
        headers and the route binds no params. All accessors below guard cap==0. */
-    d->cap=0; d->len=0; d->buckets=NULL;
+    d->cap=0; d->len=0; d->growth=0; d->ctrl=NULL; d->slots=NULL; d->keys=NULL;
     return d;
 }
+/* Pre-size for `n` entries (no-op when already large enough). */
+static void Dict_reserve(Dict* d, size_t n) {
+    if (!d || n == 0) return;
+    size_t cap = _tr_dict_cap_for(n);
+    if (d->cap == 0) _tr_dict_alloc(d, cap);
+    else if (cap > d->cap) _tr_dict_rehash(d, cap);
+}
 static void Dict_set(Dict* d, char* key, void* val) {
     if (!d || !key) return;
-    if (d->cap==0) { d->cap=16; d->buckets=(_DictNode**)TAURARO_CALLOC(16,sizeof(_DictNode*)); _TR_MEMCOUNT_INC(); }
-    size_t i=_dict_hash(key,d->cap);
-    _DictNode* n=d->buckets[i];
-    while (n) { if (strcmp(n->key,key)==0) { n->value=val; return; } n=n->next; }
-    _DictNode* nd=(_DictNode*)malloc(sizeof(_DictNode)); _TR_MEMCOUNT_INC();
-    nd->key=strdup(key); _TR_MEMCOUNT_INC(); nd->value=val; nd->next=d->buckets[i]; d->buckets[i]=nd; d->len++;
+    if (d->cap==0) _tr_dict_alloc(d, 16);
+    size_t n = strlen(key);
+    uint64_t h = _tr_dict_hash64(key, n);
+    long long at = _tr_dict_find(d, key, h);
+    if (at >= 0) { d->slots[at].value = val; return; }
+    size_t i = _tr_dict_find_free(d, h);
+    if (d->growth == 0 && d->ctrl[i] == _TR_DICT_EMPTY) {
+        /* Full enough: double, or just purge tombstones when at most half
+           the slots are live. */
+        _tr_dict_rehash(d, d->len * 2 < d->cap ? d->cap : d->cap * 2);
+        i = _tr_dict_find_free(d, h);
+    }
+    if (d->ctrl[i] == _TR_DICT_EMPTY) d->growth--;
+    _tr_dict_set_ctrl(d, i, _tr_dict_h2(h));
+    d->slots[i].hash = h;
+    d->slots[i].key = _tr_dict_key_put(d, key, n);
+    d->slots[i].value = val;
+    d->len++;
 }
 static void*     Dict_get(Dict* d, char* key) {
     if (!d||!key||d->cap==0) return NULL;
-    size_t i=_dict_hash(key,d->cap);
-    _DictNode* n=d->buckets[i];
-    while (n) { if (strcmp(n->key,key)==0) return n->value; n=n->next; }
-    return NULL;
+    long long i = _tr_dict_find(d, key, _tr_dict_hash64(key, strlen(key)));
+    return i >= 0 ? d->slots[i].value : NULL;
+}
+/* Occupancy, not the value: a stored 0/false/none is still present. */
+static bool      Dict_has(Dict* d, char* key) {
+    if (!d||!key||d->cap==0) return false;
+    return _tr_dict_find(d, key, _tr_dict_hash64(key, strlen(key))) >= 0;
 }
-static bool      Dict_has(Dict* d, char* key) { return Dict_get(d,key)!=NULL; }
 static long long Dict_len(Dict* d)  { return d?(long long)d->len:0LL; }
 static void      Dict_remove(Dict* d, char* key) {
     if (!d||!key||d->cap==0) return;
-    size_t i=_dict_hash(key,d->cap);
-    _DictNode* n=d->buckets[i]; _DictNode* prev=NULL;
-    while (n) {
-        if (strcmp(n->key,key)==0) {
-            if (prev) prev->next=n->next; else d->buckets[i]=n->next;
-            if (n->key) _tr_free(n->key); _tr_free(n);
-            if (d->len>0) d->len--;
-            return;
-        }
-        prev=n; n=n->next;
-    }
-}
+    long long i = _tr_dict_find(d, key, _tr_dict_hash64(key, strlen(key)));
+    if (i < 0) return;
+    /* The slot may become EMPTY again (instead of a DELETED tombstone) when
+       the run of non-EMPTY bytes around it is shorter than a group: then
+       every 16-byte probe window covering it also holds an EMPTY, so no
+       probe sequence ever continued past it. */
+    size_t mask = d->cap - 1, run = 1;
+    for (size_t k = 1; k < _TR_DICT_GROUP && d->ctrl[((size_t)i + k) & mask] != _TR_DICT_EMPTY; k++) run++;
+    for (size_t k = 1; k < _TR_DICT_GROUP && d->ctrl[((size_t)i - k) & mask] != _TR_DICT_EMPTY; k++) run++;
+    int reuse = run < _TR_DICT_GROUP;
+    _tr_dict_set_ctrl(d, (size_t)i, reuse ? _TR_DICT_EMPTY : _TR_DICT_DELETED);
+    if (reuse) d->growth++;
+    _tr_dict_key_drop(d, d->slots[i].key);
+    d->slots[i].key = NULL; d->slots[i].value = NULL;
+    if (d->len>0) d->len--;
+}
+/* Iterate full slots: `for (size_t i = 0; i < d->cap; i++) if (_TR_DICT_FULL(d, i))`. */
+#define _TR_DICT_FULL(d, i) ((d)->ctrl[(i)] >= 0)
 static void      Dict_free(Dict* d) {
     if (!d) return;
     _TR_MEMCOUNT_DICT_DEC();
-    for (size_t i=0; i<d->cap; i++) {
-        _DictNode* n=d->buckets[i];
-        while (n) { _DictNode* nx=n->next; if(n->key) _tr_free(n->key); _tr_free(n); n=nx; }
-    }
-    _tr_free(d->buckets); _tr_free(d);
+    _tr_dict_keys_free(d);
+    _tr_free(d->ctrl); _tr_free(d);
 }
 /* Like Dict_free(), but for Dict[K,str]/Map[K,str] whose values are
    _tr_str_box(TrStr)-allocated boxes (#54): unbox+release the TrStr, then
-   free the box itself, before freeing the node/key/buckets/struct. */
+   free the box itself, before freeing the keys/table/struct. */
 static void      Dict_free_strval(Dict* d) {
     if (!d) return;
     _TR_MEMCOUNT_DICT_DEC();
     for (size_t i=0; i<d->cap; i++) {
-        _DictNode* n=d->buckets[i];
-        while (n) {
-            _DictNode* nx=n->next;
-            if(n->key) _tr_free(n->key);
-            if(n->value) { _tr_str_release(*(TrStr*)n->value); _tr_free(n->value); }
-            _tr_free(n);
-            n=nx;
-        }
+        if (!_TR_DICT_FULL(d, i)) continue;
+        _DictSlot* s = &d->slots[i];
+        if (s->value) { _tr_str_release(*(TrStr*)s->value); _tr_free(s->value); }
     }
-    _tr_free(d->buckets); _tr_free(d);
+    _tr_dict_keys_free(d);
+    _tr_free(d->ctrl); _tr_free(d);
 }
 /* Dict[str, HeapClass]: values are owned refcounted instances (void*); the dict
-   co-owns each (insert-retain), so release each before freeing nodes/keys/struct. */
+   co-owns each (insert-retain), so release each before freeing keys/table/struct. */
 static void      Dict_free_objval(Dict* d, void(*drop)(void*)) {
     if (!d) return;
     _TR_MEMCOUNT_DICT_DEC();
     for (size_t i=0; i<d->cap; i++) {
-        _DictNode* n=d->buckets[i];
-        while (n) { _DictNode* nx=n->next; if(n->key) _tr_free(n->key); _tr_obj_release(n->value, drop); _tr_free(n); n=nx; }
+        if (!_TR_DICT_FULL(d, i)) continue;
+        _tr_obj_release(d->slots[i].value, drop);
     }
-    _tr_free(d->buckets); _tr_free(d);
+    _tr_dict_keys_free(d);
+    _tr_free(d->ctrl); _tr_free(d);
 }
 /* Free all entries (and their key strings) but keep the Dict struct itself
    alive and reusable - used by clear(), unlike Dict_free() which also frees
-   the struct (would otherwise leave m a dangling pointer after clear()). */
+   the struct (would otherwise leave m a dangling pointer after clear()).
+   The table keeps its capacity. */
 static void      Dict_clear_entries(Dict* d) {
     if (!d) return;
-    for (size_t i=0; i<d->cap; i++) {
-        _DictNode* n=d->buckets[i];
-        while (n) { _DictNode* nx=n->next; if(n->key) _tr_free(n->key); _tr_free(n); n=nx; }
-        d->buckets[i]=NULL;
+    _tr_dict_keys_free(d);
+    if (d->cap) {
+        memset(d->ctrl, (unsigned char)_TR_DICT_EMPTY, d->cap + _TR_DICT_GROUP);
+        d->growth = d->cap - d->cap / 8;
     }
     d->len=0;
 }
 
 typedef Dict TrMap;
-static inline TrMap* _tr_dict_new(long long cap) { (void)cap; return Dict_new(); }
+static inline TrMap* _tr_dict_new(long long cap) {
+    Dict* d = Dict_new();
+    /* Hints up to the lazy default are free; larger ones pre-size the table. */
+    if (cap > 16) Dict_reserve(d, (size_t)cap);
+    return d;
+}
 static inline void   _tr_dict_set_impl(TrMap* d, char* k, void* v) { if(d) Dict_set(d,k,v); }
 /* Macro: casts any type (pointer, bool, int) safely through uintptr_t to void* */
 #define _tr_dict_set(d, k, v) _tr_dict_set_impl((d), (k), (void*)(uintptr_t)(v))
@@ -3816,45 +8308,115 @@ static inline long long _tr_dict_len(TrMap* d) { return Dict_len(d); }
 /* Map.update / Map.clear / Set[T] defined after List_str below */
 
 /* ── Int-keyed Dict (Dict[int, V]) ────────────────────────────────────── */
-typedef struct _TrIDictNode { long long key; void* value; struct _TrIDictNode* next; } _TrIDictNode;
-typedef struct { _TrIDictNode** buckets; size_t cap; size_t len; } TrIDict;
+/* Open addressing over inline {key, value} slots: fibonacci hash (the top
+   bits of k * 2^64/phi) picks the home slot, linear probing resolves
+   collisions, and the table doubles past 3/4 load. Deletion shifts the rest
+   of the probe run back, so there are no tombstones and a lookup stops at
+   the first empty slot. INT64_MIN marks an empty slot; a real INT64_MIN key
+   lives out of line in min_value. Set[int] (_TrISet) and Set_i64 share it. */
+#define _TR_IDICT_EMPTY  ((long long)INT64_MIN)
+#define _TR_IDICT_MIN_CAP 16
+typedef struct { long long key; void* value; } _TrISlot;
+typedef struct {
+    _TrISlot* slots; size_t cap; size_t len;
+    unsigned shift;                 /* 64 - log2(cap) */
+    bool has_min; void* min_value;  /* the INT64_MIN key, if present */
+} TrIDict;
+static inline size_t _tr_idict_home(const TrIDict* d, long long k) {
+    return (size_t)(((unsigned long long)k * 0x9E3779B97F4A7C15ULL) >> d->shift);
+}
+static inline void _tr_idict_alloc(TrIDict* d, size_t cap) {
+    unsigned lg = 0;
+    while (((size_t)1 << lg) < cap) lg++;
+    d->cap = (size_t)1 << lg;
+    d->shift = 64u - lg;
+    d->slots = (_TrISlot*)_tr_c_calloc(d->cap, sizeof(_TrISlot));
+    for (size_t i = 0; i < d->cap; i++) d->slots[i].key = _TR_IDICT_EMPTY;
+}
 static inline TrIDict* _tr_idict_new(long long cap_hint) {
-    size_t cap = (size_t)(cap_hint > 8 ? cap_hint : 8);
-    TrIDict* d = (TrIDict*)calloc(1, sizeof(TrIDict));
-    d->buckets = (_TrIDictNode**)TAURARO_CALLOC(cap, sizeof(_TrIDictNode*));
-    d->cap = cap; d->len = 0; return d;
+    TrIDict* d = (TrIDict*)_tr_c_calloc(1, sizeof(TrIDict));
+    /* Room for cap_hint keys without a rehash. */
+    size_t want = cap_hint > 0 ? (size_t)cap_hint + (size_t)cap_hint / 3 + 1 : 0;
+    _tr_idict_alloc(d, want > _TR_IDICT_MIN_CAP ? want : _TR_IDICT_MIN_CAP);
+    return d;
+}
+static void _tr_idict_grow(TrIDict* d) {
+    _TrISlot* old = d->slots; size_t ocap = d->cap;
+    _tr_idict_alloc(d, ocap * 2);
+    size_t mask = d->cap - 1;
+    for (size_t i = 0; i < ocap; i++) {
+        if (old[i].key == _TR_IDICT_EMPTY) continue;
+        size_t j = _tr_idict_home(d, old[i].key);
+        while (d->slots[j].key != _TR_IDICT_EMPTY) j = (j + 1) & mask;
+        d->slots[j] = old[i];
+    }
+    _tr_free(old);
+}
+/* Slot index of k, or -1. */
+static inline long long _tr_idict_find(const TrIDict* d, long long k) {
+    size_t mask = d->cap - 1, i = _tr_idict_home(d, k);
+    for (;;) {
+        long long sk = d->slots[i].key;
+        if (sk == k) return (long long)i;
+        if (sk == _TR_IDICT_EMPTY) return -1;
+        i = (i + 1) & mask;
+    }
 }
 static inline void _tr_idict_set_impl(TrIDict* d, long long k, void* v) {
     if (!d) return;
-    size_t idx = (size_t)((unsigned long long)k % d->cap);
-    _TrIDictNode* n = d->buckets[idx];
-    while (n) { if (n->key == k) { n->value = v; return; } n = n->next; }
-    _TrIDictNode* nd = (_TrIDictNode*)malloc(sizeof(_TrIDictNode));
-    nd->key = k; nd->value = v; nd->next = d->buckets[idx];
-    d->buckets[idx] = nd; d->len++;
+    if (k == _TR_IDICT_EMPTY) {
+        if (!d->has_min) { d->has_min = true; d->len++; }
+        d->min_value = v; return;
+    }
+    size_t mask = d->cap - 1, i = _tr_idict_home(d, k);
+    for (;;) {
+        long long sk = d->slots[i].key;
+        if (sk == k) { d->slots[i].value = v; return; }
+        if (sk == _TR_IDICT_EMPTY) break;
+        i = (i + 1) & mask;
+    }
+    if ((d->len + 1) * 4 > d->cap * 3) {
+        _tr_idict_grow(d);
+        mask = d->cap - 1; i = _tr_idict_home(d, k);
+        while (d->slots[i].key != _TR_IDICT_EMPTY) i = (i + 1) & mask;
+    }
+    d->slots[i].key = k; d->slots[i].value = v; d->len++;
 }
 #define _tr_idict_set(d, k, v) _tr_idict_set_impl((d), (k), (void*)(uintptr_t)(v))
 static inline void* _tr_idict_get(TrIDict* d, long long k) {
     if (!d) return NULL;
-    size_t idx = (size_t)((unsigned long long)k % d->cap);
-    _TrIDictNode* n = d->buckets[idx];
-    while (n) { if (n->key == k) return n->value; n = n->next; }
-    return NULL;
+    if (k == _TR_IDICT_EMPTY) return d->has_min ? d->min_value : NULL;
+    long long i = _tr_idict_find(d, k);
+    return i >= 0 ? d->slots[i].value : NULL;
+}
+static inline bool   _tr_idict_contains(TrIDict* d, long long k) {
+    if (!d) return false;
+    if (k == _TR_IDICT_EMPTY) return d->has_min;
+    return _tr_idict_find(d, k) >= 0;
 }
-static inline bool   _tr_idict_contains(TrIDict* d, long long k) { return _tr_idict_get(d,k) != NULL; }
 static inline void   _tr_idict_remove(TrIDict* d, long long k) {
     if (!d) return;
-    size_t idx = (size_t)((unsigned long long)k % d->cap);
-    _TrIDictNode* n = d->buckets[idx]; _TrIDictNode* prev = NULL;
-    while (n) {
-        if (n->key == k) {
-            if (prev) prev->next = n->next; else d->buckets[idx] = n->next;
-            free(n);
-            if (d->len > 0) d->len--;
-            return;
+    if (k == _TR_IDICT_EMPTY) {
+        if (d->has_min) { d->has_min = false; d->min_value = NULL; d->len--; }
+        return;
+    }
+    long long f = _tr_idict_find(d, k);
+    if (f < 0) return;
+    /* Backward shift: pull each later entry of the run into the hole unless
+       its home lies cyclically in (hole, j], where it already sits. */
+    size_t mask = d->cap - 1, hole = (size_t)f, j = hole;
+    for (;;) {
+        j = (j + 1) & mask;
+        long long sk = d->slots[j].key;
+        if (sk == _TR_IDICT_EMPTY) break;
+        size_t h = _tr_idict_home(d, sk);
+        if (((j - h) & mask) >= ((j - hole) & mask)) {
+            d->slots[hole] = d->slots[j];
+            hole = j;
         }
-        prev = n; n = n->next;
     }
+    d->slots[hole].key = _TR_IDICT_EMPTY; d->slots[hole].value = NULL;
+    d->len--;
 }
 static inline long long _tr_idict_len(TrIDict* d) { return d ? (long long)d->len : 0LL; }
 
@@ -4007,40 +8569,36 @@ static inline List_TrStr* _tr_dict_keys(TrMap* d) {
     List_TrStr* out = List_TrStr_new();
     if (!d) return out;
     for (size_t i = 0; i < d->cap; i++) {
-        _DictNode* n = d->buckets[i];
+        _DictSlot* n = &d->slots[i];
         /* strdup the key: the returned TrStr owns its own buffer (rc=1), so
            freeing the list (List_TrStr_free -> _tr_str_release) doesn't free
            the dict's own key storage (which would dangle d's keys -> a later
            d.get() / d[key] would miss). */
-        while (n) { if (n->key && n->value) List_TrStr_append_owned(out, _tr_str_wrap(strdup(n->key))); n = n->next; }
+        if (_TR_DICT_FULL(d, i)) List_TrStr_append_owned(out, _tr_str_wrap(strdup(n->key)));
     }
     return out;
 }
 static inline List_ptr* _tr_dict_values(TrMap* d) {
     List_ptr* out = List_ptr_new();
     if (!d) return out;
-    for (size_t i = 0; i < d->cap; i++) {
-        _DictNode* n = d->buckets[i];
-        while (n) { if (n->key && n->value) List_ptr_append(out, n->value); n = n->next; }
-    }
+    for (size_t i = 0; i < d->cap; i++)
+        if (_TR_DICT_FULL(d, i)) List_ptr_append(out, d->slots[i].value);
     return out;
 }
 static inline List_i64* _tr_idict_keys(TrIDict* d) {
     List_i64* out = List_i64_new();
-    if (!d) return out;
-    for (size_t i = 0; i < d->cap; i++) {
-        _TrIDictNode* n = d->buckets[i];
-        while (n) { if (n->value) List_i64_append(out, n->key); n = n->next; }
-    }
+    if (!d) return out;
+    for (size_t i = 0; i < d->cap; i++)
+        if (d->slots[i].key != _TR_IDICT_EMPTY) List_i64_append(out, d->slots[i].key);
+    if (d->has_min) List_i64_append(out, _TR_IDICT_EMPTY);
     return out;
 }
 static inline List_ptr* _tr_idict_values(TrIDict* d) {
     List_ptr* out = List_ptr_new();
     if (!d) return out;
-    for (size_t i = 0; i < d->cap; i++) {
-        _TrIDictNode* n = d->buckets[i];
-        while (n) { if (n->value) List_ptr_append(out, n->value); n = n->next; }
-    }
+    for (size_t i = 0; i < d->cap; i++)
+        if (d->slots[i].key != _TR_IDICT_EMPTY) List_ptr_append(out, d->slots[i].value);
+    if (d->has_min) List_ptr_append(out, d->min_value);
     return out;
 }
 /* values() for Dict[K,str]/Map[K,str]: unbox+retain each boxed TrStr value
@@ -4049,19 +8607,16 @@ static inline List_ptr* _tr_idict_values(TrIDict* d) {
 static inline List_TrStr* _tr_dict_values_strval(TrMap* d) {
     List_TrStr* out = List_TrStr_new();
     if (!d) return out;
-    for (size_t i = 0; i < d->cap; i++) {
-        _DictNode* n = d->buckets[i];
-        while (n) { if (n->key && n->value) List_TrStr_append(out, _tr_str_unbox(n->value)); n = n->next; }
-    }
+    for (size_t i = 0; i < d->cap; i++)
+        if (_TR_DICT_FULL(d, i) && d->slots[i].value) List_TrStr_append(out, _tr_str_unbox(d->slots[i].value));
     return out;
 }
 static inline List_TrStr* _tr_idict_values_strval(TrIDict* d) {
     List_TrStr* out = List_TrStr_new();
     if (!d) return out;
-    for (size_t i = 0; i < d->cap; i++) {
-        _TrIDictNode* n = d->buckets[i];
-        while (n) { if (n->value) List_TrStr_append(out, _tr_str_unbox(n->value)); n = n->next; }
-    }
+    for (size_t i = 0; i < d->cap; i++)
+        if (d->slots[i].key != _TR_IDICT_EMPTY && d->slots[i].value) List_TrStr_append(out, _tr_str_unbox(d->slots[i].value));
+    if (d->has_min && d->min_value) List_TrStr_append(out, _tr_str_unbox(d->min_value));
     return out;
 }
 
@@ -4073,25 +8628,23 @@ static inline List_ptr* _tr_dict_items(TrMap* d) {
     List_ptr* out = List_ptr_new();
     if (!d) return out;
     for (size_t i = 0; i < d->cap; i++) {
-        _DictNode* n = d->buckets[i];
-        while (n) {
-            TrKVPair* p = (TrKVPair*)malloc(sizeof(TrKVPair));
-            p->key = n->key; p->val = n->value;
-            List_ptr_append(out, p); n = n->next;
-        }
+        if (!_TR_DICT_FULL(d, i)) continue;
+        TrKVPair* p = (TrKVPair*)malloc(sizeof(TrKVPair));
+        p->key = d->slots[i].key; p->val = d->slots[i].value;
+        List_ptr_append(out, p);
     }
     return out;
 }
 static inline List_ptr* _tr_idict_items(TrIDict* d) {
     List_ptr* out = List_ptr_new();
     if (!d) return out;
-    for (size_t i = 0; i < d->cap; i++) {
-        _TrIDictNode* n = d->buckets[i];
-        while (n) {
-            TrIKVPair* p = (TrIKVPair*)malloc(sizeof(TrIKVPair));
-            p->key = n->key; p->val = n->value;
-            List_ptr_append(out, p); n = n->next;
-        }
+    for (size_t i = 0; i <= d->cap; i++) {
+        long long k; void* v;
+        if (i < d->cap) { if (d->slots[i].key == _TR_IDICT_EMPTY) continue; k = d->slots[i].key; v = d->slots[i].value; }
+        else { if (!d->has_min) break; k = _TR_IDICT_EMPTY; v = d->min_value; }
+        TrIKVPair* p = (TrIKVPair*)malloc(sizeof(TrIKVPair));
+        p->key = k; p->val = v;
+        List_ptr_append(out, p);
     }
     return out;
 }
@@ -4116,6 +8669,728 @@ typedef struct { uint32_t* data; size_t len; size_t capacity; } List_u32;
 static inline List_u32* List_u32_new(void) { List_u32* l=(List_u32*)malloc(sizeof(List_u32)); l->data=(uint32_t*)malloc(sizeof(uint32_t)*8); l->len=0; l->capacity=8; return l; }
 static inline void List_u32_append(List_u32* l, uint32_t val) { if(l->len==l->capacity){ l->capacity*=2; l->data=(uint32_t*)realloc(l->data,sizeof(uint32_t)*l->capacity); } l->data[l->len++]=val; }
 static inline void List_u32_free(List_u32* l) { if(l){ _tr_free(l->data); _tr_free(l); } }
+/* ── Fused iterator pipelines (std.iter.pipe) ─────────────────────────────
+ * A Pipe records its stages as (op, a, b) triples; _tr_iter_run makes one
+ * pass over the source and runs every stage on each element in turn, so a
+ * chain of filters and maps allocates nothing but the result. With `par` the
+ * source is cut into chunks whose number depends on its length only (never
+ * on the core count), the chunks run on a pool of their own, and the partial
+ * results are combined in chunk order: the answer is the same everywhere. */
+enum { _TR_IT_GT = 1, _TR_IT_LT, _TR_IT_GE, _TR_IT_LE, _TR_IT_EQ, _TR_IT_NE, _TR_IT_FILTER_FN,
+       _TR_IT_ADD, _TR_IT_SUB, _TR_IT_MUL, _TR_IT_DIV, _TR_IT_ABS, _TR_IT_CLAMP, _TR_IT_MAP_FN };
+enum { _TR_IT_COLLECT, _TR_IT_SUM, _TR_IT_COUNT, _TR_IT_MIN, _TR_IT_MAX, _TR_IT_REDUCE };
+#define _TR_IT_GRAIN      4096   /* smallest chunk worth a pool job */
+#define _TR_IT_MAX_CHUNKS 64
+typedef long long (*_TrItMapFn)(long long);
+typedef bool      (*_TrItPredFn)(long long);
+typedef long long (*_TrItFoldFn)(long long, long long);
+typedef struct {
+    const long long* src; long long start, step;    /* src NULL: start + i*step */
+    const long long* ops; long long nops; void* const* fns;
+    long long term; long long init; void* rfn;
+} _TrItPlan;
+typedef struct {
+    const _TrItPlan* p; long long lo, hi;
+    long long* buf; long long kept; long long acc; int seen;
+} _TrItChunk;
+_TR_GLOBAL _TrThreadPool* _tr_global_iter_pool;
+
+static inline _TrThreadPool* _tr_iter_pool(void) {
+    _TrThreadPool* p = __atomic_load_n(&_tr_global_iter_pool, __ATOMIC_ACQUIRE);
+    if (p) return p;
+    _TrThreadPool* np = _tr_threadpool_auto();
+    if (__atomic_compare_exchange_n(&_tr_global_iter_pool, &p, np, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        return np;
+    _tr_threadpool_free(np);   /* another thread won the race */
+    return p;
+}
+
+#define _TR_IT_BLOCK 256      /* elements per stage sweep; stays in L1 */
+#define _TR_IT_KEEP(cond) for (long long i = 0; i < m; i++) { long long x = b[i]; b[j] = x; j += (cond); }
+#define _TR_IT_MAP(expr)  for (long long i = 0; i < m; i++) { long long x = b[i]; b[i] = (expr); }
+#define _TR_IT_U(x)       ((unsigned long long)(x))
+
+/* Run every stage over the m elements of b, one stage at a time: each sweep
+ * is a tight loop the C compiler can vectorise, and filters compact b in
+ * place. Returns how many elements are left. Arithmetic wraps. */
+static inline long long _tr_it_block(const _TrItPlan* p, long long* b, long long m) {
+    for (long long k = 0; k < p->nops && m > 0; k++) {
+        const long long* o = p->ops + 3 * k;
+        const long long a = o[1], hi = o[2];
+        long long j = 0;
+        switch (o[0]) {
+        case _TR_IT_GT: _TR_IT_KEEP(x >  a) m = j; break;
+        case _TR_IT_LT: _TR_IT_KEEP(x <  a) m = j; break;
+        case _TR_IT_GE: _TR_IT_KEEP(x >= a) m = j; break;
+        case _TR_IT_LE: _TR_IT_KEEP(x <= a) m = j; break;
+        case _TR_IT_EQ: _TR_IT_KEEP(x == a) m = j; break;
+        case _TR_IT_NE: _TR_IT_KEEP(x != a) m = j; break;
+        case _TR_IT_FILTER_FN: { _TrItPredFn f = (_TrItPredFn)p->fns[a]; _TR_IT_KEEP(f(x) ? 1 : 0) m = j; break; }
+        case _TR_IT_ADD: _TR_IT_MAP((long long)(_TR_IT_U(x) + _TR_IT_U(a))) break;
+        case _TR_IT_SUB: _TR_IT_MAP((long long)(_TR_IT_U(x) - _TR_IT_U(a))) break;
+        case _TR_IT_MUL: _TR_IT_MAP((long long)(_TR_IT_U(x) * _TR_IT_U(a))) break;
+        case _TR_IT_DIV:
+            if (a == 0)       memset(b, 0, (size_t)m * sizeof(long long));
+            else if (a == -1) { _TR_IT_MAP((long long)(0ULL - _TR_IT_U(x))) }
+            else              { _TR_IT_MAP(x / a) }
+            break;
+        case _TR_IT_ABS:   _TR_IT_MAP(x < 0 ? (long long)(0ULL - _TR_IT_U(x)) : x) break;
+        case _TR_IT_CLAMP: _TR_IT_MAP(x < a ? a : x > hi ? hi : x) break;
+        case _TR_IT_MAP_FN: { _TrItMapFn f = (_TrItMapFn)p->fns[a]; _TR_IT_MAP(f(x)) break; }
+        }
+    }
+    return m;
+}
+
+/* Elements [lo, hi) of the source through the stages, block by block, into
+ * c->buf (collect) or folded into c->acc. */
+static inline void _tr_it_chunk(_TrItChunk* c) {
+    const _TrItPlan* p = c->p;
+    long long blk[_TR_IT_BLOCK];
+    long long kept = 0, acc = c->acc;
+    int seen = c->seen;
+    for (long long base = c->lo; base < c->hi; base += _TR_IT_BLOCK) {
+        long long m = c->hi - base < _TR_IT_BLOCK ? c->hi - base : _TR_IT_BLOCK;
+        /* collect filters in place at the end of what it has kept so far */
+        long long* b = p->term == _TR_IT_COLLECT ? c->buf + kept : blk;
+        if (p->src) memcpy(b, p->src + base, (size_t)m * sizeof(long long));
+        else for (long long i = 0; i < m; i++) b[i] = (long long)(_TR_IT_U(p->start) + _TR_IT_U(base + i) * _TR_IT_U(p->step));
+        m = _tr_it_block(p, b, m);
+        if (m == 0) continue;
+        switch (p->term) {
+        case _TR_IT_SUM:
+            for (long long i = 0; i < m; i++) acc = (long long)(_TR_IT_U(acc) + _TR_IT_U(b[i]));
+            break;
+        case _TR_IT_MIN:
+            if (!seen) acc = b[0];
+            for (long long i = 0; i < m; i++) acc = b[i] < acc ? b[i] : acc;
+            break;
+        case _TR_IT_MAX:
+            if (!seen) acc = b[0];
+            for (long long i = 0; i < m; i++) acc = b[i] > acc ? b[i] : acc;
+            break;
+        case _TR_IT_REDUCE:
+            for (long long i = 0; i < m; i++) acc = ((_TrItFoldFn)p->rfn)(acc, b[i]);
+            break;
+        }
+        kept += m;
+        seen = 1;
+    }
+    c->kept = kept; c->acc = acc; c->seen = seen;
+}
+#undef _TR_IT_KEEP
+#undef _TR_IT_MAP
+#undef _TR_IT_U
+static void* _tr_it_job(void* arg) { _tr_it_chunk((_TrItChunk*)arg); return NULL; }
+
+/* Run a pipeline over n source elements. Collect writes the kept elements to
+ * `out` (room for n) and returns how many; the other terminals return their
+ * value (min / max of nothing: 0). A parallel reduce folds each chunk from
+ * `init` and then the partials left to right, so `init` must be the
+ * identity of an associative `rfn`. */
+static inline long long _tr_iter_run(const void* src_, long long start, long long step, long long n,
+                                     const void* ops, long long nops, const void* fns,
+                                     long long term, long long init, void* rfn, void* out_, long long par) {
+    const long long* src = (const long long*)src_;
+    long long* out = (long long*)out_;
+    _TrItPlan p = { src, start, step, (const long long*)ops, nops, (void* const*)fns, term, init, rfn };
+    if (n <= 0) return term == _TR_IT_REDUCE ? init : 0;
+    long long nch = (n + _TR_IT_GRAIN - 1) / _TR_IT_GRAIN;
+    if (nch > _TR_IT_MAX_CHUNKS) nch = _TR_IT_MAX_CHUNKS;
+    if (!par || nch < 2) {
+        _TrItChunk c = { &p, 0, n, out, 0, term == _TR_IT_REDUCE ? init : 0, 0 };
+        _tr_it_chunk(&c);
+        return term == _TR_IT_COLLECT || term == _TR_IT_COUNT ? c.kept : c.acc;
+    }
+    _TrItChunk cs[_TR_IT_MAX_CHUNKS];
+    _TrThreadPool* pool = _tr_iter_pool();
+    for (long long k = 0; k < nch; k++) {
+        _TrItChunk* c = &cs[k];
+        c->p = &p;
+        c->lo = n * k / nch;
+        c->hi = n * (k + 1) / nch;
+        /* collect: chunk k writes straight into its slice of `out` and the
+           slices are closed up afterwards, in order */
+        c->buf = out ? out + c->lo : NULL;
+        c->kept = 0; c->acc = term == _TR_IT_REDUCE ? init : 0; c->seen = 0;
+        _tr_threadpool_spawn(pool, _tr_it_job, c);
+    }
+    _tr_threadpool_wait(pool);
+    long long r = 0;
+    int seen = 0;
+    for (long long k = 0; k < nch; k++) {
+        _TrItChunk* c = &cs[k];
+        switch (term) {
+        case _TR_IT_COLLECT:
+            if (out + r != c->buf) memmove(out + r, c->buf, (size_t)c->kept * sizeof(long long));
+            r += c->kept; break;
+        case _TR_IT_COUNT: r += c->kept; break;
+        case _TR_IT_SUM:   r = (long long)((unsigned long long)r + (unsigned long long)c->acc); break;
+        case _TR_IT_MIN:   if (c->seen && (!seen || c->acc < r)) { r = c->acc; seen = 1; } break;
+        case _TR_IT_MAX:   if (c->seen && (!seen || c->acc > r)) { r = c->acc; seen = 1; } break;
+        case _TR_IT_REDUCE: r = k == 0 ? c->acc : ((_TrItFoldFn)rfn)(r, c->acc); break;
+        }
+    }
+    return r;
+}
+/* Collect into a Vec[int]: grown to room for all n, then its len set. */
+static inline void _tr_iter_collect(List_i64* l, const void* src, long long start, long long step, long long n,
+                                    const void* ops, long long nops, const void* fns, long long par) {
+    if (n > 0 && (size_t)n > l->capacity) {
+        l->data = (long long*)realloc(l->data, (size_t)n * sizeof(long long));
+        l->capacity = (size_t)n;
+    }
+    l->len = (size_t)_tr_iter_run(src, start, step, n, ops, nops, fns, _TR_IT_COLLECT, 0, NULL, l->data, par);
+}
+
+/* ── Statistics kernels (std.math.stats, FloatTransform) ──────────────────
+ * Reductions keep several independent accumulators so the C compiler turns
+ * them into vector code without reassociating anything. Float sums are
+ * pairwise: blocks of 128 summed 8 lanes wide, blocks combined as a tree,
+ * so the rounding error grows with log n rather than n. Order statistics
+ * use introselect on a scratch copy: quickselect with a median-of-3 pivot
+ * and a three-way partition, falling back to heapsort on the subrange when
+ * the recursion gets too deep; several ranks are found in one descent. */
+#define _TR_ST_BLOCK 128
+#define _TR_ST_U(x) ((unsigned long long)(x))
+
+static inline long long _tr_stats_sum_i64(const void* p_, long long n) {
+    const long long* p = (const long long*)p_;
+    unsigned long long a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+    long long i = 0;
+    for (; i + 4 <= n; i += 4) { a0 += _TR_ST_U(p[i]); a1 += _TR_ST_U(p[i+1]); a2 += _TR_ST_U(p[i+2]); a3 += _TR_ST_U(p[i+3]); }
+    for (; i < n; i++) a0 += _TR_ST_U(p[i]);
+    return (long long)(a0 + a1 + a2 + a3);
+}
+static inline long long _tr_stats_dot_i64(const void* a_, const void* b_, long long n) {
+    const long long* a = (const long long*)a_; const long long* b = (const long long*)b_;
+    unsigned long long s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    long long i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += _TR_ST_U(a[i]) * _TR_ST_U(b[i]);     s1 += _TR_ST_U(a[i+1]) * _TR_ST_U(b[i+1]);
+        s2 += _TR_ST_U(a[i+2]) * _TR_ST_U(b[i+2]); s3 += _TR_ST_U(a[i+3]) * _TR_ST_U(b[i+3]);
+    }
+    for (; i < n; i++) s0 += _TR_ST_U(a[i]) * _TR_ST_U(b[i]);
+    return (long long)(s0 + s1 + s2 + s3);
+}
+
+/* min / max of n >= 1 elements, four lanes wide. */
+#define _TR_ST_MINMAX(NAME, ET, CMP)                                           \
+static inline ET _tr_stats_##NAME(const void* p_, long long n) {               \
+    const ET* p = (const ET*)p_;                                               \
+    if (n <= 0) return 0;                                                      \
+    ET m0 = p[0], m1 = p[0], m2 = p[0], m3 = p[0];                             \
+    long long i = 0;                                                           \
+    for (; i + 4 <= n; i += 4) {                                               \
+        m0 = p[i]   CMP m0 ? p[i]   : m0; m1 = p[i+1] CMP m1 ? p[i+1] : m1;    \
+        m2 = p[i+2] CMP m2 ? p[i+2] : m2; m3 = p[i+3] CMP m3 ? p[i+3] : m3;    \
+    }                                                                          \
+    for (; i < n; i++) m0 = p[i] CMP m0 ? p[i] : m0;                           \
+    m0 = m1 CMP m0 ? m1 : m0; m2 = m3 CMP m2 ? m3 : m2;                        \
+    return m2 CMP m0 ? m2 : m0;                                                \
+}
+_TR_ST_MINMAX(min_i64, long long, <)
+_TR_ST_MINMAX(max_i64, long long, >)
+_TR_ST_MINMAX(min_f64, double, <)
+_TR_ST_MINMAX(max_f64, double, >)
+#undef _TR_ST_MINMAX
+
+/* Pairwise sum of TERM(i) over [0, n), with m subtracted from each element
+ * first (m = 0 for a plain sum). One instance per element type / term. */
+#define _TR_ST_PAIRWISE(NAME, ET, TERM)                                        \
+static double NAME(const ET* a, const ET* b, long long n, double m) {          \
+    (void)b;                                                                   \
+    if (n <= _TR_ST_BLOCK) {                                                   \
+        double r[8] = {0, 0, 0, 0, 0, 0, 0, 0};                                \
+        long long i = 0;                                                       \
+        for (; i + 8 <= n; i += 8)                                             \
+            for (int l = 0; l < 8; l++) { long long j = i + l; r[l] += (TERM); } \
+        double s = ((r[0] + r[1]) + (r[2] + r[3])) + ((r[4] + r[5]) + (r[6] + r[7])); \
+        for (; i < n; i++) { long long j = i; s += (TERM); }                   \
+        return s;                                                              \
+    }                                                                          \
+    long long h = (n / 2 + 7) & ~7LL;                                          \
+    return NAME(a, b, h, m) + NAME(a + h, b ? b + h : b, n - h, m);            \
+}
+_TR_ST_PAIRWISE(_tr_st_psum_f64,  double,    a[j] - m)
+_TR_ST_PAIRWISE(_tr_st_psum_i64,  long long, (double)a[j] - m)
+_TR_ST_PAIRWISE(_tr_st_psq_f64,   double,    (a[j] - m) * (a[j] - m))
+_TR_ST_PAIRWISE(_tr_st_psq_i64,   long long, ((double)a[j] - m) * ((double)a[j] - m))
+_TR_ST_PAIRWISE(_tr_st_pdot_f64,  double,    a[j] * b[j])
+#undef _TR_ST_PAIRWISE
+
+static inline double _tr_stats_sum_f64(const void* p, long long n) {
+    return n > 0 ? _tr_st_psum_f64((const double*)p, NULL, n, 0.0) : 0.0;
+}
+static inline double _tr_stats_dot_f64(const void* a, const void* b, long long n) {
+    return n > 0 ? _tr_st_pdot_f64((const double*)a, (const double*)b, n, 0.0) : 0.0;
+}
+/* Sum of squared deviations from the mean (the numerator of the variance),
+ * by the corrected two-pass method: sum (x-m)^2 - (sum (x-m))^2 / n, the
+ * second term cancelling the rounding error left in m. */
+static inline double _tr_stats_sqdev_f64(const void* p_, long long n) {
+    const double* p = (const double*)p_;
+    if (n < 2) return 0.0;
+    double m = _tr_st_psum_f64(p, NULL, n, 0.0) / (double)n;
+    double c = _tr_st_psum_f64(p, NULL, n, m);
+    double s = _tr_st_psq_f64(p, NULL, n, m) - c * c / (double)n;
+    return s > 0.0 ? s : 0.0;
+}
+static inline double _tr_stats_sqdev_i64(const void* p_, long long n) {
+    const long long* p = (const long long*)p_;
+    if (n < 2) return 0.0;
+    double m = _tr_st_psum_i64(p, NULL, n, 0.0) / (double)n;
+    double c = _tr_st_psum_i64(p, NULL, n, m);
+    double s = _tr_st_psq_i64(p, NULL, n, m) - c * c / (double)n;
+    return s > 0.0 ? s : 0.0;
+}
+static inline double _tr_stats_mean_i64(const void* p, long long n) {
+    return n > 0 ? _tr_st_psum_i64((const long long*)p, NULL, n, 0.0) / (double)n : 0.0;
+}
+
+/* Introselect. _tr_st_select_<T>(a, lo, hi, ks, nk, depth) leaves a[k] at
+ * its sorted position for every rank k in ks[0..nk) (ascending, all inside
+ * [lo, hi)). */
+#define _TR_ST_SELECT(T, ET)                                                   \
+static void _tr_st_sift_##T(ET* a, long long root, long long n) {              \
+    for (;;) {                                                                 \
+        long long c = 2 * root + 1;                                            \
+        if (c >= n) return;                                                    \
+        if (c + 1 < n && a[c] < a[c + 1]) c++;                                 \
+        if (!(a[root] < a[c])) return;                                         \
+        ET t = a[root]; a[root] = a[c]; a[c] = t; root = c;                    \
+    }                                                                          \
+}                                                                              \
+static void _tr_st_heapsort_##T(ET* a, long long n) {                          \
+    for (long long i = n / 2 - 1; i >= 0; i--) _tr_st_sift_##T(a, i, n);      \
+    for (long long e = n - 1; e > 0; e--) {                                    \
+        ET t = a[0]; a[0] = a[e]; a[e] = t; _tr_st_sift_##T(a, 0, e);          \
+    }                                                                          \
+}                                                                              \
+static void _tr_st_select_##T(ET* a, long long lo, long long hi,               \
+                              const long long* ks, long long nk, int depth) {  \
+    while (nk > 0 && hi - lo > 16) {                                           \
+        if (depth-- <= 0) { _tr_st_heapsort_##T(a + lo, hi - lo); return; }    \
+        ET x = a[lo], y = a[lo + (hi - lo) / 2], z = a[hi - 1];                \
+        ET pv = x < y ? (y < z ? y : (x < z ? z : x)) : (x < z ? x : (y < z ? z : y)); \
+        /* Dutch flag: [lo, lt) < pv, [lt, gt) == pv, [gt, hi) > pv */         \
+        long long lt = lo, i = lo, gt = hi;                                    \
+        while (i < gt) {                                                       \
+            ET v = a[i];                                                       \
+            if (v < pv)      { a[i] = a[lt]; a[lt] = v; lt++; i++; }           \
+            else if (pv < v) { gt--; a[i] = a[gt]; a[gt] = v; }                \
+            else i++;                                                          \
+        }                                                                      \
+        long long nl = 0, nm = 0;                                              \
+        while (nl < nk && ks[nl] < lt) nl++;                                   \
+        nm = nl;                                                               \
+        while (nm < nk && ks[nm] < gt) nm++;                                   \
+        /* recurse into the smaller side that has ranks, loop on the other */ \
+        if (nl > 0 && nm < nk) {                                               \
+            if (lt - lo < hi - gt) { _tr_st_select_##T(a, lo, lt, ks, nl, depth); lo = gt; ks += nm; nk -= nm; } \
+            else { _tr_st_select_##T(a, gt, hi, ks + nm, nk - nm, depth); hi = lt; nk = nl; } \
+        } else if (nl > 0) { hi = lt; nk = nl; }                               \
+        else { lo = gt; ks += nm; nk -= nm; }                                  \
+    }                                                                          \
+    if (nk > 0) {                                                              \
+        for (long long i = lo + 1; i < hi; i++) {                              \
+            ET v = a[i]; long long j = i;                                      \
+            while (j > lo && v < a[j - 1]) { a[j] = a[j - 1]; j--; }           \
+            a[j] = v;                                                          \
+        }                                                                      \
+    }                                                                          \
+}                                                                              \
+/* The elements of rank ranks[0..nr) (any order, 0 <= rank < n) of p[0..n),   \
+ * into out[0..nr); p is not modified. */                                      \
+static inline void _tr_stats_select_##T(const void* p, long long n, const void* ranks_, long long nr, void* out_) { \
+    const long long* ranks = (const long long*)ranks_;                         \
+    ET* out = (ET*)out_;                                                       \
+    if (n <= 0 || nr <= 0) return;                                             \
+    ET* a = (ET*)malloc((size_t)n * sizeof(ET));                               \
+    long long* ks = (long long*)malloc((size_t)nr * sizeof(long long));        \
+    if (!a || !ks) { free(a); free(ks); return; }                              \
+    memcpy(a, p, (size_t)n * sizeof(ET));                                      \
+    long long nk = 0;                                                          \
+    for (long long r = 0; r < nr; r++) {                                       \
+        long long k = ranks[r] < 0 ? 0 : ranks[r] >= n ? n - 1 : ranks[r];     \
+        long long j = nk++;                                                    \
+        while (j > 0 && ks[j - 1] > k) { ks[j] = ks[j - 1]; j--; }             \
+        ks[j] = k;                                                             \
+    }                                                                          \
+    long long u = 0;                                                           \
+    for (long long r = 0; r < nk; r++) if (u == 0 || ks[u - 1] != ks[r]) ks[u++] = ks[r]; \
+    int depth = 2;                                                             \
+    for (long long m = n; m > 1; m >>= 1) depth += 2;                          \
+    _tr_st_select_##T(a, 0, n, ks, u, depth);                                  \
+    for (long long r = 0; r < nr; r++)                                         \
+        out[r] = a[ranks[r] < 0 ? 0 : ranks[r] >= n ? n - 1 : ranks[r]];       \
+    free(a); free(ks);                                                         \
+}
+_TR_ST_SELECT(i64, long long)
+_TR_ST_SELECT(f64, double)
+#undef _TR_ST_SELECT
+#undef _TR_ST_U
+
+/* ── CSR graphs (std.collections.csr) ─────────────────────────────────────
+ * A frozen graph is three flat arrays: offsets (n + 1 entries), targets and
+ * weights (one per edge); the edges of node v are [offsets[v], offsets[v+1]).
+ * Building is a stable counting sort of the edge list by source, so a row
+ * keeps the order its edges were added in. Directed graphs also keep the
+ * reverse rows (in-edges) for bottom-up BFS.
+ *
+ * BFS is direction-optimizing: while the frontier is small each frontier
+ * node pushes to its unvisited out-neighbours (top-down); once the frontier's
+ * out-edges outnumber 1/14 of the edges still unexplored, every unvisited
+ * node looks for a parent among its in-neighbours instead and stops at the
+ * first one (bottom-up), until the frontier shrinks under n/24 nodes again.
+ * Shortest paths use delta-stepping: nodes wait in buckets of width delta,
+ * the lowest bucket is emptied by relaxing light edges (w <= delta) until it
+ * stays empty, then the heavy edges of everything it settled are relaxed
+ * once. A level or bucket big enough is cut into chunks run on the iterator
+ * pool; chunks claim nodes with one compare-and-swap (top-down), own a range
+ * of nodes (bottom-up) or only collect relax requests that are applied in
+ * chunk order afterwards, so the distances never depend on the scheduling. */
+#define _TR_CSR_GRAIN      1024   /* frontier / bucket nodes per chunk, at least */
+#define _TR_CSR_MAX_CHUNKS 64
+#define _TR_CSR_ALPHA      14
+#define _TR_CSR_BETA       24
+#define _TR_CSR_MAX_BUCKETS (1LL << 16)
+
+/* Give a Vec[int] exactly n elements (contents unspecified). */
+static inline long long* _tr_csr_fit(List_i64* l, long long n) {
+    if (n > 0 && (size_t)n > l->capacity) {
+        l->data = (long long*)realloc(l->data, (size_t)n * sizeof(long long));
+        l->capacity = (size_t)n;
+    }
+    l->len = (size_t)(n > 0 ? n : 0);
+    return l->data;
+}
+
+/* Rows for the m edges from[i] -> to[i] (weight w[i], or 1 when w is NULL)
+ * over nodes [0, n); with sym each edge is stored both ways. Edges with an
+ * endpoint outside [0, n) are dropped. Without with_w wt is left alone
+ * (targets only). */
+static inline void _tr_csr_build(List_i64* off, List_i64* tgt, List_i64* wt, long long with_w, long long n,
+                                 const void* from_, const void* to_, const void* w_, long long m, long long sym) {
+    const long long* from = (const long long*)from_;
+    const long long* to = (const long long*)to_;
+    const long long* w = (const long long*)w_;
+    if (n < 0) n = 0;
+    long long* o = _tr_csr_fit(off, n + 1);
+    memset(o, 0, (size_t)(n + 1) * sizeof(long long));
+#define _TR_CSR_OK(i) ((unsigned long long)from[i] < (unsigned long long)n && (unsigned long long)to[i] < (unsigned long long)n)
+    for (long long i = 0; i < m; i++) {
+        if (!_TR_CSR_OK(i)) continue;
+        o[from[i] + 1]++;
+        if (sym) o[to[i] + 1]++;
+    }
+    for (long long v = 0; v < n; v++) o[v + 1] += o[v];
+    long long* t = _tr_csr_fit(tgt, o[n]);
+    long long* ws = with_w ? _tr_csr_fit(wt, o[n]) : NULL;
+    long long* cur = (long long*)malloc((size_t)(n > 0 ? n : 1) * sizeof(long long));
+    memcpy(cur, o, (size_t)n * sizeof(long long));
+    for (long long i = 0; i < m; i++) {
+        if (!_TR_CSR_OK(i)) continue;
+        long long wi = w ? w[i] : 1;
+        long long p = cur[from[i]]++;
+        t[p] = to[i];
+        if (ws) ws[p] = wi;
+        if (sym) {
+            p = cur[to[i]]++;
+            t[p] = from[i];
+            if (ws) ws[p] = wi;
+        }
+    }
+#undef _TR_CSR_OK
+    free(cur);
+}
+
+/* ── BFS ── */
+typedef struct {
+    const long long *off, *tgt, *roff, *rsrc;
+    long long* dist; long long n, level;
+    const long long* front; long long* next; long long nnext;   /* top-down queues */
+    const unsigned long long* fbits; unsigned long long* nbits; /* bottom-up frontier */
+    int par;
+} _TrCsrBfs;
+typedef struct { _TrCsrBfs* b; long long lo, hi, found, edges; } _TrCsrBfsChunk;
+
+/* Frontier nodes [lo, hi) claim their unvisited out-neighbours. */
+static inline void _tr_csr_td(_TrCsrBfsChunk* c) {
+    _TrCsrBfs* b = c->b;
+    const long long *off = b->off, *tgt = b->tgt;
+    long long* dist = b->dist;
+    const long long lvl = b->level + 1;
+    long long buf[256], nb = 0, found = 0, edges = 0;
+    for (long long i = c->lo; i < c->hi; i++) {
+        const long long u = b->front[i];
+        for (long long e = off[u]; e < off[u + 1]; e++) {
+            const long long v = tgt[e];
+            if (__atomic_load_n(&dist[v], __ATOMIC_RELAXED) >= 0) continue;
+            if (b->par) {
+                long long seen = -1;
+                if (!__atomic_compare_exchange_n(&dist[v], &seen, lvl, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) continue;
+            } else dist[v] = lvl;
+            found++;
+            edges += off[v + 1] - off[v];
+            buf[nb++] = v;
+            if (nb == 256) {
+                long long at = __atomic_fetch_add(&b->nnext, nb, __ATOMIC_RELAXED);
+                memcpy(b->next + at, buf, sizeof buf);
+                nb = 0;
+            }
+        }
+    }
+    if (nb) {
+        long long at = __atomic_fetch_add(&b->nnext, nb, __ATOMIC_RELAXED);
+        memcpy(b->next + at, buf, (size_t)nb * sizeof(long long));
+    }
+    c->found = found; c->edges = edges;
+}
+
+/* Unvisited nodes [lo, hi) (lo a multiple of 64) look for a parent in the
+ * frontier bitmap; each chunk owns its words of nbits. */
+static inline void _tr_csr_bu(_TrCsrBfsChunk* c) {
+    _TrCsrBfs* b = c->b;
+    const long long *roff = b->roff, *rsrc = b->rsrc, *off = b->off;
+    const unsigned long long* fb = b->fbits;
+    long long* dist = b->dist;
+    const long long lvl = b->level + 1;
+    long long found = 0, edges = 0;
+    for (long long v = c->lo; v < c->hi; v++) {
+        if (dist[v] >= 0) continue;
+        for (long long e = roff[v]; e < roff[v + 1]; e++) {
+            const long long u = rsrc[e];
+            if (fb[u >> 6] >> (u & 63) & 1) {
+                dist[v] = lvl;
+                b->nbits[v >> 6] |= 1ULL << (v & 63);
+                found++;
+                edges += off[v + 1] - off[v];
+                break;
+            }
+        }
+    }
+    c->found = found; c->edges = edges;
+}
+static void* _tr_csr_td_job(void* a) { _tr_csr_td((_TrCsrBfsChunk*)a); return NULL; }
+static void* _tr_csr_bu_job(void* a) { _tr_csr_bu((_TrCsrBfsChunk*)a); return NULL; }
+
+/* Hop counts from src into dist (-1: unreachable); returns how many nodes
+ * were reached. roff / rsrc are the in-edge rows (the out-edge rows again
+ * for an undirected graph). */
+static inline long long _tr_csr_bfs(List_i64* dist_l, const void* off_, const void* tgt_,
+                                    const void* roff_, const void* rsrc_, long long n, long long src) {
+    long long* dist = _tr_csr_fit(dist_l, n);
+    for (long long v = 0; v < n; v++) dist[v] = -1;
+    if (src < 0 || src >= n) return 0;
+    _TrCsrBfs b;
+    b.off = (const long long*)off_; b.tgt = (const long long*)tgt_;
+    b.roff = (const long long*)roff_; b.rsrc = (const long long*)rsrc_;
+    b.dist = dist; b.n = n; b.level = 0;
+    long long* qa = (long long*)malloc((size_t)n * sizeof(long long));
+    long long* qb = (long long*)malloc((size_t)n * sizeof(long long));
+    const long long nw = (n + 63) / 64;
+    unsigned long long *ba = NULL, *bb = NULL;
+    dist[src] = 0;
+    qa[0] = src;
+    long long nf = 1, prev_nf = 0, reached = 1;
+    long long mf = b.off[src + 1] - b.off[src];
+    long long mu = b.off[n] - mf;           /* out-edges of unvisited nodes */
+    int bottom = 0;
+    _TrCsrBfsChunk cs[_TR_CSR_MAX_CHUNKS];
+    while (nf > 0) {
+        if (!bottom && mf > mu / _TR_CSR_ALPHA && nf > prev_nf) {
+            if (!ba) {
+                ba = (unsigned long long*)malloc((size_t)nw * sizeof(unsigned long long));
+                bb = (unsigned long long*)malloc((size_t)nw * sizeof(unsigned long long));
+            }
+            memset(ba, 0, (size_t)nw * sizeof(unsigned long long));
+            for (long long i = 0; i < nf; i++) ba[qa[i] >> 6] |= 1ULL << (qa[i] & 63);
+            bottom = 1;
+        } else if (bottom && nf < n / _TR_CSR_BETA && nf < prev_nf) {
+            long long k = 0;
+            for (long long wi = 0; wi < nw; wi++)
+                for (unsigned long long x = ba[wi]; x; x &= x - 1)
+                    qa[k++] = wi * 64 + __builtin_ctzll(x);
+            bottom = 0;
+        }
+        long long nch, found = 0, edges = 0;
+        if (bottom) {
+            memset(bb, 0, (size_t)nw * sizeof(unsigned long long));
+            b.fbits = ba; b.nbits = bb;
+            nch = n / (_TR_CSR_GRAIN * 16);
+            if (nch > _TR_CSR_MAX_CHUNKS) nch = _TR_CSR_MAX_CHUNKS;
+            if (nch < 1) nch = 1;
+            b.par = nch > 1;
+            for (long long k = 0; k < nch; k++) {
+                cs[k].b = &b;
+                cs[k].lo = nw * k / nch * 64;
+                cs[k].hi = nw * (k + 1) / nch * 64;
+                if (cs[k].hi > n) cs[k].hi = n;
+            }
+        } else {
+            b.front = qa; b.next = qb; b.nnext = 0;
+            nch = nf / _TR_CSR_GRAIN;
+            if (nch > _TR_CSR_MAX_CHUNKS) nch = _TR_CSR_MAX_CHUNKS;
+            if (nch < 1) nch = 1;
+            b.par = nch > 1;
+            for (long long k = 0; k < nch; k++) {
+                cs[k].b = &b;
+                cs[k].lo = nf * k / nch;
+                cs[k].hi = nf * (k + 1) / nch;
+            }
+        }
+        if (nch > 1) {
+            _TrThreadPool* pool = _tr_iter_pool();
+            for (long long k = 0; k < nch; k++)
+                _tr_threadpool_spawn(pool, bottom ? _tr_csr_bu_job : _tr_csr_td_job, &cs[k]);
+            _tr_threadpool_wait(pool);
+        } else if (bottom) _tr_csr_bu(&cs[0]);
+        else _tr_csr_td(&cs[0]);
+        for (long long k = 0; k < nch; k++) { found += cs[k].found; edges += cs[k].edges; }
+        if (bottom) { unsigned long long* t = ba; ba = bb; bb = t; }
+        else { long long* t = qa; qa = qb; qb = t; }
+        prev_nf = nf;
+        nf = found;
+        mf = edges;
+        mu -= edges;
+        reached += found;
+        b.level++;
+    }
+    free(qa); free(qb); free(ba); free(bb);
+    return reached;
+}
+
+/* ── Delta-stepping ── */
+typedef struct { long long* v; long long n, cap; } _TrCsrBuf;
+static inline void _tr_csr_buf_push(_TrCsrBuf* b, long long x) {
+    if (b->n == b->cap) {
+        b->cap = b->cap ? b->cap * 2 : 64;
+        b->v = (long long*)realloc(b->v, (size_t)b->cap * sizeof(long long));
+    }
+    b->v[b->n++] = x;
+}
+typedef struct {
+    const long long *off, *tgt, *wt, *dist, *set;
+    long long lo, hi, delta;
+    int heavy;
+    _TrCsrBuf req;                  /* (node, distance) pairs */
+} _TrCsrRelax;
+
+/* Requests for the light (or heavy) edges of set[lo, hi) that would
+ * shorten a distance; dist is only read. */
+static inline void _tr_csr_relax(_TrCsrRelax* r) {
+    const long long *off = r->off, *tgt = r->tgt, *wt = r->wt, *dist = r->dist;
+    r->req.n = 0;
+    for (long long i = r->lo; i < r->hi; i++) {
+        const long long u = r->set[i], du = dist[u];
+        for (long long e = off[u]; e < off[u + 1]; e++) {
+            const long long w = wt[e];
+            if ((w > r->delta) != r->heavy) continue;
+            const long long v = tgt[e], nd = du + w;
+            if (nd < dist[v]) { _tr_csr_buf_push(&r->req, v); _tr_csr_buf_push(&r->req, nd); }
+        }
+    }
+}
+static void* _tr_csr_relax_job(void* a) { _tr_csr_relax((_TrCsrRelax*)a); return NULL; }
+
+/* Shortest distances from src into dist (-1: unreachable); delta <= 0
+ * picks a bucket width from the weights. Returns how many nodes were
+ * reached, or -1 (all distances -1) when an edge weight is negative. */
+static inline long long _tr_csr_sssp(List_i64* dist_l, const void* off_, const void* tgt_, const void* wt_,
+                                     long long n, long long src, long long delta) {
+    const long long* off = (const long long*)off_;
+    const long long* tgt = (const long long*)tgt_;
+    const long long* wt = (const long long*)wt_;
+    long long* dist = _tr_csr_fit(dist_l, n);
+    const long long m = n > 0 ? off[n] : 0;
+    long long maxw = 0;
+    for (long long e = 0; e < m; e++) {
+        if (wt[e] < 0) { for (long long v = 0; v < n; v++) dist[v] = -1; return -1; }
+        if (wt[e] > maxw) maxw = wt[e];
+    }
+    for (long long v = 0; v < n; v++) dist[v] = LLONG_MAX;
+    if (src < 0 || src >= n) { for (long long v = 0; v < n; v++) dist[v] = -1; return 0; }
+    if (delta <= 0) {
+        long long deg = m / n;
+        delta = maxw / (deg > 1 ? deg : 1);
+        if (delta < 1) delta = 1;
+    }
+    if (maxw / delta + 2 > _TR_CSR_MAX_BUCKETS) delta = maxw / (_TR_CSR_MAX_BUCKETS - 2) + 1;
+    const long long nb = maxw / delta + 2;  /* live distances span < nb buckets */
+    _TrCsrBuf* bk = (_TrCsrBuf*)calloc((size_t)nb, sizeof(_TrCsrBuf));
+    long long* mark = (long long*)malloc((size_t)n * sizeof(long long));   /* inner round that took v */
+    long long* rmark = (long long*)malloc((size_t)n * sizeof(long long));  /* bucket that settled v */
+    for (long long v = 0; v < n; v++) { mark[v] = -1; rmark[v] = -1; }
+    _TrCsrBuf s = { NULL, 0, 0 }, settled = { NULL, 0, 0 };
+    _TrCsrRelax rs[_TR_CSR_MAX_CHUNKS];
+    memset(rs, 0, sizeof rs);
+    dist[src] = 0;
+    _tr_csr_buf_push(&bk[0], src);
+    long long pending = 1, round = 0;
+    for (long long cur = 0; pending > 0; cur++) {
+        _TrCsrBuf* b = &bk[cur % nb];
+        if (b->n == 0) continue;
+        settled.n = 0;
+        for (int heavy = 0; heavy < 2; heavy++) {
+            while (heavy ? settled.n > 0 : b->n > 0) {
+                const long long* set = settled.v;
+                long long cnt = settled.n;
+                if (!heavy) {
+                    /* take the bucket, keeping live entries seen once */
+                    _TrCsrBuf t = s; s = *b; *b = t; b->n = 0;
+                    pending -= s.n;
+                    round++;
+                    long long k = 0;
+                    for (long long i = 0; i < s.n; i++) {
+                        const long long v = s.v[i];
+                        if (dist[v] / delta != cur || mark[v] == round) continue;
+                        mark[v] = round;
+                        s.v[k++] = v;
+                        if (rmark[v] != cur) { rmark[v] = cur; _tr_csr_buf_push(&settled, v); }
+                    }
+                    s.n = k;
+                    set = s.v; cnt = k;
+                }
+                long long nch = cnt / _TR_CSR_GRAIN;
+                if (nch > _TR_CSR_MAX_CHUNKS) nch = _TR_CSR_MAX_CHUNKS;
+                if (nch < 1) nch = 1;
+                for (long long k = 0; k < nch; k++) {
+                    _TrCsrRelax* r = &rs[k];
+                    r->off = off; r->tgt = tgt; r->wt = wt; r->dist = dist; r->set = set;
+                    r->lo = cnt * k / nch; r->hi = cnt * (k + 1) / nch;
+                    r->delta = delta; r->heavy = heavy;
+                }
+                if (nch > 1) {
+                    _TrThreadPool* pool = _tr_iter_pool();
+                    for (long long k = 0; k < nch; k++) _tr_threadpool_spawn(pool, _tr_csr_relax_job, &rs[k]);
+                    _tr_threadpool_wait(pool);
+                } else _tr_csr_relax(&rs[0]);
+                for (long long k = 0; k < nch; k++) {
+                    const _TrCsrBuf* q = &rs[k].req;
+                    for (long long i = 0; i < q->n; i += 2) {
+                        const long long v = q->v[i], nd = q->v[i + 1];
+                        if (nd >= dist[v]) continue;
+                        dist[v] = nd;
+                        _tr_csr_buf_push(&bk[nd / delta % nb], v);
+                        pending++;
+                    }
+                }
+                if (heavy) break;
+            }
+        }
+    }
+    long long reached = 0;
+    for (long long v = 0; v < n; v++) {
+        if (dist[v] == LLONG_MAX) dist[v] = -1;
+        else reached++;
+    }
+    for (long long k = 0; k < nb; k++) free(bk[k].v);
+    for (long long k = 0; k < _TR_CSR_MAX_CHUNKS; k++) free(rs[k].req.v);
+    free(bk); free(mark); free(rmark); free(s.v); free(settled.v);
+    return reached;
+}
+
 /* ── Extended Vec/List operations: remove, swap, clear, is_empty, extend ──── */
 static inline void List_i64_remove(List_i64* l, long long i) { if(!l||(size_t)i>=l->len) return; for(size_t j=(size_t)i;j<l->len-1;j++) l->data[j]=l->data[j+1]; l->len--; }
 static inline void List_i64_swap(List_i64* l, long long a, long long b) { if(!l||(size_t)a>=l->len||(size_t)b>=l->len) return; long long t=l->data[a]; l->data[a]=l->data[b]; l->data[b]=t; }
@@ -4178,17 +9453,15 @@ static inline bool List_i32_contains(List_i32* l, int v) { if(!l) return false;
 static inline int List_i32_pop(List_i32* l) { if(!l||l->len==0) return 0; l->len--; return l->data[l->len]; }
 
 
-typedef struct { long long* data; size_t len; size_t capacity; } Set_i64;
-static inline Set_i64* Set_i64_new(void) { Set_i64* l=(Set_i64*)malloc(sizeof(Set_i64)); l->data=(long long*)malloc(sizeof(long long)*8); l->len=0; l->capacity=8; return l; }
-static inline void Set_i64_add(Set_i64* l, long long val) { 
-    for (size_t i = 0; i < l->len; i++) { if (l->data[i] == val) return; }
-    if(l->len==l->capacity){ l->capacity*=2; l->data=(long long*)TAURARO_REALLOC(l->data,sizeof(long long)*l->capacity); } l->data[l->len++]=val; 
-}
-static inline void Set_i64_free(Set_i64* l) { if(l){ _tr_free(l->data); _tr_free(l); } }
-static inline _Bool Set_i64_contains(Set_i64* l, long long v) { if(!l) return 0; for(size_t i=0;i<l->len;i++) if(l->data[i]==v) return 1; return 0; }
-static inline long long Set_i64_len(Set_i64* l) { return l ? (long long)l->len : 0LL; }
+/* Set_i64 is the TrIDict table with the values unused. */
+typedef TrIDict Set_i64;
+static inline Set_i64* Set_i64_new(void) { return _tr_idict_new(0); }
+static inline void Set_i64_add(Set_i64* l, long long val) { _tr_idict_set(l, val, 1); }
+static inline void Set_i64_free(Set_i64* l) { if(l){ _tr_free(l->slots); _tr_free(l); } }
+static inline _Bool Set_i64_contains(Set_i64* l, long long v) { return _tr_idict_contains(l, v); }
+static inline long long Set_i64_len(Set_i64* l) { return _tr_idict_len(l); }
 static inline _Bool Set_i64_is_empty(Set_i64* l) { return !l || l->len==0; }
-static inline void Set_i64_remove(Set_i64* l, long long v) { if(!l) return; for(size_t i=0;i<l->len;i++) if(l->data[i]==v){ for(size_t j=i;j+1<l->len;j++) l->data[j]=l->data[j+1]; l->len--; return; } }
+static inline void Set_i64_remove(Set_i64* l, long long v) { _tr_idict_remove(l, v); }
 
 typedef struct { void** data; size_t len; size_t capacity; } Set_ptr;
 static inline Set_ptr* Set_ptr_new(void) { Set_ptr* l=(Set_ptr*)malloc(sizeof(Set_ptr)); l->data=(void**)malloc(sizeof(void*)*8); l->len=0; l->capacity=8; return l; }
@@ -4449,6 +9722,441 @@ static inline TrStr _tr_trstr_join(List_TrStr* parts, const char* sep) {
     return out;
 }
 
+/* ── JSON (std.encoding.json) ────────────────────────────────────────────
+ * Stage 1 of a JsonDoc parse: one pass over the input that records the byte
+ * offset of every structural token into a List_i64 — { } [ ] : , outside
+ * strings, BOTH quotes of every string, and the first byte of every scalar
+ * (number / true / false / null). Stage 2 (json.tr) walks these offsets, so it
+ * never visits whitespace or string bodies a byte at a time.
+ *
+ * Bytes are classified 64 at a time into bitmasks (AVX2 2x32, SSE2 4x16, else
+ * a byte loop building the same masks). Escaped quotes are dropped, a prefix
+ * XOR of the quote mask gives the in-string mask, and the surviving bits are
+ * emitted with ctz. An unterminated string is closed at `len`, keeping stage 2
+ * as lenient as the byte-at-a-time parser it replaced. */
+#if !defined(TAURARO_BARE) && defined(__AVX2__)
+#  include <immintrin.h>
+#elif !defined(TAURARO_BARE) && defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
+typedef struct { uint64_t quote, bslash, op, ws; } _TrJsonMasks;
+
+static inline void _tr_json_classify(const unsigned char* p, _TrJsonMasks* m) {
+#if !defined(TAURARO_BARE) && defined(__AVX2__)
+    m->quote = m->bslash = m->op = m->ws = 0;
+    for (int h = 0; h < 2; h++) {
+        __m256i v  = _mm256_loadu_si256((const __m256i*)(p + 32 * h));
+        __m256i lc = _mm256_or_si256(v, _mm256_set1_epi8(0x20));          /* [ ] -> { } */
+        __m256i op = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(lc, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(lc, _mm256_set1_epi8('}'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(','))));
+        __m256i ws = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+        int sh = 32 * h;
+        m->quote  |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))) << sh;
+        m->bslash |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))) << sh;
+        m->op     |= (uint64_t)(uint32_t)_mm256_movemask_epi8(op) << sh;
+        m->ws     |= (uint64_t)(uint32_t)_mm256_movemask_epi8(ws) << sh;
+    }
+#elif !defined(TAURARO_BARE) && defined(__SSE2__)
+    m->quote = m->bslash = m->op = m->ws = 0;
+    for (int h = 0; h < 4; h++) {
+        __m128i v  = _mm_loadu_si128((const __m128i*)(p + 16 * h));
+        __m128i lc = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        __m128i op = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(lc, _mm_set1_epi8('{')), _mm_cmpeq_epi8(lc, _mm_set1_epi8('}'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')), _mm_cmpeq_epi8(v, _mm_set1_epi8(','))));
+        __m128i ws = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+        int sh = 16 * h;
+        m->quote  |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"'))) << sh;
+        m->bslash |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))) << sh;
+        m->op     |= (uint64_t)(uint16_t)_mm_movemask_epi8(op) << sh;
+        m->ws     |= (uint64_t)(uint16_t)_mm_movemask_epi8(ws) << sh;
+    }
+#else
+    uint64_t q = 0, b = 0, o = 0, w = 0;
+    for (int i = 0; i < 64; i++) {
+        unsigned char c = p[i];
+        uint64_t bit = 1ULL << i;
+        if (c == '"') q |= bit;
+        else if (c == '\\') b |= bit;
+        else if (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',') o |= bit;
+        else if (c == ' ' || c == '\t' || c == '\n' || c == '\r') w |= bit;
+    }
+    m->quote = q; m->bslash = b; m->op = o; m->ws = w;
+#endif
+}
+
+/* Inclusive prefix XOR: bit i = parity of bits [0, i] of x. */
+static inline uint64_t _tr_json_prefix_xor(uint64_t x) {
+    x ^= x << 1;  x ^= x << 2;  x ^= x << 4;
+    x ^= x << 8;  x ^= x << 16; x ^= x << 32;
+    return x;
+}
+
+/* Fill `out` with the structural offsets of src[0, len); returns their count. */
+static long long _tr_json_index(const char* src, long long len, List_i64* out) {
+    out->len = 0;
+    if (!src || len <= 0) return 0;
+    uint64_t esc_carry = 0;      /* the next block's first byte is escaped */
+    uint64_t str_carry = 0;      /* all-ones when the next block starts inside a string */
+    uint64_t scalar_carry = 0;   /* the previous block ended inside a scalar */
+    unsigned char tail[64];
+    for (long long base = 0; base < len; base += 64) {
+        const unsigned char* p = (const unsigned char*)src + base;
+        if (len - base < 64) {
+            memset(tail, ' ', sizeof tail);
+            memcpy(tail, p, (size_t)(len - base));
+            p = tail;
+        }
+        _TrJsonMasks m;
+        _tr_json_classify(p, &m);
+        /* Each backslash that is not itself escaped escapes the byte after it;
+         * backslashes are rare, so walk them rather than carry-chain them. */
+        uint64_t escaped = esc_carry;
+        uint64_t bs = m.bslash & ~escaped;
+        esc_carry = 0;
+        while (bs) {
+            int i = __builtin_ctzll(bs);
+            if (i == 63) { esc_carry = 1; break; }
+            escaped |= 1ULL << (i + 1);
+            bs &= ~(3ULL << i);
+        }
+        uint64_t quotes = m.quote & ~escaped;
+        /* Opening quotes and string bodies are 1, closing quotes 0. */
+        uint64_t in_str = _tr_json_prefix_xor(quotes) ^ str_carry;
+        str_carry = (uint64_t)((int64_t)in_str >> 63);
+        uint64_t scalar = ~(m.ws | m.op | quotes | in_str);
+        uint64_t starts = scalar & ~((scalar << 1) | scalar_carry);
+        scalar_carry = scalar >> 63;
+        uint64_t s = (m.op & ~in_str) | quotes | starts;
+        size_t need = out->len + (size_t)__builtin_popcountll(s);
+        if (need > out->capacity) {
+            size_t cap = out->capacity * 2;
+            if (cap < need) cap = need;
+            if (cap < (size_t)(len / 8)) cap = (size_t)(len / 8);
+            out->data = (long long*)TAURARO_REALLOC(out->data, sizeof(long long) * cap);
+            out->capacity = cap;
+        }
+        while (s) {
+            out->data[out->len++] = base + __builtin_ctzll(s);
+            s &= s - 1;
+        }
+    }
+    if (str_carry) List_i64_append(out, len);
+    return (long long)out->len;
+}
+
+/* Index of the token after the value that starts at token k (skips a whole
+ * object/array by bracket depth; a string is its two quote tokens). */
+static long long _tr_json_skip(const char* src, List_i64* ix, long long k) {
+    long long n = (long long)ix->len;
+    const long long* x = ix->data;
+    if (k < 0 || k >= n) return n;
+    char c = src[x[k]];
+    if (c == '"') return k + 2;
+    if (c != '{' && c != '[') return k + 1;
+    long long depth = 0;
+    for (; k < n; k++) {
+        char d = src[x[k]];
+        if (d == '"') { k++; continue; }
+        if (d == '{' || d == '[') depth++;
+        else if ((d == '}' || d == ']') && --depth == 0) return k + 1;
+    }
+    return n;
+}
+
+/* Resize `l` to n zeroed slots in one allocation (the JsonDoc tape). */
+static inline void _tr_json_tape_init(List_i64* l, long long n) {
+    if ((size_t)n > l->capacity) {
+        l->data = (long long*)TAURARO_REALLOC(l->data, sizeof(long long) * (size_t)n);
+        l->capacity = (size_t)n;
+    }
+    memset(l->data, 0, sizeof(long long) * (size_t)n);
+    l->len = (size_t)n;
+}
+
+static inline bool _tr_json_has_bslash(const char* s, long long a, long long b) {
+    return b > a && memchr(s + a, '\\', (size_t)(b - a)) != NULL;
+}
+/* buf[off, off+n) == key, without materializing the slice. */
+static inline bool _tr_json_key_eq(const char* buf, long long off, long long n, const char* key) {
+    return strlen(key) == (size_t)n && memcmp(buf + off, key, (size_t)n) == 0;
+}
+/* FNV-1a of buf[off, off+n), non-negative. */
+static inline long long _tr_json_hash(const char* buf, long long off, long long n) {
+    uint64_t h = 1469598103934665603ULL;
+    for (long long i = 0; i < n; i++) { h ^= (unsigned char)buf[off + i]; h *= 1099511628211ULL; }
+    return (long long)(h >> 1);
+}
+/* Scalar token at src[pos]: 3 for a float (has . e E), else 2. */
+static inline long long _tr_json_num_kind(const char* s, long long pos) {
+    const char* p = s + pos;
+    if (*p == '-') p++;
+    while (*p >= '0' && *p <= '9') p++;
+    return (*p == '.' || *p == 'e' || *p == 'E') ? 3 : 2;
+}
+static inline long long _tr_json_int_at(const char* s, long long pos) { return strtoll(s + pos, NULL, 10); }
+static inline double _tr_json_float_at(const char* s, long long pos) { return strtod(s + pos, NULL); }
+/* Length of the scalar token at src[pos] (up to whitespace / structural / end). */
+static inline long long _tr_json_scalar_len(const char* s, long long pos) {
+    const char* p = s + pos;
+    while (*p && !strchr(" \t\r\n{}[]:,\"", *p)) p++;
+    return (long long)(p - (s + pos));
+}
+static inline long long _tr_f64_to_bits(double x) { long long b; memcpy(&b, &x, sizeof b); return b; }
+static inline double _tr_f64_from_bits(long long b) { double x; memcpy(&x, &b, sizeof x); return x; }
+
+/* Appends into a std.core.string StringObj instance ({ __rc, data, len,
+ * capacity }), leaving it NUL-terminated after each call. Used by JsonWriter
+ * output and by the regex replacer. */
+typedef struct { size_t rc; char* data; long long len; long long capacity; } _TrStrBuf;
+
+static inline char* _tr_strbuf_grow(_TrStrBuf* b, long long extra) {
+    long long need = b->len + extra + 1;
+    if (need > b->capacity) {
+        long long cap = b->capacity * 2 + 8;
+        if (cap < need) cap = need;
+        b->data = (char*)_tr_c_realloc(b->data, (size_t)cap);
+        b->capacity = cap;
+    }
+    return b->data + b->len;
+}
+
+/* Append n raw bytes to a StringObj (std.io.bufio line reads). */
+static inline void _tr_strbuf_append(void* bp, const char* s, long long n) {
+    _TrStrBuf* b = (_TrStrBuf*)bp;
+    if (n <= 0) return;
+    char* o = _tr_strbuf_grow(b, n);
+    memcpy(o, s, (size_t)n);
+    b->len += n;
+    b->data[b->len] = '\0';
+}
+
+static inline void _tr_json_put_raw(void* bp, const char* s, long long n) {
+    _TrStrBuf* b = (_TrStrBuf*)bp;
+    char* o = _tr_strbuf_grow(b, n);
+    memcpy(o, s, (size_t)n);
+    b->len += n;
+    b->data[b->len] = '\0';
+}
+
+/* First index >= i in s[0..n) that needs escaping: " \ or a control byte. */
+static inline long long _tr_json_plain_run(const unsigned char* s, long long i, long long n) {
+#if !defined(TAURARO_BARE) && defined(__AVX2__)
+    const __m256i q = _mm256_set1_epi8('"'), bs = _mm256_set1_epi8('\\'), lo = _mm256_set1_epi8(0x1f);
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(s + i));
+        __m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, q), _mm256_cmpeq_epi8(v, bs)),
+                                      _mm256_cmpeq_epi8(_mm256_max_epu8(v, lo), lo));
+        uint32_t m = (uint32_t)_mm256_movemask_epi8(hit);
+        if (m) return i + __builtin_ctz(m);
+    }
+#elif !defined(TAURARO_BARE) && defined(__SSE2__)
+    const __m128i q = _mm_set1_epi8('"'), bs = _mm_set1_epi8('\\'), lo = _mm_set1_epi8(0x1f);
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, q), _mm_cmpeq_epi8(v, bs)),
+                                   _mm_cmpeq_epi8(_mm_max_epu8(v, lo), lo));
+        uint32_t m = (uint32_t)_mm_movemask_epi8(hit);
+        if (m) return i + __builtin_ctz(m);
+    }
+#endif
+    while (i < n && s[i] != '"' && s[i] != '\\' && s[i] >= 0x20) i++;
+    return i;
+}
+
+/* Append s[0..n) as a quoted JSON string: plain runs are memcpy'd, the rest
+ * get their short escape or \u00XX. */
+static void _tr_json_put_str(void* bp, const char* s, long long n) {
+    static const char hex[] = "0123456789abcdef";
+    _TrStrBuf* b = (_TrStrBuf*)bp;
+    const unsigned char* u = (const unsigned char*)s;
+    char* o = _tr_strbuf_grow(b, n + 2);
+    *o = '"';
+    b->len++;
+    long long i = 0;
+    while (i < n) {
+        long long j = _tr_json_plain_run(u, i, n);
+        if (j > i) {
+            o = _tr_strbuf_grow(b, j - i);
+            memcpy(o, s + i, (size_t)(j - i));
+            b->len += j - i;
+            i = j;
+            if (i >= n) break;
+        }
+        unsigned char c = u[i++];
+        o = _tr_strbuf_grow(b, 6);
+        o[0] = '\\';
+        switch (c) {
+            case '"':  o[1] = '"';  b->len += 2; break;
+            case '\\': o[1] = '\\'; b->len += 2; break;
+            case '\n': o[1] = 'n';  b->len += 2; break;
+            case '\r': o[1] = 'r';  b->len += 2; break;
+            case '\t': o[1] = 't';  b->len += 2; break;
+            case '\b': o[1] = 'b';  b->len += 2; break;
+            case '\f': o[1] = 'f';  b->len += 2; break;
+            default:
+                o[1] = 'u'; o[2] = '0'; o[3] = '0'; o[4] = hex[c >> 4]; o[5] = hex[c & 15];
+                b->len += 6;
+        }
+    }
+    o = _tr_strbuf_grow(b, 1);
+    *o = '"';
+    b->len++;
+    b->data[b->len] = '\0';
+}
+
+/* Decimal integer, two digits per step from a pair table. */
+static inline void _tr_json_put_int(void* bp, long long v) {
+    static const char d2[] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+    char tmp[24];
+    char* e = tmp + sizeof tmp;
+    char* p = e;
+    unsigned long long x = v < 0 ? 0ULL - (unsigned long long)v : (unsigned long long)v;
+    while (x >= 100) { unsigned r = (unsigned)(x % 100); x /= 100; p -= 2; memcpy(p, d2 + 2 * r, 2); }
+    if (x >= 10) { p -= 2; memcpy(p, d2 + 2 * x, 2); }
+    else *--p = (char)('0' + x);
+    if (v < 0) *--p = '-';
+    _tr_json_put_raw(bp, p, (long long)(e - p));
+}
+
+/* Shortest of %.15g / %.17g that reads back exactly; integral values print
+ * as "N.0" without going through printf, NaN and infinities as null. */
+static void _tr_json_put_float(void* bp, double v) {
+    if (v != v || v - v != 0) { _tr_json_put_raw(bp, "null", 4); return; }
+    if (v > -1e15 && v < 1e15 && v == (double)(long long)v) {
+        _tr_json_put_int(bp, (long long)v);
+        _tr_json_put_raw(bp, ".0", 2);
+        return;
+    }
+    char tmp[32];
+    int k = snprintf(tmp, sizeof tmp, "%.15g", v);
+    if (strtod(tmp, NULL) != v) k = snprintf(tmp, sizeof tmp, "%.17g", v);
+    _tr_json_put_raw(bp, tmp, k);
+}
+
+/* HTTP framing for HttpConn.begin_json: the connection's output buffer holds
+ * [header prefix | gap | body] with the body starting at `body`. Each helper
+ * writes what goes between prefix and body, slides the prefix up to meet it,
+ * and returns the offset to send from, so the body is never copied. */
+static long long _tr_http_frame_head(_TrStrBuf* b, long long plen, long long body, const char* tail, long long tn) {
+    long long start = body - tn - plen;
+    memcpy(b->data + body - tn, tail, (size_t)tn);
+    if (start != 0) memmove(b->data + start, b->data, (size_t)plen);
+    return start;
+}
+
+/* Content-Length response. */
+static long long _tr_http_frame_length(void* bp, long long plen, long long body) {
+    _TrStrBuf* b = (_TrStrBuf*)bp;
+    char tail[48];
+    int tn = snprintf(tail, sizeof tail, "Content-Length: %lld\r\n\r\n", b->len - body);
+    return _tr_http_frame_head(b, plen, body, tail, tn);
+}
+
+/* One chunk of a chunked response (plen > 0: the first, which also carries the
+ * header prefix). Appends the chunk's CRLF, plus the final 0-chunk if last. */
+static long long _tr_http_frame_chunk(void* bp, long long plen, long long body, bool last) {
+    _TrStrBuf* b = (_TrStrBuf*)bp;
+    long long n = b->len - body;
+    char tail[64];
+    int tn = 0;
+    if (plen > 0) tn = snprintf(tail, sizeof tail, "Transfer-Encoding: chunked\r\n\r\n");
+    long long start = body;
+    if (n > 0) {
+        tn += snprintf(tail + tn, sizeof tail - (size_t)tn, "%llx\r\n", (unsigned long long)n);
+        _tr_json_put_raw(b, "\r\n", 2);
+    }
+    if (last) _tr_json_put_raw(b, "0\r\n\r\n", 5);
+    if (tn > 0) start = _tr_http_frame_head(b, plen, body, tail, tn);
+    return start;
+}
+
+/* Pick a response Content-Coding from an Accept-Encoding value (p[0..n)):
+ * 2 = gzip, 0 = deflate (the zlib format, per RFC 9110), -1 = none. The
+ * coding with the higher q wins, gzip on a tie; q=0 refuses a coding and
+ * "*" stands for any coding not listed. */
+static int _tr_http_pick_coding(const char* p, long long n) {
+    int qg = -1, qd = -1, qs = -1;   /* q * 1000, -1 = not mentioned */
+    long long i = 0;
+    while (p && i < n) {
+        while (i < n && (p[i] == ' ' || p[i] == '\t' || p[i] == ',')) i++;
+        long long t0 = i;
+        while (i < n && p[i] != ',' && p[i] != ';' && p[i] != ' ' && p[i] != '\t') i++;
+        long long tl = i - t0;
+        int q = 1000;
+        while (i < n && p[i] != ',') {
+            if ((p[i] == 'q' || p[i] == 'Q') && i + 1 < n && p[i + 1] == '=') {
+                i += 2;
+                q = 0;
+                if (i < n && p[i] == '1') q = 1000;
+                else if (i < n && p[i] == '0') {
+                    i++;
+                    if (i < n && p[i] == '.') {
+                        i++;
+                        for (int d = 100; d > 0 && i < n && p[i] >= '0' && p[i] <= '9'; d /= 10, i++)
+                            q += (p[i] - '0') * d;
+                    }
+                }
+                continue;
+            }
+            i++;
+        }
+        if (tl == 4 && (p[t0] | 32) == 'g' && (p[t0+1] | 32) == 'z' && (p[t0+2] | 32) == 'i' && (p[t0+3] | 32) == 'p') qg = q;
+        else if (tl == 6 && (p[t0] | 32) == 'x' && (p[t0+1] | 32) == '-' && (p[t0+2] | 32) == 'g' && (p[t0+3] | 32) == 'z' && (p[t0+4] | 32) == 'i' && (p[t0+5] | 32) == 'p') { if (qg < 0) qg = q; }
+        else if (tl == 7 && (p[t0] | 32) == 'd' && (p[t0+1] | 32) == 'e' && (p[t0+2] | 32) == 'f' && (p[t0+3] | 32) == 'l' && (p[t0+4] | 32) == 'a' && (p[t0+5] | 32) == 't' && (p[t0+6] | 32) == 'e') qd = q;
+        else if (tl == 1 && p[t0] == '*') qs = q;
+    }
+    if (qg < 0) qg = qs;
+    if (qd < 0) qd = qs;
+    if (qg <= 0 && qd <= 0) return -1;
+    return qg >= qd ? 2 : 0;
+}
+
+/* Resolve a Range header value (p[0..n)) against a body of `size` bytes.
+ * Only a single "bytes=" range is honoured: "a-b", "a-" or the suffix "-n",
+ * with b clamped to the end. Returns the first byte (which == 0) or the last
+ * byte, inclusive (which == 1); -1 = no usable range (absent, malformed or
+ * several ranges: serve the whole body), -2 = unsatisfiable (416). */
+static long long _tr_http_range(const char* p, long long n, long long size, long long which) {
+    long long i = 0;
+    while (p && i < n && (p[i] == ' ' || p[i] == '\t')) i++;
+    if (!p || n - i < 6 || memcmp(p + i, "bytes=", 6) != 0) return -1;
+    i += 6;
+    for (long long k = i; k < n; k++) if (p[k] == ',') return -1;
+    while (i < n && p[i] == ' ') i++;
+    long long a = -1, b = -1;
+    if (i < n && p[i] >= '0' && p[i] <= '9') {
+        a = 0;
+        while (i < n && p[i] >= '0' && p[i] <= '9') { if (a > (1LL << 58)) return -1; a = a * 10 + (p[i++] - '0'); }
+    }
+    if (i >= n || p[i] != '-') return -1;
+    i++;
+    if (i < n && p[i] >= '0' && p[i] <= '9') {
+        b = 0;
+        while (i < n && p[i] >= '0' && p[i] <= '9') { if (b > (1LL << 58)) return -1; b = b * 10 + (p[i++] - '0'); }
+    }
+    while (i < n && (p[i] == ' ' || p[i] == '\t')) i++;
+    if (i != n || (a < 0 && b < 0)) return -1;
+    long long first, last;
+    if (a < 0) {                                   /* suffix: the last b bytes */
+        if (b == 0 || size == 0) return -2;
+        first = b >= size ? 0 : size - b;
+        last  = size - 1;
+    } else {
+        if (b >= 0 && b < a) return -1;
+        if (a >= size) return -2;
+        first = a;
+        last  = (b < 0 || b >= size) ? size - 1 : b;
+    }
+    return which == 0 ? first : last;
+}
+
 /* ── Test runner helpers ─────────────────────────────────────────────── */
 
 _TR_GLOBAL int _tr_tests_passed;
@@ -4641,42 +10349,54 @@ static inline void _tr_init_console(void) {}
    ========================================================================== */
 
 /* -- DateTime helpers ------------------------------------------------------ */
+_TR_COLD int _tr_tm_year(long long ts);
+_TR_COLD int _tr_tm_month(long long ts);
+_TR_COLD int _tr_tm_day(long long ts);
+_TR_COLD int _tr_tm_hour(long long ts);
+_TR_COLD int _tr_tm_min(long long ts);
+_TR_COLD int _tr_tm_sec(long long ts);
+_TR_COLD int _tr_tm_weekday(long long ts);
+_TR_COLD int _tr_tm_yearday(long long ts);
+_TR_COLD long long _tr_tm_make(int year,int month,int day,int hour,int mi,int sec);
+_TR_COLD char* _tr_strftime(long long ts, const char* fmt);
+#if _TR_COLD_BODIES
 #ifdef _TR_HAS_TIME
-static inline int    _tr_tm_year(long long ts)    { time_t t=(time_t)ts; struct tm* m=localtime(&t); return m->tm_year+1900; }
-static inline int    _tr_tm_month(long long ts)   { time_t t=(time_t)ts; struct tm* m=localtime(&t); return m->tm_mon+1; }
-static inline int    _tr_tm_day(long long ts)     { time_t t=(time_t)ts; struct tm* m=localtime(&t); return m->tm_mday; }
-static inline int    _tr_tm_hour(long long ts)    { time_t t=(time_t)ts; struct tm* m=localtime(&t); return m->tm_hour; }
-static inline int    _tr_tm_min(long long ts)     { time_t t=(time_t)ts; struct tm* m=localtime(&t); return m->tm_min; }
-static inline int    _tr_tm_sec(long long ts)     { time_t t=(time_t)ts; struct tm* m=localtime(&t); return m->tm_sec; }
-static inline int    _tr_tm_weekday(long long ts) { time_t t=(time_t)ts; struct tm* m=localtime(&t); return m->tm_wday; }
-static inline int    _tr_tm_yearday(long long ts) { time_t t=(time_t)ts; struct tm* m=localtime(&t); return m->tm_yday+1; }
-static inline long long _tr_tm_make(int year,int month,int day,int hour,int mi,int sec) {
+_TR_COLD int    _tr_tm_year(long long ts)    { time_t t=(time_t)ts; struct tm* m=localtime(&t); return m->tm_year+1900; }
+_TR_COLD int    _tr_tm_month(long long ts)   { time_t t=(time_t)ts; struct tm* m=localtime(&t); return m->tm_mon+1; }
+_TR_COLD int    _tr_tm_day(long long ts)     { time_t t=(time_t)ts; struct tm* m=localtime(&t); return m->tm_mday; }
+_TR_COLD int    _tr_tm_hour(long long ts)    { time_t t=(time_t)ts; struct tm* m=localtime(&t); return m->tm_hour; }
+_TR_COLD int    _tr_tm_min(long long ts)     { time_t t=(time_t)ts; struct tm* m=localtime(&t); return m->tm_min; }
+_TR_COLD int    _tr_tm_sec(long long ts)     { time_t t=(time_t)ts; struct tm* m=localtime(&t); return m->tm_sec; }
+_TR_COLD int    _tr_tm_weekday(long long ts) { time_t t=(time_t)ts; struct tm* m=localtime(&t); return m->tm_wday; }
+_TR_COLD int    _tr_tm_yearday(long long ts) { time_t t=(time_t)ts; struct tm* m=localtime(&t); return m->tm_yday+1; }
+_TR_COLD long long _tr_tm_make(int year,int month,int day,int hour,int mi,int sec) {
     struct tm t; memset(&t,0,sizeof(t));
     t.tm_year=year-1900; t.tm_mon=month-1; t.tm_mday=day;
     t.tm_hour=hour; t.tm_min=mi; t.tm_sec=sec; t.tm_isdst=-1;
     return (long long)mktime(&t);
 }
-static inline char* _tr_strftime(long long ts, const char* fmt) {
+_TR_COLD char* _tr_strftime(long long ts, const char* fmt) {
     time_t t=(time_t)ts; struct tm* m=localtime(&t);
     char* buf=(char*)_tr_c_malloc(256); if(!buf) return _tr_empty_heap_str();
     strftime(buf,256,fmt,m); return buf;
 }
 #else  /* no <time.h> (bare toolchain): no calendar/RTC — stub the datetime helpers */
-static inline int    _tr_tm_year(long long ts)    { (void)ts; return 1970; }
-static inline int    _tr_tm_month(long long ts)   { (void)ts; return 1; }
-static inline int    _tr_tm_day(long long ts)     { (void)ts; return 1; }
-static inline int    _tr_tm_hour(long long ts)    { (void)ts; return 0; }
-static inline int    _tr_tm_min(long long ts)     { (void)ts; return 0; }
-static inline int    _tr_tm_sec(long long ts)     { (void)ts; return 0; }
-static inline int    _tr_tm_weekday(long long ts) { (void)ts; return 0; }
-static inline int    _tr_tm_yearday(long long ts) { (void)ts; return 1; }
-static inline long long _tr_tm_make(int year,int month,int day,int hour,int mi,int sec) {
+_TR_COLD int    _tr_tm_year(long long ts)    { (void)ts; return 1970; }
+_TR_COLD int    _tr_tm_month(long long ts)   { (void)ts; return 1; }
+_TR_COLD int    _tr_tm_day(long long ts)     { (void)ts; return 1; }
+_TR_COLD int    _tr_tm_hour(long long ts)    { (void)ts; return 0; }
+_TR_COLD int    _tr_tm_min(long long ts)     { (void)ts; return 0; }
+_TR_COLD int    _tr_tm_sec(long long ts)     { (void)ts; return 0; }
+_TR_COLD int    _tr_tm_weekday(long long ts) { (void)ts; return 0; }
+_TR_COLD int    _tr_tm_yearday(long long ts) { (void)ts; return 1; }
+_TR_COLD long long _tr_tm_make(int year,int month,int day,int hour,int mi,int sec) {
     (void)year;(void)month;(void)day;(void)hour;(void)mi;(void)sec; return 0LL;
 }
-static inline char* _tr_strftime(long long ts, const char* fmt) {
+_TR_COLD char* _tr_strftime(long long ts, const char* fmt) {
     (void)ts;(void)fmt; return _tr_empty_heap_str();
 }
 #endif
+#endif /* _TR_COLD_BODIES */
 
 /* -- OS / System helpers (platform-specific) ------------------------------- */
 #if defined(TAURARO_BARE) && !defined(__wasi__)
@@ -4729,6 +10449,11 @@ static inline int _tr_tcp_listen(const char* host,int port,int backlog) {
     if(listen(s,backlog)!=0){closesocket(s);return -1;}
     return (int)s;
 }
+/* Winsock has no SO_REUSEPORT load balancing: -1 tells the caller to fall
+ * back to one shared listener. */
+static inline int _tr_tcp_listen_reuseport(const char* host,int port,int backlog) {
+    (void)host; (void)port; (void)backlog; return -1;
+}
 /* Disable Nagle's algorithm: without this, every small HTTP response gets
  * delayed ~40ms by Nagle + the peer's delayed-ACK timer, capping keep-alive
  * request latency at ~20-40ms regardless of how fast the handler itself is. */
@@ -4770,6 +10495,34 @@ static inline char* _tr_dns_resolve(const char* host) {
     inet_ntop(AF_INET,&((struct sockaddr_in*)res->ai_addr)->sin_addr,ip,64);
     freeaddrinfo(res); return ip;
 }
+/* Windows has no resolv.conf: these go through getaddrinfo, uncached. */
+static inline char* _tr_dns_resolve6(const char* host) {
+    _tr_net_init();
+    struct addrinfo hints={0},*res=NULL; hints.ai_family=AF_INET6;
+    if(getaddrinfo(host,NULL,&hints,&res)!=0) return _tr_empty_heap_str();
+    char* ip=(char*)_tr_c_malloc(64);
+    inet_ntop(AF_INET6,&((struct sockaddr_in6*)res->ai_addr)->sin6_addr,ip,64);
+    freeaddrinfo(res); return ip;
+}
+static inline char* _tr_dns_resolve_all(const char* host) {
+    _tr_net_init();
+    struct addrinfo hints={0},*res=NULL; hints.ai_family=AF_UNSPEC; hints.ai_socktype=SOCK_STREAM;
+    if(getaddrinfo(host,NULL,&hints,&res)!=0) return _tr_empty_heap_str();
+    int n=0; for(struct addrinfo* r=res;r;r=r->ai_next) n++;
+    char* s=(char*)_tr_c_malloc((size_t)n*48+1); size_t p=0;
+    for(int fam=0;fam<2;fam++) for(struct addrinfo* r=res;r;r=r->ai_next){
+        if(r->ai_family!=(fam?AF_INET6:AF_INET)) continue;
+        if(p) s[p++]='\n';
+        if(fam) inet_ntop(AF_INET6,&((struct sockaddr_in6*)r->ai_addr)->sin6_addr,s+p,47);
+        else    inet_ntop(AF_INET,&((struct sockaddr_in*)r->ai_addr)->sin_addr,s+p,47);
+        p+=strlen(s+p);
+    }
+    s[p]=0; freeaddrinfo(res); return s;
+}
+static inline int  _tr_dns_use_nameserver(const char* ip, long long port) { (void)ip;(void)port; return -1; }
+static inline void _tr_dns_set_timeout(long long ms, long long attempts)  { (void)ms;(void)attempts; }
+static inline void _tr_dns_cache_clear(void)                               { }
+static inline long long _tr_dns_queries(void)                              { return 0; }
 static inline char* _tr_dns_reverse(const char* ip) {
     struct sockaddr_in a; memset(&a,0,sizeof(a));
     a.sin_family=AF_INET; inet_pton(AF_INET,ip,&a.sin_addr);
@@ -4836,12 +10589,32 @@ static inline long long _tr_memory_total_mb(void) {
     return (p>0&&s>0)?(long long)p*s/(1024LL*1024LL):0;
 }
 static inline int _tr_tcp_listen(const char* host,int port,int backlog) {
+    _tr_net_init();
+    int s=socket(AF_INET,SOCK_STREAM,0); if(s<0) return -1;
+    int opt=1; setsockopt(s,SOL_SOCKET,SO_REUSEADDR,&opt,sizeof(opt));
+    struct sockaddr_in a; memset(&a,0,sizeof(a));
+    a.sin_family=AF_INET; a.sin_port=htons((unsigned short)port); a.sin_addr.s_addr=INADDR_ANY;
+    if(bind(s,(struct sockaddr*)&a,sizeof(a))<0){close(s);return -1;}
+    if(listen(s,backlog)<0){close(s);return -1;} return s;
+}
+/* Like _tr_tcp_listen, but with SO_REUSEPORT set before bind: several
+ * sockets can listen on the same port and the kernel spreads incoming
+ * connections across them (Linux >= 3.9 hashes per 4-tuple). Returns -1 when
+ * the platform has no SO_REUSEPORT, so the caller falls back to one shared
+ * listener. */
+static inline int _tr_tcp_listen_reuseport(const char* host,int port,int backlog) {
+#ifdef SO_REUSEPORT
+    _tr_net_init();
     int s=socket(AF_INET,SOCK_STREAM,0); if(s<0) return -1;
     int opt=1; setsockopt(s,SOL_SOCKET,SO_REUSEADDR,&opt,sizeof(opt));
+    if(setsockopt(s,SOL_SOCKET,SO_REUSEPORT,&opt,sizeof(opt))<0){close(s);return -1;}
     struct sockaddr_in a; memset(&a,0,sizeof(a));
     a.sin_family=AF_INET; a.sin_port=htons((unsigned short)port); a.sin_addr.s_addr=INADDR_ANY;
     if(bind(s,(struct sockaddr*)&a,sizeof(a))<0){close(s);return -1;}
     if(listen(s,backlog)<0){close(s);return -1;} return s;
+#else
+    (void)host; (void)port; (void)backlog; return -1;
+#endif
 }
 /* Disable Nagle's algorithm: without this, every small HTTP response gets
  * delayed ~40ms by Nagle + the peer's delayed-ACK timer, capping keep-alive
@@ -4876,13 +10649,6 @@ static inline int  _tr_udp_recv_from(int fd,char* buf,int cap,char* src) {
     return n;
 }
 static inline void _tr_udp_close(int fd) { close(fd); }
-static inline char* _tr_dns_resolve(const char* host) {
-    struct addrinfo hints={0},*res=NULL; hints.ai_family=AF_INET;
-    if(getaddrinfo(host,NULL,&hints,&res)!=0) return _tr_empty_heap_str();
-    char* ip=(char*)_tr_c_malloc(64);
-    inet_ntop(AF_INET,&((struct sockaddr_in*)res->ai_addr)->sin_addr,ip,64);
-    freeaddrinfo(res); return ip;
-}
 static inline char* _tr_dns_reverse(const char* ip) {
     struct sockaddr_in a; memset(&a,0,sizeof(a));
     a.sin_family=AF_INET; inet_pton(AF_INET,ip,&a.sin_addr);
@@ -4894,6 +10660,350 @@ static inline void _tr_console_reset(void)     { printf("\033[0m"); fflush(stdou
 static inline void _tr_console_clear(void)     { printf("\033[2J\033[H"); fflush(stdout); }
 #endif
 
+/* ── Batched UDP (std.net.udp UdpAddr / UdpBatch) ───────────────────────── *
+ * A UdpBatch is a pool of n slots of cap bytes, allocated once with the   *
+ * length and address of each slot. recv_batch fills up to n datagrams    *
+ * with one recvmmsg and send_batch sends everything queued with one      *
+ * sendmmsg (Linux; a recvfrom / sendto loop elsewhere). With GSO on, a   *
+ * run of equal-size messages to one destination goes out as a single    *
+ * UDP_SEGMENT send, and on a socket with UDP_GRO the coalesced runs the  *
+ * kernel hands up are split back into datagrams here. Every call is      *
+ * MSG_DONTWAIT: one that would block parks on the reactor in a coroutine *
+ * and polls outside one. A UdpAddr is a resolved sockaddr_in, so a send  *
+ * does not parse or look up the host again.                              */
+#if defined(TAURARO_BARE) || defined(TAURARO_WASM) || defined(_WIN32)
+static inline char* _tr_udp_addr(const char* h, int p)                       { (void)h;(void)p; return NULL; }
+static inline char* _tr_udp_addr_str(char* a)                                { (void)a; return _tr_empty_heap_str(); }
+static inline void  _tr_udp_addr_free(char* a)                               { (void)a; }
+static inline int   _tr_udp_send_addr(int fd, const char* d, int l, char* a) { (void)fd;(void)d;(void)l;(void)a; return -1; }
+static inline int   _tr_udp_set_gro(int fd, bool on)                         { (void)fd;(void)on; return -1; }
+static inline int   _tr_udp_set_rcvbuf(int fd, int bytes)                    { (void)fd;(void)bytes; return -1; }
+static inline char* _tr_udp_batch_new(int n, int cap)                        { (void)n;(void)cap; return NULL; }
+static inline void  _tr_udp_batch_free(char* h)                              { (void)h; }
+static inline void  _tr_udp_batch_set_gso(char* h, bool on)                  { (void)h;(void)on; }
+static inline void  _tr_udp_batch_clear(char* h)                             { (void)h; }
+static inline int   _tr_udp_batch_add(char* h, const char* d, int l, char* a) { (void)h;(void)d;(void)l;(void)a; return -1; }
+static inline int   _tr_udp_batch_queued(char* h)                            { (void)h; return 0; }
+static inline int   _tr_udp_batch_count(char* h)                             { (void)h; return 0; }
+static inline int   _tr_udp_batch_len(char* h, int i)                        { (void)h;(void)i; return 0; }
+static inline char* _tr_udp_batch_ptr(char* h, int i)                        { (void)h;(void)i; return NULL; }
+static inline char* _tr_udp_batch_str(char* h, int i)                        { (void)h;(void)i; return _tr_empty_heap_str(); }
+static inline char* _tr_udp_batch_src(char* h, int i)                        { (void)h;(void)i; return _tr_empty_heap_str(); }
+static inline char* _tr_udp_batch_src_addr(char* h, int i)                   { (void)h;(void)i; return NULL; }
+static inline int   _tr_udp_recv_batch(int fd, char* h, int max, bool wait)  { (void)fd;(void)h;(void)max;(void)wait; return -1; }
+static inline int   _tr_udp_send_batch(int fd, char* h)                      { (void)fd;(void)h; return -1; }
+#else
+#ifdef __linux__
+#include <netinet/udp.h>
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#endif
+#define _TR_UDP_GSO_MAX  64        /* segments per GSO send (the kernel's limit) */
+#define _TR_UDP_GSO_SIZE 65507     /* payload bytes per GSO send */
+#define _TR_UDP_CTL      64        /* control bytes per slot: one UDP_SEGMENT / UDP_GRO cmsg */
+
+typedef struct {
+    int n, cap, used;              /* slots, bytes per slot, slots filled */
+    int gso;                       /* coalesce equal-size runs on send */
+    char* data;                    /* n * cap bytes */
+    int* len;                      /* bytes in each slot */
+    struct sockaddr_in* addr;      /* source (recv) or destination (send) */
+    int nv, vcap;                  /* datagrams from the last recv: GRO can */
+    int* voff; int* vlen; int* vslot;  /* pack several into one slot */
+#ifdef __linux__
+    struct mmsghdr* hdr;
+    struct iovec* iov;
+    int* run;                      /* slots covered by each hdr on send */
+    char* ctl;                     /* n * _TR_UDP_CTL */
+#endif
+} _TrUdpBatch;
+
+static inline char* _tr_udp_addr(const char* host, int port) {
+    _TrDnsAddr a[_TR_DNS_ADDRS];
+    if (_tr_dns_lookup(host, 1, a) < 1) return NULL;
+    struct sockaddr_in* s = (struct sockaddr_in*)TAURARO_CALLOC(1, sizeof(struct sockaddr_in));
+    s->sin_family = AF_INET;
+    s->sin_port = htons((unsigned short)port);
+    memcpy(&s->sin_addr, a[0].a, 4);
+    return (char*)s;
+}
+static inline char* _tr_udp_sa_text(const struct sockaddr_in* s) {
+    char ip[32];
+    char* out = (char*)_tr_c_malloc(64);
+    inet_ntop(AF_INET, &s->sin_addr, ip, sizeof ip);
+    snprintf(out, 64, "%s:%d", ip, (int)ntohs(s->sin_port));
+    return out;
+}
+static inline char* _tr_udp_addr_str(char* a) { return a ? _tr_udp_sa_text((struct sockaddr_in*)a) : _tr_empty_heap_str(); }
+static inline void  _tr_udp_addr_free(char* a) { TAURARO_FREE(a); }
+
+/* Park until fd is readable / writable: on the reactor in a coroutine,
+ * poll() outside one. */
+static inline void _tr_udp_wait(int fd, unsigned int ev) {
+    if (_tr_sched_cur()->current) { _tr_co_await_fd(fd, ev); return; }
+    struct pollfd pf;
+    pf.fd = fd; pf.events = ev == TAURARO_POLLIN ? POLLIN : POLLOUT; pf.revents = 0;
+    while (poll(&pf, 1, -1) < 0 && errno == EINTR) {}
+}
+static inline bool _tr_udp_again(void) { return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR; }
+
+/* len < 0: up to the NUL. */
+static inline int _tr_udp_send_addr(int fd, const char* data, int len, char* a) {
+    if (!a) return -1;
+    if (len < 0) len = (int)strlen(data);
+    for (;;) {
+        int r = (int)sendto(fd, data, (size_t)len, MSG_DONTWAIT, (struct sockaddr*)a, sizeof(struct sockaddr_in));
+        if (r >= 0 || !_tr_udp_again()) return r;
+        if (errno != EINTR) _tr_udp_wait(fd, TAURARO_POLLOUT);
+    }
+}
+
+/* Coalesced receive: the kernel then hands up runs of same-size datagrams
+ * as one, so slots should have room for 64 KiB. */
+static inline int _tr_udp_set_gro(int fd, bool on) {
+#if defined(__linux__)
+    int v = on ? 1 : 0;
+    return setsockopt(fd, SOL_UDP, UDP_GRO, &v, sizeof v) == 0 ? 0 : -1;
+#else
+    (void)fd; (void)on; return -1;
+#endif
+}
+/* Ask for a receive buffer of `bytes`; returns what the kernel granted. */
+static inline int _tr_udp_set_rcvbuf(int fd, int bytes) {
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bytes, sizeof bytes);
+    int got = 0; socklen_t gl = sizeof got;
+    return getsockopt(fd, SOL_SOCKET, SO_RCVBUF, &got, &gl) == 0 ? got : -1;
+}
+
+static inline char* _tr_udp_batch_new(int n, int cap) {
+    if (n < 1) n = 1;
+    if (n > 1024) n = 1024;
+    if (cap < 1) cap = 1;
+    if (cap > 65535) cap = 65535;
+    _TrUdpBatch* b = (_TrUdpBatch*)TAURARO_CALLOC(1, sizeof(_TrUdpBatch));
+    b->n = n; b->cap = cap; b->vcap = n;
+    b->data  = (char*)TAURARO_ALLOC((size_t)n * (size_t)cap);
+    b->len   = (int*)TAURARO_CALLOC((size_t)n, sizeof(int));
+    b->addr  = (struct sockaddr_in*)TAURARO_CALLOC((size_t)n, sizeof(struct sockaddr_in));
+    b->voff  = (int*)TAURARO_ALLOC((size_t)n * sizeof(int));
+    b->vlen  = (int*)TAURARO_ALLOC((size_t)n * sizeof(int));
+    b->vslot = (int*)TAURARO_ALLOC((size_t)n * sizeof(int));
+#ifdef __linux__
+    b->hdr = (struct mmsghdr*)TAURARO_CALLOC((size_t)n, sizeof(struct mmsghdr));
+    b->iov = (struct iovec*)TAURARO_CALLOC((size_t)n, sizeof(struct iovec));
+    b->run = (int*)TAURARO_CALLOC((size_t)n, sizeof(int));
+    b->ctl = (char*)TAURARO_CALLOC((size_t)n, _TR_UDP_CTL);
+#endif
+    return (char*)b;
+}
+static inline void _tr_udp_batch_free(char* h) {
+    _TrUdpBatch* b = (_TrUdpBatch*)h;
+    if (!b) return;
+    TAURARO_FREE(b->data); TAURARO_FREE(b->len); TAURARO_FREE(b->addr);
+    TAURARO_FREE(b->voff); TAURARO_FREE(b->vlen); TAURARO_FREE(b->vslot);
+#ifdef __linux__
+    TAURARO_FREE(b->hdr); TAURARO_FREE(b->iov); TAURARO_FREE(b->run); TAURARO_FREE(b->ctl);
+#endif
+    TAURARO_FREE(b);
+}
+static inline void _tr_udp_batch_set_gso(char* h, bool on) { ((_TrUdpBatch*)h)->gso = on ? 1 : 0; }
+static inline void _tr_udp_batch_clear(char* h) { _TrUdpBatch* b = (_TrUdpBatch*)h; b->used = 0; b->nv = 0; }
+static inline int  _tr_udp_batch_queued(char* h) { return ((_TrUdpBatch*)h)->used; }
+
+/* Queue len bytes (len < 0: up to the NUL) for `a`: 0, or -1 when the
+ * batch is full or the message does not fit a slot. */
+static inline int _tr_udp_batch_add(char* h, const char* data, int len, char* a) {
+    _TrUdpBatch* b = (_TrUdpBatch*)h;
+    if (len < 0) len = (int)strlen(data);
+    if (!a || b->used >= b->n || len > b->cap) return -1;
+    int i = b->used++;
+    memcpy(b->data + (size_t)i * (size_t)b->cap, data, (size_t)len);
+    b->len[i] = len;
+    b->addr[i] = *(struct sockaddr_in*)a;
+    b->nv = 0;
+    return 0;
+}
+
+static inline void _tr_udp_view(_TrUdpBatch* b, int slot, int off, int len) {
+    if (b->nv == b->vcap) {
+        b->vcap *= 2;
+        b->voff  = (int*)TAURARO_REALLOC(b->voff,  (size_t)b->vcap * sizeof(int));
+        b->vlen  = (int*)TAURARO_REALLOC(b->vlen,  (size_t)b->vcap * sizeof(int));
+        b->vslot = (int*)TAURARO_REALLOC(b->vslot, (size_t)b->vcap * sizeof(int));
+    }
+    b->voff[b->nv] = off; b->vlen[b->nv] = len; b->vslot[b->nv] = slot;
+    b->nv++;
+}
+
+static inline int _tr_udp_batch_count(char* h) { return ((_TrUdpBatch*)h)->nv; }
+static inline int _tr_udp_batch_len(char* h, int i) {
+    _TrUdpBatch* b = (_TrUdpBatch*)h;
+    return i >= 0 && i < b->nv ? b->vlen[i] : 0;
+}
+/* Datagram i in place: valid until the next recv into the batch. */
+static inline char* _tr_udp_batch_ptr(char* h, int i) {
+    _TrUdpBatch* b = (_TrUdpBatch*)h;
+    if (i < 0 || i >= b->nv) return NULL;
+    return b->data + (size_t)b->vslot[i] * (size_t)b->cap + b->voff[i];
+}
+static inline char* _tr_udp_batch_str(char* h, int i) {
+    _TrUdpBatch* b = (_TrUdpBatch*)h;
+    if (i < 0 || i >= b->nv) return _tr_empty_heap_str();
+    char* s = (char*)_tr_c_malloc((size_t)b->vlen[i] + 1);
+    memcpy(s, _tr_udp_batch_ptr(h, i), (size_t)b->vlen[i]);
+    s[b->vlen[i]] = '\0';
+    return s;
+}
+static inline char* _tr_udp_batch_src(char* h, int i) {
+    _TrUdpBatch* b = (_TrUdpBatch*)h;
+    if (i < 0 || i >= b->nv) return _tr_empty_heap_str();
+    return _tr_udp_sa_text(&b->addr[b->vslot[i]]);
+}
+/* The sender of datagram i as a new UdpAddr, for replies. */
+static inline char* _tr_udp_batch_src_addr(char* h, int i) {
+    _TrUdpBatch* b = (_TrUdpBatch*)h;
+    if (i < 0 || i >= b->nv) return NULL;
+    struct sockaddr_in* s = (struct sockaddr_in*)TAURARO_ALLOC(sizeof(struct sockaddr_in));
+    *s = b->addr[b->vslot[i]];
+    return (char*)s;
+}
+
+/* Up to max datagrams into slots 0.. without blocking: slots filled, or -1
+ * with errno set. */
+static inline int _tr_udp_recv_some(int fd, _TrUdpBatch* b, int max) {
+#ifdef __linux__
+    for (int i = 0; i < max; i++) {
+        struct msghdr* m = &b->hdr[i].msg_hdr;
+        b->iov[i].iov_base = b->data + (size_t)i * (size_t)b->cap;
+        b->iov[i].iov_len = (size_t)b->cap;
+        m->msg_name = &b->addr[i]; m->msg_namelen = sizeof(struct sockaddr_in);
+        m->msg_iov = &b->iov[i]; m->msg_iovlen = 1;
+        m->msg_control = b->ctl + (size_t)i * _TR_UDP_CTL; m->msg_controllen = _TR_UDP_CTL;
+        m->msg_flags = 0;
+    }
+    int r = recvmmsg(fd, b->hdr, (unsigned)max, MSG_DONTWAIT, NULL);
+    for (int i = 0; i < r; i++) {
+        int len = (int)b->hdr[i].msg_len, seg = 0;
+        struct msghdr* m = &b->hdr[i].msg_hdr;
+        for (struct cmsghdr* c = CMSG_FIRSTHDR(m); c; c = CMSG_NXTHDR(m, c))
+            if (c->cmsg_level == SOL_UDP && c->cmsg_type == UDP_GRO) memcpy(&seg, CMSG_DATA(c), sizeof seg);
+        b->len[i] = len;
+        if (seg > 0 && len > seg)
+            for (int off = 0; off < len; off += seg) _tr_udp_view(b, i, off, len - off < seg ? len - off : seg);
+        else
+            _tr_udp_view(b, i, 0, len);
+    }
+    return r;
+#else
+    int i = 0;
+    for (; i < max; i++) {
+        socklen_t al = sizeof(struct sockaddr_in);
+        int r = (int)recvfrom(fd, b->data + (size_t)i * (size_t)b->cap, (size_t)b->cap, MSG_DONTWAIT,
+                              (struct sockaddr*)&b->addr[i], &al);
+        if (r < 0) break;
+        b->len[i] = r;
+        _tr_udp_view(b, i, 0, r);
+    }
+    return i > 0 ? i : -1;
+#endif
+}
+
+/* Receive into the batch: the number of datagrams, 0 when wait is false and
+ * none is pending, -1 on error. Waits for the first datagram only; the rest
+ * are whatever else is already queued, up to max slots. */
+static inline int _tr_udp_recv_batch(int fd, char* h, int max, bool wait) {
+    _TrUdpBatch* b = (_TrUdpBatch*)h;
+    if (!b || fd < 0) return -1;
+    if (max <= 0 || max > b->n) max = b->n;
+    for (;;) {
+        b->used = 0; b->nv = 0;
+        int r = _tr_udp_recv_some(fd, b, max);
+        if (r > 0) { b->used = r; return b->nv; }
+        if (r == 0) return 0;
+        if (!_tr_udp_again()) return -1;
+        if (errno == EINTR) continue;
+        if (!wait) return 0;
+        _tr_udp_wait(fd, TAURARO_POLLIN);
+    }
+}
+
+/* Queued slots from `from` on without blocking: how many went, or -1 with
+ * errno set. */
+static inline int _tr_udp_send_some(int fd, _TrUdpBatch* b, int from) {
+#ifdef __linux__
+    int nm = 0, any_gso = 0;
+    for (int i = from; i < b->used; ) {
+        int cnt = 1, total = b->len[i];
+        /* a GSO run: equal-size slots to one destination, the last may be shorter */
+        while (b->gso && b->len[i] > 0 && i + cnt < b->used && cnt < _TR_UDP_GSO_MAX
+               && b->len[i + cnt - 1] == b->len[i] && b->len[i + cnt] <= b->len[i]
+               && total + b->len[i + cnt] <= _TR_UDP_GSO_SIZE
+               && memcmp(&b->addr[i + cnt], &b->addr[i], sizeof(struct sockaddr_in)) == 0) {
+            total += b->len[i + cnt];
+            cnt++;
+        }
+        for (int k = i; k < i + cnt; k++) {
+            b->iov[k].iov_base = b->data + (size_t)k * (size_t)b->cap;
+            b->iov[k].iov_len = (size_t)b->len[k];
+        }
+        struct msghdr* m = &b->hdr[nm].msg_hdr;
+        memset(m, 0, sizeof *m);
+        m->msg_name = &b->addr[i]; m->msg_namelen = sizeof(struct sockaddr_in);
+        m->msg_iov = &b->iov[i]; m->msg_iovlen = (size_t)cnt;
+        if (cnt > 1) {
+            uint16_t seg = (uint16_t)b->len[i];
+            m->msg_control = b->ctl + (size_t)nm * _TR_UDP_CTL;
+            m->msg_controllen = CMSG_SPACE(sizeof seg);
+            struct cmsghdr* c = CMSG_FIRSTHDR(m);
+            c->cmsg_level = SOL_UDP; c->cmsg_type = UDP_SEGMENT; c->cmsg_len = CMSG_LEN(sizeof seg);
+            memcpy(CMSG_DATA(c), &seg, sizeof seg);
+            any_gso = 1;
+        }
+        b->run[nm++] = cnt;
+        i += cnt;
+    }
+    int r = sendmmsg(fd, b->hdr, (unsigned)nm, MSG_DONTWAIT);
+    if (r < 0 && any_gso && (errno == EIO || errno == EINVAL || errno == ENOPROTOOPT || errno == EOPNOTSUPP)) {
+        b->gso = 0;                /* no GSO on this path: plain datagrams from now on */
+        return _tr_udp_send_some(fd, b, from);
+    }
+    if (r < 0) return -1;
+    int slots = 0;
+    for (int k = 0; k < r; k++) slots += b->run[k];
+    return slots;
+#else
+    int i = from;
+    for (; i < b->used; i++) {
+        if (sendto(fd, b->data + (size_t)i * (size_t)b->cap, (size_t)b->len[i], MSG_DONTWAIT,
+                   (struct sockaddr*)&b->addr[i], sizeof(struct sockaddr_in)) < 0) break;
+    }
+    return i > from ? i - from : -1;
+#endif
+}
+
+/* Send every queued message, in order: how many went (all of them unless a
+ * send failed), -1 when the first one did. The queue is left as it is. */
+static inline int _tr_udp_send_batch(int fd, char* h) {
+    _TrUdpBatch* b = (_TrUdpBatch*)h;
+    if (!b || fd < 0) return -1;
+    int sent = 0;
+    while (sent < b->used) {
+        int r = _tr_udp_send_some(fd, b, sent);
+        if (r > 0) { sent += r; continue; }
+        if (!_tr_udp_again()) return sent > 0 ? sent : -1;
+        if (errno != EINTR) _tr_udp_wait(fd, TAURARO_POLLOUT);
+    }
+    return sent;
+}
+#endif
+
 /* ══════════════════════════════════════════════════════════════════════════
  * Non-blocking socket API
  *
@@ -4973,36 +11083,426 @@ static inline int _tr_tcp_recv_nb(int fd, char* buf, int cap) {
     if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return TAURARO_WOULD_BLOCK;
     return n;
 }
-static inline int _tr_tcp_send_nb(int fd, const char* data, int len) {
-    int n = (int)send(fd, data, (size_t)len, 0);
-    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return TAURARO_WOULD_BLOCK;
-    return n;
+static inline int _tr_tcp_send_nb(int fd, const char* data, int len) {
+    int n = (int)send(fd, data, (size_t)len, 0);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return TAURARO_WOULD_BLOCK;
+    return n;
+}
+static inline int _tr_tcp_accept_nb(int server_fd) {
+    int fd = accept(server_fd, NULL, NULL);
+    if (fd < 0) return (errno == EAGAIN || errno == EWOULDBLOCK) ? TAURARO_WOULD_BLOCK : -1;
+    _tr_tcp_set_nodelay(fd);
+    return fd;
+}
+static inline int _tr_tcp_connect_nb(const char* host, int port) {
+    _tr_net_init();
+    struct sockaddr_in a;
+    memset(&a, 0, sizeof a);
+    a.sin_family = AF_INET;
+    a.sin_port   = htons((unsigned short)port);
+    if (_tr_dns_addr4(host, &a.sin_addr) != 0) return -1;   /* parks in a coroutine */
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    connect(fd, (struct sockaddr*)&a, sizeof a); /* EINPROGRESS expected */
+    return fd;
+}
+#endif /* non-blocking socket API */
+
+/* Binary-safe non-blocking send: like _tr_tcp_send_nb but takes a raw byte
+ * pointer + explicit length (no NUL-terminated str), for framed protocols
+ * (e.g. WebSocket) whose payloads contain NUL bytes. */
+static inline int _tr_tcp_send_raw(int fd, char* buf, int len) { return _tr_tcp_send_nb(fd, buf, len); }
+
+/* ── Coroutine socket I/O ─────────────────────────────────────────────────
+ * Park-until-done socket ops for green threads. With the io_uring completion
+ * reactor on (Linux, opt-in: _tr_co_use_io_uring) each op is one SQE that
+ * goes out with the scheduler tick's batch, and the coro resumes on its
+ * completion - no readiness wait followed by a retry syscall. Otherwise, and
+ * outside a coroutine, they are the readiness loop: try the non-blocking
+ * call, park on the reactor when it would block, retry. Results follow
+ * recv()/send(): bytes transferred, 0 = peer closed, -1 = error. */
+#if !defined(TAURARO_BARE) && !defined(TAURARO_WASM)
+
+#if defined(_TR_URING)
+/* The ring to use for an op from the running coro, or NULL. */
+static inline _TrIOURing* _tr_co_ring(_TrSchedG* g) {
+    return g->current ? _tr_uring_get(g) : NULL;
+}
+#endif
+
+static int _tr_co_recv(int fd, char* buf, int cap) {
+#if defined(_TR_URING)
+    _TrSchedG* g = _tr_sched_cur();
+    _TrIOURing* u = _tr_co_ring(g);
+    struct io_uring_sqe* s = u ? _tr_uring_sqe(u) : NULL;
+    if (s) {
+        _TrURingOp op;
+        s->opcode    = IORING_OP_RECV;
+        s->fd        = fd;
+        s->addr      = (unsigned long long)(uintptr_t)buf;
+        s->len       = (unsigned)cap;
+        s->user_data = (unsigned long long)(uintptr_t)&op;
+        int r = _tr_uring_park(g, &op);
+        if (r != -EAGAIN) return r < 0 ? -1 : r;
+    }
+#endif
+    for (;;) {
+        int n = _tr_tcp_recv_nb(fd, buf, cap);
+        if (n != TAURARO_WOULD_BLOCK) return n;
+        _tr_co_await_fd(fd, TAURARO_POLLIN);
+    }
+}
+
+/* Receive up to `cap` bytes into a fresh NUL-terminated buffer (caller owns
+ * it); NULL when the peer closed or on error. On the ring the kernel picks a
+ * buffer from the provided-buffer ring at completion time, so an idle
+ * connection pins no buffer while it waits. */
+static char* _tr_co_recv_str(int fd, int cap) {
+#if defined(_TR_URING)
+    _TrSchedG* g = _tr_sched_cur();
+    _TrIOURing* u = _tr_co_ring(g);
+    struct io_uring_sqe* s = (u && u->br) ? _tr_uring_sqe(u) : NULL;
+    if (s) {
+        _TrURingOp op;
+        op.data      = NULL;
+        s->opcode    = IORING_OP_RECV;
+        s->fd        = fd;
+        s->len       = (unsigned)(cap < (int)_TR_URING_BUFSZ ? cap : (int)_TR_URING_BUFSZ);
+        s->flags     = IOSQE_BUFFER_SELECT;
+        s->buf_group = _TR_URING_BGID;
+        s->user_data = (unsigned long long)(uintptr_t)&op;
+        int r = _tr_uring_park(g, &op);
+        if (op.flags & IORING_CQE_F_BUFFER) return op.data;
+        /* -ENOBUFS (every buffer in flight) / -EAGAIN: plain recv below. */
+        if (r != -ENOBUFS && r != -EAGAIN) return NULL;
+    }
+#endif
+    char* buf = (char*)_tr_c_malloc((size_t)cap + 1);
+    if (!buf) return NULL;
+    int n = _tr_co_recv(fd, buf, cap);
+    if (n <= 0) { _tr_free(buf); return NULL; }
+    buf[n] = '\0';
+    return buf;
+}
+
+/* _tr_co_recv_str that also returns NULL when nothing arrives for `ms`
+ * milliseconds (ms <= 0: no limit). A timed recv always takes the readiness
+ * path: an in-flight ring recv could not be abandoned at the deadline. */
+static char* _tr_co_recv_str_to(int fd, int cap, long long ms) {
+    if (ms <= 0) return _tr_co_recv_str(fd, cap);
+    char* buf = (char*)_tr_c_malloc((size_t)cap + 1);
+    if (!buf) return NULL;
+    for (;;) {
+        int n = _tr_tcp_recv_nb(fd, buf, cap);
+        if (n != TAURARO_WOULD_BLOCK) {
+            if (n <= 0) { _tr_free(buf); return NULL; }
+            buf[n] = '\0';
+            return buf;
+        }
+        if (!_tr_co_await_fd_timeout(fd, TAURARO_POLLIN, ms)) { _tr_free(buf); return NULL; }
+    }
+}
+
+/* Send all `len` bytes; returns the count sent (short only on error). */
+static int _tr_co_send(int fd, const char* data, int len) {
+    int sent = 0;
+    while (sent < len) {
+        int n = TAURARO_WOULD_BLOCK;
+#if defined(_TR_URING)
+        _TrSchedG* g = _tr_sched_cur();
+        _TrIOURing* u = _tr_co_ring(g);
+        struct io_uring_sqe* s = u ? _tr_uring_sqe(u) : NULL;
+        if (s) {
+            _TrURingOp op;
+            s->opcode    = IORING_OP_SEND;
+            s->fd        = fd;
+            s->addr      = (unsigned long long)(uintptr_t)(data + sent);
+            s->len       = (unsigned)(len - sent);
+            s->msg_flags = MSG_NOSIGNAL;
+            s->user_data = (unsigned long long)(uintptr_t)&op;
+            n = _tr_uring_park(g, &op);
+            if (n == -EAGAIN) n = TAURARO_WOULD_BLOCK;
+            else if (n < 0) n = -1;
+        } else
+#endif
+        n = _tr_tcp_send_nb(fd, data + sent, len - sent);
+        if (n == TAURARO_WOULD_BLOCK) { _tr_co_await_fd(fd, TAURARO_POLLOUT); continue; }
+        if (n <= 0) return sent;
+        sent += n;
+    }
+    return sent;
+}
+
+/* Send a response and receive the next request in one go. On the ring the
+ * send and the recv are a linked pair submitted together, so a keep-alive
+ * round trip costs no syscall of its own. Returns the recv result, or -1
+ * if the send failed. */
+static int _tr_co_send_recv(int fd, const char* out, int olen, char* buf, int cap) {
+#if defined(_TR_URING)
+    _TrSchedG* g = _tr_sched_cur();
+    _TrIOURing* u = _tr_co_ring(g);
+    if (u && olen > 0 && _tr_uring_sq_space(u) < 2) _tr_uring_enter(u, 0, 0);
+    if (u && olen > 0 && _tr_uring_sq_space(u) >= 2) {
+        _TrURingOp sop, rop;
+        struct io_uring_sqe* s = _tr_uring_sqe(u);
+        s->opcode    = IORING_OP_SEND;
+        s->fd        = fd;
+        s->addr      = (unsigned long long)(uintptr_t)out;
+        s->len       = (unsigned)olen;
+        s->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;   /* a short send breaks the link */
+        s->flags     = IOSQE_IO_LINK;
+        s->user_data = (unsigned long long)(uintptr_t)&sop;
+        sop.co = NULL; sop.res = 0; sop.flags = 0;
+        struct io_uring_sqe* r = _tr_uring_sqe(u);
+        r->opcode    = IORING_OP_RECV;
+        r->fd        = fd;
+        r->addr      = (unsigned long long)(uintptr_t)buf;
+        r->len       = (unsigned)cap;
+        r->user_data = (unsigned long long)(uintptr_t)&rop;
+        /* CQEs of a link post in order: sop is final once rop completes. */
+        int n = _tr_uring_park(g, &rop);
+        if (sop.res == olen) {
+            if (n != -EAGAIN) return n < 0 ? -1 : n;
+            return _tr_co_recv(fd, buf, cap);
+        }
+        if (sop.res < 0 && sop.res != -EAGAIN) return -1;
+        int done = sop.res > 0 ? sop.res : 0;
+        if (_tr_co_send(fd, out + done, olen - done) < olen - done) return -1;
+        return _tr_co_recv(fd, buf, cap);
+    }
+#endif
+    if (_tr_co_send(fd, out, olen) < olen) return -1;
+    return _tr_co_recv(fd, buf, cap);
+}
+
+/* Accept the next connection on listener `lfd` (non-blocking fd, TCP_NODELAY
+ * set); -1 once the listener fails or has been shut down. On the ring this is
+ * a multishot accept armed once: the kernel keeps accepting and queues fds for
+ * the loop, and the accepting coro stays on this worker. One accepting coro
+ * per listener per worker. */
+static int _tr_co_accept(int lfd) {
+#if defined(_TR_URING)
+    _TrSchedG* g = _tr_sched_cur();
+    if (_tr_co_ring(g)) {
+        _TrURingLsn* l = g->lsn;
+        while (l && l->lfd != lfd) l = l->next;
+        if (!l) {
+            l = (_TrURingLsn*)TAURARO_CALLOC(1, sizeof(_TrURingLsn));
+            if (!l) return -1;
+            l->lfd = lfd;
+            l->next = g->lsn;
+            g->lsn = l;
+        }
+#if defined(_TR_MC)
+        if (g->mc) g->current->pin = g->mc->id;
+#endif
+        for (;;) {
+            if (l->qn > 0) {
+                int fd = l->q[l->qh];
+                l->qh = (l->qh + 1) % l->qcap;
+                l->qn--;
+                _tr_tcp_set_nodelay(fd);
+                return fd;
+            }
+            if (l->err) {
+                int e = l->err;
+                l->err = 0;
+                /* A kernel without multishot accept rejects the flag before
+                 * ever accepting: fall back to one SQE per connection. */
+                if (e == -EINVAL && !l->single && l->n_ok == 0) l->single = 1;
+                else if (e != -EAGAIN && e != -EINTR && e != -ECONNABORTED) return -1;
+            }
+            if (!l->armed) {
+                struct io_uring_sqe* s = _tr_uring_sqe(g->uring);
+                if (!s) return -1;
+                s->opcode       = IORING_OP_ACCEPT;
+                s->fd           = lfd;
+                s->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+                if (!l->single) s->ioprio = IORING_ACCEPT_MULTISHOT;
+                s->user_data    = (unsigned long long)(uintptr_t)l | 1ull;
+                l->armed = 1;
+            }
+            l->waiter = g->current;
+            g->current->state = _TRC_SUSP;
+            g->n_uring++;
+            _tr_co_to_sched(l->waiter);
+            g = _tr_sched_cur();
+        }
+    }
+#endif
+    for (;;) {
+        int fd = _tr_tcp_accept_nb(lfd);
+        /* accept() does not pass the listener's O_NONBLOCK on: a blocking
+         * connection fd would stall the whole worker on its next idle read. */
+        if (fd >= 0) _tr_tcp_set_nonblocking(fd);
+        if (fd != TAURARO_WOULD_BLOCK) return fd;
+        _tr_co_await_fd(lfd, TAURARO_POLLIN);
+    }
+}
+
+/* Forget the ring state of a listener that is being closed: cancel its
+ * multishot accept (the ring holds a reference that would keep the socket
+ * listening) and close any accepted fds nobody took. */
+static void _tr_co_accept_forget(int lfd) {
+#if defined(_TR_URING)
+    _TrSchedG* g = _tr_sched_cur();
+    _TrURingLsn* l = g->lsn;
+    while (l && l->lfd != lfd) l = l->next;
+    if (!l) return;
+    l->lfd = -1;
+    while (l->qn > 0) { close(l->q[l->qh]); l->qh = (l->qh + 1) % l->qcap; l->qn--; }
+    if (!l->armed) { _tr_uring_lsn_free(g, l); return; }
+    struct io_uring_sqe* s = _tr_uring_sqe(g->uring);
+    if (s) {
+        s->opcode = IORING_OP_ASYNC_CANCEL;
+        s->addr   = (unsigned long long)(uintptr_t)l | 1ull;
+        s->user_data = 0;
+        _tr_uring_enter(g->uring, 0, 0);
+    }
+#else
+    (void)lfd;
+#endif
 }
-static inline int _tr_tcp_accept_nb(int server_fd) {
-    int fd = accept(server_fd, NULL, NULL);
-    if (fd < 0) return (errno == EAGAIN || errno == EWOULDBLOCK) ? TAURARO_WOULD_BLOCK : -1;
-    _tr_tcp_set_nodelay(fd);
-    return fd;
+
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
+
+/* Send `alen` bytes at `a` followed by `blen` bytes at `b` as one gathered
+ * write (an HTTP header block and a body the caller still owns), so neither
+ * is copied next to the other. Returns the total sent (short only on error). */
+static long long _tr_co_send2(int fd, const char* a, long long alen, const char* b, long long blen) {
+#if defined(_WIN32)
+    long long s = _tr_co_send(fd, a, (int)alen);
+    if (s < alen || blen <= 0) return s;
+    return s + _tr_co_send(fd, b, (int)blen);
+#else
+    long long done = 0, total = alen + blen;
+    while (done < total) {
+        struct iovec iov[2];
+        int k = 0;
+        if (done < alen) { iov[k].iov_base = (void*)(a + done); iov[k].iov_len = (size_t)(alen - done); k++; }
+        long long bo = done > alen ? done - alen : 0;
+        if (blen > bo) { iov[k].iov_base = (void*)(b + bo); iov[k].iov_len = (size_t)(blen - bo); k++; }
+        struct msghdr m;
+        memset(&m, 0, sizeof(m));
+        m.msg_iov    = iov;
+        m.msg_iovlen = k;
+        ssize_t n = sendmsg(fd, &m, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) { _tr_co_await_fd(fd, TAURARO_POLLOUT); continue; }
+            return done;
+        }
+        if (n == 0) return done;
+        done += (long long)n;
+    }
+    return done;
+#endif
 }
-static inline int _tr_tcp_connect_nb(const char* host, int port) {
-    struct addrinfo hints = {0}, *res = NULL;
-    hints.ai_family = AF_INET; hints.ai_socktype = SOCK_STREAM;
-    char pbuf[16]; snprintf(pbuf, sizeof(pbuf), "%d", port);
-    if (getaddrinfo(host, pbuf, &hints, &res) != 0) return -1;
-    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
-    if (fd < 0) { freeaddrinfo(res); return -1; }
-    int flags = fcntl(fd, F_GETFL, 0);
-    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
-    connect(fd, res->ai_addr, res->ai_addrlen); /* EINPROGRESS expected */
-    freeaddrinfo(res);
+
+/* Send `hlen` bytes of `head`, then `n` bytes of the open file `ffd` from
+ * `off`, to socket `fd`. On Linux the head goes out with MSG_MORE and the
+ * kernel moves the file pages itself (sendfile), so the body never enters
+ * user space and still shares a segment with the head. Elsewhere the file
+ * streams through a 64 KiB buffer, the head gathered with the first block.
+ * Returns the total sent (short on error, or if the file shrank). */
+static long long _tr_co_sendfile(int fd, const char* head, long long hlen, int ffd, long long off, long long n) {
+    long long done = 0;
+#if defined(__linux__)
+    while (done < hlen) {
+        ssize_t r = send(fd, head + done, (size_t)(hlen - done), n > 0 ? MSG_MORE : 0);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) { _tr_co_await_fd(fd, TAURARO_POLLOUT); continue; }
+            return done;
+        }
+        done += (long long)r;
+    }
+    long long body = 0;
+    while (body < n) {
+        off_t o = (off_t)(off + body);
+        long long want = n - body;
+        if (want > 0x40000000LL) want = 0x40000000LL;
+        ssize_t r = sendfile(fd, ffd, &o, (size_t)want);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) { _tr_co_await_fd(fd, TAURARO_POLLOUT); continue; }
+            if (body == 0 && (errno == EINVAL || errno == ENOSYS)) break;   /* not sendfile-able: copy */
+            return done + body;
+        }
+        if (r == 0) return done + body;
+        body += (long long)r;
+    }
+    if (body >= n) return done + body;
+    head = NULL; hlen = 0;
+#endif
+    char* buf = (char*)_tr_c_malloc(65536);
+    if (!buf) return done;
+    long long copied = 0;
+    while (copied < n || hlen > 0) {
+        long long want = n - copied < 65536 ? n - copied : 65536;
+        long long r = 0;
+        if (want > 0) {
+#if defined(_WIN32)
+            if (_lseeki64(ffd, off + copied, SEEK_SET) < 0) break;
+            r = _read(ffd, buf, (unsigned)want);
+#else
+            r = (long long)pread(ffd, buf, (size_t)want, (off_t)(off + copied));
+            if (r < 0 && errno == EINTR) continue;
+#endif
+            if (r <= 0) r = 0;
+        }
+        long long s = _tr_co_send2(fd, head, hlen, buf, r);
+        done += s;
+        if (s < hlen + r || r == 0) break;
+        copied += r;
+        head = NULL; hlen = 0;
+    }
+    _tr_free(buf);
+    return done;
+}
+
+/* Connect to host:port. In a coroutine the lookup and the connect are
+ * non-blocking and the coroutine parks until they complete; outside one
+ * they block. Returns the fd (TCP_NODELAY) or -1. */
+static int _tr_co_connect(const char* host, int port) {
+    if (!_tr_sched_cur()->current) {
+        int bfd = _tr_tcp_connect(host, port);
+        if (bfd >= 0) _tr_tcp_set_nodelay(bfd);
+        return bfd;
+    }
+    int fd = _tr_tcp_connect_nb(host, port);
+    if (fd < 0) return -1;
+    _tr_co_await_fd(fd, TAURARO_POLLOUT);
+    int err = 0;
+    socklen_t el = (socklen_t)sizeof err;
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, (char*)&err, &el) != 0 || err != 0) {
+        _tr_co_fd_forget(fd);
+        _tr_tcp_close(fd);
+        return -1;
+    }
+    _tr_tcp_set_nodelay(fd);
     return fd;
 }
-#endif /* non-blocking socket API */
 
-/* Binary-safe non-blocking send: like _tr_tcp_send_nb but takes a raw byte
- * pointer + explicit length (no NUL-terminated str), for framed protocols
- * (e.g. WebSocket) whose payloads contain NUL bytes. */
-static inline int _tr_tcp_send_raw(int fd, char* buf, int len) { return _tr_tcp_send_nb(fd, buf, len); }
+/* Tauraro-callable wrappers (extern "C" in std/net/tcp.tr). */
+static int   _tr_co_recv_h(long long fd, char* buf, long long cap)   { return _tr_co_recv((int)fd, buf, (int)cap); }
+static char* _tr_co_recv_str_h(long long fd, long long cap)          { return _tr_co_recv_str((int)fd, (int)cap); }
+static char* _tr_co_recv_str_to_h(long long fd, long long cap, long long ms) { return _tr_co_recv_str_to((int)fd, (int)cap, ms); }
+static int   _tr_co_send_h(long long fd, char* data, long long len)  { return _tr_co_send((int)fd, data, (int)len); }
+static long long _tr_co_send2_h(long long fd, char* a, long long alen, char* b, long long blen)
+    { return _tr_co_send2((int)fd, a, alen, b, blen); }
+static long long _tr_co_sendfile_h(long long fd, char* head, long long hlen, long long ffd, long long off, long long n)
+    { return _tr_co_sendfile((int)fd, head, hlen, (int)ffd, off, n); }
+static int   _tr_co_send_recv_h(long long fd, char* out, long long olen, char* buf, long long cap)
+    { return _tr_co_send_recv((int)fd, out, (int)olen, buf, (int)cap); }
+static int   _tr_co_accept_h(long long fd)                           { return _tr_co_accept((int)fd); }
+static void  _tr_co_accept_forget_h(long long fd)                    { _tr_co_accept_forget((int)fd); }
+
+#endif /* coroutine socket I/O */
 
 /* -- Random (LCG-64) ------------------------------------------------------- */
 typedef struct { unsigned long long s; } _TrRng;
@@ -5161,93 +11661,1437 @@ static inline bool _tr_shutdown_requested(void) { return false; }
 #endif
 
 /* ═══════════════════════════════════════════════════════════════════════════
- * REGEX — POSIX regex.h on Linux/Mac; stubs on Windows and bare-metal.
+ * REGEX — portable automata engine (std.regex). No libc regex, so every
+ * platform (bare-metal included) matches the same way.
+ *
+ *   pattern ─parse→ AST ─compile→ Thompson NFA, once forward, once reversed
+ *   find      literal-prefix prefilter (memchr) skips to candidates, a lazy
+ *             forward DFA finds where the leftmost-first match ends, then a
+ *             lazy reverse DFA anchored there walks back to where it starts
+ *   match     forward DFA anchored at 0 over the whole text
+ *   captures  PikeVM over just the span the DFAs found
+ *
+ * DFA states are built on first use and cached per Regex, so the hot loop is
+ * one table load per byte. A state is the ordered list of NFA threads waiting
+ * to consume the next byte plus what the previous byte was (start of text /
+ * word char / newline), which is all ^ $ \b need; those assertions are
+ * resolved when the next byte's class is known. The cache is flushed and
+ * rebuilt when it passes _TR_RE_DFA_MAX_STATES.
+ *
+ * Semantics are leftmost-first (Perl/RE2): alternation prefers the earlier
+ * branch, greedy quantifiers the longer run. Matching is bytewise; '.' does
+ * not match '\n' unless (?s). Not thread-safe: the DFA cache and last-match
+ * state live in the handle.
  * ═══════════════════════════════════════════════════════════════════════════ */
-#ifndef TAURARO_BARE
-#  if defined(__linux__) || defined(__APPLE__) || defined(__unix__)
-#    include <regex.h>
-#    define TAURARO_HAVE_REGEX 1
-#  endif
-#endif
+_TR_COLD void _tr_regex_free(char* handle);
+_TR_COLD char* _tr_regex_compile(char* pattern, int icase);
+_TR_COLD bool _tr_regex_match(char* handle, char* text);
+_TR_COLD long long _tr_regex_find(char* handle, char* text, long long len, long long from);
+_TR_COLD long long _tr_regex_end(char* handle);
+_TR_COLD bool _tr_regex_search(char* handle, char* text, long long len);
+_TR_COLD long long _tr_regex_groups(char* handle);
+_TR_COLD bool _tr_regex_capture(char* handle, char* text, long long len, long long start);
+_TR_COLD long long _tr_regex_group_start(char* handle, long long i);
+_TR_COLD long long _tr_regex_group_end(char* handle, long long i);
+_TR_COLD char* _tr_regex_replace(char* handle, char* text, char* repl, long long limit);
+_TR_COLD void _tr_regex_replace_into(char* handle, void* sb, char* text, long long len, char* repl);
+_TR_COLD long long _tr_regex_count(char* handle, char* text, long long len);
+#if _TR_COLD_BODIES
+enum { _TR_RE_BYTE, _TR_RE_SPLIT, _TR_RE_JMP, _TR_RE_SAVE, _TR_RE_ASSERT, _TR_RE_MATCH };
+enum { _TR_RE_BOT, _TR_RE_EOT, _TR_RE_BOL, _TR_RE_EOL, _TR_RE_WORDB, _TR_RE_NWORDB };
+enum { _TR_RA_EMPTY, _TR_RA_SET, _TR_RA_CAT, _TR_RA_ALT, _TR_RA_REP, _TR_RA_GROUP, _TR_RA_ASSERT };
+
+#define _TR_RE_ICASE     1
+#define _TR_RE_DOTALL    2
+#define _TR_RE_MULTILINE 4
+#define _TR_RE_MAX_INSTS 65536
+#define _TR_RE_MAX_REPEAT 1000
+#define _TR_RE_DFA_MAX_STATES 4096
+
+/* Previous-byte context carried by DFA states. */
+#define _TR_RE_F_START 1
+#define _TR_RE_F_WORD  2
+#define _TR_RE_F_NL    4
+
+/* BYTE: x = byte set; SPLIT: x preferred, y fallback; JMP: x; SAVE: x = slot;
+ * ASSERT: arg = kind. */
+typedef struct { uint8_t op, arg; int x, y; } _TrReInst;
+typedef struct { _TrReInst* in; int n, cap; } _TrReProg;
+
+/* SET: a = set; REP: a..b (b < 0 = unbounded); GROUP: a = capture index or -1;
+ * ASSERT: a = kind. CAT/ALT children are linked through next. */
+typedef struct { uint8_t kind, greedy; int a, b, child, last, next; } _TrReNode;
 
-#ifdef TAURARO_HAVE_REGEX
-typedef struct { regex_t re; } _TrRegex;
-static inline char* _tr_regex_compile(char* pattern, int icase) {
-    _TrRegex* r = (_TrRegex*)TAURARO_ALLOC(sizeof(_TrRegex));
-    if (!r) return NULL;
-    int flags = REG_EXTENDED; if (icase) flags |= REG_ICASE;
-    if (regcomp(&r->re, pattern, flags) != 0) { TAURARO_FREE(r); return NULL; }
-    return (char*)r;
+typedef struct {
+    const unsigned char *p, *end;
+    _TrReNode* nodes; int nn, ncap;
+    uint32_t (*sets)[8]; int ns, scap;
+    int ngroups, flags, err, depth;
+} _TrReParse;
+
+typedef struct {
+    int ncol, longest, start_pc, nstates, scap, npool, pcap, hcap;
+    int* trans;                  /* nstates * ncol; -1 = not built yet; else next*2 | matched-before */
+    int* off; int* len; uint8_t* flags; uint8_t* idle;
+    int* pool; int* hash;
+    int start_st[8];
+    int* stack; int* mark; int* scratch; int gen;
+} _TrReDfa;
+
+typedef struct {
+    _TrReProg fwd, rev;
+    uint32_t (*sets)[8]; int nsets;
+    uint8_t cls[256], rep[256]; int ncls;
+    int ngroups, ctx_mask;
+    unsigned char prefix[64]; int plen;
+    _TrReDfa *dfa_fwd, *dfa_rev, *dfa_full;
+    long long m_start, m_end;
+    long long* caps;
+    int *pk_pc, *pk_sp, *pk_stack; long long *pk_caps, *pk_undo, *pk_work;
+} _TrRegex;
+
+static inline int _tr_re_isword(int c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+static inline int _tr_re_in(const uint32_t* s, int c) { return (int)((s[c >> 5] >> (c & 31)) & 1u); }
+static inline void _tr_re_put1(uint32_t* s, int c) { s[c >> 5] |= 1u << (c & 31); }
+
+/* ── parser ─────────────────────────────────────────────────────────────── */
+static int _tr_re_node(_TrReParse* P, int kind) {
+    if (P->nn == P->ncap) {
+        int cap = P->ncap ? P->ncap * 2 : 32;
+        _TrReNode* n = (_TrReNode*)TAURARO_REALLOC(P->nodes, (size_t)cap * sizeof(_TrReNode));
+        if (!n) { P->err = 1; return 0; }
+        P->nodes = n; P->ncap = cap;
+    }
+    _TrReNode* n = &P->nodes[P->nn];
+    memset(n, 0, sizeof *n);
+    n->kind = (uint8_t)kind; n->child = n->last = n->next = -1; n->greedy = 1;
+    return P->nn++;
+}
+static int _tr_re_newset(_TrReParse* P) {
+    if (P->ns == P->scap) {
+        int cap = P->scap ? P->scap * 2 : 16;
+        uint32_t (*s)[8] = (uint32_t (*)[8])TAURARO_REALLOC(P->sets, (size_t)cap * sizeof *s);
+        if (!s) { P->err = 1; return 0; }
+        P->sets = s; P->scap = cap;
+    }
+    memset(P->sets[P->ns], 0, sizeof P->sets[0]);
+    return P->ns++;
+}
+static void _tr_re_append(_TrReParse* P, int parent, int child) {
+    _TrReNode* n = &P->nodes[parent];
+    if (n->child < 0) n->child = child; else P->nodes[n->last].next = child;
+    P->nodes[parent].last = child;
+}
+static void _tr_re_add(_TrReParse* P, uint32_t* s, int c) {
+    _tr_re_put1(s, c);
+    if (P->flags & _TR_RE_ICASE) {
+        if (c >= 'a' && c <= 'z') _tr_re_put1(s, c - 32);
+        else if (c >= 'A' && c <= 'Z') _tr_re_put1(s, c + 32);
+    }
 }
-static inline bool _tr_regex_match(char* handle, char* text) {
-    if (!handle || !text) return false;
-    return regexec(&((_TrRegex*)handle)->re, text, 0, NULL, 0) == 0;
-}
-static inline int _tr_regex_find_start(char* handle, char* text, int from) {
-    if (!handle || !text) return -1;
-    regmatch_t m;
-    if (regexec(&((_TrRegex*)handle)->re, text + from, 1, &m, 0) != 0) return -1;
-    return from + (int)m.rm_so;
-}
-static inline int _tr_regex_find_len(char* handle, char* text, int from) {
-    if (!handle || !text) return -1;
-    regmatch_t m;
-    if (regexec(&((_TrRegex*)handle)->re, text + from, 1, &m, 0) != 0) return -1;
-    return (int)(m.rm_eo - m.rm_so);
-}
-static inline char* _tr_regex_replace_first(char* handle, char* text, char* repl) {
-    if (!handle || !text || !repl) return _tr_strdup(text ? text : "");
-    regmatch_t m;
-    if (regexec(&((_TrRegex*)handle)->re, text, 1, &m, 0) != 0) return _tr_strdup(text);
-    size_t pre = (size_t)m.rm_so, rlen = strlen(repl), post = strlen(text) - (size_t)m.rm_eo;
-    char* out = (char*)TAURARO_ALLOC(pre + rlen + post + 1); if (!out) return _tr_strdup(text);
-    memcpy(out, text, pre); memcpy(out+pre, repl, rlen); memcpy(out+pre+rlen, text+m.rm_eo, post);
-    out[pre+rlen+post] = '\0'; return out;
-}
-static inline char* _tr_regex_replace_all(char* handle, char* text, char* repl) {
-    if (!handle || !text || !repl) return _tr_strdup(text ? text : "");
-    _TrRegex* r = (_TrRegex*)handle; regmatch_t m;
-    size_t rlen = strlen(repl), cur = 0, tlen = strlen(text);
-    char* result = _tr_strdup("");
-    while (cur < tlen && regexec(&r->re, text + cur, 1, &m, 0) == 0) {
-        size_t pre = (size_t)m.rm_so, olen = strlen(result);
-        char* tmp = (char*)TAURARO_ALLOC(olen + pre + rlen + 1); if (!tmp) break;
-        memcpy(tmp, result, olen); memcpy(tmp+olen, text+cur, pre);
-        memcpy(tmp+olen+pre, repl, rlen); tmp[olen+pre+rlen] = '\0';
-        TAURARO_FREE(result); result = tmp;
-        size_t adv = (size_t)(m.rm_eo - m.rm_so); if (adv == 0) adv = 1;
-        cur += pre + adv;
-    }
-    size_t rem = tlen - cur, olen2 = strlen(result);
-    char* out = (char*)TAURARO_ALLOC(olen2 + rem + 1);
-    if (out) { memcpy(out, result, olen2); memcpy(out+olen2, text+cur, rem); out[olen2+rem]='\0'; TAURARO_FREE(result); return out; }
-    return result;
+static void _tr_re_add_named(uint32_t* s, int which, int neg) {
+    uint32_t t[8] = {0};
+    for (int c = 0; c < 256; c++) {
+        int in = 0;
+        switch (which) {
+            case 'd': in = c >= '0' && c <= '9'; break;
+            case 'w': in = _tr_re_isword(c); break;
+            case 's': in = c == ' ' || (c >= '\t' && c <= '\r'); break;
+            case 'a': in = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); break;
+            case 'n': in = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'); break;
+            case 'u': in = c >= 'A' && c <= 'Z'; break;
+            case 'l': in = c >= 'a' && c <= 'z'; break;
+            case 'x': in = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'); break;
+            case 'p': in = c > 32 && c < 127 && !((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')); break;
+            case 'c': in = c < 32 || c == 127; break;
+            case 'g': in = c > 32 && c < 127; break;
+            case 'r': in = c >= 32 && c < 127; break;
+            case 'b': in = c == ' ' || c == '\t'; break;
+        }
+        if (in) _tr_re_put1(t, c);
+    }
+    for (int i = 0; i < 8; i++) s[i] |= neg ? ~t[i] : t[i];
+}
+static int _tr_re_hex(int c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+/* Escape after '\'. A class escape (\d \w \s and negations) ORs into s and
+ * returns -2; a single byte is returned (and not added). -1 = error. */
+static int _tr_re_escape(_TrReParse* P, uint32_t* s) {
+    if (P->p >= P->end) return -1;
+    int c = *P->p++;
+    switch (c) {
+        case 'd': case 'w': case 's': _tr_re_add_named(s, c, 0); return -2;
+        case 'D': case 'W': case 'S': _tr_re_add_named(s, c + 32, 1); return -2;
+        case 'n': return '\n';
+        case 't': return '\t';
+        case 'r': return '\r';
+        case 'f': return '\f';
+        case 'v': return '\v';
+        case 'a': return 7;
+        case 'e': return 27;
+        case '0': return 0;
+        case 'x': {
+            if (P->end - P->p < 2) return -1;
+            int h = _tr_re_hex(P->p[0]), l = _tr_re_hex(P->p[1]);
+            if (h < 0 || l < 0) return -1;
+            P->p += 2;
+            return h * 16 + l;
+        }
+    }
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) return -1;
+    return c;
 }
-static inline int _tr_regex_count(char* handle, char* text) {
-    if (!handle || !text) return 0;
-    regmatch_t m; int n = 0; size_t cur = 0, tlen = strlen(text);
-    while (cur < tlen && regexec(&((_TrRegex*)handle)->re, text+cur, 1, &m, 0) == 0) {
-        n++; size_t adv=(size_t)(m.rm_eo-m.rm_so); if(adv==0)adv=1; cur+=(size_t)m.rm_so+adv;
+static int _tr_re_class(_TrReParse* P) {
+    int id = _tr_re_newset(P);
+    if (P->err) return 0;
+    uint32_t s[8] = {0};
+    int neg = 0;
+    if (P->p < P->end && *P->p == '^') { neg = 1; P->p++; }
+    int first = 1;
+    while (P->p < P->end && (*P->p != ']' || first)) {
+        first = 0;
+        int lo;
+        if (*P->p == '[' && P->end - P->p >= 2 && P->p[1] == ':') {
+            static const char* names[] = { "alpha", "digit", "alnum", "upper", "lower", "space",
+                                           "xdigit", "punct", "cntrl", "graph", "print", "blank", "word" };
+            static const char codes[] = "adnulsxpcgrbw";
+            const unsigned char* q = P->p + 2;
+            const unsigned char* e = q;
+            while (e < P->end && *e != ':') e++;
+            int k = -1;
+            for (int i = 0; i < 13; i++)
+                if ((size_t)(e - q) == strlen(names[i]) && memcmp(q, names[i], (size_t)(e - q)) == 0) k = i;
+            if (k < 0 || e + 1 >= P->end || e[1] != ']') { P->err = 1; return 0; }
+            int w = codes[k];
+            _tr_re_add_named(s, w, 0);
+            if (P->flags & _TR_RE_ICASE && (w == 'u' || w == 'l')) _tr_re_add_named(s, 'a', 0);
+            P->p = e + 2;
+            continue;
+        }
+        if (*P->p == '\\') {
+            P->p++;
+            lo = _tr_re_escape(P, s);
+            if (lo == -1) { P->err = 1; return 0; }
+            if (lo == -2) continue;
+        } else {
+            lo = *P->p++;
+        }
+        int hi = lo;
+        if (P->end - P->p >= 2 && *P->p == '-' && P->p[1] != ']') {
+            P->p++;
+            if (*P->p == '\\') {
+                P->p++;
+                hi = _tr_re_escape(P, s);
+                if (hi < 0) { P->err = 1; return 0; }
+            } else {
+                hi = *P->p++;
+            }
+            if (hi < lo) { P->err = 1; return 0; }
+        }
+        for (int c = lo; c <= hi; c++) _tr_re_add(P, s, c);
     }
+    if (P->p >= P->end) { P->err = 1; return 0; }
+    P->p++;
+    for (int i = 0; i < 8; i++) P->sets[id][i] = neg ? ~s[i] : s[i];
+    int n = _tr_re_node(P, _TR_RA_SET);
+    P->nodes[n].a = id;
     return n;
 }
-static inline void _tr_regex_free(char* handle) {
-    if (!handle) return; regfree(&((_TrRegex*)handle)->re); TAURARO_FREE(handle);
+static int _tr_re_lit(_TrReParse* P, int c) {
+    int id = _tr_re_newset(P);
+    if (P->err) return 0;
+    _tr_re_add(P, P->sets[id], c);
+    int n = _tr_re_node(P, _TR_RA_SET);
+    P->nodes[n].a = id;
+    return n;
+}
+static int _tr_re_assert(_TrReParse* P, int kind) {
+    int n = _tr_re_node(P, _TR_RA_ASSERT);
+    if (!P->err) P->nodes[n].a = kind;
+    return n;
+}
+/* {m}, {m,}, {m,n}. Returns 0 (and consumes nothing) when the brace is not a
+ * well-formed count, in which case it is an ordinary literal. */
+static int _tr_re_count(_TrReParse* P, int* lo, int* hi) {
+    const unsigned char* q = P->p + 1;
+    int a = 0, b, digits = 0;
+    while (q < P->end && *q >= '0' && *q <= '9') { a = a * 10 + (*q++ - '0'); if (++digits > 4) return 0; }
+    if (!digits) return 0;
+    b = a;
+    if (q < P->end && *q == ',') {
+        q++;
+        b = -1;
+        if (q < P->end && *q >= '0' && *q <= '9') {
+            b = 0; digits = 0;
+            while (q < P->end && *q >= '0' && *q <= '9') { b = b * 10 + (*q++ - '0'); if (++digits > 4) return 0; }
+        }
+    }
+    if (q >= P->end || *q != '}') return 0;
+    P->p = q + 1;
+    *lo = a; *hi = b;
+    return 1;
+}
+
+static int _tr_re_alt(_TrReParse* P);
+
+static int _tr_re_group(_TrReParse* P) {
+    int cap = -1, saved = P->flags;
+    if (P->p < P->end && *P->p == '?') {
+        P->p++;
+        if (P->p < P->end && (*P->p == '<' || *P->p == 'P')) {
+            if (*P->p == 'P') P->p++;
+            if (P->p >= P->end || *P->p != '<') { P->err = 1; return 0; }
+            while (P->p < P->end && *P->p != '>') P->p++;
+            if (P->p >= P->end) { P->err = 1; return 0; }
+            P->p++;
+            cap = ++P->ngroups;
+        } else {
+            int on = 1, f = P->flags;
+            for (;;) {
+                if (P->p >= P->end) { P->err = 1; return 0; }
+                int c = *P->p++;
+                int bit = c == 'i' ? _TR_RE_ICASE : c == 's' ? _TR_RE_DOTALL : c == 'm' ? _TR_RE_MULTILINE : 0;
+                if (bit) { f = on ? (f | bit) : (f & ~bit); continue; }
+                if (c == '-' && on) { on = 0; continue; }
+                if (c == ')') { P->flags = f; return _tr_re_node(P, _TR_RA_EMPTY); }  /* rest of the enclosing group */
+                if (c == ':') { P->flags = f; break; }
+                P->err = 1; return 0;
+            }
+        }
+    } else {
+        cap = ++P->ngroups;
+    }
+    int body = _tr_re_alt(P);
+    if (P->err) return 0;
+    if (P->p >= P->end || *P->p != ')') { P->err = 1; return 0; }
+    P->p++;
+    P->flags = saved;
+    int g = _tr_re_node(P, _TR_RA_GROUP);
+    if (P->err) return 0;
+    P->nodes[g].a = cap;
+    P->nodes[g].child = body;
+    return g;
+}
+static int _tr_re_atom(_TrReParse* P) {
+    int c = *P->p++;
+    switch (c) {
+        case '(':
+            if (++P->depth > 1000) { P->err = 1; return 0; }
+            { int g = _tr_re_group(P); P->depth--; return g; }
+        case '[': return _tr_re_class(P);
+        case '.': {
+            int id = _tr_re_newset(P);
+            if (P->err) return 0;
+            memset(P->sets[id], 0xff, sizeof P->sets[0]);
+            if (!(P->flags & _TR_RE_DOTALL)) P->sets[id]['\n' >> 5] &= ~(1u << ('\n' & 31));
+            int n = _tr_re_node(P, _TR_RA_SET);
+            P->nodes[n].a = id;
+            return n;
+        }
+        case '^': return _tr_re_assert(P, P->flags & _TR_RE_MULTILINE ? _TR_RE_BOL : _TR_RE_BOT);
+        case '$': return _tr_re_assert(P, P->flags & _TR_RE_MULTILINE ? _TR_RE_EOL : _TR_RE_EOT);
+        case '*': case '+': case '?': P->err = 1; return 0;
+        case '\\': {
+            if (P->p < P->end) {
+                switch (*P->p) {
+                    case 'b': P->p++; return _tr_re_assert(P, _TR_RE_WORDB);
+                    case 'B': P->p++; return _tr_re_assert(P, _TR_RE_NWORDB);
+                    case 'A': P->p++; return _tr_re_assert(P, _TR_RE_BOT);
+                    case 'z': P->p++; return _tr_re_assert(P, _TR_RE_EOT);
+                }
+            }
+            int id = _tr_re_newset(P);
+            if (P->err) return 0;
+            int e = _tr_re_escape(P, P->sets[id]);
+            if (e == -1) { P->err = 1; return 0; }
+            if (e >= 0) _tr_re_add(P, P->sets[id], e);
+            int n = _tr_re_node(P, _TR_RA_SET);
+            P->nodes[n].a = id;
+            return n;
+        }
+    }
+    return _tr_re_lit(P, c);
+}
+static int _tr_re_cat(_TrReParse* P) {
+    int cat = _tr_re_node(P, _TR_RA_CAT);
+    while (!P->err && P->p < P->end && *P->p != '|' && *P->p != ')') {
+        int a = _tr_re_atom(P);
+        while (!P->err && P->p < P->end) {
+            int lo, hi, c = *P->p;
+            if (c == '*') { lo = 0; hi = -1; P->p++; }
+            else if (c == '+') { lo = 1; hi = -1; P->p++; }
+            else if (c == '?') { lo = 0; hi = 1; P->p++; }
+            else if (c == '{' && _tr_re_count(P, &lo, &hi)) {
+                if (lo > _TR_RE_MAX_REPEAT || hi > _TR_RE_MAX_REPEAT || (hi >= 0 && hi < lo)) { P->err = 1; return 0; }
+            } else break;
+            int r = _tr_re_node(P, _TR_RA_REP);
+            if (P->err) return 0;
+            P->nodes[r].a = lo; P->nodes[r].b = hi; P->nodes[r].child = a;
+            if (P->p < P->end && *P->p == '?') { P->nodes[r].greedy = 0; P->p++; }
+            a = r;
+        }
+        if (P->err) return 0;
+        _tr_re_append(P, cat, a);
+    }
+    return cat;
+}
+static int _tr_re_alt(_TrReParse* P) {
+    int first = _tr_re_cat(P);
+    if (P->err || P->p >= P->end || *P->p != '|') return first;
+    int alt = _tr_re_node(P, _TR_RA_ALT);
+    _tr_re_append(P, alt, first);
+    while (!P->err && P->p < P->end && *P->p == '|') {
+        P->p++;
+        int next = _tr_re_cat(P);
+        if (!P->err) _tr_re_append(P, alt, next);
+    }
+    return alt;
+}
+
+/* ── compiler ───────────────────────────────────────────────────────────── */
+static int _tr_re_emit(_TrReProg* g, int op, int arg, int x, int y) {
+    if (g->n >= _TR_RE_MAX_INSTS) return -1;
+    if (g->n == g->cap) {
+        int cap = g->cap ? g->cap * 2 : 64;
+        _TrReInst* in = (_TrReInst*)TAURARO_REALLOC(g->in, (size_t)cap * sizeof(_TrReInst));
+        if (!in) return -1;
+        g->in = in; g->cap = cap;
+    }
+    _TrReInst* i = &g->in[g->n];
+    i->op = (uint8_t)op; i->arg = (uint8_t)arg; i->x = x; i->y = y;
+    return g->n++;
+}
+/* Emit node n; rev builds the program for the reversed language (children of
+ * a concatenation in reverse order, anchors mirrored, no capture slots). */
+static int _tr_re_gen(_TrReProg* g, const _TrReNode* N, int n, int rev) {
+    const _TrReNode* nd = &N[n];
+    switch (nd->kind) {
+        case _TR_RA_EMPTY: return 0;
+        case _TR_RA_SET: return _tr_re_emit(g, _TR_RE_BYTE, 0, nd->a, 0) < 0 ? -1 : 0;
+        case _TR_RA_ASSERT: {
+            int k = nd->a;
+            if (rev) k = k == _TR_RE_BOT ? _TR_RE_EOT : k == _TR_RE_EOT ? _TR_RE_BOT
+                       : k == _TR_RE_BOL ? _TR_RE_EOL : k == _TR_RE_EOL ? _TR_RE_BOL : k;
+            return _tr_re_emit(g, _TR_RE_ASSERT, k, 0, 0) < 0 ? -1 : 0;
+        }
+        case _TR_RA_GROUP:
+            if (rev || nd->a < 0) return _tr_re_gen(g, N, nd->child, rev);
+            if (_tr_re_emit(g, _TR_RE_SAVE, 0, 2 * nd->a, 0) < 0) return -1;
+            if (_tr_re_gen(g, N, nd->child, rev) < 0) return -1;
+            return _tr_re_emit(g, _TR_RE_SAVE, 0, 2 * nd->a + 1, 0) < 0 ? -1 : 0;
+        case _TR_RA_CAT: {
+            if (!rev) {
+                for (int c = nd->child; c >= 0; c = N[c].next)
+                    if (_tr_re_gen(g, N, c, rev) < 0) return -1;
+                return 0;
+            }
+            int cnt = 0;
+            for (int c = nd->child; c >= 0; c = N[c].next) cnt++;
+            for (int k = cnt - 1; k >= 0; k--) {
+                int c = nd->child;
+                for (int j = 0; j < k; j++) c = N[c].next;
+                if (_tr_re_gen(g, N, c, rev) < 0) return -1;
+            }
+            return 0;
+        }
+        case _TR_RA_ALT: {
+            int jumps = -1;   /* chain of JMPs to patch, linked through x */
+            for (int c = nd->child; c >= 0; c = N[c].next) {
+                if (N[c].next < 0) { if (_tr_re_gen(g, N, c, rev) < 0) return -1; break; }
+                int sp = _tr_re_emit(g, _TR_RE_SPLIT, 0, 0, 0);
+                if (sp < 0) return -1;
+                g->in[sp].x = sp + 1;
+                if (_tr_re_gen(g, N, c, rev) < 0) return -1;
+                int j = _tr_re_emit(g, _TR_RE_JMP, 0, jumps, 0);
+                if (j < 0) return -1;
+                jumps = j;
+                g->in[sp].y = g->n;
+            }
+            while (jumps >= 0) { int nx = g->in[jumps].x; g->in[jumps].x = g->n; jumps = nx; }
+            return 0;
+        }
+        case _TR_RA_REP: {
+            int lo = nd->a, hi = nd->b, greedy = nd->greedy;
+            for (int i = 0; i < lo - (hi < 0 && lo > 0 ? 1 : 0); i++)
+                if (_tr_re_gen(g, N, nd->child, rev) < 0) return -1;
+            if (hi < 0) {
+                if (lo > 0) {               /* last copy is the loop body: x+ */
+                    int top = g->n;
+                    if (_tr_re_gen(g, N, nd->child, rev) < 0) return -1;
+                    int sp = _tr_re_emit(g, _TR_RE_SPLIT, 0, 0, 0);
+                    if (sp < 0) return -1;
+                    g->in[sp].x = greedy ? top : sp + 1;
+                    g->in[sp].y = greedy ? sp + 1 : top;
+                } else {                    /* x* */
+                    int sp = _tr_re_emit(g, _TR_RE_SPLIT, 0, 0, 0);
+                    if (sp < 0 || _tr_re_gen(g, N, nd->child, rev) < 0) return -1;
+                    if (_tr_re_emit(g, _TR_RE_JMP, 0, sp, 0) < 0) return -1;
+                    g->in[sp].x = greedy ? sp + 1 : g->n;
+                    g->in[sp].y = greedy ? g->n : sp + 1;
+                }
+                return 0;
+            }
+            int splits = -1;                /* x{lo,hi}: hi - lo optional copies */
+            for (int i = lo; i < hi; i++) {
+                int sp = _tr_re_emit(g, _TR_RE_SPLIT, 0, splits, greedy);
+                if (sp < 0) return -1;
+                splits = sp;
+                if (_tr_re_gen(g, N, nd->child, rev) < 0) return -1;
+            }
+            while (splits >= 0) {
+                _TrReInst* in = &g->in[splits];
+                int nx = in->x;
+                if (in->y) { in->x = splits + 1; in->y = g->n; } else { in->x = g->n; in->y = splits + 1; }
+                splits = nx;
+            }
+            return 0;
+        }
+    }
+    return -1;
+}
+/* Program layout: 0..2 is the unanchored `(?s:.)*?` prefix, 3 the anchored
+ * entry; the forward body is wrapped in SAVE 0 / SAVE 1 for group 0. */
+static int _tr_re_build(_TrReProg* g, const _TrReNode* N, int root, int rev) {
+    if (_tr_re_emit(g, _TR_RE_SPLIT, 0, 3, 1) < 0) return -1;
+    if (_tr_re_emit(g, _TR_RE_BYTE, 0, 0, 0) < 0) return -1;
+    if (_tr_re_emit(g, _TR_RE_JMP, 0, 0, 0) < 0) return -1;
+    if (!rev && _tr_re_emit(g, _TR_RE_SAVE, 0, 0, 0) < 0) return -1;
+    if (_tr_re_gen(g, N, root, rev) < 0) return -1;
+    if (!rev && _tr_re_emit(g, _TR_RE_SAVE, 0, 1, 0) < 0) return -1;
+    return _tr_re_emit(g, _TR_RE_MATCH, 0, 0, 0) < 0 ? -1 : 0;
+}
+/* Literal bytes every match must begin with. Returns 1 when node n was
+ * consumed entirely (so the literal may continue into the next node). */
+static int _tr_re_prefix(_TrRegex* r, const _TrReNode* N, int n) {
+    const _TrReNode* nd = &N[n];
+    switch (nd->kind) {
+        case _TR_RA_EMPTY: case _TR_RA_ASSERT: return 1;
+        case _TR_RA_GROUP: return _tr_re_prefix(r, N, nd->child);
+        case _TR_RA_CAT:
+            for (int c = nd->child; c >= 0; c = N[c].next)
+                if (!_tr_re_prefix(r, N, c)) return 0;
+            return 1;
+        case _TR_RA_REP:
+            if (nd->a >= 1) _tr_re_prefix(r, N, nd->child);
+            return 0;
+        case _TR_RA_SET: {
+            const uint32_t* s = r->sets[nd->a];
+            int only = -1, cnt = 0;
+            for (int i = 0; i < 8 && cnt < 2; i++) {
+                uint32_t w = s[i];
+                while (w && cnt < 2) { only = i * 32 + __builtin_ctz(w); w &= w - 1; cnt++; }
+            }
+            if (cnt != 1 || r->plen == (int)sizeof r->prefix) return 0;
+            r->prefix[r->plen++] = (unsigned char)only;
+            return 1;
+        }
+    }
+    return 0;
 }
-#else
-static inline char* _tr_regex_compile(char* p, int i) { (void)p;(void)i; return NULL; }
-static inline bool  _tr_regex_match(char* h, char* t) { (void)h;(void)t; return false; }
-static inline int   _tr_regex_find_start(char* h, char* t, int f) { (void)h;(void)t;(void)f; return -1; }
-static inline int   _tr_regex_find_len(char* h, char* t, int f) { (void)h;(void)t;(void)f; return -1; }
-static inline char* _tr_regex_replace_first(char* h, char* t, char* r) { (void)h;(void)r; return _tr_strdup(t?t:""); }
-static inline char* _tr_regex_replace_all(char* h, char* t, char* r) { (void)h;(void)r; return _tr_strdup(t?t:""); }
-static inline int   _tr_regex_count(char* h, char* t) { (void)h;(void)t; return 0; }
-static inline void  _tr_regex_free(char* h) { (void)h; }
-#endif
+
+/* ── lazy DFA ───────────────────────────────────────────────────────────── */
+static _TrReDfa* _tr_re_dfa_new(const _TrRegex* r, const _TrReProg* g, int start_pc, int longest) {
+    _TrReDfa* d = (_TrReDfa*)TAURARO_CALLOC(1, sizeof(_TrReDfa));
+    if (!d) return NULL;
+    d->ncol = r->ncls + 1;
+    d->longest = longest;
+    d->start_pc = start_pc;
+    d->stack = (int*)TAURARO_ALLOC((size_t)g->n * 2 * sizeof(int) + 16);
+    d->mark = (int*)TAURARO_CALLOC((size_t)g->n + 1, sizeof(int));
+    d->scratch = (int*)TAURARO_ALLOC((size_t)g->n * sizeof(int) + 16);
+    if (!d->stack || !d->mark || !d->scratch) {
+        TAURARO_FREE(d->stack); TAURARO_FREE(d->mark); TAURARO_FREE(d->scratch); TAURARO_FREE(d);
+        return NULL;
+    }
+    return d;
+}
+static void _tr_re_dfa_free(_TrReDfa* d) {
+    if (!d) return;
+    TAURARO_FREE(d->trans); TAURARO_FREE(d->off); TAURARO_FREE(d->len); TAURARO_FREE(d->flags);
+    TAURARO_FREE(d->idle); TAURARO_FREE(d->pool); TAURARO_FREE(d->hash);
+    TAURARO_FREE(d->stack); TAURARO_FREE(d->mark); TAURARO_FREE(d->scratch);
+    TAURARO_FREE(d);
+}
+/* Drop every state but the dead one (state 0, no threads). */
+static void _tr_re_dfa_reset(_TrReDfa* d) {
+    d->nstates = 1;
+    d->npool = 0;
+    if (d->hash) for (int i = 0; i < d->hcap; i++) d->hash[i] = -1;
+    for (int i = 0; i < 8; i++) d->start_st[i] = -1;
+    for (int c = 0; c < d->ncol; c++) d->trans[c] = 0;
+    d->off[0] = d->len[0] = 0; d->flags[0] = 0; d->idle[0] = 0;
+}
+static int _tr_re_dfa_init(_TrReDfa* d) {
+    d->scap = 64;
+    d->hcap = 256;
+    d->trans = (int*)TAURARO_ALLOC((size_t)d->scap * d->ncol * sizeof(int));
+    d->off = (int*)TAURARO_ALLOC((size_t)d->scap * sizeof(int));
+    d->len = (int*)TAURARO_ALLOC((size_t)d->scap * sizeof(int));
+    d->flags = (uint8_t*)TAURARO_ALLOC((size_t)d->scap);
+    d->idle = (uint8_t*)TAURARO_ALLOC((size_t)d->scap);
+    d->hash = (int*)TAURARO_ALLOC((size_t)d->hcap * sizeof(int));
+    d->pcap = 256;
+    d->pool = (int*)TAURARO_ALLOC((size_t)d->pcap * sizeof(int));
+    if (!d->trans || !d->off || !d->len || !d->flags || !d->idle || !d->hash || !d->pool) return -1;
+    _tr_re_dfa_reset(d);
+    return 0;
+}
+static inline unsigned _tr_re_hash(const int* k, int n, int flags) {
+    unsigned h = 2166136261u ^ (unsigned)flags;
+    for (int i = 0; i < n; i++) h = (h ^ (unsigned)k[i]) * 16777619u;
+    return h;
+}
+/* State for thread list k with context flags; -1 when the cache is full. */
+static int _tr_re_dfa_state(_TrReDfa* d, const int* k, int n, int flags) {
+    if (n == 0) return 0;
+    unsigned h = _tr_re_hash(k, n, flags);
+    int mask = d->hcap - 1;
+    for (unsigned i = h & (unsigned)mask;; i = (i + 1) & (unsigned)mask) {
+        int s = d->hash[i];
+        if (s < 0) break;
+        if (d->flags[s] == flags && d->len[s] == n && memcmp(d->pool + d->off[s], k, (size_t)n * sizeof(int)) == 0)
+            return s;
+    }
+    if (d->nstates >= _TR_RE_DFA_MAX_STATES) return -1;
+    if (d->nstates == d->scap) {
+        int cap = d->scap * 2;
+        int* t = (int*)TAURARO_REALLOC(d->trans, (size_t)cap * d->ncol * sizeof(int));
+        if (!t) return -1;
+        d->trans = t;
+        int* o = (int*)TAURARO_REALLOC(d->off, (size_t)cap * sizeof(int));
+        if (o) d->off = o;
+        int* l = (int*)TAURARO_REALLOC(d->len, (size_t)cap * sizeof(int));
+        if (l) d->len = l;
+        uint8_t* f = (uint8_t*)TAURARO_REALLOC(d->flags, (size_t)cap);
+        if (f) d->flags = f;
+        uint8_t* id = (uint8_t*)TAURARO_REALLOC(d->idle, (size_t)cap);
+        if (id) d->idle = id;
+        if (!o || !l || !f || !id) return -1;
+        d->scap = cap;
+    }
+    if (d->npool + n > d->pcap) {
+        int cap = d->pcap * 2;
+        while (cap < d->npool + n) cap *= 2;
+        int* p = (int*)TAURARO_REALLOC(d->pool, (size_t)cap * sizeof(int));
+        if (!p) return -1;
+        d->pool = p; d->pcap = cap;
+    }
+    if ((d->nstates + 1) * 2 > d->hcap) {
+        int cap = d->hcap * 2;
+        int* hs = (int*)TAURARO_ALLOC((size_t)cap * sizeof(int));
+        if (!hs) return -1;
+        for (int i = 0; i < cap; i++) hs[i] = -1;
+        for (int s = 1; s < d->nstates; s++) {
+            unsigned j = _tr_re_hash(d->pool + d->off[s], d->len[s], d->flags[s]) & (unsigned)(cap - 1);
+            while (hs[j] >= 0) j = (j + 1) & (unsigned)(cap - 1);
+            hs[j] = s;
+        }
+        TAURARO_FREE(d->hash);
+        d->hash = hs; d->hcap = cap;
+    }
+    int s = d->nstates++;
+    memcpy(d->pool + d->npool, k, (size_t)n * sizeof(int));
+    d->off[s] = d->npool; d->len[s] = n; d->flags[s] = (uint8_t)flags;
+    d->idle[s] = n == 1 && k[0] == d->start_pc && d->start_pc == 0;
+    d->npool += n;
+    for (int c = 0; c < d->ncol; c++) d->trans[(size_t)s * d->ncol + c] = -1;
+    unsigned j = h & (unsigned)(d->hcap - 1);
+    while (d->hash[j] >= 0) j = (j + 1) & (unsigned)(d->hcap - 1);
+    d->hash[j] = s;
+    return s;
+}
+static int _tr_re_dfa_start(_TrReDfa* d, int flags) {
+    int s = d->start_st[flags];
+    if (s >= 0) return s;
+    s = _tr_re_dfa_state(d, &d->start_pc, 1, flags);
+    if (s < 0) { _tr_re_dfa_reset(d); s = _tr_re_dfa_state(d, &d->start_pc, 1, flags); }
+    d->start_st[flags] = s;
+    return s;
+}
+static inline int _tr_re_holds(int kind, int flags, int next) {
+    int pw = (flags & _TR_RE_F_WORD) != 0, nw = next >= 0 && _tr_re_isword(next);
+    switch (kind) {
+        case _TR_RE_BOT: return (flags & _TR_RE_F_START) != 0;
+        case _TR_RE_EOT: return next < 0;
+        case _TR_RE_BOL: return (flags & (_TR_RE_F_START | _TR_RE_F_NL)) != 0;
+        case _TR_RE_EOL: return next < 0 || next == '\n';
+        case _TR_RE_WORDB: return pw != nw;
+        case _TR_RE_NWORDB: return pw == nw;
+    }
+    return 0;
+}
+static inline int _tr_re_ctx(int c, int mask) {
+    int f = 0;
+    if (_tr_re_isword(c)) f |= _TR_RE_F_WORD;
+    if (c == '\n') f |= _TR_RE_F_NL;
+    return f & mask;
+}
+/* Build the transition out of state s on byte class c (ncls = end of text).
+ * Expands the epsilon closure in priority order; leftmost-first DFAs drop
+ * every thread ranked below the first MATCH. */
+static int _tr_re_dfa_step(_TrRegex* r, _TrReDfa* d, const _TrReProg* g, int s, int c) {
+    int next = c < r->ncls ? r->rep[c] : -1;
+    int flags = d->flags[s], nk = 0, mb = 0;
+    int* stack = d->stack;
+    int* mark = d->mark;
+    if (++d->gen == 0x7fffffff) { memset(mark, 0, (size_t)g->n * sizeof(int)); d->gen = 1; }
+    int gen = d->gen;
+    int off = d->off[s], n = d->len[s];
+    for (int i = 0; i < n; i++) {
+        int sp = 0;
+        stack[sp++] = d->pool[off + i];
+        while (sp) {
+            int pc = stack[--sp];
+            if (mark[pc] == gen) continue;
+            mark[pc] = gen;
+            const _TrReInst* in = &g->in[pc];
+            switch (in->op) {
+                case _TR_RE_BYTE:
+                    if (next >= 0 && _tr_re_in(r->sets[in->x], next)) {
+                        int np = pc + 1;
+                        if (g->in[np].op == _TR_RE_JMP) np = g->in[np].x;   /* keeps the idle loop at pc 0 */
+                        d->scratch[nk++] = np;
+                    }
+                    break;
+                case _TR_RE_MATCH:
+                    mb = 1;
+                    if (!d->longest) goto done;
+                    break;
+                case _TR_RE_SPLIT: stack[sp++] = in->y; stack[sp++] = in->x; break;
+                case _TR_RE_JMP: stack[sp++] = in->x; break;
+                case _TR_RE_SAVE: stack[sp++] = pc + 1; break;
+                case _TR_RE_ASSERT: if (_tr_re_holds(in->arg, flags, next)) stack[sp++] = pc + 1; break;
+            }
+        }
+    }
+done:;
+    int nf = next >= 0 ? _tr_re_ctx(next, r->ctx_mask) : 0;
+    int t = _tr_re_dfa_state(d, d->scratch, nk, nf);
+    if (t < 0) {
+        _tr_re_dfa_reset(d);
+        t = _tr_re_dfa_state(d, d->scratch, nk, nf);
+        return t * 2 | mb;          /* s was flushed with the cache: don't record */
+    }
+    int v = t * 2 | mb;
+    d->trans[(size_t)s * d->ncol + c] = v;
+    return v;
+}
+static inline int _tr_re_fwd_flags(const unsigned char* t, long long pos, int mask) {
+    if (pos == 0) return _TR_RE_F_START & mask;
+    return _tr_re_ctx(t[pos - 1], mask);
+}
+static const unsigned char* _tr_re_memmem(const unsigned char* h, long long n, const unsigned char* k, int kn) {
+    const unsigned char* end = h + n - kn + 1;
+    while (h < end) {
+        const unsigned char* p = (const unsigned char*)memchr(h, k[0], (size_t)(end - h));
+        if (!p) return NULL;
+        if (memcmp(p + 1, k + 1, (size_t)kn - 1) == 0) return p;
+        h = p + 1;
+    }
+    return NULL;
+}
+/* Forward scan from pos. Returns where the leftmost-first match ends (or, with
+ * earliest, the first position any match ends), or -1. */
+static long long _tr_re_scan_fwd(_TrRegex* r, _TrReDfa* d, const _TrReProg* g,
+                                 const unsigned char* t, long long len, long long pos, int earliest) {
+    int s = _tr_re_dfa_start(d, _tr_re_fwd_flags(t, pos, r->ctx_mask));
+    long long last = -1;
+    const int ncol = d->ncol;
+    for (;;) {
+        if (r->plen && d->idle[s]) {
+            const unsigned char* hit = _tr_re_memmem(t + pos, len - pos, r->prefix, r->plen);
+            if (!hit) return last;
+            if (hit - t != pos) {
+                pos = hit - t;
+                s = _tr_re_dfa_start(d, _tr_re_fwd_flags(t, pos, r->ctx_mask));
+            }
+        }
+        int c = pos < len ? r->cls[t[pos]] : r->ncls;
+        int v = d->trans[(size_t)s * ncol + c];
+        if (v < 0) v = _tr_re_dfa_step(r, d, g, s, c);
+        if (v & 1) { last = pos; if (earliest) return last; }
+        s = v >> 1;
+        if (pos >= len || s == 0) return last;
+        pos++;
+    }
+}
+/* Reverse scan from end e down to from: the smallest start of a match that
+ * ends exactly at e. */
+static long long _tr_re_scan_rev(_TrRegex* r, const unsigned char* t, long long len, long long from, long long e) {
+    _TrReDfa* d = r->dfa_rev;
+    int f = e == len ? _TR_RE_F_START & r->ctx_mask : _tr_re_ctx(t[e], r->ctx_mask);
+    int s = _tr_re_dfa_start(d, f);
+    long long best = -1, pos = e;
+    for (;;) {
+        int c = pos > 0 ? r->cls[t[pos - 1]] : r->ncls;
+        int v = d->trans[(size_t)s * d->ncol + c];
+        if (v < 0) v = _tr_re_dfa_step(r, d, &r->rev, s, c);
+        if (v & 1) best = pos;
+        s = v >> 1;
+        if (pos <= from || s == 0) return best;
+        pos--;
+    }
+}
+
+/* ── PikeVM (captures) ──────────────────────────────────────────────────── */
+/* Add pc and its epsilon closure at pos to a thread list, in priority order,
+ * each BYTE/MATCH thread carrying a copy of the slots in pk_work. */
+static void _tr_re_pike_add(_TrRegex* r, int* pcs, int* n, long long* caps, int pc,
+                            const unsigned char* t, long long len, long long pos) {
+    const _TrReProg* g = &r->fwd;
+    int ncap = 2 * (r->ngroups + 1);
+    int flags = pos == 0 ? _TR_RE_F_START : _tr_re_ctx(t[pos - 1], _TR_RE_F_WORD | _TR_RE_F_NL);
+    int next = pos < len ? t[pos] : -1;
+    long long* work = r->pk_work;
+    int* stack = r->pk_stack;    /* pc to visit, or -(slot + 1) to undo a SAVE */
+    int sp = 0, nu = 0;
+    stack[sp++] = pc;
+    while (sp) {
+        int e = stack[--sp];
+        if (e < 0) { work[-e - 1] = r->pk_undo[--nu]; continue; }
+        if (r->pk_sp[e] < *n && pcs[r->pk_sp[e]] == e) continue;
+        r->pk_sp[e] = *n;
+        pcs[(*n)++] = e;
+        const _TrReInst* in = &g->in[e];
+        switch (in->op) {
+            case _TR_RE_BYTE: case _TR_RE_MATCH:
+                memcpy(caps + (size_t)e * ncap, work, (size_t)ncap * sizeof(long long));
+                break;
+            case _TR_RE_SPLIT: stack[sp++] = in->y; stack[sp++] = in->x; break;
+            case _TR_RE_JMP: stack[sp++] = in->x; break;
+            case _TR_RE_SAVE:
+                r->pk_undo[nu++] = work[in->x];
+                stack[sp++] = -in->x - 1;
+                work[in->x] = pos;
+                stack[sp++] = e + 1;
+                break;
+            case _TR_RE_ASSERT: if (_tr_re_holds(in->arg, flags, next)) stack[sp++] = e + 1; break;
+        }
+    }
+}
+/* Leftmost-first match anchored at s, recording capture slots into r->caps. */
+static int _tr_re_pike(_TrRegex* r, const unsigned char* t, long long len, long long s) {
+    const _TrReProg* g = &r->fwd;
+    int ni = g->n, ncap = 2 * (r->ngroups + 1), matched = 0;
+    if (!r->pk_pc) {
+        r->pk_pc = (int*)TAURARO_ALLOC((size_t)ni * 2 * sizeof(int));
+        r->pk_sp = (int*)TAURARO_ALLOC((size_t)ni * sizeof(int));
+        r->pk_stack = (int*)TAURARO_ALLOC(((size_t)ni * 2 + 16) * sizeof(int));
+        r->pk_caps = (long long*)TAURARO_ALLOC((size_t)ni * ncap * 2 * sizeof(long long));
+        r->pk_undo = (long long*)TAURARO_ALLOC((size_t)ni * sizeof(long long));
+        r->pk_work = (long long*)TAURARO_ALLOC((size_t)ncap * sizeof(long long));
+        if (!r->pk_pc || !r->pk_sp || !r->pk_stack || !r->pk_caps || !r->pk_undo || !r->pk_work) return 0;
+    }
+    int *cpc = r->pk_pc, *npc = r->pk_pc + ni, cn = 0;
+    long long *ccap = r->pk_caps, *ncp = r->pk_caps + (size_t)ni * ncap;
+    for (int i = 0; i < ncap; i++) r->pk_work[i] = -1;
+    memset(r->pk_sp, 0x7f, (size_t)ni * sizeof(int));
+    _tr_re_pike_add(r, cpc, &cn, ccap, 3, t, len, s);
+    for (long long pos = s; cn; pos++) {
+        int c = pos < len ? t[pos] : -1, nn = 0;
+        memset(r->pk_sp, 0x7f, (size_t)ni * sizeof(int));
+        for (int i = 0; i < cn; i++) {
+            const _TrReInst* in = &g->in[cpc[i]];
+            long long* tc = ccap + (size_t)cpc[i] * ncap;
+            if (in->op == _TR_RE_MATCH) {       /* lower-priority threads lose */
+                memcpy(r->caps, tc, (size_t)ncap * sizeof(long long));
+                matched = 1;
+                break;
+            }
+            if (in->op == _TR_RE_BYTE && c >= 0 && _tr_re_in(r->sets[in->x], c)) {
+                memcpy(r->pk_work, tc, (size_t)ncap * sizeof(long long));
+                _tr_re_pike_add(r, npc, &nn, ncp, cpc[i] + 1, t, len, pos + 1);
+            }
+        }
+        if (c < 0) break;
+        int* tp = cpc; cpc = npc; npc = tp;
+        long long* tcp = ccap; ccap = ncp; ncp = tcp;
+        cn = nn;
+    }
+    return matched;
+}
+
+/* ── handle ─────────────────────────────────────────────────────────────── */
+_TR_COLD void _tr_regex_free(char* handle) {
+    _TrRegex* r = (_TrRegex*)handle;
+    if (!r) return;
+    TAURARO_FREE(r->fwd.in); TAURARO_FREE(r->rev.in); TAURARO_FREE(r->sets);
+    _tr_re_dfa_free(r->dfa_fwd); _tr_re_dfa_free(r->dfa_rev); _tr_re_dfa_free(r->dfa_full);
+    TAURARO_FREE(r->caps);
+    TAURARO_FREE(r->pk_pc); TAURARO_FREE(r->pk_sp); TAURARO_FREE(r->pk_stack);
+    TAURARO_FREE(r->pk_caps); TAURARO_FREE(r->pk_undo); TAURARO_FREE(r->pk_work);
+    TAURARO_FREE(r);
+}
+/* Compile pattern; NULL on a syntax error. */
+_TR_COLD char* _tr_regex_compile(char* pattern, int icase) {
+    if (!pattern) return NULL;
+    _TrReParse P;
+    memset(&P, 0, sizeof P);
+    P.p = (const unsigned char*)pattern;
+    P.end = P.p + strlen(pattern);
+    P.flags = icase ? _TR_RE_ICASE : 0;
+    int all = _tr_re_newset(&P);                /* set 0: any byte, for the unanchored prefix */
+    if (!P.err) memset(P.sets[all], 0xff, sizeof P.sets[0]);
+    int root = P.err ? 0 : _tr_re_alt(&P);
+    if (!P.err && P.p != P.end) P.err = 1;      /* unbalanced ')' */
+    _TrRegex* r = P.err ? NULL : (_TrRegex*)TAURARO_CALLOC(1, sizeof(_TrRegex));
+    if (!r) { TAURARO_FREE(P.nodes); TAURARO_FREE(P.sets); return NULL; }
+    r->sets = P.sets; r->nsets = P.ns; r->ngroups = P.ngroups;
+    r->m_start = r->m_end = -1;
+    if (_tr_re_build(&r->fwd, P.nodes, root, 0) < 0 || _tr_re_build(&r->rev, P.nodes, root, 1) < 0) {
+        TAURARO_FREE(P.nodes); _tr_regex_free((char*)r); return NULL;
+    }
+    _tr_re_prefix(r, P.nodes, root);
+    TAURARO_FREE(P.nodes);
+    /* Byte classes: bytes no set (or context flag) tells apart share a column. */
+    uint8_t cut[256] = {0};
+    for (int i = 0; i < r->fwd.n; i++) {
+        const _TrReInst* in = &r->fwd.in[i];
+        if (in->op == _TR_RE_ASSERT) {
+            if (in->arg == _TR_RE_BOT || in->arg == _TR_RE_EOT) r->ctx_mask |= _TR_RE_F_START;
+            if (in->arg == _TR_RE_BOL || in->arg == _TR_RE_EOL) r->ctx_mask |= _TR_RE_F_START | _TR_RE_F_NL;
+            if (in->arg == _TR_RE_WORDB || in->arg == _TR_RE_NWORDB) r->ctx_mask |= _TR_RE_F_WORD;
+            continue;
+        }
+        if (in->op != _TR_RE_BYTE) continue;
+        const uint32_t* s = r->sets[in->x];
+        for (int c = 1; c < 256; c++) if (_tr_re_in(s, c) != _tr_re_in(s, c - 1)) cut[c] = 1;
+    }
+    for (int c = 1; c < 256; c++) {
+        if ((r->ctx_mask & _TR_RE_F_WORD) && _tr_re_isword(c) != _tr_re_isword(c - 1)) cut[c] = 1;
+        if ((r->ctx_mask & _TR_RE_F_NL) && (c == '\n' || c == '\n' + 1)) cut[c] = 1;
+    }
+    int k = 0;
+    r->rep[0] = 0;
+    for (int c = 0; c < 256; c++) {
+        if (c && cut[c]) r->rep[++k] = (uint8_t)c;
+        r->cls[c] = (uint8_t)k;
+    }
+    r->ncls = k + 1;
+    r->caps = (long long*)TAURARO_ALLOC((size_t)(2 * (r->ngroups + 1)) * sizeof(long long));
+    r->dfa_fwd = _tr_re_dfa_new(r, &r->fwd, 0, 0);
+    r->dfa_rev = _tr_re_dfa_new(r, &r->rev, 3, 1);
+    r->dfa_full = _tr_re_dfa_new(r, &r->fwd, 3, 1);
+    if (!r->caps || !r->dfa_fwd || !r->dfa_rev || !r->dfa_full
+        || _tr_re_dfa_init(r->dfa_fwd) < 0 || _tr_re_dfa_init(r->dfa_rev) < 0 || _tr_re_dfa_init(r->dfa_full) < 0) {
+        _tr_regex_free((char*)r);
+        return NULL;
+    }
+    return (char*)r;
+}
+/* True when the whole text is in the language. */
+_TR_COLD bool _tr_regex_match(char* handle, char* text) {
+    _TrRegex* r = (_TrRegex*)handle;
+    if (!r || !text) return false;
+    const unsigned char* t = (const unsigned char*)text;
+    long long len = (long long)strlen(text), pos = 0;
+    _TrReDfa* d = r->dfa_full;
+    int s = _tr_re_dfa_start(d, _TR_RE_F_START & r->ctx_mask);
+    for (;;) {
+        int c = pos < len ? r->cls[t[pos]] : r->ncls;
+        int v = d->trans[(size_t)s * d->ncol + c];
+        if (v < 0) v = _tr_re_dfa_step(r, d, &r->fwd, s, c);
+        if (pos >= len) return (v & 1) != 0;
+        s = v >> 1;
+        if (s == 0) return false;
+        pos++;
+    }
+}
+/* Start of the leftmost-first match in text[from, len), or -1. The end is
+ * then available from _tr_regex_end. */
+_TR_COLD long long _tr_regex_find(char* handle, char* text, long long len, long long from) {
+    _TrRegex* r = (_TrRegex*)handle;
+    if (!r || !text || from > len) return -1;
+    if (from < 0) from = 0;
+    const unsigned char* t = (const unsigned char*)text;
+    long long e = _tr_re_scan_fwd(r, r->dfa_fwd, &r->fwd, t, len, from, 0);
+    if (e < 0) { r->m_start = r->m_end = -1; return -1; }
+    long long s = _tr_re_scan_rev(r, t, len, from, e);
+    r->m_start = s < 0 ? e : s;
+    r->m_end = e;
+    return r->m_start;
+}
+_TR_COLD long long _tr_regex_end(char* handle) {
+    return handle ? ((_TrRegex*)handle)->m_end : -1;
+}
+/* True when any match exists; stops at the first position one ends. */
+_TR_COLD bool _tr_regex_search(char* handle, char* text, long long len) {
+    _TrRegex* r = (_TrRegex*)handle;
+    if (!r || !text) return false;
+    return _tr_re_scan_fwd(r, r->dfa_fwd, &r->fwd, (const unsigned char*)text, len, 0, 1) >= 0;
+}
+_TR_COLD long long _tr_regex_groups(char* handle) {
+    return handle ? ((_TrRegex*)handle)->ngroups : 0;
+}
+/* Fill capture slots for the match that starts at start; false when none. */
+_TR_COLD bool _tr_regex_capture(char* handle, char* text, long long len, long long start) {
+    _TrRegex* r = (_TrRegex*)handle;
+    if (!r || !text || start < 0 || start > len) return false;
+    return _tr_re_pike(r, (const unsigned char*)text, len, start) != 0;
+}
+_TR_COLD long long _tr_regex_group_start(char* handle, long long i) {
+    _TrRegex* r = (_TrRegex*)handle;
+    if (!r || i < 0 || i > r->ngroups) return -1;
+    return r->caps[2 * i];
+}
+_TR_COLD long long _tr_regex_group_end(char* handle, long long i) {
+    _TrRegex* r = (_TrRegex*)handle;
+    if (!r || i < 0 || i > r->ngroups) return -1;
+    return r->caps[2 * i + 1];
+}
+/* One pass over text: copy the gaps and repl for up to limit matches (< 0 =
+ * all) into b. An empty match right where the previous one ended is skipped. */
+static void _tr_re_replace(_TrRegex* r, _TrStrBuf* b, const char* text, long long len, const char* repl, long long limit) {
+    long long rl = (long long)strlen(repl), copied = 0, pos = 0, prev = -1, n = 0;
+    while (r && pos <= len && (limit < 0 || n < limit)) {
+        long long s = _tr_regex_find((char*)r, (char*)text, len, pos);
+        if (s < 0) break;
+        long long e = r->m_end;
+        if (s == e && s == prev) { pos = s + 1; continue; }
+        char* o = _tr_strbuf_grow(b, s - copied + rl);
+        memcpy(o, text + copied, (size_t)(s - copied));
+        memcpy(o + (s - copied), repl, (size_t)rl);
+        b->len += s - copied + rl;
+        copied = prev = e;
+        pos = e > s ? e : e + 1;
+        n++;
+    }
+    char* o = _tr_strbuf_grow(b, len - copied);
+    memcpy(o, text + copied, (size_t)(len - copied));
+    b->len += len - copied;
+    b->data[b->len] = '\0';
+}
+_TR_COLD char* _tr_regex_replace(char* handle, char* text, char* repl, long long limit) {
+    _TrStrBuf b = { 0, NULL, 0, 0 };
+    if (!text) text = (char*)"";
+    _tr_re_replace((_TrRegex*)handle, &b, text, (long long)strlen(text), repl ? repl : "", limit);
+    return b.data;
+}
+/* Append the replaced text to a StringBuilder's buffer. */
+_TR_COLD void _tr_regex_replace_into(char* handle, void* sb, char* text, long long len, char* repl) {
+    if (!text) return;
+    _tr_re_replace((_TrRegex*)handle, (_TrStrBuf*)sb, text, len, repl ? repl : "", -1);
+}
+_TR_COLD long long _tr_regex_count(char* handle, char* text, long long len) {
+    _TrRegex* r = (_TrRegex*)handle;
+    long long pos = 0, prev = -1, n = 0;
+    while (r && text && pos <= len) {
+        long long s = _tr_regex_find(handle, text, len, pos);
+        if (s < 0) break;
+        long long e = r->m_end;
+        if (s == e && s == prev) { pos = s + 1; continue; }
+        prev = e;
+        pos = e > s ? e : e + 1;
+        n++;
+    }
+    return n;
+}
+#endif /* _TR_COLD_BODIES */
 
 /* ═══════════════════════════════════════════════════════════════════════════
- * SHA-256 — pure C, no external dependencies.
+ * Hash and codec kernels — runtime CPU dispatch.
+ * SHA-1/SHA-256 blocks, base64 and hex each have a portable scalar kernel plus
+ * hardware kernels chosen once per process from what the CPU reports: SHA-NI
+ * and AVX2 on x86 (cpuid; the kernels carry target attributes, so no -m flags
+ * are needed), the ARMv8 SHA1/SHA2 instructions and NEON on aarch64
+ * (getauxval; always present on Apple). TAURARO_HWACCEL=0 in the environment
+ * pins the scalar kernels.
  * ═══════════════════════════════════════════════════════════════════════════ */
+_TR_COLD char* _tr_hash_kernels(void);
+_TR_COLD char* _tr_base64_encode(char* s, long long n, long long url);
+_TR_COLD char* _tr_base64_decode(char* s, long long n);
+_TR_COLD char* _tr_hex_encode(char* s, long long n, long long upper);
+_TR_COLD char* _tr_hex_decode(char* s, long long n);
+_TR_COLD char* _tr_sha256_hex_n(char* input, long long ilen);
+_TR_COLD char* _tr_sha256_hex(char* input);
+_TR_COLD char* _tr_sha1_hex(char* input, long long ilen);
+_TR_COLD char* _tr_hmac_sha256(char* key, int klen, char* msg);
+_TR_COLD char* _tr_uuid_v4(void);
+_TR_COLD char* _tr_md5_hex(char* s);
+#if _TR_COLD_BODIES
+#if !defined(TAURARO_BARE) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define _TR_HW_X86 1
+#  include <cpuid.h>
+#  include <immintrin.h>
+#elif !defined(TAURARO_BARE) && defined(__GNUC__) && defined(__aarch64__)
+#  define _TR_HW_ARM 1
+#  include <arm_neon.h>
+#  if defined(__linux__)
+#    include <sys/auxv.h>
+#  endif
+#  if defined(__clang__)
+#    define _TR_ARM_CRYPTO __attribute__((target("crypto")))
+#  else
+#    define _TR_ARM_CRYPTO __attribute__((target("+crypto")))
+#  endif
+#endif
+
+#define _TR_CPU_SHA  1   /* SHA-NI (x86) / ARMv8 SHA1 + SHA2 */
+#define _TR_CPU_AVX2 2
+#define _TR_CPU_NEON 4
+
+/* Detected feature bits; -1 until the first kernel call. */
+#ifdef _TR_MAIN
+int _tr_cpu_feat = -1;
+#else
+extern int _tr_cpu_feat;
+#endif
+
+static inline int _tr_cpu_detect(void) {
+    int f = 0;
+#if defined(_TR_HW_X86) || defined(_TR_HW_ARM)
+    const char* e = getenv("TAURARO_HWACCEL");
+    if (e && e[0] == '0') return 0;
+#endif
+#if defined(_TR_HW_X86)
+    unsigned a, b, c, d;
+    if (__get_cpuid(1, &a, &b, &c, &d)) {
+        int sse41 = (c >> 19) & 1, ymm = 0;
+        if (((c >> 27) & 1) && ((c >> 28) & 1)) {          /* OSXSAVE + AVX */
+            unsigned lo, hi;
+            __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+            ymm = (lo & 6) == 6;                            /* OS saves XMM and YMM */
+        }
+        if (__get_cpuid_count(7, 0, &a, &b, &c, &d)) {
+            if (((b >> 29) & 1) && sse41) f |= _TR_CPU_SHA;
+            if (((b >> 5) & 1) && ymm)    f |= _TR_CPU_AVX2;
+        }
+    }
+#elif defined(_TR_HW_ARM)
+    f |= _TR_CPU_NEON;
+#  if defined(__APPLE__)
+    f |= _TR_CPU_SHA;
+#  elif defined(__linux__)
+    unsigned long hw = getauxval(AT_HWCAP);
+    if ((hw & (1UL << 5)) && (hw & (1UL << 6))) f |= _TR_CPU_SHA;   /* HWCAP_SHA1 | HWCAP_SHA2 */
+#  endif
+#endif
+    return f;
+}
+static inline int _tr_cpu_features(void) {
+    int f = __atomic_load_n(&_tr_cpu_feat, __ATOMIC_RELAXED);
+    if (f < 0) {
+        f = _tr_cpu_detect();
+        __atomic_store_n(&_tr_cpu_feat, f, __ATOMIC_RELAXED);
+    }
+    return f;
+}
+/* Names of the kernels in use, e.g. "sha-ni avx2" or "scalar" (heap string). */
+_TR_COLD char* _tr_hash_kernels(void) {
+    int f = _tr_cpu_features();
+    char buf[48]; buf[0] = '\0';
+#if defined(_TR_HW_X86)
+    if (f & _TR_CPU_SHA)  strcat(buf, " sha-ni");
+    if (f & _TR_CPU_AVX2) strcat(buf, " avx2");
+#elif defined(_TR_HW_ARM)
+    if (f & _TR_CPU_SHA)  strcat(buf, " armv8-sha");
+    if (f & _TR_CPU_NEON) strcat(buf, " neon");
+#endif
+    (void)f;
+    return _tr_strdup(buf[0] ? buf + 1 : "scalar");
+}
+
+/* ── Base64 / hex codecs ──────────────────────────────────────────────────
+ * _tr_b64_enc writes 4 chars per 3 bytes ('=' padded; the URL alphabet is
+ * unpadded, as RFC 4648 §5 allows) and returns the count. _tr_b64_dec accepts
+ * either alphabet, skips quartets padded with '=' and stops at the first
+ * quartet that does not start with two base64 chars; a trailing 2-3 char
+ * quartet decodes as if padded. Its output needs (n/4)*3 + 3 bytes: the AVX2
+ * kernel stores 32 bytes per 24 decoded and only runs while that fits. */
+static const char _tr_b64_std[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char _tr_b64_url[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+static const uint8_t _tr_b64_val[128] = {
+    255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+    255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+    255,255,255,255,255,255,255,255,255,255,255, 62,255, 62,255, 63,
+     52, 53, 54, 55, 56, 57, 58, 59, 60, 61,255,255,255,255,255,255,
+    255,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+     15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25,255,255,255,255, 63,
+    255, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+     41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51,255,255,255,255,255,
+};
+static const char _tr_hex_lc[] = "0123456789abcdef";
+static const char _tr_hex_uc[] = "0123456789ABCDEF";
+
+#if defined(_TR_HW_X86)
+/* 24 bytes -> 32 chars per step (Muła's multiply-shift split, then a pshufb
+ * offset table per alphabet range). Reads 28 bytes, so needs n - i >= 28. */
+__attribute__((target("avx2")))
+static inline size_t _tr_b64_enc_avx2(const uint8_t* s, size_t n, char* o, int url) {
+    const __m256i shuf = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                          1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m256i lut = url
+        ? _mm256_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -17, 32, 0, 0,
+                           65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -17, 32, 0, 0)
+        : _mm256_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0,
+                           65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+    size_t i = 0, j = 0;
+    for (; n - i >= 28; i += 24, j += 32) {
+        __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(s + i))),
+                                            _mm_loadu_si128((const __m128i*)(s + i + 12)), 1);
+        v = _mm256_shuffle_epi8(v, shuf);
+        __m256i hi = _mm256_mulhi_epu16(_mm256_and_si256(v, _mm256_set1_epi32(0x0FC0FC00)), _mm256_set1_epi32(0x04000040));
+        __m256i lo = _mm256_mullo_epi16(_mm256_and_si256(v, _mm256_set1_epi32(0x003F03F0)), _mm256_set1_epi32(0x01000010));
+        __m256i idx = _mm256_or_si256(hi, lo);                              /* four 6-bit values per dword */
+        __m256i r = _mm256_subs_epu8(idx, _mm256_set1_epi8(51));
+        r = _mm256_sub_epi8(r, _mm256_cmpgt_epi8(idx, _mm256_set1_epi8(25)));
+        _mm256_storeu_si256((__m256i*)(o + j), _mm256_add_epi8(idx, _mm256_shuffle_epi8(lut, r)));
+    }
+    return i;
+}
+/* 32 chars -> 24 bytes per step; stops (returning chars consumed) at the
+ * first block holding '=', the URL alphabet or anything invalid. */
+__attribute__((target("avx2")))
+static inline size_t _tr_b64_dec_avx2(const char* s, size_t n, uint8_t* o) {
+    const __m256i lut_lo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+                                            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lut_hi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                                              0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i m2f = _mm256_set1_epi8(0x2F);
+    const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                          2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    size_t i = 0, j = 0;
+    for (; n - i >= 44; i += 32, j += 24) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(s + i));
+        __m256i hn = _mm256_and_si256(_mm256_srli_epi32(v, 4), m2f);
+        __m256i ln = _mm256_and_si256(v, m2f);
+        if (!_mm256_testz_si256(_mm256_shuffle_epi8(lut_lo, ln), _mm256_shuffle_epi8(lut_hi, hn))) break;
+        v = _mm256_add_epi8(v, _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(_mm256_cmpeq_epi8(v, m2f), hn)));
+        v = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));        /* merge 6+6 bits */
+        v = _mm256_madd_epi16(v, _mm256_set1_epi32(0x00011000));           /* merge 12+12 bits */
+        v = _mm256_shuffle_epi8(v, pack);
+        v = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+        _mm256_storeu_si256((__m256i*)(o + j), v);
+    }
+    return i;
+}
+__attribute__((target("avx2")))
+static inline size_t _tr_hex_enc_avx2(const uint8_t* s, size_t n, char* o, const char* digits) {
+    const __m256i lut = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)digits));
+    const __m256i m = _mm256_set1_epi8(15);
+    size_t i = 0;
+    for (; n - i >= 32; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(s + i));
+        __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), m));
+        __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, m));
+        __m256i a = _mm256_unpacklo_epi8(hi, lo), b = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256((__m256i*)(o + 2 * i),      _mm256_permute2x128_si256(a, b, 0x20));
+        _mm256_storeu_si256((__m256i*)(o + 2 * i + 32), _mm256_permute2x128_si256(a, b, 0x31));
+    }
+    return i;
+}
+/* 64 chars -> 32 bytes per step; stops at the first block with a non-hex char. */
+__attribute__((target("avx2")))
+static inline size_t _tr_hex_dec_avx2(const char* s, size_t n, uint8_t* o) {
+    size_t i = 0;
+    for (; n - i >= 64; i += 64) {
+        __m256i w[2];
+        for (int h = 0; h < 2; h++) {
+            __m256i c = _mm256_loadu_si256((const __m256i*)(s + i + 32 * h));
+            __m256i d = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+            __m256i l = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+            __m256i isd = _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(9)), d);
+            __m256i isl = _mm256_cmpeq_epi8(_mm256_min_epu8(l, _mm256_set1_epi8(5)), l);
+            if ((unsigned)_mm256_movemask_epi8(_mm256_or_si256(isd, isl)) != 0xFFFFFFFFu) return i;
+            __m256i v = _mm256_or_si256(_mm256_and_si256(isd, d),
+                                        _mm256_and_si256(isl, _mm256_add_epi8(l, _mm256_set1_epi8(10))));
+            w[h] = _mm256_maddubs_epi16(v, _mm256_set1_epi16(0x0110));      /* hi*16 + lo */
+        }
+        _mm256_storeu_si256((__m256i*)(o + i / 2), _mm256_permute4x64_epi64(_mm256_packus_epi16(w[0], w[1]), 0xD8));
+    }
+    return i;
+}
+#elif defined(_TR_HW_ARM)
+/* 48 bytes -> 64 chars per step: vld3 splits the byte triples, vst4
+ * interleaves the four 6-bit lanes after a 64-entry table lookup. */
+static inline size_t _tr_b64_enc_neon(const uint8_t* s, size_t n, char* o, int url) {
+    const uint8_t* a = (const uint8_t*)(url ? _tr_b64_url : _tr_b64_std);
+    uint8x16x4_t tbl = {{ vld1q_u8(a), vld1q_u8(a + 16), vld1q_u8(a + 32), vld1q_u8(a + 48) }};
+    size_t i = 0, j = 0;
+    for (; n - i >= 48; i += 48, j += 64) {
+        uint8x16x3_t in = vld3q_u8(s + i);
+        uint8x16x4_t r;
+        r.val[0] = vshrq_n_u8(in.val[0], 2);
+        r.val[1] = vorrq_u8(vshlq_n_u8(vandq_u8(in.val[0], vdupq_n_u8(3)), 4), vshrq_n_u8(in.val[1], 4));
+        r.val[2] = vorrq_u8(vshlq_n_u8(vandq_u8(in.val[1], vdupq_n_u8(15)), 2), vshrq_n_u8(in.val[2], 6));
+        r.val[3] = vandq_u8(in.val[2], vdupq_n_u8(63));
+        for (int k = 0; k < 4; k++) r.val[k] = vqtbl4q_u8(tbl, r.val[k]);
+        vst4q_u8((uint8_t*)o + j, r);
+    }
+    return i;
+}
+/* 64 chars -> 48 bytes per step through the 128-entry value table. */
+static inline size_t _tr_b64_dec_neon(const char* s, size_t n, uint8_t* o) {
+    const uint8_t* t = _tr_b64_val;
+    uint8x16x4_t lo = {{ vld1q_u8(t), vld1q_u8(t + 16), vld1q_u8(t + 32), vld1q_u8(t + 48) }};
+    uint8x16x4_t hi = {{ vld1q_u8(t + 64), vld1q_u8(t + 80), vld1q_u8(t + 96), vld1q_u8(t + 112) }};
+    size_t i = 0, j = 0;
+    for (; n - i >= 64; i += 64, j += 48) {
+        uint8x16x4_t in = vld4q_u8((const uint8_t*)s + i), v;
+        uint8x16_t bad = vdupq_n_u8(0);
+        for (int k = 0; k < 4; k++) {
+            v.val[k] = vqtbx4q_u8(vqtbl4q_u8(lo, in.val[k]), hi, vsubq_u8(in.val[k], vdupq_n_u8(64)));
+            bad = vorrq_u8(bad, vorrq_u8(v.val[k], in.val[k]));     /* 0xFF entries or bytes >= 0x80 */
+        }
+        if (vmaxvq_u8(bad) >= 0x80) break;
+        uint8x16x3_t r;
+        r.val[0] = vorrq_u8(vshlq_n_u8(v.val[0], 2), vshrq_n_u8(v.val[1], 4));
+        r.val[1] = vorrq_u8(vshlq_n_u8(v.val[1], 4), vshrq_n_u8(v.val[2], 2));
+        r.val[2] = vorrq_u8(vshlq_n_u8(v.val[2], 6), v.val[3]);
+        vst3q_u8(o + j, r);
+    }
+    return i;
+}
+static inline size_t _tr_hex_enc_neon(const uint8_t* s, size_t n, char* o, const char* digits) {
+    const uint8x16_t lut = vld1q_u8((const uint8_t*)digits);
+    size_t i = 0;
+    for (; n - i >= 16; i += 16) {
+        uint8x16_t v = vld1q_u8(s + i);
+        uint8x16x2_t r = {{ vqtbl1q_u8(lut, vshrq_n_u8(v, 4)), vqtbl1q_u8(lut, vandq_u8(v, vdupq_n_u8(15))) }};
+        vst2q_u8((uint8_t*)o + 2 * i, r);
+    }
+    return i;
+}
+static inline size_t _tr_hex_dec_neon(const char* s, size_t n, uint8_t* o) {
+    size_t i = 0;
+    for (; n - i >= 32; i += 32) {
+        uint8x16x2_t c = vld2q_u8((const uint8_t*)s + i);          /* val[0] high nibbles, val[1] low */
+        uint8x16_t v[2], ok = vdupq_n_u8(0xFF);
+        for (int h = 0; h < 2; h++) {
+            uint8x16_t d = vsubq_u8(c.val[h], vdupq_n_u8('0'));
+            uint8x16_t l = vsubq_u8(vorrq_u8(c.val[h], vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+            uint8x16_t isd = vcleq_u8(d, vdupq_n_u8(9)), isl = vcleq_u8(l, vdupq_n_u8(5));
+            ok = vandq_u8(ok, vorrq_u8(isd, isl));
+            v[h] = vorrq_u8(vandq_u8(isd, d), vandq_u8(isl, vaddq_u8(l, vdupq_n_u8(10))));
+        }
+        if (vminvq_u8(ok) == 0) return i;
+        vst1q_u8(o + i / 2, vorrq_u8(vshlq_n_u8(v[0], 4), v[1]));
+    }
+    return i;
+}
+#endif
+
+static inline size_t _tr_b64_enc(const uint8_t* s, size_t n, char* o, int url) {
+    const char* a = url ? _tr_b64_url : _tr_b64_std;
+    size_t i = 0, j = 0;
+#if defined(_TR_HW_X86)
+    if (_tr_cpu_features() & _TR_CPU_AVX2) { i = _tr_b64_enc_avx2(s, n, o, url); j = i / 3 * 4; }
+#elif defined(_TR_HW_ARM)
+    if (_tr_cpu_features() & _TR_CPU_NEON) { i = _tr_b64_enc_neon(s, n, o, url); j = i / 3 * 4; }
+#endif
+    for (; n - i >= 3; i += 3) {
+        uint32_t v = ((uint32_t)s[i] << 16) | ((uint32_t)s[i + 1] << 8) | s[i + 2];
+        o[j++] = a[v >> 18]; o[j++] = a[(v >> 12) & 63]; o[j++] = a[(v >> 6) & 63]; o[j++] = a[v & 63];
+    }
+    if (n - i) {
+        uint32_t v = ((uint32_t)s[i] << 16) | (n - i == 2 ? (uint32_t)s[i + 1] << 8 : 0);
+        o[j++] = a[v >> 18]; o[j++] = a[(v >> 12) & 63];
+        if (n - i == 2) o[j++] = a[(v >> 6) & 63];
+        else if (!url) o[j++] = '=';
+        if (!url) o[j++] = '=';
+    }
+    return j;
+}
+static inline size_t _tr_b64_dec(const char* s, size_t n, uint8_t* o) {
+    const uint8_t* u = (const uint8_t*)s;
+    size_t i = 0, j = 0;
+#if defined(_TR_HW_X86)
+    if (_tr_cpu_features() & _TR_CPU_AVX2) { i = _tr_b64_dec_avx2(s, n, o); j = i / 4 * 3; }
+#elif defined(_TR_HW_ARM)
+    if (_tr_cpu_features() & _TR_CPU_NEON) { i = _tr_b64_dec_neon(s, n, o); j = i / 4 * 3; }
+#endif
+    for (; i + 1 < n; i += 4) {
+        int v[4];
+        for (int k = 0; k < 4; k++) v[k] = (i + k < n && u[i + k] < 128) ? _tr_b64_val[u[i + k]] : 255;
+        if (v[0] == 255 || v[1] == 255) break;
+        o[j++] = (uint8_t)((v[0] << 2) | (v[1] >> 4));
+        if (v[2] == 255) continue;
+        o[j++] = (uint8_t)((v[1] << 4) | (v[2] >> 2));
+        if (v[3] == 255) continue;
+        o[j++] = (uint8_t)((v[2] << 6) | v[3]);
+    }
+    return j;
+}
+/* Writes 2n chars (no terminator). */
+static inline void _tr_hex_enc(const uint8_t* s, size_t n, char* o, int upper) {
+    const char* digits = upper ? _tr_hex_uc : _tr_hex_lc;
+    size_t i = 0;
+#if defined(_TR_HW_X86)
+    if (_tr_cpu_features() & _TR_CPU_AVX2) i = _tr_hex_enc_avx2(s, n, o, digits);
+#elif defined(_TR_HW_ARM)
+    if (_tr_cpu_features() & _TR_CPU_NEON) i = _tr_hex_enc_neon(s, n, o, digits);
+#endif
+    for (; i < n; i++) { o[2 * i] = digits[s[i] >> 4]; o[2 * i + 1] = digits[s[i] & 15]; }
+}
+static inline int _tr_hex_nibble(uint8_t c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c |= 0x20;
+    return (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+}
+/* Writes n/2 bytes; returns that count, or -1 for odd n or a non-hex char. */
+static inline long long _tr_hex_dec(const char* s, size_t n, uint8_t* o) {
+    if (n & 1) return -1;
+    size_t i = 0;
+#if defined(_TR_HW_X86)
+    if (_tr_cpu_features() & _TR_CPU_AVX2) i = _tr_hex_dec_avx2(s, n, o);
+#elif defined(_TR_HW_ARM)
+    if (_tr_cpu_features() & _TR_CPU_NEON) i = _tr_hex_dec_neon(s, n, o);
+#endif
+    for (; i < n; i += 2) {
+        int hi = _tr_hex_nibble((uint8_t)s[i]), lo = _tr_hex_nibble((uint8_t)s[i + 1]);
+        if (hi < 0 || lo < 0) return -1;
+        o[i / 2] = (uint8_t)((hi << 4) | lo);
+    }
+    return (long long)(n / 2);
+}
+
+/* std.encoding entry points. A negative length means strlen(s). */
+_TR_COLD char* _tr_base64_encode(char* s, long long n, long long url) {
+    if (!s) return _tr_empty_heap_str();
+    size_t len = n < 0 ? strlen(s) : (size_t)n;
+    char* out = (char*)TAURARO_ALLOC((len + 2) / 3 * 4 + 1);
+    if (!out) return _tr_empty_heap_str();
+    out[_tr_b64_enc((const uint8_t*)s, len, out, url != 0)] = '\0';
+    return out;
+}
+_TR_COLD char* _tr_base64_decode(char* s, long long n) {
+    if (!s) return _tr_empty_heap_str();
+    size_t len = n < 0 ? strlen(s) : (size_t)n;
+    char* out = (char*)TAURARO_ALLOC(len / 4 * 3 + 4);
+    if (!out) return _tr_empty_heap_str();
+    out[_tr_b64_dec(s, len, (uint8_t*)out)] = '\0';
+    return out;
+}
+_TR_COLD char* _tr_hex_encode(char* s, long long n, long long upper) {
+    if (!s) return _tr_empty_heap_str();
+    size_t len = n < 0 ? strlen(s) : (size_t)n;
+    char* out = (char*)TAURARO_ALLOC(len * 2 + 1);
+    if (!out) return _tr_empty_heap_str();
+    _tr_hex_enc((const uint8_t*)s, len, out, upper != 0);
+    out[len * 2] = '\0';
+    return out;
+}
+/* Accepts an optional 0x/0X prefix; "" for odd-length or non-hex input. */
+_TR_COLD char* _tr_hex_decode(char* s, long long n) {
+    if (!s) return _tr_empty_heap_str();
+    size_t len = n < 0 ? strlen(s) : (size_t)n;
+    if (len >= 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) { s += 2; len -= 2; }
+    char* out = (char*)TAURARO_ALLOC(len / 2 + 1);
+    if (!out) return _tr_empty_heap_str();
+    long long k = _tr_hex_dec(s, len, (uint8_t*)out);
+    out[k < 0 ? 0 : k] = '\0';
+    return out;
+}
+
+/* ── SHA-256 ──────────────────────────────────────────────────────────────── */
 #define _TR_ROTR32(x,n) (((x)>>(n))|((x)<<(32-(n))))
 #define _TR_S0(x) (_TR_ROTR32(x,2)^_TR_ROTR32(x,13)^_TR_ROTR32(x,22))
 #define _TR_S1(x) (_TR_ROTR32(x,6)^_TR_ROTR32(x,11)^_TR_ROTR32(x,25))
@@ -5269,54 +13113,125 @@ static const uint32_t _tr_sha256_K[64] = {
 
 typedef struct { uint32_t h[8]; uint8_t buf[64]; uint64_t bits; uint32_t buf_len; } _TrSHA256Ctx;
 
+static inline void _tr_sha256_blocks_c(uint32_t* st, const uint8_t* blk, size_t n) {
+    for (; n; n--, blk += 64) {
+        uint32_t w[64],a,b,cc,d,e,f,g,h,t1,t2; int i;
+        for(i=0;i<16;i++) w[i]=((uint32_t)blk[i*4]<<24)|((uint32_t)blk[i*4+1]<<16)|((uint32_t)blk[i*4+2]<<8)|(uint32_t)blk[i*4+3];
+        for(i=16;i<64;i++) w[i]=_TR_s1(w[i-2])+w[i-7]+_TR_s0(w[i-15])+w[i-16];
+        a=st[0];b=st[1];cc=st[2];d=st[3];e=st[4];f=st[5];g=st[6];h=st[7];
+        for(i=0;i<64;i++){
+            t1=h+_TR_S1(e)+_TR_CH(e,f,g)+_tr_sha256_K[i]+w[i];
+            t2=_TR_S0(a)+_TR_MAJ(a,b,cc);
+            h=g;g=f;f=e;e=d+t1;d=cc;cc=b;b=a;a=t1+t2;
+        }
+        st[0]+=a;st[1]+=b;st[2]+=cc;st[3]+=d;st[4]+=e;st[5]+=f;st[6]+=g;st[7]+=h;
+    }
+}
+#if defined(_TR_HW_X86)
+/* SHA-NI: the state lives as ABEF/CDGH; each sha256rnds2 pair does 4 rounds
+ * and msg1/msg2 extend the schedule 4 words at a time. */
+__attribute__((target("sha,sse4.1")))
+static inline void _tr_sha256_blocks_hw(uint32_t* st, const uint8_t* p, size_t n) {
+    const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+    __m128i t  = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)st), 0xB1);        /* CDAB */
+    __m128i s1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)(st + 4)), 0x1B);  /* EFGH */
+    __m128i s0 = _mm_alignr_epi8(t, s1, 8);                                           /* ABEF */
+    s1 = _mm_blend_epi16(s1, t, 0xF0);                                                /* CDGH */
+    for (; n; n--, p += 64) {
+        __m128i abef = s0, cdgh = s1, m[4];
+        for (int i = 0; i < 16; i++) {
+            if (i < 4) m[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + 16 * i)), bswap);
+            else m[i & 3] = _mm_sha256msg2_epu32(
+                    _mm_add_epi32(_mm_sha256msg1_epu32(m[i & 3], m[(i + 1) & 3]),
+                                  _mm_alignr_epi8(m[(i + 3) & 3], m[(i + 2) & 3], 4)),
+                    m[(i + 3) & 3]);
+            __m128i k = _mm_add_epi32(m[i & 3], _mm_loadu_si128((const __m128i*)&_tr_sha256_K[4 * i]));
+            s1 = _mm_sha256rnds2_epu32(s1, s0, k);
+            s0 = _mm_sha256rnds2_epu32(s0, s1, _mm_shuffle_epi32(k, 0x0E));
+        }
+        s0 = _mm_add_epi32(s0, abef);
+        s1 = _mm_add_epi32(s1, cdgh);
+    }
+    t  = _mm_shuffle_epi32(s0, 0x1B);                                                 /* FEBA */
+    s1 = _mm_shuffle_epi32(s1, 0xB1);                                                 /* DCHG */
+    _mm_storeu_si128((__m128i*)st, _mm_blend_epi16(t, s1, 0xF0));                     /* DCBA */
+    _mm_storeu_si128((__m128i*)(st + 4), _mm_alignr_epi8(s1, t, 8));                  /* HGFE */
+}
+#elif defined(_TR_HW_ARM)
+_TR_ARM_CRYPTO
+static inline void _tr_sha256_blocks_hw(uint32_t* st, const uint8_t* p, size_t n) {
+    uint32x4_t s0 = vld1q_u32(st), s1 = vld1q_u32(st + 4);
+    for (; n; n--, p += 64) {
+        uint32x4_t abcd = s0, efgh = s1, m[4];
+        for (int i = 0; i < 16; i++) {
+            if (i < 4) m[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(p + 16 * i)));
+            else m[i & 3] = vsha256su1q_u32(vsha256su0q_u32(m[i & 3], m[(i + 1) & 3]), m[(i + 2) & 3], m[(i + 3) & 3]);
+            uint32x4_t k = vaddq_u32(m[i & 3], vld1q_u32(&_tr_sha256_K[4 * i])), t = s0;
+            s0 = vsha256hq_u32(s0, s1, k);
+            s1 = vsha256h2q_u32(s1, t, k);
+        }
+        s0 = vaddq_u32(s0, abcd);
+        s1 = vaddq_u32(s1, efgh);
+    }
+    vst1q_u32(st, s0);
+    vst1q_u32(st + 4, s1);
+}
+#endif
+static inline void _tr_sha256_blocks(uint32_t* st, const uint8_t* p, size_t n) {
+#if defined(_TR_HW_X86) || defined(_TR_HW_ARM)
+    if (_tr_cpu_features() & _TR_CPU_SHA) { _tr_sha256_blocks_hw(st, p, n); return; }
+#endif
+    _tr_sha256_blocks_c(st, p, n);
+}
+
 static inline void _tr_sha256_init(_TrSHA256Ctx* c) {
     c->h[0]=0x6a09e667;c->h[1]=0xbb67ae85;c->h[2]=0x3c6ef372;c->h[3]=0xa54ff53a;
     c->h[4]=0x510e527f;c->h[5]=0x9b05688c;c->h[6]=0x1f83d9ab;c->h[7]=0x5be0cd19;
     c->bits=0; c->buf_len=0;
 }
-static inline void _tr_sha256_block(_TrSHA256Ctx* c, const uint8_t* blk) {
-    uint32_t w[64],a,b,cc,d,e,f,g,h,t1,t2; int i;
-    for(i=0;i<16;i++) w[i]=((uint32_t)blk[i*4]<<24)|((uint32_t)blk[i*4+1]<<16)|((uint32_t)blk[i*4+2]<<8)|(uint32_t)blk[i*4+3];
-    for(i=16;i<64;i++) w[i]=_TR_s1(w[i-2])+w[i-7]+_TR_s0(w[i-15])+w[i-16];
-    a=c->h[0];b=c->h[1];cc=c->h[2];d=c->h[3];e=c->h[4];f=c->h[5];g=c->h[6];h=c->h[7];
-    for(i=0;i<64;i++){
-        t1=h+_TR_S1(e)+_TR_CH(e,f,g)+_tr_sha256_K[i]+w[i];
-        t2=_TR_S0(a)+_TR_MAJ(a,b,cc);
-        h=g;g=f;f=e;e=d+t1;d=cc;cc=b;b=a;a=t1+t2;
-    }
-    c->h[0]+=a;c->h[1]+=b;c->h[2]+=cc;c->h[3]+=d;c->h[4]+=e;c->h[5]+=f;c->h[6]+=g;c->h[7]+=h;
-}
+static inline void _tr_sha256_block(_TrSHA256Ctx* c, const uint8_t* blk) { _tr_sha256_blocks(c->h, blk, 1); }
+/* Tops up a partial block, then hashes whole blocks straight from `data`. */
 static inline void _tr_sha256_update(_TrSHA256Ctx* c, const uint8_t* data, size_t len) {
-    for(size_t i=0;i<len;i++){
-        c->buf[c->buf_len++]=data[i]; c->bits+=8;
-        if(c->buf_len==64){_tr_sha256_block(c,c->buf);c->buf_len=0;}
+    c->bits += (uint64_t)len * 8;
+    if (c->buf_len) {
+        size_t k = 64 - c->buf_len; if (k > len) k = len;
+        memcpy(c->buf + c->buf_len, data, k); c->buf_len += (uint32_t)k; data += k; len -= k;
+        if (c->buf_len < 64) return;
+        _tr_sha256_blocks(c->h, c->buf, 1); c->buf_len = 0;
     }
+    if (len >= 64) { _tr_sha256_blocks(c->h, data, len / 64); data += len & ~(size_t)63; len &= 63; }
+    if (len) { memcpy(c->buf, data, len); c->buf_len = (uint32_t)len; }
 }
 static inline void _tr_sha256_final(_TrSHA256Ctx* c, uint8_t* dig) {
     uint64_t bits=c->bits;
     c->buf[c->buf_len++]=0x80;
-    while(c->buf_len!=56){if(c->buf_len==64){_tr_sha256_block(c,c->buf);c->buf_len=0;}c->buf[c->buf_len++]=0;}
+    if(c->buf_len>56){memset(c->buf+c->buf_len,0,64-c->buf_len);_tr_sha256_blocks(c->h,c->buf,1);c->buf_len=0;}
+    memset(c->buf+c->buf_len,0,56-c->buf_len);
     for(int i=7;i>=0;i--){c->buf[56+(7-i)]=(uint8_t)(bits>>((uint64_t)i*8));}
-    _tr_sha256_block(c,c->buf);
+    _tr_sha256_blocks(c->h,c->buf,1);
     for(int i=0;i<8;i++){dig[i*4]=(uint8_t)(c->h[i]>>24);dig[i*4+1]=(uint8_t)(c->h[i]>>16);dig[i*4+2]=(uint8_t)(c->h[i]>>8);dig[i*4+3]=(uint8_t)c->h[i];}
 }
-static const char _tr_hex_lc[] = "0123456789abcdef";
-static inline char* _tr_sha256_hex(char* input) {
+static inline char* _tr_digest_hex(const uint8_t* dig, size_t n) {
+    char* out=(char*)TAURARO_ALLOC(n*2+1); if(!out) return NULL;
+    _tr_hex_enc(dig,n,out,0); out[n*2]='\0'; return out;
+}
+/* SHA-256 of `ilen` bytes (strlen when negative) as 64 hex chars. */
+_TR_COLD char* _tr_sha256_hex_n(char* input, long long ilen) {
     _TrSHA256Ctx ctx; uint8_t dig[32];
     _tr_sha256_init(&ctx);
-    if(input) _tr_sha256_update(&ctx,(const uint8_t*)input,strlen(input));
+    if(input){ size_t n = ilen < 0 ? strlen(input) : (size_t)ilen; if(n) _tr_sha256_update(&ctx,(const uint8_t*)input,n); }
     _tr_sha256_final(&ctx,dig);
-    char* out=(char*)TAURARO_ALLOC(65); if(!out) return NULL;
-    for(int i=0;i<32;i++){out[i*2]=_tr_hex_lc[dig[i]>>4];out[i*2+1]=_tr_hex_lc[dig[i]&15];}
-    out[64]='\0'; return out;
+    return _tr_digest_hex(dig,32);
 }
+_TR_COLD char* _tr_sha256_hex(char* input) { return _tr_sha256_hex_n(input, -1); }
+/* Raw 32-byte digest (NUL-terminated, but may contain NULs). */
 static inline char* _tr_sha256_bytes_of(char* input, int ilen) {
     _TrSHA256Ctx ctx; uint8_t dig[32];
     _tr_sha256_init(&ctx);
     if(input&&ilen>0) _tr_sha256_update(&ctx,(const uint8_t*)input,(size_t)ilen);
     _tr_sha256_final(&ctx,dig);
-    char* out=(char*)TAURARO_ALLOC(32); if(!out) return NULL;
-    memcpy(out,dig,32); return out;
+    char* out=(char*)TAURARO_ALLOC(33); if(!out) return NULL;
+    memcpy(out,dig,32); out[32]='\0'; return out;
 }
 
 /* ── SHA-1 + WebSocket accept key ─────────────────────────────────────────
@@ -5324,58 +13239,131 @@ static inline char* _tr_sha256_bytes_of(char* input, int ilen) {
  * hash and must not be used for anything else). _tr_ws_accept(key) computes
  * base64(SHA1(key + WS_GUID)), the Sec-WebSocket-Accept response value. */
 typedef struct { uint32_t h[5]; uint64_t len; uint8_t buf[64]; size_t n; } _TrSHA1Ctx;
+static const uint32_t _tr_sha1_K[4] = { 0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6 };
 static inline uint32_t _tr_sha1_rol(uint32_t v, int b){ return (v<<b)|(v>>(32-b)); }
-static inline void _tr_sha1_block(_TrSHA1Ctx* c, const uint8_t* p){
-    uint32_t w[80];
-    for(int i=0;i<16;i++) w[i]=((uint32_t)p[i*4]<<24)|((uint32_t)p[i*4+1]<<16)|((uint32_t)p[i*4+2]<<8)|((uint32_t)p[i*4+3]);
-    for(int i=16;i<80;i++) w[i]=_tr_sha1_rol(w[i-3]^w[i-8]^w[i-14]^w[i-16],1);
-    uint32_t a=c->h[0],b=c->h[1],cc=c->h[2],d=c->h[3],e=c->h[4];
-    for(int i=0;i<80;i++){
-        uint32_t f,k;
-        if(i<20){f=(b&cc)|((~b)&d);k=0x5A827999;}
-        else if(i<40){f=b^cc^d;k=0x6ED9EBA1;}
-        else if(i<60){f=(b&cc)|(b&d)|(cc&d);k=0x8F1BBCDC;}
-        else {f=b^cc^d;k=0xCA62C1D6;}
-        uint32_t t=_tr_sha1_rol(a,5)+f+e+k+w[i];
-        e=d;d=cc;cc=_tr_sha1_rol(b,30);b=a;a=t;
-    }
-    c->h[0]+=a;c->h[1]+=b;c->h[2]+=cc;c->h[3]+=d;c->h[4]+=e;
+static inline void _tr_sha1_blocks_c(uint32_t* st, const uint8_t* p, size_t n){
+    for (; n; n--, p += 64) {
+        uint32_t w[80];
+        for(int i=0;i<16;i++) w[i]=((uint32_t)p[i*4]<<24)|((uint32_t)p[i*4+1]<<16)|((uint32_t)p[i*4+2]<<8)|((uint32_t)p[i*4+3]);
+        for(int i=16;i<80;i++) w[i]=_tr_sha1_rol(w[i-3]^w[i-8]^w[i-14]^w[i-16],1);
+        uint32_t a=st[0],b=st[1],cc=st[2],d=st[3],e=st[4];
+        for(int i=0;i<80;i++){
+            uint32_t f;
+            if(i<20) f=(b&cc)|((~b)&d);
+            else if(i<40) f=b^cc^d;
+            else if(i<60) f=(b&cc)|(b&d)|(cc&d);
+            else f=b^cc^d;
+            uint32_t t=_tr_sha1_rol(a,5)+f+e+_tr_sha1_K[i/20]+w[i];
+            e=d;d=cc;cc=_tr_sha1_rol(b,30);b=a;a=t;
+        }
+        st[0]+=a;st[1]+=b;st[2]+=cc;st[3]+=d;st[4]+=e;
+    }
+}
+#if defined(_TR_HW_X86)
+/* SHA-NI: sha1rnds4 runs 4 rounds (its immediate picks the round function),
+ * sha1nexte derives the next E from the previous ABCD. */
+__attribute__((target("sha,sse4.1")))
+static inline void _tr_sha1_blocks_hw(uint32_t* st, const uint8_t* p, size_t n) {
+    const __m128i bswap = _mm_set_epi64x(0x0001020304050607LL, 0x08090a0b0c0d0e0fLL);
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)st), 0x1B);
+    __m128i e0 = _mm_set_epi32((int)st[4], 0, 0, 0);
+    for (; n; n--, p += 64) {
+        __m128i abcd0 = abcd, e00 = e0, prev = abcd, e, m[4];
+        for (int g = 0; g < 20; g++) {
+            if (g < 4) m[g] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + 16 * g)), bswap);
+            else m[g & 3] = _mm_sha1msg2_epu32(
+                    _mm_xor_si128(_mm_sha1msg1_epu32(m[g & 3], m[(g + 1) & 3]), m[(g + 2) & 3]),
+                    m[(g + 3) & 3]);
+            e = g == 0 ? _mm_add_epi32(e0, m[0]) : _mm_sha1nexte_epu32(prev, m[g & 3]);
+            prev = abcd;
+            switch (g / 5) {
+            case 0:  abcd = _mm_sha1rnds4_epu32(abcd, e, 0); break;
+            case 1:  abcd = _mm_sha1rnds4_epu32(abcd, e, 1); break;
+            case 2:  abcd = _mm_sha1rnds4_epu32(abcd, e, 2); break;
+            default: abcd = _mm_sha1rnds4_epu32(abcd, e, 3); break;
+            }
+        }
+        e0 = _mm_sha1nexte_epu32(prev, e00);
+        abcd = _mm_add_epi32(abcd, abcd0);
+    }
+    _mm_storeu_si128((__m128i*)st, _mm_shuffle_epi32(abcd, 0x1B));
+    st[4] = (uint32_t)_mm_extract_epi32(e0, 3);
+}
+#elif defined(_TR_HW_ARM)
+_TR_ARM_CRYPTO
+static inline void _tr_sha1_blocks_hw(uint32_t* st, const uint8_t* p, size_t n) {
+    uint32x4_t abcd = vld1q_u32(st);
+    uint32_t e0 = st[4];
+    for (; n; n--, p += 64) {
+        uint32x4_t abcd0 = abcd, m[4];
+        uint32_t e00 = e0;
+        for (int g = 0; g < 20; g++) {
+            if (g < 4) m[g] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(p + 16 * g)));
+            else m[g & 3] = vsha1su1q_u32(vsha1su0q_u32(m[g & 3], m[(g + 1) & 3], m[(g + 2) & 3]), m[(g + 3) & 3]);
+            uint32x4_t k = vaddq_u32(m[g & 3], vdupq_n_u32(_tr_sha1_K[g / 5]));
+            uint32_t e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+            if (g < 5)                abcd = vsha1cq_u32(abcd, e0, k);
+            else if (g < 10 || g >= 15) abcd = vsha1pq_u32(abcd, e0, k);
+            else                      abcd = vsha1mq_u32(abcd, e0, k);
+            e0 = e1;
+        }
+        abcd = vaddq_u32(abcd, abcd0);
+        e0 += e00;
+    }
+    vst1q_u32(st, abcd);
+    st[4] = e0;
 }
+#endif
+static inline void _tr_sha1_blocks(uint32_t* st, const uint8_t* p, size_t n) {
+#if defined(_TR_HW_X86) || defined(_TR_HW_ARM)
+    if (_tr_cpu_features() & _TR_CPU_SHA) { _tr_sha1_blocks_hw(st, p, n); return; }
+#endif
+    _tr_sha1_blocks_c(st, p, n);
+}
+static inline void _tr_sha1_block(_TrSHA1Ctx* c, const uint8_t* p){ _tr_sha1_blocks(c->h, p, 1); }
 static inline void _tr_sha1_init(_TrSHA1Ctx* c){ c->h[0]=0x67452301;c->h[1]=0xEFCDAB89;c->h[2]=0x98BADCFE;c->h[3]=0x10325476;c->h[4]=0xC3D2E1F0;c->len=0;c->n=0; }
 static inline void _tr_sha1_update(_TrSHA1Ctx* c, const uint8_t* d, size_t len){
     c->len += (uint64_t)len*8;
-    while(len){ size_t k=64-c->n; if(k>len)k=len; memcpy(c->buf+c->n,d,k); c->n+=k; d+=k; len-=k; if(c->n==64){ _tr_sha1_block(c,c->buf); c->n=0; } }
+    if(c->n){
+        size_t k=64-c->n; if(k>len)k=len;
+        memcpy(c->buf+c->n,d,k); c->n+=k; d+=k; len-=k;
+        if(c->n<64) return;
+        _tr_sha1_blocks(c->h,c->buf,1); c->n=0;
+    }
+    if(len>=64){ _tr_sha1_blocks(c->h,d,len/64); d+=len&~(size_t)63; len&=63; }
+    if(len){ memcpy(c->buf,d,len); c->n=len; }
 }
 static inline void _tr_sha1_final(_TrSHA1Ctx* c, uint8_t* out){
-    uint64_t total = c->len;   /* message bit-length, fixed BEFORE padding bytes bump c->len */
-    uint8_t pad=0x80; _tr_sha1_update(c,&pad,1);
-    uint8_t z=0; while(c->n!=56) _tr_sha1_update(c,&z,1);
-    uint8_t lb[8]; for(int i=0;i<8;i++) lb[i]=(uint8_t)(total>>(56-i*8)); _tr_sha1_update(c,lb,8);
+    uint64_t total = c->len;
+    c->buf[c->n++]=0x80;
+    if(c->n>56){ memset(c->buf+c->n,0,64-c->n); _tr_sha1_blocks(c->h,c->buf,1); c->n=0; }
+    memset(c->buf+c->n,0,56-c->n);
+    for(int i=0;i<8;i++) c->buf[56+i]=(uint8_t)(total>>(56-i*8));
+    _tr_sha1_blocks(c->h,c->buf,1);
     for(int i=0;i<5;i++){ out[i*4]=(uint8_t)(c->h[i]>>24);out[i*4+1]=(uint8_t)(c->h[i]>>16);out[i*4+2]=(uint8_t)(c->h[i]>>8);out[i*4+3]=(uint8_t)c->h[i]; }
 }
+/* SHA-1 of `ilen` bytes (strlen when negative) as 40 hex chars. */
+_TR_COLD char* _tr_sha1_hex(char* input, long long ilen){
+    _TrSHA1Ctx c; uint8_t dig[20];
+    _tr_sha1_init(&c);
+    if(input){ size_t n = ilen < 0 ? strlen(input) : (size_t)ilen; if(n) _tr_sha1_update(&c,(const uint8_t*)input,n); }
+    _tr_sha1_final(&c,dig);
+    return _tr_digest_hex(dig,20);
+}
 static inline char* _tr_ws_accept(char* key){
     static const char* GUID="258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
-    static const char* B64="ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
     _TrSHA1Ctx c; uint8_t dig[20];
     _tr_sha1_init(&c);
     if(key) _tr_sha1_update(&c,(const uint8_t*)key,strlen(key));
     _tr_sha1_update(&c,(const uint8_t*)GUID,strlen(GUID));
     _tr_sha1_final(&c,dig);
     char* out=(char*)TAURARO_ALLOC(29); if(!out) return NULL;  /* 20 bytes -> 28 b64 chars + NUL */
-    int o=0;
-    for(int i=0;i<18;i+=3){
-        uint32_t v=((uint32_t)dig[i]<<16)|((uint32_t)dig[i+1]<<8)|dig[i+2];
-        out[o++]=B64[(v>>18)&63];out[o++]=B64[(v>>12)&63];out[o++]=B64[(v>>6)&63];out[o++]=B64[v&63];
-    }
-    /* final 2 bytes (18,19) -> 3 chars + '=' */
-    uint32_t v=((uint32_t)dig[18]<<16)|((uint32_t)dig[19]<<8);
-    out[o++]=B64[(v>>18)&63];out[o++]=B64[(v>>12)&63];out[o++]=B64[(v>>6)&63];out[o++]='=';
-    out[o]='\0';
+    out[_tr_b64_enc(dig,20,out,0)]='\0';
     return out;
 }
 
 /* ── HMAC-SHA256 ────────────────────────────────────────────────────────── */
-static inline char* _tr_hmac_sha256(char* key, int klen, char* msg) {
+_TR_COLD char* _tr_hmac_sha256(char* key, int klen, char* msg) {
     uint8_t k[64]={0}; _TrSHA256Ctx ctx;
     if(klen>64){_tr_sha256_init(&ctx);_tr_sha256_update(&ctx,(const uint8_t*)key,(size_t)klen);uint8_t tmp[32];_tr_sha256_final(&ctx,tmp);memcpy(k,tmp,32);}
     else memcpy(k,key,(size_t)klen);
@@ -5387,13 +13375,10 @@ static inline char* _tr_hmac_sha256(char* key, int klen, char* msg) {
     _tr_sha256_final(&ctx,inner);
     _tr_sha256_init(&ctx);_tr_sha256_update(&ctx,opad,64);_tr_sha256_update(&ctx,inner,32);
     uint8_t dig[32]; _tr_sha256_final(&ctx,dig);
-    char* out=(char*)TAURARO_ALLOC(65); if(!out) return NULL;
-    for(int i=0;i<32;i++){out[i*2]=_tr_hex_lc[dig[i]>>4];out[i*2+1]=_tr_hex_lc[dig[i]&15];}
-    out[64]='\0'; return out;
+    return _tr_digest_hex(dig,32);
 }
-
 /* ── UUID v4 ────────────────────────────────────────────────────────────── */
-static inline char* _tr_uuid_v4(void) {
+_TR_COLD char* _tr_uuid_v4(void) {
     uint8_t b[16];
 #if (!defined(_WIN32) || defined(__MINGW32__) || defined(__MINGW64__)) && !defined(TAURARO_BARE)
     FILE* f=fopen("/dev/urandom","rb");
@@ -5411,8 +13396,7 @@ static inline char* _tr_uuid_v4(void) {
 }
 
 /* ── MD5 (compact, for legacy use) ─────────────────────────────────────── */
-static inline char* _tr_md5_hex(char* s) {
-    /* Minimal MD5; message expanded inline. */
+static inline void _tr_md5_blocks(uint32_t* st, const uint8_t* p, size_t n) {
     static const uint32_t T[64]={
         0xd76aa478,0xe8c7b756,0x242070db,0xc1bdceee,0xf57c0faf,0x4787c62a,0xa8304613,0xfd469501,
         0x698098d8,0x8b44f7af,0xffff5bb1,0x895cd7be,0x6b901122,0xfd987193,0xa679438e,0x49b40821,
@@ -5427,79 +13411,326 @@ static inline char* _tr_md5_hex(char* s) {
                              5, 9,14,20,5, 9,14,20,5, 9,14,20,5, 9,14,20,
                              4,11,16,23,4,11,16,23,4,11,16,23,4,11,16,23,
                              6,10,15,21,6,10,15,21,6,10,15,21,6,10,15,21};
-    size_t ilen = s ? strlen(s) : 0;
-    size_t padlen = ((ilen+8)/64+1)*64;
-    uint8_t* msg = (uint8_t*)TAURARO_CALLOC(1,padlen);
-    if(!msg) return _tr_strdup("00000000000000000000000000000000");
-    if(s) memcpy(msg,s,ilen);
-    msg[ilen]=0x80;
-    uint64_t bits=(uint64_t)ilen*8;
-    for(int i=0;i<8;i++) msg[padlen-8+i]=(uint8_t)(bits>>(uint64_t)(i*8));
-    uint32_t a=0x67452301,b=0xefcdab89,cc=0x98badcfe,d=0x10325476;
-    for(size_t off=0;off<padlen;off+=64){
-        uint32_t M[16],A=a,B=b,C=cc,D=d;
-        for(int i=0;i<16;i++) M[i]=((uint32_t)msg[off+i*4])|((uint32_t)msg[off+i*4+1]<<8)|((uint32_t)msg[off+i*4+2]<<16)|((uint32_t)msg[off+i*4+3]<<24);
+    for(; n; n--, p += 64){
+        uint32_t M[16],A=st[0],B=st[1],C=st[2],D=st[3];
+        for(int i=0;i<16;i++) M[i]=((uint32_t)p[i*4])|((uint32_t)p[i*4+1]<<8)|((uint32_t)p[i*4+2]<<16)|((uint32_t)p[i*4+3]<<24);
         for(int i=0;i<64;i++){
             uint32_t F,g2;
             if(i<16){F=(_TR_CH(B,C,D));g2=(uint32_t)i;}
-            else if(i<32){F=(D^(B&(C^D)));g2=(uint32_t)(5*i+1)%16;}
+            else if(i<32){F=(C^(D&(B^C)));g2=(uint32_t)(5*i+1)%16;}
             else if(i<48){F=(B^C^D);g2=(uint32_t)(3*i+5)%16;}
             else{F=(C^(B|(~D)));g2=(uint32_t)(7*i)%16;}
             F=F+A+T[i]+M[g2];
             A=D;D=C;C=B;B=B+((F<<S[i])|(F>>(32-S[i])));
         }
-        a+=A;b+=B;cc+=C;d+=D;
+        st[0]+=A;st[1]+=B;st[2]+=C;st[3]+=D;
     }
-    TAURARO_FREE(msg);
-    char* out=(char*)TAURARO_ALLOC(33); if(!out) return _tr_strdup("00000000000000000000000000000000");
-    uint32_t r[4]={a,b,cc,d};
-    for(int i=0;i<4;i++) for(int j=0;j<4;j++){
-        uint8_t byte=(uint8_t)(r[i]>>(j*8));
-        out[i*8+j*2]=_tr_hex_lc[byte>>4]; out[i*8+j*2+1]=_tr_hex_lc[byte&15];
+}
+/* Whole blocks are hashed in place; only the padded tail is copied. */
+_TR_COLD char* _tr_md5_hex(char* s) {
+    size_t ilen = s ? strlen(s) : 0, full = ilen & ~(size_t)63, rest = ilen - full;
+    uint32_t st[4]={0x67452301,0xefcdab89,0x98badcfe,0x10325476};
+    if(full) _tr_md5_blocks(st,(const uint8_t*)s,full/64);
+    uint8_t tail[128]={0};
+    if(rest) memcpy(tail,s+full,rest);
+    tail[rest]=0x80;
+    size_t tlen = rest < 56 ? 64 : 128;
+    uint64_t bits=(uint64_t)ilen*8;
+    for(int i=0;i<8;i++) tail[tlen-8+i]=(uint8_t)(bits>>(uint64_t)(i*8));
+    _tr_md5_blocks(st,tail,tlen/64);
+    uint8_t dig[16];
+    for(int i=0;i<4;i++) for(int j=0;j<4;j++) dig[i*4+j]=(uint8_t)(st[i]>>(j*8));
+    char* out=_tr_digest_hex(dig,16);
+    return out ? out : _tr_strdup("00000000000000000000000000000000");
+}
+#endif /* _TR_COLD_BODIES */
+
+/* ── Fast non-cryptographic hash ──────────────────────────────────────────
+ * wyhash (final v4 construction): 64x64->128 multiply-xor mixing over 48-byte
+ * stripes, about an order of magnitude faster than SHA-256 and well
+ * distributed, for hash tables, sharding and dedup keys. NOT collision
+ * resistant against an adversary — seed it per process for untrusted keys.
+ * Reads are little-endian so values match across platforms. */
+static const uint64_t _tr_wy_secret[4] = {
+    0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+};
+static inline void _tr_wymum(uint64_t* a, uint64_t* b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (uint64_t)r; *b = (uint64_t)(r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32), c = t < rl, lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo; *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+static inline uint64_t _tr_wymix(uint64_t a, uint64_t b) { _tr_wymum(&a, &b); return a ^ b; }
+static inline uint64_t _tr_wyr8(const uint8_t* p) {
+    uint64_t v; memcpy(&v, p, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+static inline uint64_t _tr_wyr4(const uint8_t* p) {
+    uint32_t v; memcpy(&v, p, 4);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+static inline uint64_t _tr_wyhash(const void* key, size_t len, uint64_t seed) {
+    const uint8_t* p = (const uint8_t*)key;
+    const uint64_t* s = _tr_wy_secret;
+    uint64_t a, b;
+    seed ^= _tr_wymix(seed ^ s[0], s[1]);
+    if (len <= 16) {
+        if (len >= 4) {
+            a = (_tr_wyr4(p) << 32) | _tr_wyr4(p + ((len >> 3) << 2));
+            b = (_tr_wyr4(p + len - 4) << 32) | _tr_wyr4(p + len - 4 - ((len >> 3) << 2));
+        } else if (len > 0) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        } else a = b = 0;
+    } else {
+        size_t i = len;
+        if (i > 48) {
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = _tr_wymix(_tr_wyr8(p) ^ s[1], _tr_wyr8(p + 8) ^ seed);
+                see1 = _tr_wymix(_tr_wyr8(p + 16) ^ s[2], _tr_wyr8(p + 24) ^ see1);
+                see2 = _tr_wymix(_tr_wyr8(p + 32) ^ s[3], _tr_wyr8(p + 40) ^ see2);
+                p += 48; i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = _tr_wymix(_tr_wyr8(p) ^ s[1], _tr_wyr8(p + 8) ^ seed);
+            i -= 16; p += 16;
+        }
+        a = _tr_wyr8(p + i - 16);
+        b = _tr_wyr8(p + i - 8);
     }
-    out[32]='\0'; return out;
+    a ^= s[1]; b ^= seed;
+    _tr_wymum(&a, &b);
+    return _tr_wymix(a ^ s[0] ^ len, b ^ s[1]);
+}
+/* std.crypto.hash entry points. A negative length means strlen(s). */
+static inline long long _tr_fast_hash(char* s, long long n, long long seed) {
+    size_t len = !s ? 0 : n < 0 ? strlen(s) : (size_t)n;
+    return (long long)_tr_wyhash(s ? s : "", len, (uint64_t)seed);
+}
+static inline long long _tr_fast_hash_int(long long x, long long seed) {
+    return (long long)_tr_wymix((uint64_t)x ^ _tr_wy_secret[0], (uint64_t)seed ^ _tr_wy_secret[1]);
+}
+/* Maps a 64-bit hash onto [0, n) with a multiply-high (no modulo bias from
+ * weak low bits, no division). */
+static inline long long _tr_hash_shard(long long h, long long n) {
+    if (n <= 0) return 0;
+#if defined(__SIZEOF_INT128__)
+    return (long long)(((__uint128_t)(uint64_t)h * (uint64_t)n) >> 64);
+#else
+    return (long long)((uint64_t)h % (uint64_t)n);
+#endif
 }
 
 /* ═══════════════════════════════════════════════════════════════════════════
  * TLS/HTTPS — OpenSSL (opt-in: -DTAURARO_TLS_OPENSSL -lssl -lcrypto).
  * ═══════════════════════════════════════════════════════════════════════════ */
+_TR_COLD int _tr_tls_send(char* h, char* d);
+_TR_COLD long long _tr_tls_write(char* h, const char* p, long long n);
+_TR_COLD long long _tr_tls_sendfile(char* h, const char* head, long long hlen, long long ffd, long long off, long long n);
+_TR_COLD char* _tr_tls_recv(char* h, int cap);
+_TR_COLD void _tr_tls_close(char* h);
+_TR_COLD char* _tr_hcc_open(char* host, long long port, long long tls, long long ms);
+_TR_COLD void _tr_hcc_close(char* h);
+_TR_COLD long long _tr_hcc_send2(char* h, char* a, long long al, char* b, long long bl);
+_TR_COLD long long _tr_hcc_read_head(char* h, long long nb);
+_TR_COLD char* _tr_hcc_read_str(char* h, long long cap);
+_TR_COLD char* _tr_hcc_read_all(char* h, long long limit);
+_TR_COLD char* _tr_hcc_head(char* h);
+_TR_COLD long long _tr_hcc_state(char* h);
+_TR_COLD int _tr_hcc_reusable(char* h);
+_TR_COLD void _tr_hcc_park(char* h);
+_TR_COLD int _tr_hcc_alive(char* h, long long ms);
+_TR_COLD int _tr_hcc_resumed(char* h);
+#if _TR_COLD_BODIES
 #ifdef TAURARO_TLS_OPENSSL
 #  include <openssl/ssl.h>
 #  include <openssl/err.h>
-typedef struct { SSL_CTX* ctx; SSL* ssl; int fd; } _TrTLSConn;
+typedef struct { SSL_CTX* ctx; SSL* ssl; int fd; int to_ms; char key[128]; } _TrTLSConn;
 #  ifdef _WIN32
 #    define _TR_SOCK_CLOSE(fd) closesocket(fd)
 #  else
 #    define _TR_SOCK_CLOSE(fd) close(fd)
 #  endif
-static inline char* _tr_tls_connect(char* host, int port) {
+/* Client sessions for resumption, keyed by "host:port". A reconnect to the
+ * same server offers the cached session and skips the full handshake (the
+ * certificate exchange and key agreement). TLS 1.3 issues its tickets after
+ * the handshake, so they are picked up by the new-session callback rather
+ * than read back after SSL_connect. */
+#  define _TR_TLS_SESS_SLOTS 64
+typedef struct { char key[128]; SSL_SESSION* s; } _TrTLSSess;
+/* Process-wide, like _tr_g: defined in the _TR_MAIN TU so that connections
+ * made from every module share one cache and one client ctx. */
+#  ifdef _TR_MAIN
+_TrTLSSess _tr_tls_sess[_TR_TLS_SESS_SLOTS];
+int _tr_tls_sess_next = 0;
+atomic_flag _tr_tls_sess_lk = ATOMIC_FLAG_INIT;
+SSL_CTX* _Atomic _tr_tls_cctx = NULL;
+#  else
+extern _TrTLSSess _tr_tls_sess[_TR_TLS_SESS_SLOTS];
+extern int _tr_tls_sess_next;
+extern atomic_flag _tr_tls_sess_lk;
+extern SSL_CTX* _Atomic _tr_tls_cctx;
+#  endif
+static inline void _tr_tls_sess_lock(void)   { while (atomic_flag_test_and_set_explicit(&_tr_tls_sess_lk, memory_order_acquire)) {} }
+static inline void _tr_tls_sess_unlock(void) { atomic_flag_clear_explicit(&_tr_tls_sess_lk, memory_order_release); }
+static int _tr_tls_new_session(SSL* ssl, SSL_SESSION* s) {
+    _TrTLSConn* c = (_TrTLSConn*)SSL_get_app_data(ssl);
+    if (!c || !c->key[0]) return 0;
+    _tr_tls_sess_lock();
+    int slot = -1;
+    for (int i = 0; i < _TR_TLS_SESS_SLOTS; i++)
+        if (_tr_tls_sess[i].s && strcmp(_tr_tls_sess[i].key, c->key) == 0) { slot = i; break; }
+    if (slot < 0) { slot = _tr_tls_sess_next; _tr_tls_sess_next = (_tr_tls_sess_next + 1) % _TR_TLS_SESS_SLOTS; }
+    if (_tr_tls_sess[slot].s) SSL_SESSION_free(_tr_tls_sess[slot].s);
+    memcpy(_tr_tls_sess[slot].key, c->key, sizeof c->key);
+    _tr_tls_sess[slot].s = s;
+    _tr_tls_sess_unlock();
+    return 1;   /* the cache keeps the reference */
+}
+/* One client SSL_CTX for the process (it was one per connection): shared
+ * settings, and the session cache above hangs off it. */
+static SSL_CTX* _tr_tls_client_ctx(void) {
+    SSL_CTX* c = atomic_load(&_tr_tls_cctx);
+    if (c) return c;
     static _Atomic int _tr_ssl_once = 0;
     if (atomic_fetch_add(&_tr_ssl_once,1)==0){SSL_library_init();SSL_load_error_strings();OpenSSL_add_all_algorithms();}
+    SSL_CTX* n = SSL_CTX_new(TLS_client_method());
+    if (!n) return NULL;
+    SSL_CTX_set_session_cache_mode(n, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(n, _tr_tls_new_session);
+    SSL_CTX* expect = NULL;
+    if (!atomic_compare_exchange_strong(&_tr_tls_cctx, &expect, n)) { SSL_CTX_free(n); return expect; }
+    return n;
+}
+/* After an SSL call returned r <= 0: wait for what OpenSSL wants and return
+ * 1 to retry, or 0 on a real failure. A socket used from a coroutine is
+ * non-blocking, so the coroutine parks (for at most to_ms, when set); a
+ * blocking socket only asks when its SO_RCVTIMEO/SO_SNDTIMEO ran out. */
+static inline int _tr_tls_retry(_TrTLSConn* c, int r) {
+#if !defined(TAURARO_BARE) && !defined(TAURARO_WASM)
+    int e = SSL_get_error(c->ssl, r);
+    if (e != SSL_ERROR_WANT_READ && e != SSL_ERROR_WANT_WRITE) return 0;
+    if (!_tr_sched_cur()->current) return 0;
+    return _tr_co_await_fd_timeout(c->fd, e == SSL_ERROR_WANT_READ ? TAURARO_POLLIN : TAURARO_POLLOUT,
+                                   c->to_ms > 0 ? c->to_ms : -1);
+#else
+    (void)c; (void)r;
+    return 0;
+#endif
+}
+/* Connect a socket for a TLS client: in a coroutine the connect parks on
+ * the reactor; otherwise it blocks (IPv4 or IPv6). */
+static inline int _tr_tls_dial(const char* host, int port) {
+#if !defined(TAURARO_BARE) && !defined(TAURARO_WASM)
+    if (_tr_sched_cur()->current) return _tr_co_connect(host, port);
+#endif
     struct addrinfo hints={0},*res=NULL;
     hints.ai_family=AF_UNSPEC;hints.ai_socktype=SOCK_STREAM;
     char pbuf[16]; snprintf(pbuf,sizeof(pbuf),"%d",port);
-    if(getaddrinfo(host,pbuf,&hints,&res)!=0) return NULL;
+    _tr_net_init();
+    if(getaddrinfo(host,pbuf,&hints,&res)!=0) return -1;
     int fd=(int)socket(res->ai_family,res->ai_socktype,res->ai_protocol);
-    if(fd<0){freeaddrinfo(res);return NULL;}
-    if(connect(fd,res->ai_addr,(int)res->ai_addrlen)!=0){freeaddrinfo(res);_TR_SOCK_CLOSE(fd);return NULL;}
+    if(fd<0){freeaddrinfo(res);return -1;}
+    if(connect(fd,res->ai_addr,(int)res->ai_addrlen)!=0){freeaddrinfo(res);_TR_SOCK_CLOSE(fd);return -1;}
     freeaddrinfo(res);
-    SSL_CTX* ctx=SSL_CTX_new(TLS_client_method());
-    if(!ctx){_TR_SOCK_CLOSE(fd);return NULL;}
-    SSL* ssl=SSL_new(ctx); SSL_set_fd(ssl,fd); SSL_set_tlsext_host_name(ssl,host);
-    if(SSL_connect(ssl)!=1){SSL_free(ssl);SSL_CTX_free(ctx);_TR_SOCK_CLOSE(fd);return NULL;}
+    return fd;
+}
+static inline char* _tr_tls_connect(char* host, int port) {
+    SSL_CTX* ctx=_tr_tls_client_ctx();
+    if(!ctx) return NULL;
+    int fd=_tr_tls_dial(host,port);
+    if(fd<0) return NULL;
     _TrTLSConn* c=(_TrTLSConn*)TAURARO_ALLOC(sizeof(_TrTLSConn));
-    if(!c){SSL_free(ssl);SSL_CTX_free(ctx);_TR_SOCK_CLOSE(fd);return NULL;}
-    c->ctx=ctx;c->ssl=ssl;c->fd=fd; return (char*)c;
+    if(!c){_TR_SOCK_CLOSE(fd);return NULL;}
+    SSL* ssl=SSL_new(ctx);
+    if(!ssl){TAURARO_FREE(c);_TR_SOCK_CLOSE(fd);return NULL;}
+    c->ctx=NULL; c->ssl=ssl; c->fd=fd; c->to_ms=0;   /* ctx is the shared client ctx */
+    snprintf(c->key,sizeof c->key,"%s:%d",host,port);
+    SSL_set_app_data(ssl,c);
+    SSL_set_fd(ssl,fd); SSL_set_tlsext_host_name(ssl,host);
+    _tr_tls_sess_lock();
+    for(int i=0;i<_TR_TLS_SESS_SLOTS;i++)
+        if(_tr_tls_sess[i].s && strcmp(_tr_tls_sess[i].key,c->key)==0){SSL_set_session(ssl,_tr_tls_sess[i].s);break;}
+    _tr_tls_sess_unlock();
+    int r;
+    while((r=SSL_connect(ssl))!=1){
+        if(!_tr_tls_retry(c,r)){SSL_free(ssl);TAURARO_FREE(c);_TR_SOCK_CLOSE(fd);return NULL;}
+    }
+    return (char*)c;
+}
+/* 1 when the connection resumed a cached session (abbreviated handshake). */
+static inline int _tr_tls_resumed(char* h) { return h && SSL_session_reused(((_TrTLSConn*)h)->ssl) ? 1 : 0; }
+_TR_COLD int   _tr_tls_send(char* h, char* d) { if(!h||!d) return -1; return SSL_write(((_TrTLSConn*)h)->ssl,d,(int)strlen(d)); }
+/* Binary-safe sends: `n` bytes at `p` (SSL_write may take them in parts),
+ * and `n` bytes of file `ffd` from `off` through a bounce buffer (a TLS
+ * record has to be encrypted in user space, so there is no sendfile). */
+_TR_COLD long long _tr_tls_write(char* h, const char* p, long long n) {
+    if(!h||!p) return -1;
+    long long done=0;
+    while(done<n){
+        int w=(int)(n-done>0x40000000LL?0x40000000LL:n-done);
+        int r=SSL_write(((_TrTLSConn*)h)->ssl,p+done,w);
+        if(r<=0){ if(_tr_tls_retry((_TrTLSConn*)h,r)) continue; break; }
+        done+=r;
+    }
+    return done;
+}
+_TR_COLD long long _tr_tls_sendfile(char* h, const char* head, long long hlen, long long ffd, long long off, long long n) {
+    if(!h||ffd<0) return -1;
+    long long hs=_tr_tls_write(h,head,hlen);
+    if(hs<hlen) return hs;
+    char* buf=(char*)TAURARO_ALLOC(65536); if(!buf) return hs;
+    long long done=0;
+    while(done<n){
+        long long want=n-done<65536?n-done:65536;
+#if defined(_WIN32)
+        if(_lseeki64((int)ffd,off+done,SEEK_SET)<0) break;
+        int r=_read((int)ffd,buf,(unsigned)want);
+#else
+        ssize_t r=pread((int)ffd,buf,(size_t)want,(off_t)(off+done));
+#endif
+        if(r<=0) break;
+        long long s=_tr_tls_write(h,buf,(long long)r);
+        done+=s;
+        if(s<(long long)r) break;
+    }
+    TAURARO_FREE(buf);
+    return hs+done;
+}
+/* Binary-safe read of up to `cap` bytes: bytes read, 0 = closed, -1 = error. */
+static inline int _tr_tls_read(char* h, char* buf, int cap) {
+    if(!h||cap<=0) return -1;
+    _TrTLSConn* c=(_TrTLSConn*)h;
+    for(;;){
+        int n=SSL_read(c->ssl,buf,cap);
+        if(n>0) return n;
+        if(SSL_get_error(c->ssl,n)==SSL_ERROR_ZERO_RETURN) return 0;
+        if(!_tr_tls_retry(c,n)) return n==0?0:-1;
+    }
 }
-static inline int   _tr_tls_send(char* h, char* d) { if(!h||!d) return -1; return SSL_write(((_TrTLSConn*)h)->ssl,d,(int)strlen(d)); }
-static inline char* _tr_tls_recv(char* h, int cap) {
+_TR_COLD char* _tr_tls_recv(char* h, int cap) {
     if(!h||cap<=0) return _tr_strdup("");
     char* buf=(char*)TAURARO_ALLOC((size_t)cap+1); if(!buf) return _tr_strdup("");
     int n=SSL_read(((_TrTLSConn*)h)->ssl,buf,cap);
     if(n<=0){TAURARO_FREE(buf);return _tr_strdup("");}
     buf[n]='\0'; return buf;
 }
-static inline void _tr_tls_close(char* h) {
+_TR_COLD void _tr_tls_close(char* h) {
     if(!h) return; _TrTLSConn* c=(_TrTLSConn*)h;
     SSL_shutdown(c->ssl);SSL_free(c->ssl);SSL_CTX_free(c->ctx);_TR_SOCK_CLOSE(c->fd);TAURARO_FREE(c);
 }
@@ -5522,61 +13753,581 @@ static inline char* _tr_tls_accept(char* ctxh, int fd) {
     if(SSL_accept(ssl)!=1){SSL_free(ssl);return NULL;}
     _TrTLSConn* c=(_TrTLSConn*)TAURARO_ALLOC(sizeof(_TrTLSConn));
     if(!c){SSL_free(ssl);return NULL;}
-    c->ctx=NULL; c->ssl=ssl; c->fd=fd;   /* ctx is shared/server-owned, not freed per-conn */
+    c->ctx=NULL; c->ssl=ssl; c->fd=fd; c->to_ms=0; c->key[0]=0;   /* ctx is shared/server-owned, not freed per-conn */
     return (char*)c;
 }
 static inline void _tr_tls_server_free(char* ctxh) { if(ctxh) SSL_CTX_free((SSL_CTX*)ctxh); }
 #else
 static inline char* _tr_tls_connect(char* h, int p) { (void)h;(void)p; return NULL; }
-static inline int   _tr_tls_send(char* h, char* d)  { (void)h;(void)d; return -1; }
-static inline char* _tr_tls_recv(char* h, int c)    { (void)h;(void)c; return _tr_strdup(""); }
-static inline void  _tr_tls_close(char* h)          { (void)h; }
+_TR_COLD int   _tr_tls_send(char* h, char* d)  { (void)h;(void)d; return -1; }
+_TR_COLD long long _tr_tls_write(char* h, const char* p, long long n) { (void)h;(void)p;(void)n; return -1; }
+_TR_COLD long long _tr_tls_sendfile(char* h, const char* hd, long long hl, long long f, long long o, long long n) { (void)h;(void)hd;(void)hl;(void)f;(void)o;(void)n; return -1; }
+_TR_COLD char* _tr_tls_recv(char* h, int c)    { (void)h;(void)c; return _tr_strdup(""); }
+static inline int   _tr_tls_read(char* h, char* b, int c) { (void)h;(void)b;(void)c; return -1; }
+static inline int   _tr_tls_resumed(char* h)         { (void)h; return 0; }
+_TR_COLD void  _tr_tls_close(char* h)          { (void)h; }
 static inline char* _tr_tls_server_new(char* c, char* k) { (void)c;(void)k; return NULL; }
 static inline char* _tr_tls_accept(char* x, int fd) { (void)x;(void)fd; return NULL; }
 static inline void  _tr_tls_server_free(char* x) { (void)x; }
 #endif
 
+/* ═══════════════════════════════════════════════════════════════════════════
+ * HTTP/1.1 client connections (std.net.http HttpClient).
+ *
+ * One _TrHcc is a keep-alive connection to one server, plain or TLS, with a
+ * read buffer that outlives a response so pipelined responses can be read
+ * back to back. Responses are framed here (Content-Length, chunked, or
+ * read-to-close), so the body can be streamed in pieces or read whole and
+ * the connection knows when it may be reused. Socket I/O goes through the
+ * coroutine ops: from a coroutine the fd is non-blocking and waits park on
+ * the reactor; from plain code it is blocking. The mode is switched on use,
+ * so an idle connection can move between the two. Reads are bounded by the
+ * timeout either way: a timed await in a coroutine, SO_RCVTIMEO otherwise.
+ * ═══════════════════════════════════════════════════════════════════════════ */
+#if !defined(TAURARO_BARE) && !defined(TAURARO_WASM)
+typedef struct {
+    int       fd;
+    char*     tls;         /* _TrTLSConn*, or NULL for plain TCP             */
+    int       nb;          /* fd is O_NONBLOCK (last used from a coroutine)  */
+    long long to_ms;       /* give up on a read that waits this long (0 = never) */
+    char*     buf;         /* unread bytes are buf[pos..len)                 */
+    long long cap, pos, len;
+    int       frame;       /* body framing: 0 none/done, 1 length, 2 chunked, 3 to close */
+    long long left;        /* length: bytes left; chunked: left in the chunk,
+                            * -1 = size line next, -2 = CRLF then size line */
+    int       keep;        /* the server allows another request             */
+    int       failed;
+    int       status;
+    char*     head;        /* the last response's status line + headers      */
+    long long idle_since;  /* _tr_mono_ms() when parked in a pool           */
+} _TrHcc;
+
+static void _tr_hcc_mode(_TrHcc* h) {
+    int want = _tr_sched_cur()->current != NULL;
+    if (want == h->nb) return;
+#if defined(_WIN32)
+    u_long m = (u_long)want;
+    ioctlsocket((SOCKET)h->fd, FIONBIO, &m);
+#else
+    int fl = fcntl(h->fd, F_GETFL, 0);
+    if (fl >= 0) fcntl(h->fd, F_SETFL, want ? (fl | O_NONBLOCK) : (fl & ~O_NONBLOCK));
+#endif
+    h->nb = want;
+}
+
+_TR_COLD char* _tr_hcc_open(char* host, long long port, long long tls, long long timeout_ms) {
+    _TrHcc* h = (_TrHcc*)TAURARO_ALLOC(sizeof(_TrHcc));
+    if (!h) return NULL;
+    memset(h, 0, sizeof *h);
+    if (tls) {
+        h->tls = _tr_tls_connect(host, (int)port);
+        if (!h->tls) { TAURARO_FREE(h); return NULL; }
+#if defined(TAURARO_TLS_OPENSSL)
+        h->fd = ((_TrTLSConn*)h->tls)->fd;
+        ((_TrTLSConn*)h->tls)->to_ms = (int)timeout_ms;
+#endif
+    } else {
+        h->fd = _tr_co_connect(host, (int)port);
+        if (h->fd < 0) { TAURARO_FREE(h); return NULL; }
+    }
+    h->to_ms = timeout_ms > 0 ? timeout_ms : 0;
+    if (h->to_ms > 0) {
+#if defined(_WIN32)
+        DWORD tv = (DWORD)h->to_ms;
+#else
+        struct timeval tv;
+        tv.tv_sec  = (time_t)(h->to_ms / 1000);
+        tv.tv_usec = (suseconds_t)((h->to_ms % 1000) * 1000);
+#endif
+        setsockopt(h->fd, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof tv);
+        setsockopt(h->fd, SOL_SOCKET, SO_SNDTIMEO, (const char*)&tv, sizeof tv);
+    }
+    h->nb   = -1;
+    h->cap  = 16384;
+    h->buf  = (char*)TAURARO_ALLOC((size_t)h->cap);
+    h->keep = 1;
+    if (!h->buf) { if (h->tls) _tr_tls_close(h->tls); else _tr_tcp_close(h->fd); TAURARO_FREE(h); return NULL; }
+    _tr_hcc_mode(h);
+    return (char*)h;
+}
+
+_TR_COLD void _tr_hcc_close(char* hp) {
+    _TrHcc* h = (_TrHcc*)hp;
+    if (!h) return;
+    _tr_co_fd_forget(h->fd);
+    if (h->tls) _tr_tls_close(h->tls); else _tr_tcp_close(h->fd);
+    _tr_free(h->buf);
+    _tr_free(h->head);
+    TAURARO_FREE(h);
+}
+
+_TR_COLD long long _tr_hcc_send2(char* hp, char* a, long long alen, char* b, long long blen) {
+    _TrHcc* h = (_TrHcc*)hp;
+    if (!h || h->failed) return -1;
+    _tr_hcc_mode(h);
+    long long s;
+    if (h->tls) {
+        s = _tr_tls_write(h->tls, a, alen);
+        if (s == alen && blen > 0) s += _tr_tls_write(h->tls, b, blen);
+    } else {
+        s = _tr_co_send2(h->fd, a, alen, b, blen);
+    }
+    if (s < alen + blen) h->failed = 1;
+    return s;
+}
+
+/* One read: bytes, 0 = closed, -1 = error or timeout. */
+static int _tr_hcc_recv(_TrHcc* h, char* buf, int cap) {
+    if (h->tls) return _tr_tls_read(h->tls, buf, cap);
+    if (!h->nb) {
+        for (;;) {
+            int n = (int)recv(h->fd, buf, cap, 0);
+            if (n >= 0) return n;
+#if !defined(_WIN32)
+            if (errno == EINTR) continue;
+#endif
+            return -1;
+        }
+    }
+    for (;;) {
+        int n = _tr_tcp_recv_nb(h->fd, buf, cap);
+        if (n != TAURARO_WOULD_BLOCK) return n < 0 ? -1 : n;
+        if (!_tr_co_await_fd_timeout(h->fd, TAURARO_POLLIN, h->to_ms > 0 ? h->to_ms : -1)) return -1;
+    }
+}
+
+/* Read more bytes into the buffer (compacting or growing it first).
+ * Returns the count, 0 on a closed connection, -1 on an error. */
+static long long _tr_hcc_fill(_TrHcc* h) {
+    if (h->pos > 0 && h->pos == h->len) h->pos = h->len = 0;
+    if (h->len == h->cap) {
+        if (h->pos > 0) {
+            memmove(h->buf, h->buf + h->pos, (size_t)(h->len - h->pos));
+            h->len -= h->pos; h->pos = 0;
+        } else {
+            char* nb = (char*)realloc(h->buf, (size_t)h->cap * 2);
+            if (!nb) { h->failed = 1; return -1; }
+            h->buf = nb; h->cap *= 2;
+        }
+    }
+    _tr_hcc_mode(h);
+    int room = (int)(h->cap - h->len < 0x40000000LL ? h->cap - h->len : 0x40000000LL);
+    int n = _tr_hcc_recv(h, h->buf + h->len, room);
+    if (n <= 0) return n < 0 ? -1 : 0;
+    h->len += n;
+    return n;
+}
+
+static long long _tr_hcc_find(const char* p, long long n, const char* pat, int pn) {
+    for (long long i = 0; i + pn <= n; i++)
+        if (p[i] == pat[0] && memcmp(p + i, pat, (size_t)pn) == 0) return i;
+    return -1;
+}
+
+/* Case-insensitive: does header line [p, p+n) have name `name`? Sets *v and *vn
+ * to the trimmed value. */
+static int _tr_hcc_hdr(const char* p, long long n, const char* name, const char** v, long long* vn) {
+    long long k = (long long)strlen(name);
+    if (n <= k || p[k] != ':') return 0;
+    for (long long i = 0; i < k; i++)
+        if (tolower((unsigned char)p[i]) != name[i]) return 0;
+    long long s = k + 1;
+    while (s < n && (p[s] == ' ' || p[s] == '\t')) s++;
+    long long e = n;
+    while (e > s && (p[e - 1] == ' ' || p[e - 1] == '\t')) e--;
+    *v = p + s; *vn = e - s;
+    return 1;
+}
+static int _tr_hcc_has_token(const char* v, long long n, const char* tok) {
+    long long k = (long long)strlen(tok);
+    for (long long i = 0; i + k <= n; i++) {
+        long long j = 0;
+        while (j < k && tolower((unsigned char)v[i + j]) == tok[j]) j++;
+        if (j == k) return 1;
+    }
+    return 0;
+}
+
+/* Read the next response's status line and headers and set up its body
+ * framing. `no_body`: the request was HEAD. Interim 1xx responses are
+ * skipped. Returns the status, -2 when the connection was closed before any
+ * byte of the response (a stale keep-alive connection: the request may be
+ * retried on a new one), or -1 on any other failure. */
+_TR_COLD long long _tr_hcc_read_head(char* hp, long long no_body) {
+    _TrHcc* h = (_TrHcc*)hp;
+    if (!h || h->failed || h->frame != 0) return -1;
+    int got_any = h->len > h->pos;
+    for (;;) {
+        long long e = _tr_hcc_find(h->buf + h->pos, h->len - h->pos, "\r\n\r\n", 4);
+        if (e < 0) {
+            if (h->len - h->pos > 65536) { h->failed = 1; return -1; }
+            long long n = _tr_hcc_fill(h);
+            if (n <= 0) { h->failed = 1; h->keep = 0; return (n == 0 && !got_any) ? -2 : -1; }
+            got_any = 1;
+            continue;
+        }
+        const char* p = h->buf + h->pos;
+        long long hl = e + 2;   /* through the last header's CRLF */
+        if (hl < 12 || memcmp(p, "HTTP/1.", 7) != 0) { h->failed = 1; return -1; }
+        int status = 0;
+        for (int i = 9; i < 12; i++) {
+            if (p[i] < '0' || p[i] > '9') { h->failed = 1; return -1; }
+            status = status * 10 + (p[i] - '0');
+        }
+        int http10 = p[7] == '0';
+        if (status >= 100 && status < 200) { h->pos += e + 4; continue; }
+        _tr_free(h->head);
+        h->head = (char*)TAURARO_ALLOC((size_t)hl + 1);
+        if (!h->head) { h->failed = 1; return -1; }
+        memcpy(h->head, p, (size_t)hl);
+        h->head[hl] = '\0';
+        long long clen = -1;
+        int chunked = 0, close_ = 0, keep = !http10;
+        long long i = 0;
+        while (i < hl) {
+            long long le = _tr_hcc_find(p + i, hl - i, "\r\n", 2);
+            if (le < 0) break;
+            const char* v; long long vn;
+            if (_tr_hcc_hdr(p + i, le, "content-length", &v, &vn)) {
+                clen = 0;
+                for (long long j = 0; j < vn && v[j] >= '0' && v[j] <= '9'; j++) clen = clen * 10 + (v[j] - '0');
+            } else if (_tr_hcc_hdr(p + i, le, "transfer-encoding", &v, &vn)) {
+                if (_tr_hcc_has_token(v, vn, "chunked")) chunked = 1;
+            } else if (_tr_hcc_hdr(p + i, le, "connection", &v, &vn)) {
+                if (_tr_hcc_has_token(v, vn, "close")) close_ = 1;
+                if (_tr_hcc_has_token(v, vn, "keep-alive")) keep = 1;
+            }
+            i += le + 2;
+        }
+        h->pos += e + 4;
+        h->status = status;
+        h->keep = keep && !close_;
+        if (no_body || status == 204 || status == 304) { h->frame = 0; }
+        else if (chunked)      { h->frame = 2; h->left = -1; }
+        else if (clen >= 0)    { h->frame = clen > 0 ? 1 : 0; h->left = clen; }
+        else                   { h->frame = 3; h->keep = 0; }
+        return status;
+    }
+}
+
+/* Make at least one unread byte (or `need` of them) available. */
+static int _tr_hcc_want(_TrHcc* h, long long need) {
+    while (h->len - h->pos < need) {
+        if (_tr_hcc_fill(h) <= 0) { h->failed = 1; h->keep = 0; return 0; }
+    }
+    return 1;
+}
+
+/* Copy up to `cap` bytes of the current body to `dst`. Returns the count,
+ * 0 once the body is complete, or -1 on a failure. */
+static long long _tr_hcc_read(char* hp, char* dst, long long cap) {
+    _TrHcc* h = (_TrHcc*)hp;
+    if (!h || h->failed) return -1;
+    for (;;) {
+        if (h->frame == 0 || cap <= 0) return 0;
+        if (h->frame == 3) {
+            if (h->len == h->pos) {
+                long long n = _tr_hcc_fill(h);
+                if (n < 0) { h->failed = 1; return -1; }
+                if (n == 0) { h->frame = 0; return 0; }
+            }
+            long long k = h->len - h->pos < cap ? h->len - h->pos : cap;
+            memcpy(dst, h->buf + h->pos, (size_t)k);
+            h->pos += k;
+            return k;
+        }
+        if (h->frame == 2 && h->left < 0) {
+            if (h->left == -2) {
+                if (!_tr_hcc_want(h, 2)) return -1;
+                if (h->buf[h->pos] != '\r' || h->buf[h->pos + 1] != '\n') { h->failed = 1; return -1; }
+                h->pos += 2;
+                h->left = -1;
+            }
+            long long le;
+            while ((le = _tr_hcc_find(h->buf + h->pos, h->len - h->pos, "\r\n", 2)) < 0) {
+                if (h->len - h->pos > 4096 || !_tr_hcc_want(h, h->len - h->pos + 1)) { h->failed = 1; return -1; }
+            }
+            long long size = 0;
+            int digits = 0;
+            for (long long j = 0; j < le; j++) {
+                char c = h->buf[h->pos + j];
+                int d = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+                if (d < 0) break;
+                if (size > (0x7fffffffffffffffLL >> 4)) { h->failed = 1; return -1; }
+                size = size * 16 + d;
+                digits++;
+            }
+            if (!digits) { h->failed = 1; return -1; }
+            h->pos += le + 2;
+            if (size == 0) {
+                /* Trailer section: header lines up to an empty line. */
+                for (;;) {
+                    while ((le = _tr_hcc_find(h->buf + h->pos, h->len - h->pos, "\r\n", 2)) < 0) {
+                        if (h->len - h->pos > 65536 || !_tr_hcc_want(h, h->len - h->pos + 1)) { h->failed = 1; return -1; }
+                    }
+                    h->pos += le + 2;
+                    if (le == 0) break;
+                }
+                h->frame = 0;
+                return 0;
+            }
+            h->left = size;
+        }
+        if (h->len == h->pos && !_tr_hcc_want(h, 1)) return -1;
+        long long k = h->len - h->pos;
+        if (k > h->left) k = h->left;
+        if (k > cap) k = cap;
+        memcpy(dst, h->buf + h->pos, (size_t)k);
+        h->pos += k;
+        h->left -= k;
+        if (h->left == 0) {
+            if (h->frame == 1) h->frame = 0;
+            else h->left = -2;
+        }
+        return k;
+    }
+}
+
+/* The next piece of the body (at most `cap` bytes) as a fresh string; ""
+ * when the body is complete or on a failure (see _tr_hcc_state). */
+_TR_COLD char* _tr_hcc_read_str(char* hp, long long cap) {
+    if (cap <= 0) cap = 16384;
+    char* out = (char*)TAURARO_ALLOC((size_t)cap + 1);
+    if (!out) return _tr_strdup("");
+    long long n = _tr_hcc_read(hp, out, cap);
+    if (n < 0) n = 0;
+    out[n] = '\0';
+    return out;
+}
+
+/* The rest of the body as one fresh string, or NULL on a failure or when it
+ * is longer than `limit` bytes (0 = no limit). */
+_TR_COLD char* _tr_hcc_read_all(char* hp, long long limit) {
+    _TrHcc* h = (_TrHcc*)hp;
+    if (!h || h->failed) return NULL;
+    long long cap = h->frame == 1 ? h->left : 4096;
+    if (limit > 0 && cap > limit) { h->failed = 1; return NULL; }
+    char* out = (char*)TAURARO_ALLOC((size_t)cap + 1);
+    long long n = 0;
+    while (out) {
+        if (n == cap) {
+            if (limit > 0 && cap >= limit) { h->failed = 1; break; }
+            long long nc = cap * 2;
+            if (limit > 0 && nc > limit) nc = limit;
+            char* g = (char*)realloc(out, (size_t)nc + 1);
+            if (!g) { h->failed = 1; break; }
+            out = g; cap = nc;
+        }
+        long long r = _tr_hcc_read(hp, out + n, cap - n);
+        if (r < 0) break;
+        if (r == 0) { out[n] = '\0'; return out; }
+        n += r;
+    }
+    _tr_free(out);
+    return NULL;
+}
+
+_TR_COLD char* _tr_hcc_head(char* hp) {
+    _TrHcc* h = (_TrHcc*)hp;
+    return _tr_strdup(h && h->head ? h->head : "");
+}
+
+/* 1 = the current body has been read to its end, 0 = more to read,
+ * -1 = the connection failed. */
+_TR_COLD long long _tr_hcc_state(char* hp) {
+    _TrHcc* h = (_TrHcc*)hp;
+    if (!h || h->failed) return -1;
+    return h->frame == 0 ? 1 : 0;
+}
+
+/* May this connection carry another request once idle? The response must be
+ * fully read, the server must not have asked to close, and no unsolicited
+ * bytes may be waiting. */
+_TR_COLD int _tr_hcc_reusable(char* hp) {
+    _TrHcc* h = (_TrHcc*)hp;
+    return h && !h->failed && h->keep && h->frame == 0 && h->pos == h->len;
+}
+
+/* Park in an idle pool: release this coroutine's reactor registration (the
+ * next user may be another coroutine) and start the idle clock. */
+_TR_COLD void _tr_hcc_park(char* hp) {
+    _TrHcc* h = (_TrHcc*)hp;
+    if (!h) return;
+    _tr_co_fd_forget(h->fd);
+    h->idle_since = _tr_mono_ms();
+}
+
+/* Health check before reusing a pooled connection: not idle past `idle_ms`
+ * (0 = no limit), and nothing readable. An idle keep-alive connection has
+ * nothing to say, so readable means the server closed it (EOF, a TLS
+ * close_notify) or broke the protocol. */
+_TR_COLD int _tr_hcc_alive(char* hp, long long idle_ms) {
+    _TrHcc* h = (_TrHcc*)hp;
+    if (!h || h->failed) return 0;
+    if (idle_ms > 0 && _tr_mono_ms() - h->idle_since > idle_ms) return 0;
+#if defined(_WIN32)
+    WSAPOLLFD pf; pf.fd = (SOCKET)h->fd; pf.events = POLLRDNORM; pf.revents = 0;
+    return WSAPoll(&pf, 1, 0) == 0;
+#else
+    char b;
+    ssize_t r = recv(h->fd, &b, 1, MSG_PEEK | MSG_DONTWAIT);
+    return r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+#endif
+}
+
+_TR_COLD int _tr_hcc_resumed(char* hp) {
+    _TrHcc* h = (_TrHcc*)hp;
+    return h && h->tls ? _tr_tls_resumed(h->tls) : 0;
+}
+#else
+_TR_COLD char* _tr_hcc_open(char* host, long long port, long long tls, long long ms) { (void)host;(void)port;(void)tls;(void)ms; return NULL; }
+_TR_COLD void  _tr_hcc_close(char* h) { (void)h; }
+_TR_COLD long long _tr_hcc_send2(char* h, char* a, long long al, char* b, long long bl) { (void)h;(void)a;(void)al;(void)b;(void)bl; return -1; }
+_TR_COLD long long _tr_hcc_read_head(char* h, long long nb) { (void)h;(void)nb; return -1; }
+_TR_COLD char* _tr_hcc_read_str(char* h, long long cap) { (void)h;(void)cap; return _tr_strdup(""); }
+_TR_COLD char* _tr_hcc_read_all(char* h, long long limit) { (void)h;(void)limit; return NULL; }
+_TR_COLD char* _tr_hcc_head(char* h) { (void)h; return _tr_strdup(""); }
+_TR_COLD long long _tr_hcc_state(char* h) { (void)h; return -1; }
+_TR_COLD int   _tr_hcc_reusable(char* h) { (void)h; return 0; }
+_TR_COLD void  _tr_hcc_park(char* h) { (void)h; }
+_TR_COLD int   _tr_hcc_alive(char* h, long long ms) { (void)h;(void)ms; return 0; }
+_TR_COLD int   _tr_hcc_resumed(char* h) { (void)h; return 0; }
+#endif /* HTTP client connections */
+#endif /* _TR_COLD_BODIES */
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * COMPRESS — zlib (opt-in: -DTAURARO_COMPRESS_ZLIB -lz).
  * ═══════════════════════════════════════════════════════════════════════════ */
+_TR_COLD char* _tr_zlib_decompress(char* input, int ilen, int max_out);
+_TR_COLD char* _tr_inflate(char* input, int ilen, int max_out);
+_TR_COLD void* _tr_z_new(long long inflate_, long long fmt, long long level);
+_TR_COLD long long _tr_z_deflate(void* h, const char* src, long long n, long long mode, void* sb);
+_TR_COLD int _tr_z_inflate(void* h, const char* src, long long n, void* sb);
+_TR_COLD void _tr_z_set_limit(void* h, long long limit);
+_TR_COLD long long _tr_z_total_in(void* h);
+_TR_COLD long long _tr_z_total_out(void* h);
+_TR_COLD void _tr_z_free(void* h);
+_TR_COLD int _tr_z_available(void);
+#if _TR_COLD_BODIES
 #ifdef TAURARO_COMPRESS_ZLIB
 #  include <zlib.h>
-static inline char* _tr_zlib_compress(char* input, int ilen, int* out_len) {
-    if(!input||ilen<=0){if(out_len)*out_len=0;return NULL;}
-    uLong bound=compressBound((uLong)ilen);
-    char* out=(char*)TAURARO_ALLOC(bound);if(!out){if(out_len)*out_len=0;return NULL;}
-    uLong dlen=bound;
-    if(compress2((Bytef*)out,&dlen,(const Bytef*)input,(uLong)ilen,Z_BEST_COMPRESSION)!=Z_OK){TAURARO_FREE(out);if(out_len)*out_len=0;return NULL;}
-    if(out_len)*out_len=(int)dlen; return out;
-}
-static inline char* _tr_zlib_decompress(char* input, int ilen, int max_out) {
+_TR_COLD char* _tr_zlib_decompress(char* input, int ilen, int max_out) {
     if(!input||ilen<=0) return _tr_strdup("");
     char* out=(char*)TAURARO_ALLOC((size_t)max_out+1);if(!out) return _tr_strdup("");
     uLong dlen=(uLong)max_out;
     if(uncompress((Bytef*)out,&dlen,(const Bytef*)input,(uLong)ilen)!=Z_OK){TAURARO_FREE(out);return _tr_strdup("");}
     out[dlen]='\0'; return out;
 }
-static inline char* _tr_deflate(char* input, int ilen, int* out_len) {
-    if(!input||ilen<=0){if(out_len)*out_len=0;return NULL;}
-    z_stream s={0}; deflateInit2(&s,Z_BEST_COMPRESSION,Z_DEFLATED,-15,8,Z_DEFAULT_STRATEGY);
-    uLong bound=deflateBound(&s,(uLong)ilen);
-    char* out=(char*)TAURARO_ALLOC(bound);if(!out){deflateEnd(&s);if(out_len)*out_len=0;return NULL;}
-    s.next_in=(Bytef*)input;s.avail_in=(uInt)ilen;s.next_out=(Bytef*)out;s.avail_out=(uInt)bound;
-    deflate(&s,Z_FINISH);if(out_len)*out_len=(int)s.total_out;deflateEnd(&s);return out;
-}
-static inline char* _tr_inflate(char* input, int ilen, int max_out) {
+_TR_COLD char* _tr_inflate(char* input, int ilen, int max_out) {
     if(!input||ilen<=0) return _tr_strdup("");
     z_stream s={0};inflateInit2(&s,-15);
     char* out=(char*)TAURARO_ALLOC((size_t)max_out+1);if(!out){inflateEnd(&s);return _tr_strdup("");}
     s.next_in=(Bytef*)input;s.avail_in=(uInt)ilen;s.next_out=(Bytef*)out;s.avail_out=(uInt)max_out;
     inflate(&s,Z_FINISH);int n=(int)s.total_out;inflateEnd(&s);out[n]='\0';return out;
 }
+
+/* Streaming codec (std.compress.zlib Deflater / Inflater). Output is written
+ * straight into the caller's StringObj (see _TrStrBuf), grown 16 KiB at a
+ * time, so a stream never holds more than one feed's worth of output and
+ * the caller drains it between feeds. fmt: 0 zlib, 1 raw deflate, 2 gzip
+ * (inflate: 2 accepts either a gzip or a zlib header). */
+#define _TR_Z_STEP 16384
+typedef struct { z_stream s; int inflate; int state; long long limit; } _TrZ;
+
+_TR_COLD void* _tr_z_new(long long inflate_, long long fmt, long long level) {
+    _TrZ* z = (_TrZ*)calloc(1, sizeof(_TrZ));
+    if (!z) return NULL;
+    z->inflate = inflate_ != 0;
+    int wb = fmt == 1 ? -15 : fmt == 2 ? (z->inflate ? 15 + 32 : 15 + 16) : 15;
+    int rc;
+    if (z->inflate) rc = inflateInit2(&z->s, wb);
+    else {
+        if (level < 0 || level > 9) level = Z_DEFAULT_COMPRESSION;
+        rc = deflateInit2(&z->s, (int)level, Z_DEFLATED, wb, 8, Z_DEFAULT_STRATEGY);
+    }
+    if (rc != Z_OK) { free(z); return NULL; }
+    return z;
+}
+
+/* Point the stream's output at the free tail of b (at least _TR_Z_STEP). */
+static inline void _tr_z_out(_TrZ* z, _TrStrBuf* b) {
+    _tr_strbuf_grow(b, _TR_Z_STEP);
+    z->s.next_out  = (Bytef*)(b->data + b->len);
+    z->s.avail_out = (uInt)(b->capacity - b->len - 1);
+}
+static inline void _tr_z_took(_TrZ* z, _TrStrBuf* b) {
+    b->len = (long long)((char*)z->s.next_out - b->data);
+    b->data[b->len] = '\0';
+}
+
+/* Compress n bytes of src into sb. mode: 0 buffer freely, 1 sync flush
+ * (everything so far becomes decodable), 2 finish (write the trailer; the
+ * stream accepts nothing after). Returns the bytes appended, or -1. */
+_TR_COLD long long _tr_z_deflate(void* h, const char* src, long long n, long long mode, void* sb) {
+    _TrZ* z = (_TrZ*)h;
+    _TrStrBuf* b = (_TrStrBuf*)sb;
+    if (!z || z->inflate || z->state != 0 || !b) return -1;
+    long long before = b->len;
+    int flush = mode == 2 ? Z_FINISH : mode == 1 ? Z_SYNC_FLUSH : Z_NO_FLUSH;
+    z->s.next_in  = (Bytef*)src;
+    z->s.avail_in = (uInt)(src && n > 0 ? n : 0);
+    for (;;) {
+        _tr_z_out(z, b);
+        int rc = deflate(&z->s, flush);
+        _tr_z_took(z, b);
+        if (rc == Z_STREAM_END) { z->state = 1; break; }
+        if (rc != Z_OK && rc != Z_BUF_ERROR) { z->state = -1; return -1; }
+        if (z->s.avail_out != 0 && z->s.avail_in == 0) break;
+    }
+    return b->len - before;
+}
+
+/* Decompress n bytes of src into sb. Returns 1 at the end of the stream
+ * (bytes past it are ignored), 0 when it needs more input, -1 on corrupt
+ * input or once the output passes the limit set by _tr_z_set_limit. */
+_TR_COLD int _tr_z_inflate(void* h, const char* src, long long n, void* sb) {
+    _TrZ* z = (_TrZ*)h;
+    _TrStrBuf* b = (_TrStrBuf*)sb;
+    if (!z || !z->inflate || !b) return -1;
+    if (z->state != 0) return z->state;
+    z->s.next_in  = (Bytef*)src;
+    z->s.avail_in = (uInt)(src && n > 0 ? n : 0);
+    for (;;) {
+        _tr_z_out(z, b);
+        int rc = inflate(&z->s, Z_NO_FLUSH);
+        _tr_z_took(z, b);
+        if (z->limit > 0 && (long long)z->s.total_out > z->limit) { z->state = -1; break; }
+        if (rc == Z_STREAM_END) { z->state = 1; break; }
+        if (rc == Z_BUF_ERROR && z->s.avail_in == 0) break;
+        if (rc != Z_OK && rc != Z_BUF_ERROR) { z->state = -1; break; }
+        if (z->s.avail_out != 0 && z->s.avail_in == 0) break;
+    }
+    return z->state;
+}
+
+_TR_COLD void _tr_z_set_limit(void* h, long long limit) { if (h) ((_TrZ*)h)->limit = limit; }
+_TR_COLD long long _tr_z_total_in(void* h)  { return h ? (long long)((_TrZ*)h)->s.total_in : 0; }
+_TR_COLD long long _tr_z_total_out(void* h) { return h ? (long long)((_TrZ*)h)->s.total_out : 0; }
+_TR_COLD void _tr_z_free(void* h) {
+    _TrZ* z = (_TrZ*)h;
+    if (!z) return;
+    if (z->inflate) inflateEnd(&z->s); else deflateEnd(&z->s);
+    free(z);
+}
+_TR_COLD int _tr_z_available(void) { return 1; }
 #else
-static inline char* _tr_zlib_compress(char* i, int il, int* n) { (void)i;(void)il;if(n)*n=0;return NULL; }
-static inline char* _tr_zlib_decompress(char* i, int il, int m) { (void)i;(void)il;(void)m;return _tr_strdup(""); }
-static inline char* _tr_deflate(char* i, int il, int* n) { (void)i;(void)il;if(n)*n=0;return NULL; }
-static inline char* _tr_inflate(char* i, int il, int m) { (void)i;(void)il;(void)m;return _tr_strdup(""); }
+_TR_COLD void* _tr_z_new(long long i, long long f, long long l) { (void)i;(void)f;(void)l; return NULL; }
+_TR_COLD long long _tr_z_deflate(void* h, const char* s, long long n, long long m, void* b) { (void)h;(void)s;(void)n;(void)m;(void)b; return -1; }
+_TR_COLD int  _tr_z_inflate(void* h, const char* s, long long n, void* b) { (void)h;(void)s;(void)n;(void)b; return -1; }
+_TR_COLD void _tr_z_set_limit(void* h, long long l) { (void)h;(void)l; }
+_TR_COLD long long _tr_z_total_in(void* h)  { (void)h; return 0; }
+_TR_COLD long long _tr_z_total_out(void* h) { (void)h; return 0; }
+_TR_COLD void _tr_z_free(void* h) { (void)h; }
+_TR_COLD int  _tr_z_available(void) { return 0; }
+_TR_COLD char* _tr_zlib_decompress(char* i, int il, int m) { (void)i;(void)il;(void)m;return _tr_strdup(""); }
+_TR_COLD char* _tr_inflate(char* i, int il, int m) { (void)i;(void)il;(void)m;return _tr_strdup(""); }
 #endif
+#endif /* _TR_COLD_BODIES */
 
 /* ═══════════════════════════════════════════════════════════════════════════
  * UNICODE / UTF-8 — pure C, no external dependencies.
@@ -5674,6 +14425,9 @@ static inline char* _tr_unicode_category(int cp) {
 }
 
 /* ── std.gpu helpers ─────────────────────────────────────────────────────── */
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 static inline bool _tr_gpu_is_openmp(void) {
 #ifdef _OPENMP
     return true;
@@ -5709,6 +14463,360 @@ static inline void _tr_gpu_openmp_parallel_i64(int64_t n, void* fn_ptr) {
 #endif
 }
 
+/* Chunked parallel-for (std.gpu ParFor). [0, n) is cut into chunks and the
+ * body is called once per chunk as body(lo, hi), so the per-index loop is
+ * compiled code and costs one indirect call per chunk rather than per index.
+ * Schedules: 0 static (each worker takes a contiguous run of chunks), 1
+ * dynamic (workers claim chunks one at a time), 2 guided (claimed the same
+ * way, sizes shrinking from remaining/16 down to the chunk size). Chunk
+ * boundaries depend only on n, the schedule and the chunk size — never on
+ * the worker count — and reduction partials are kept per chunk and combined
+ * in chunk order, so a float sum is the same on 1 thread or 64. Workers are
+ * an OpenMP team under -fopenmp, otherwise jobs on the shared pool. */
+#define _TR_PF_MAX_CHUNKS  65536
+#define _TR_PF_MAX_WORKERS 256
+#define _TR_PF_NONE 0          /* body kinds */
+#define _TR_PF_I64  1
+#define _TR_PF_F64  2
+typedef void    (*_TrPfBody)(int64_t, int64_t);
+typedef int64_t (*_TrPfBodyI)(int64_t, int64_t);
+typedef double  (*_TrPfBodyF)(int64_t, int64_t);
+typedef struct {
+    int64_t* bnd;               /* nch + 1 chunk boundaries */
+    int64_t nch, sched, next;   /* next: first unclaimed chunk */
+    int kind; void* body;
+    int64_t* pi; double* pf;    /* one partial per chunk */
+} _TrParFor;
+typedef struct { _TrParFor* f; int64_t w, nw; } _TrPfJob;
+
+/* Fill f->bnd / f->nch for n indices. chunk <= 0 picks ceil(n / 256). */
+static inline void _tr_pf_plan(_TrParFor* f, int64_t n, int64_t sched, int64_t chunk) {
+    if (chunk <= 0) chunk = (n + 255) / 256;
+    if ((n + chunk - 1) / chunk > _TR_PF_MAX_CHUNKS) chunk = (n + _TR_PF_MAX_CHUNKS - 1) / _TR_PF_MAX_CHUNKS;
+    int64_t cap = (n + chunk - 1) / chunk;
+    f->bnd = (int64_t*)TAURARO_ALLOC((size_t)(cap + 1) * sizeof(int64_t));
+    int64_t k = 0, lo = 0;
+    f->bnd[0] = 0;
+    while (lo < n) {
+        int64_t sz = chunk;
+        if (sched == 2 && (n - lo) / 16 > sz) sz = (n - lo) / 16;
+        lo = n - lo < sz ? n : lo + sz;
+        f->bnd[++k] = lo;
+    }
+    f->nch = k; f->sched = sched; f->next = 0;
+}
+
+static inline void _tr_pf_chunk(_TrParFor* f, int64_t k) {
+    int64_t lo = f->bnd[k], hi = f->bnd[k + 1];
+    switch (f->kind) {
+    case _TR_PF_NONE: ((_TrPfBody)f->body)(lo, hi); break;
+    case _TR_PF_I64:  f->pi[k] = ((_TrPfBodyI)f->body)(lo, hi); break;
+    case _TR_PF_F64:  f->pf[k] = ((_TrPfBodyF)f->body)(lo, hi); break;
+    }
+}
+
+/* Worker w of nw: its static run of chunks, or claim until none are left. */
+static inline void _tr_pf_work(_TrParFor* f, int64_t w, int64_t nw) {
+    if (f->sched == 0) {
+        for (int64_t k = f->nch * w / nw; k < f->nch * (w + 1) / nw; k++) _tr_pf_chunk(f, k);
+        return;
+    }
+    for (;;) {
+        int64_t k = __atomic_fetch_add(&f->next, 1, __ATOMIC_RELAXED);
+        if (k >= f->nch) return;
+        _tr_pf_chunk(f, k);
+    }
+}
+static void* _tr_pf_job(void* arg) { _TrPfJob* j = (_TrPfJob*)arg; _tr_pf_work(j->f, j->w, j->nw); return NULL; }
+
+static inline void _tr_pf_exec(_TrParFor* f) {
+#ifdef _OPENMP
+    int64_t nw = (int64_t)omp_get_max_threads();
+#else
+    int64_t nw = _tr_threadpool_auto_n();
+#endif
+    if (nw > f->nch) nw = f->nch;
+    if (nw > _TR_PF_MAX_WORKERS) nw = _TR_PF_MAX_WORKERS;
+    if (nw < 2) {
+        for (int64_t k = 0; k < f->nch; k++) _tr_pf_chunk(f, k);
+        return;
+    }
+#ifdef _OPENMP
+    #pragma omp parallel num_threads((int)nw)
+    _tr_pf_work(f, (int64_t)omp_get_thread_num(), (int64_t)omp_get_num_threads());
+#else
+    _TrPfJob jobs[_TR_PF_MAX_WORKERS];
+    _TrThreadPool* pool = _tr_iter_pool();
+    for (int64_t w = 0; w < nw; w++) {
+        jobs[w].f = f; jobs[w].w = w; jobs[w].nw = nw;
+        _tr_threadpool_spawn(pool, _tr_pf_job, &jobs[w]);
+    }
+    _tr_threadpool_wait(pool);
+#endif
+}
+
+/* body(lo, hi) over every chunk of [0, n). */
+static inline void _tr_pf_for(int64_t n, int64_t sched, int64_t chunk, void* body) {
+    if (n <= 0) return;
+    _TrParFor f = {0};
+    _tr_pf_plan(&f, n, sched, chunk);
+    f.kind = _TR_PF_NONE; f.body = body;
+    _tr_pf_exec(&f);
+    TAURARO_FREE(f.bnd);
+}
+
+/* Reduce the chunk results of body. op: 0 sum (wrapping), 1 min, 2 max, 3
+ * combine(acc, partial) left to right. An empty range gives 0. */
+static inline int64_t _tr_pf_reduce_i64(int64_t n, int64_t sched, int64_t chunk, void* body,
+                                        int64_t op, void* combine) {
+    if (n <= 0) return 0;
+    _TrParFor f = {0};
+    _tr_pf_plan(&f, n, sched, chunk);
+    f.kind = _TR_PF_I64; f.body = body;
+    f.pi = (int64_t*)TAURARO_ALLOC((size_t)f.nch * sizeof(int64_t));
+    _tr_pf_exec(&f);
+    int64_t r = f.pi[0];
+    for (int64_t k = 1; k < f.nch; k++) {
+        int64_t x = f.pi[k];
+        switch (op) {
+        case 0: r = (int64_t)((uint64_t)r + (uint64_t)x); break;
+        case 1: r = x < r ? x : r; break;
+        case 2: r = x > r ? x : r; break;
+        default: r = ((int64_t(*)(int64_t, int64_t))combine)(r, x); break;
+        }
+    }
+    TAURARO_FREE(f.pi); TAURARO_FREE(f.bnd);
+    return r;
+}
+
+static inline double _tr_pf_reduce_f64(int64_t n, int64_t sched, int64_t chunk, void* body,
+                                       int64_t op, void* combine) {
+    if (n <= 0) return 0.0;
+    _TrParFor f = {0};
+    _tr_pf_plan(&f, n, sched, chunk);
+    f.kind = _TR_PF_F64; f.body = body;
+    f.pf = (double*)TAURARO_ALLOC((size_t)f.nch * sizeof(double));
+    _tr_pf_exec(&f);
+    double r = f.pf[0];
+    for (int64_t k = 1; k < f.nch; k++) {
+        double x = f.pf[k];
+        switch (op) {
+        case 0: r += x; break;
+        case 1: r = x < r ? x : r; break;
+        case 2: r = x > r ? x : r; break;
+        default: r = ((double(*)(double, double))combine)(r, x); break;
+        }
+    }
+    TAURARO_FREE(f.pf); TAURARO_FREE(f.bnd);
+    return r;
+}
+
+/* How many chunks a ParFor over n would run (for tuning and tests). */
+static inline int64_t _tr_pf_chunks(int64_t n, int64_t sched, int64_t chunk) {
+    if (n <= 0) return 0;
+    _TrParFor f = {0};
+    _tr_pf_plan(&f, n, sched, chunk);
+    TAURARO_FREE(f.bnd);
+    return f.nch;
+}
+
+/* Device offload (std.gpu Device / DeviceBuffer / Kernel): CUDA through the
+ * driver API and NVRTC, both dlopen'd on first use, so nothing links against
+ * CUDA and a machine without a driver just reports no device. Kernels are
+ * CUDA C source compiled at run time for the device's compute capability;
+ * every argument is an 8-byte slot (a device pointer, a long long or a
+ * double). Transfers are explicit and synchronous. */
+#if !defined(TAURARO_BARE) && !defined(_WIN32) && !defined(TAURARO_WASM)
+#include <dlfcn.h>
+typedef struct {
+    int state;                  /* 0 untried, 2 loading, 1 ready, -1 unavailable */
+    int dev, cc_major, cc_minor;
+    void* ctx;
+    int (*cuDeviceGetName)(char*, int, int);
+    int (*cuCtxSetCurrent)(void*);
+    int (*cuModuleLoadData)(void**, const void*);
+    int (*cuModuleUnload)(void*);
+    int (*cuModuleGetFunction)(void**, void*, const char*);
+    int (*cuMemAlloc)(unsigned long long*, size_t);
+    int (*cuMemFree)(unsigned long long);
+    int (*cuMemcpyHtoD)(unsigned long long, const void*, size_t);
+    int (*cuMemcpyDtoH)(void*, unsigned long long, size_t);
+    int (*cuLaunchKernel)(void*, unsigned, unsigned, unsigned, unsigned, unsigned, unsigned,
+                          unsigned, void*, void**, void**);
+    int (*cuCtxSynchronize)(void);
+    int (*nvrtcCreateProgram)(void**, const char*, const char*, int, const char* const*, const char* const*);
+    int (*nvrtcCompileProgram)(void*, int, const char* const*);
+    int (*nvrtcGetPTXSize)(void*, size_t*);
+    int (*nvrtcGetPTX)(void*, char*);
+    int (*nvrtcGetProgramLogSize)(void*, size_t*);
+    int (*nvrtcGetProgramLog)(void*, char*);
+    int (*nvrtcDestroyProgram)(void**);
+} _TrCuda;
+_TR_GLOBAL _TrCuda _tr_cuda;
+
+#define _TR_CU_SYM(lib, field, name) \
+    if (!(*(void**)&_tr_cuda.field = dlsym(lib, name))) return false;
+static inline bool _tr_cuda_load(void) {
+    void* cu = dlopen("libcuda.so.1", RTLD_NOW | RTLD_LOCAL);
+    if (!cu) cu = dlopen("libcuda.dylib", RTLD_NOW | RTLD_LOCAL);
+    void* rt = dlopen("libnvrtc.so", RTLD_NOW | RTLD_LOCAL);
+    if (!rt) rt = dlopen("libnvrtc.so.12", RTLD_NOW | RTLD_LOCAL);
+    if (!rt) rt = dlopen("libnvrtc.so.11.2", RTLD_NOW | RTLD_LOCAL);
+    if (!cu || !rt) return false;
+    int (*init)(unsigned) = NULL;
+    int (*dev_get)(int*, int) = NULL;
+    int (*attr)(int*, int, int) = NULL;
+    int (*retain)(void**, int) = NULL;
+    *(void**)&init    = dlsym(cu, "cuInit");
+    *(void**)&dev_get = dlsym(cu, "cuDeviceGet");
+    *(void**)&attr    = dlsym(cu, "cuDeviceGetAttribute");
+    *(void**)&retain  = dlsym(cu, "cuDevicePrimaryCtxRetain");
+    if (!init || !dev_get || !attr || !retain) return false;
+    _TR_CU_SYM(cu, cuDeviceGetName, "cuDeviceGetName")
+    _TR_CU_SYM(cu, cuCtxSetCurrent, "cuCtxSetCurrent")
+    _TR_CU_SYM(cu, cuModuleLoadData, "cuModuleLoadData")
+    _TR_CU_SYM(cu, cuModuleUnload, "cuModuleUnload")
+    _TR_CU_SYM(cu, cuModuleGetFunction, "cuModuleGetFunction")
+    _TR_CU_SYM(cu, cuMemAlloc, "cuMemAlloc_v2")
+    _TR_CU_SYM(cu, cuMemFree, "cuMemFree_v2")
+    _TR_CU_SYM(cu, cuMemcpyHtoD, "cuMemcpyHtoD_v2")
+    _TR_CU_SYM(cu, cuMemcpyDtoH, "cuMemcpyDtoH_v2")
+    _TR_CU_SYM(cu, cuLaunchKernel, "cuLaunchKernel")
+    _TR_CU_SYM(cu, cuCtxSynchronize, "cuCtxSynchronize")
+    _TR_CU_SYM(rt, nvrtcCreateProgram, "nvrtcCreateProgram")
+    _TR_CU_SYM(rt, nvrtcCompileProgram, "nvrtcCompileProgram")
+    _TR_CU_SYM(rt, nvrtcGetPTXSize, "nvrtcGetPTXSize")
+    _TR_CU_SYM(rt, nvrtcGetPTX, "nvrtcGetPTX")
+    _TR_CU_SYM(rt, nvrtcGetProgramLogSize, "nvrtcGetProgramLogSize")
+    _TR_CU_SYM(rt, nvrtcGetProgramLog, "nvrtcGetProgramLog")
+    _TR_CU_SYM(rt, nvrtcDestroyProgram, "nvrtcDestroyProgram")
+    if (init(0) != 0 || dev_get(&_tr_cuda.dev, 0) != 0) return false;
+    attr(&_tr_cuda.cc_major, 75, _tr_cuda.dev);   /* COMPUTE_CAPABILITY_MAJOR */
+    attr(&_tr_cuda.cc_minor, 76, _tr_cuda.dev);   /* COMPUTE_CAPABILITY_MINOR */
+    return retain(&_tr_cuda.ctx, _tr_cuda.dev) == 0;
+}
+#undef _TR_CU_SYM
+
+/* Load once (racing first callers wait for the winner), then make the
+ * primary context current on this thread. */
+static inline bool _tr_gpu_dev_available(void) {
+    int s = 0;
+    if (__atomic_compare_exchange_n(&_tr_cuda.state, &s, 2, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        __atomic_store_n(&_tr_cuda.state, _tr_cuda_load() ? 1 : -1, __ATOMIC_RELEASE);
+    while ((s = __atomic_load_n(&_tr_cuda.state, __ATOMIC_ACQUIRE)) == 2) {}
+    return s == 1 && _tr_cuda.cuCtxSetCurrent(_tr_cuda.ctx) == 0;
+}
+
+static inline char* _tr_gpu_dev_name(void) {
+    char name[256] = "";
+    if (_tr_gpu_dev_available()) _tr_cuda.cuDeviceGetName(name, (int)sizeof name, _tr_cuda.dev);
+    return _tr_strdup(name);
+}
+
+/* Device memory: a CUdeviceptr as an int, 0 on failure. */
+static inline int64_t _tr_gpu_buf_alloc(int64_t bytes) {
+    unsigned long long d = 0;
+    if (bytes <= 0 || !_tr_gpu_dev_available() || _tr_cuda.cuMemAlloc(&d, (size_t)bytes) != 0) return 0;
+    return (int64_t)d;
+}
+static inline void _tr_gpu_buf_free(int64_t d) {
+    if (d && _tr_gpu_dev_available()) _tr_cuda.cuMemFree((unsigned long long)d);
+}
+static inline int64_t _tr_gpu_buf_upload(int64_t d, const void* src, int64_t bytes) {
+    if (!d || !_tr_gpu_dev_available()) return -1;
+    return bytes > 0 ? _tr_cuda.cuMemcpyHtoD((unsigned long long)d, src, (size_t)bytes) : 0;
+}
+static inline int64_t _tr_gpu_buf_download(int64_t d, void* dst, int64_t bytes) {
+    if (!d || !_tr_gpu_dev_available()) return -1;
+    return bytes > 0 ? _tr_cuda.cuMemcpyDtoH(dst, (unsigned long long)d, (size_t)bytes) : 0;
+}
+
+#define _TR_GPU_MAX_ARGS 16
+typedef struct {
+    void* mod; void* fn; char* err;
+    int64_t nargs; uint64_t slots[_TR_GPU_MAX_ARGS];
+} _TrGpuKernel;
+
+/* Compile `src` and look up the extern "C" __global__ function `name`. The
+ * handle always comes back; err is "" on success, else the NVRTC log or
+ * what failed. */
+static inline char* _tr_gpu_kernel_new(char* src, char* name) {
+    _TrGpuKernel* k = (_TrGpuKernel*)TAURARO_CALLOC(1, sizeof(_TrGpuKernel));
+    if (!_tr_gpu_dev_available()) { k->err = _tr_strdup("no CUDA device"); return (char*)k; }
+    void* prog = NULL;
+    if (_tr_cuda.nvrtcCreateProgram(&prog, src, "tauraro_kernel.cu", 0, NULL, NULL) != 0) {
+        k->err = _tr_strdup("nvrtcCreateProgram failed"); return (char*)k;
+    }
+    char arch[48];
+    snprintf(arch, sizeof arch, "--gpu-architecture=compute_%d%d", _tr_cuda.cc_major, _tr_cuda.cc_minor);
+    const char* opts[] = { arch, "--use_fast_math" };
+    if (_tr_cuda.nvrtcCompileProgram(prog, 2, opts) != 0) {
+        size_t n = 0;
+        _tr_cuda.nvrtcGetProgramLogSize(prog, &n);
+        k->err = (char*)TAURARO_CALLOC(1, n + 1);
+        _tr_cuda.nvrtcGetProgramLog(prog, k->err);
+        _tr_cuda.nvrtcDestroyProgram(&prog);
+        return (char*)k;
+    }
+    size_t n = 0;
+    _tr_cuda.nvrtcGetPTXSize(prog, &n);
+    char* ptx = (char*)TAURARO_CALLOC(1, n + 1);
+    _tr_cuda.nvrtcGetPTX(prog, ptx);
+    _tr_cuda.nvrtcDestroyProgram(&prog);
+    if (_tr_cuda.cuModuleLoadData(&k->mod, ptx) != 0) k->err = _tr_strdup("cuModuleLoadData failed");
+    else if (_tr_cuda.cuModuleGetFunction(&k->fn, k->mod, name) != 0) k->err = _tr_strdup("kernel function not found");
+    else k->err = _tr_strdup("");
+    TAURARO_FREE(ptx);
+    return (char*)k;
+}
+static inline char* _tr_gpu_kernel_error(char* h) { return _tr_strdup(((_TrGpuKernel*)h)->err); }
+
+/* Append one 8-byte argument; false once all slots are used. */
+static inline bool _tr_gpu_kernel_arg(char* h, int64_t bits) {
+    _TrGpuKernel* k = (_TrGpuKernel*)h;
+    if (k->nargs >= _TR_GPU_MAX_ARGS) return false;
+    k->slots[k->nargs++] = (uint64_t)bits;
+    return true;
+}
+static inline bool _tr_gpu_kernel_arg_f64(char* h, double x) {
+    uint64_t bits; memcpy(&bits, &x, sizeof bits);
+    return _tr_gpu_kernel_arg(h, (int64_t)bits);
+}
+static inline void _tr_gpu_kernel_clear_args(char* h) { ((_TrGpuKernel*)h)->nargs = 0; }
+
+/* Launch on a 1-D grid and wait for it: 0 on success, else the CUresult
+ * (-1 when there is no compiled kernel). */
+static inline int64_t _tr_gpu_kernel_launch(char* h, int64_t grid, int64_t block) {
+    _TrGpuKernel* k = (_TrGpuKernel*)h;
+    if (!k->fn || !_tr_gpu_dev_available()) return -1;
+    void* params[_TR_GPU_MAX_ARGS];
+    for (int64_t i = 0; i < k->nargs; i++) params[i] = &k->slots[i];
+    int rc = _tr_cuda.cuLaunchKernel(k->fn, (unsigned)grid, 1, 1, (unsigned)block, 1, 1, 0, NULL, params, NULL);
+    return rc != 0 ? rc : _tr_cuda.cuCtxSynchronize();
+}
+static inline void _tr_gpu_kernel_free(char* h) {
+    _TrGpuKernel* k = (_TrGpuKernel*)h;
+    if (k->mod && _tr_gpu_dev_available()) _tr_cuda.cuModuleUnload(k->mod);
+    TAURARO_FREE(k->err);
+    TAURARO_FREE(k);
+}
+#else
+/* No dlopen here: offload always reports no device. */
+static inline bool    _tr_gpu_dev_available(void) { return false; }
+static inline char*   _tr_gpu_dev_name(void) { return _tr_strdup(""); }
+static inline int64_t _tr_gpu_buf_alloc(int64_t bytes) { (void)bytes; return 0; }
+static inline void    _tr_gpu_buf_free(int64_t d) { (void)d; }
+static inline int64_t _tr_gpu_buf_upload(int64_t d, const void* src, int64_t bytes) { (void)d; (void)src; (void)bytes; return -1; }
+static inline int64_t _tr_gpu_buf_download(int64_t d, void* dst, int64_t bytes) { (void)d; (void)dst; (void)bytes; return -1; }
+static inline char*   _tr_gpu_kernel_new(char* src, char* name) { (void)src; (void)name; return NULL; }
+static inline char*   _tr_gpu_kernel_error(char* h) { (void)h; return _tr_strdup("no CUDA device"); }
+static inline bool    _tr_gpu_kernel_arg(char* h, int64_t bits) { (void)h; (void)bits; return false; }
+static inline bool    _tr_gpu_kernel_arg_f64(char* h, double x) { (void)h; (void)x; return false; }
+static inline void    _tr_gpu_kernel_clear_args(char* h) { (void)h; }
+static inline int64_t _tr_gpu_kernel_launch(char* h, int64_t grid, int64_t block) { (void)h; (void)grid; (void)block; return -1; }
+static inline void    _tr_gpu_kernel_free(char* h) { (void)h; }
+#endif
+
 /* ── v0.0.5: Map.update / Set[T] / List helpers ──────────────────────────────
  * All placed here so TrMap, List_str, List_i64 etc. are defined above.   */
 
@@ -5724,51 +14832,39 @@ static void _tr_dict_update(TrMap* dst, TrMap* src) {
 }
 static void _tr_idict_update(TrMap* dst, TrMap* src) { _tr_dict_update(dst, src); }
 static void _tr_dict_clear(TrMap* m) { Dict_clear_entries(m); }
+/* Keeps the slot array (and its size) for refilling. */
 static void _tr_idict_clear(TrIDict* m) {
     if (!m) return;
-    for (size_t i=0;i<m->cap;i++) {
-        _TrIDictNode* n=m->buckets[i];
-        while(n){ _TrIDictNode* nx=n->next; _tr_free(n); n=nx; }
-        m->buckets[i]=NULL;
-    }
+    for (size_t i=0;i<m->cap;i++) { m->slots[i].key=_TR_IDICT_EMPTY; m->slots[i].value=NULL; }
+    m->has_min=false; m->min_value=NULL;
     m->len=0;
 }
-/* Free a Map[int,V]/Dict[int,V] (TrIDict) entirely - nodes, buckets array and
-   the struct itself. Mirrors Dict_free() but for the int-keyed node layout
-   (whose key is a long long, not a heap string). */
+/* Free a Map[int,V]/Dict[int,V] (TrIDict) entirely - slot array and the
+   struct itself. Values are inline and not owned. */
 static void _tr_idict_free(TrIDict* d) {
     if (!d) return;
-    for (size_t i=0;i<d->cap;i++) {
-        _TrIDictNode* n=d->buckets[i];
-        while(n){ _TrIDictNode* nx=n->next; _tr_free(n); n=nx; }
-    }
-    _tr_free(d->buckets); _tr_free(d);
+    _tr_free(d->slots); _tr_free(d);
 }
 /* Like _tr_idict_free(), but for Dict[int,str]/Map[int,str] whose values are
    _tr_str_box(TrStr)-allocated boxes (#54): unbox+release the TrStr, then
-   free the box itself, before freeing the node/buckets/struct. */
+   free the box itself, before freeing the slots/struct. */
 static void _tr_idict_free_strval(TrIDict* d) {
     if (!d) return;
     for (size_t i=0;i<d->cap;i++) {
-        _TrIDictNode* n=d->buckets[i];
-        while(n){
-            _TrIDictNode* nx=n->next;
-            if(n->value) { _tr_str_release(*(TrStr*)n->value); _tr_free(n->value); }
-            _tr_free(n);
-            n=nx;
-        }
+        void* v=d->slots[i].value;
+        if(d->slots[i].key!=_TR_IDICT_EMPTY && v) { _tr_str_release(*(TrStr*)v); _tr_free(v); }
     }
-    _tr_free(d->buckets); _tr_free(d);
+    if(d->has_min && d->min_value) { _tr_str_release(*(TrStr*)d->min_value); _tr_free(d->min_value); }
+    _tr_free(d->slots); _tr_free(d);
 }
 /* Dict[int, HeapClass]: values are owned refcounted instances stored directly as
    void* (the dict co-owns each via insert-retain) — release each before teardown. */
 static void _tr_idict_free_objval(TrIDict* d, void(*drop)(void*)) {
     if (!d) return;
-    for (size_t i=0;i<d->cap;i++) {
-        _TrIDictNode* n=d->buckets[i];
-        while(n){ _TrIDictNode* nx=n->next; _tr_obj_release(n->value, drop); _tr_free(n); n=nx; }
-    }
-    _tr_free(d->buckets); _tr_free(d);
+    for (size_t i=0;i<d->cap;i++)
+        if(d->slots[i].key!=_TR_IDICT_EMPTY) _tr_obj_release(d->slots[i].value, drop);
+    if(d->has_min) _tr_obj_release(d->min_value, drop);
+    _tr_free(d->slots); _tr_free(d);
 }
 
 /* Set[HeapClass] — hash set of heap instances keyed by POINTER IDENTITY. The set
@@ -5863,30 +14959,30 @@ static void     _tr_iset_add(_TrISet* s, int64_t e)      { _tr_idict_set(s, e, (
 static int64_t  _tr_iset_contains(_TrISet* s, int64_t e) { return (int64_t)_tr_idict_contains(s, e); }
 static void     _tr_iset_remove(_TrISet* s, int64_t e)   { _tr_idict_remove(s, e); }
 static int64_t  _tr_iset_len(_TrISet* s)                 { return _tr_idict_len(s); }
-static void     _tr_iset_clear(_TrISet* s)               { if(s){ for(size_t i=0;i<s->cap;i++){ _TrIDictNode* n=s->buckets[i]; while(n){ _TrIDictNode* nx=n->next; free(n); n=nx; } s->buckets[i]=NULL; } s->len=0; } }
+static void     _tr_iset_clear(_TrISet* s)               { _tr_idict_clear(s); }
 static List_i64* _tr_iset_to_list(_TrISet* s)            { return _tr_idict_keys(s); }
+/* Each visits a's slots (and its out-of-line INT64_MIN) directly. */
+#define _TR_ISET_EACH(s, k, body) do { if(s){ \
+    for(size_t _i=0;_i<(s)->cap;_i++){ int64_t k=(s)->slots[_i].key; if(k!=_TR_IDICT_EMPTY){ body; } } \
+    if((s)->has_min){ int64_t k=_TR_IDICT_EMPTY; body; } } } while(0)
 static _TrISet* _tr_iset_union(_TrISet* a, _TrISet* b) {
-    _TrISet* r=_tr_iset_new(16);
-    List_i64* ka=_tr_idict_keys(a); if(ka) for(int64_t i=0;i<(int64_t)ka->len;i++) _tr_iset_add(r,ka->data[i]);
-    List_i64* kb=_tr_idict_keys(b); if(kb) for(int64_t i=0;i<(int64_t)kb->len;i++) _tr_iset_add(r,kb->data[i]);
+    _TrISet* r=_tr_iset_new(_tr_iset_len(a)+_tr_iset_len(b));
+    _TR_ISET_EACH(a, k, _tr_iset_add(r,k));
+    _TR_ISET_EACH(b, k, _tr_iset_add(r,k));
     return r;
 }
 static _TrISet* _tr_iset_intersection(_TrISet* a, _TrISet* b) {
     _TrISet* r=_tr_iset_new(16);
-    List_i64* ka=_tr_idict_keys(a);
-    if(ka) for(int64_t i=0;i<(int64_t)ka->len;i++) if(_tr_iset_contains(b,ka->data[i])) _tr_iset_add(r,ka->data[i]);
+    _TR_ISET_EACH(a, k, if(_tr_iset_contains(b,k)) _tr_iset_add(r,k));
     return r;
 }
 static _TrISet* _tr_iset_difference(_TrISet* a, _TrISet* b) {
     _TrISet* r=_tr_iset_new(16);
-    List_i64* ka=_tr_idict_keys(a);
-    if(ka) for(int64_t i=0;i<(int64_t)ka->len;i++) if(!_tr_iset_contains(b,ka->data[i])) _tr_iset_add(r,ka->data[i]);
+    _TR_ISET_EACH(a, k, if(!_tr_iset_contains(b,k)) _tr_iset_add(r,k));
     return r;
 }
 static int64_t _tr_iset_is_subset(_TrISet* a, _TrISet* b) {
-    List_i64* ka=_tr_idict_keys(a);
-    if(!ka) return 1LL;
-    for(int64_t i=0;i<(int64_t)ka->len;i++) if(!_tr_iset_contains(b,ka->data[i])) return 0LL;
+    _TR_ISET_EACH(a, k, if(!_tr_iset_contains(b,k)) return 0LL);
     return 1LL;
 }
 
@@ -6017,21 +15113,447 @@ static char* _tr_default_obj_str(const char* cls_name, const void* obj) {
     return b;
 }
 
+/* ── List sorting ──────────────────────────────────────────────────────────
+ * sort() on primitive lists never goes through a comparator pointer. Short
+ * lists use pattern-defeating quicksort (pdqsort), instantiated per element
+ * type so every comparison inlines: median-of-3 / ninther pivots, runs of
+ * equal keys partitioned off in one pass, already-sorted partitions finished
+ * by a bounded insertion sort, and a heapsort fallback after log2(n)
+ * unbalanced partitions. Longer List[int] / List[float] use an LSD radix sort
+ * over the 8 key bytes (a byte that is the same in every key costs no pass);
+ * floats are sorted as integers through an order-preserving bit map, so
+ * -0.0 < 0.0 and NaNs go last (negative NaNs first). Input that is already
+ * ascending or descending is caught by one scan first. Past _TR_SORT_PAR_MIN
+ * elements, with more than one core, the list is cut into chunks that are
+ * radix sorted on the std.iter pool and merged pairwise, each merge split
+ * by co-ranking into as many jobs as there were chunks. Without room for a
+ * scratch copy the sort stays in place (pdqsort).
+ *
+ * Descending sorts sort ascending and reverse. sort_by(cmp) and sort() on a
+ * class with __lt__ are stable merge sorts; sort_by_key(f) calls f once per
+ * element and sorts (key, index) pairs, which is stable too. */
+#define _TR_SORT_INSERTION  24
+#define _TR_SORT_NINTHER    128
+#define _TR_SORT_RADIX_MIN  512
+#define _TR_SORT_PAR_MIN    (1LL << 17)   /* smallest list sorted in parallel */
+#define _TR_SORT_PAR_CHUNK  (1LL << 15)   /* smallest chunk per core */
+#define _TR_SORT_SWAP(T, x, y) do { T _t = (x); (x) = (y); (y) = _t; } while (0)
+
+/* pdqsort for T* with the strict ordering LESS(x, y). Defines NAME(a, n). */
+#define _TR_PDQ(NAME, T, LESS)                                                          \
+static void NAME##_ins(T* a, long long n) {                                             \
+    for (long long i = 1; i < n; i++) {                                                 \
+        T t = a[i]; long long j = i;                                                    \
+        while (j > 0 && LESS(t, a[j - 1])) { a[j] = a[j - 1]; j--; }                     \
+        a[j] = t;                                                                       \
+    }                                                                                   \
+}                                                                                       \
+/* a[-1] is no greater than any element of a: no bounds check needed. */               \
+static void NAME##_ins_unguarded(T* a, long long n) {                                   \
+    for (long long i = 1; i < n; i++) {                                                 \
+        T t = a[i]; long long j = i;                                                    \
+        while (LESS(t, a[j - 1])) { a[j] = a[j - 1]; j--; }                              \
+        a[j] = t;                                                                       \
+    }                                                                                   \
+}                                                                                       \
+/* Insertion sort that gives up after 8 moves; 1 when it finished. */                    \
+static int NAME##_ins_partial(T* a, long long n) {                                      \
+    long long moved = 0;                                                                \
+    for (long long i = 1; i < n; i++) {                                                 \
+        if (moved > 8) return 0;                                                        \
+        T t = a[i]; long long j = i;                                                    \
+        if (!LESS(t, a[j - 1])) continue;                                               \
+        do { a[j] = a[j - 1]; j--; } while (j > 0 && LESS(t, a[j - 1]));                 \
+        a[j] = t; moved += i - j;                                                       \
+    }                                                                                   \
+    return 1;                                                                           \
+}                                                                                       \
+static void NAME##_sift(T* a, long long n, long long i) {                               \
+    T t = a[i];                                                                         \
+    for (;;) {                                                                          \
+        long long c = 2 * i + 1;                                                        \
+        if (c >= n) break;                                                              \
+        if (c + 1 < n && LESS(a[c], a[c + 1])) c++;                                     \
+        if (!LESS(t, a[c])) break;                                                      \
+        a[i] = a[c]; i = c;                                                             \
+    }                                                                                   \
+    a[i] = t;                                                                           \
+}                                                                                       \
+static void NAME##_heap(T* a, long long n) {                                            \
+    for (long long i = n / 2 - 1; i >= 0; i--) NAME##_sift(a, n, i);                   \
+    for (long long e = n - 1; e > 0; e--) {                                             \
+        _TR_SORT_SWAP(T, a[0], a[e]);                                                   \
+        NAME##_sift(a, e, 0);                                                           \
+    }                                                                                   \
+}                                                                                       \
+static inline void NAME##_sort2(T* x, T* y) { if (LESS(*y, *x)) _TR_SORT_SWAP(T, *x, *y); } \
+static inline void NAME##_sort3(T* x, T* y, T* z) {                                     \
+    NAME##_sort2(x, y); NAME##_sort2(y, z); NAME##_sort2(x, y);                         \
+}                                                                                       \
+/* Pivot a[0]; elements equal to it go right. Returns its final index and    \
+   sets *done when nothing had to move. */                                               \
+static long long NAME##_part_right(T* a, long long n, int* done) {                      \
+    T pivot = a[0];                                                                     \
+    long long first = 0, last = n;                                                      \
+    while (LESS(a[++first], pivot)) {}                                                  \
+    if (first == 1) { while (first < last && !LESS(a[--last], pivot)) {} }              \
+    else            { while (!LESS(a[--last], pivot)) {} }                              \
+    *done = first >= last;                                                              \
+    while (first < last) {                                                              \
+        _TR_SORT_SWAP(T, a[first], a[last]);                                            \
+        while (LESS(a[++first], pivot)) {}                                              \
+        while (!LESS(a[--last], pivot)) {}                                              \
+    }                                                                                   \
+    a[0] = a[first - 1]; a[first - 1] = pivot;                                          \
+    return first - 1;                                                                   \
+}                                                                                       \
+/* Pivot a[0], which equals the element before a: everything equal to it goes \
+   left and is then done. Returns the pivot's final index. */                            \
+static long long NAME##_part_left(T* a, long long n) {                                  \
+    T pivot = a[0];                                                                     \
+    long long first = 0, last = n;                                                      \
+    while (LESS(pivot, a[--last])) {}                                                   \
+    if (last + 1 == n) { while (first < last && !LESS(pivot, a[++first])) {} }          \
+    else               { while (!LESS(pivot, a[++first])) {} }                          \
+    while (first < last) {                                                              \
+        _TR_SORT_SWAP(T, a[first], a[last]);                                            \
+        while (LESS(pivot, a[--last])) {}                                               \
+        while (!LESS(pivot, a[++first])) {}                                             \
+    }                                                                                   \
+    a[0] = a[last]; a[last] = pivot;                                                    \
+    return last;                                                                        \
+}                                                                                       \
+static void NAME##_loop(T* a, long long n, int bad, int leftmost) {                     \
+    for (;;) {                                                                          \
+        if (n < _TR_SORT_INSERTION) {                                                   \
+            if (leftmost) NAME##_ins(a, n); else NAME##_ins_unguarded(a, n);            \
+            return;                                                                     \
+        }                                                                               \
+        long long h = n / 2;                                                            \
+        if (n > _TR_SORT_NINTHER) {                                                     \
+            NAME##_sort3(a, a + h, a + n - 1);                                          \
+            NAME##_sort3(a + 1, a + h - 1, a + n - 2);                                  \
+            NAME##_sort3(a + 2, a + h + 1, a + n - 3);                                  \
+            NAME##_sort3(a + h - 1, a + h, a + h + 1);                                  \
+            _TR_SORT_SWAP(T, a[0], a[h]);                                               \
+        } else {                                                                        \
+            NAME##_sort3(a + h, a, a + n - 1);                                          \
+        }                                                                               \
+        if (!leftmost && !LESS(a[-1], a[0])) {                                          \
+            long long p = NAME##_part_left(a, n);                                       \
+            a += p + 1; n -= p + 1;                                                     \
+            continue;                                                                   \
+        }                                                                               \
+        int done;                                                                       \
+        long long p = NAME##_part_right(a, n, &done);                                   \
+        long long ls = p, rs = n - p - 1;                                               \
+        if (ls < n / 8 || rs < n / 8) {                                                 \
+            if (--bad == 0) { NAME##_heap(a, n); return; }                              \
+            /* Break the pattern that made the partition lopsided. */                    \
+            if (ls >= _TR_SORT_INSERTION) {                                             \
+                _TR_SORT_SWAP(T, a[0], a[ls / 4]);                                      \
+                _TR_SORT_SWAP(T, a[p - 1], a[p - ls / 4]);                              \
+                if (ls > _TR_SORT_NINTHER) {                                            \
+                    _TR_SORT_SWAP(T, a[1], a[ls / 4 + 1]);                              \
+                    _TR_SORT_SWAP(T, a[2], a[ls / 4 + 2]);                              \
+                    _TR_SORT_SWAP(T, a[p - 2], a[p - (ls / 4 + 1)]);                    \
+                    _TR_SORT_SWAP(T, a[p - 3], a[p - (ls / 4 + 2)]);                    \
+                }                                                                       \
+            }                                                                           \
+            if (rs >= _TR_SORT_INSERTION) {                                             \
+                _TR_SORT_SWAP(T, a[p + 1], a[p + 1 + rs / 4]);                          \
+                _TR_SORT_SWAP(T, a[n - 1], a[n - rs / 4]);                              \
+                if (rs > _TR_SORT_NINTHER) {                                            \
+                    _TR_SORT_SWAP(T, a[p + 2], a[p + 2 + rs / 4]);                      \
+                    _TR_SORT_SWAP(T, a[p + 3], a[p + 3 + rs / 4]);                      \
+                    _TR_SORT_SWAP(T, a[n - 2], a[n - (1 + rs / 4)]);                    \
+                    _TR_SORT_SWAP(T, a[n - 3], a[n - (2 + rs / 4)]);                    \
+                }                                                                       \
+            }                                                                           \
+        } else if (done && NAME##_ins_partial(a, p) && NAME##_ins_partial(a + p + 1, rs)) { \
+            return;                                                                     \
+        }                                                                               \
+        NAME##_loop(a, p, bad, leftmost);                                               \
+        a += p + 1; n = rs; leftmost = 0;                                               \
+    }                                                                                   \
+}                                                                                       \
+static void NAME(T* a, long long n) {                                                   \
+    if (n < 2) return;                                                                  \
+    int bad = 1;                                                                        \
+    for (long long m = n; m > 1; m >>= 1) bad++;                                        \
+    NAME##_loop(a, n, bad, 1);                                                          \
+}
+
+/* LSD radix sort of T* by the unsigned 64-bit KEY(x), through `tmp` (room
+   for n). Stable. */
+#define _TR_RADIX(NAME, T, KEY)                                                         \
+static void NAME(T* a, T* tmp, long long n) {                                           \
+    size_t cnt[8][256];                                                                 \
+    memset(cnt, 0, sizeof cnt);                                                         \
+    for (long long i = 0; i < n; i++) {                                                 \
+        unsigned long long k = KEY(a[i]);                                               \
+        for (int b = 0; b < 8; b++) cnt[b][(k >> (8 * b)) & 255]++;                     \
+    }                                                                                   \
+    T* src = a; T* dst = tmp;                                                           \
+    for (int b = 0; b < 8; b++) {                                                       \
+        size_t* c = cnt[b];                                                             \
+        if (c[(KEY(src[0]) >> (8 * b)) & 255] == (size_t)n) continue;                  \
+        size_t s = 0;                                                                   \
+        for (int d = 0; d < 256; d++) { size_t t = c[d]; c[d] = s; s += t; }            \
+        for (long long i = 0; i < n; i++) dst[c[(KEY(src[i]) >> (8 * b)) & 255]++] = src[i]; \
+        T* t = src; src = dst; dst = t;                                                 \
+    }                                                                                   \
+    if (src != a) memcpy(a, src, (size_t)n * sizeof(T));                                \
+}
+
+/* Stable merge sort of T* with the strict ordering LESS(x, y), which may use \
+   `fn`: insertion-sorted runs of 16, then bottom-up merges through `tmp`. */
+#define _TR_MSORT(NAME, T, LESS)                                                        \
+static void NAME(T* a, long long n, void* fn, T* tmp) {                                 \
+    (void)fn;                                                                           \
+    for (long long lo = 0; lo < n; lo += 16) {                                          \
+        long long hi = lo + 16 < n ? lo + 16 : n;                                       \
+        for (long long i = lo + 1; i < hi; i++) {                                       \
+            T t = a[i]; long long j = i;                                                \
+            while (j > lo && LESS(t, a[j - 1])) { a[j] = a[j - 1]; j--; }                \
+            a[j] = t;                                                                   \
+        }                                                                               \
+    }                                                                                   \
+    T* src = a; T* dst = tmp;                                                           \
+    for (long long w = 16; w < n; w *= 2) {                                             \
+        for (long long lo = 0; lo < n; lo += 2 * w) {                                   \
+            long long mid = lo + w < n ? lo + w : n, hi = lo + 2 * w < n ? lo + 2 * w : n; \
+            long long i = lo, j = mid, k = lo;                                          \
+            while (i < mid && j < hi) dst[k++] = LESS(src[j], src[i]) ? src[j++] : src[i++]; \
+            while (i < mid) dst[k++] = src[i++];                                        \
+            while (j < hi) dst[k++] = src[j++];                                         \
+        }                                                                               \
+        T* t = src; src = dst; dst = t;                                                 \
+    }                                                                                   \
+    if (src != a) memcpy(a, src, (size_t)n * sizeof(T));                                \
+}
+
+#define _TR_LT(x, y) ((x) < (y))
+#define _TR_STR_LT(x, y) (strcmp((x), (y)) < 0)
+#define _TR_TRSTR_LT(x, y) (strcmp((x).data, (y).data) < 0)
+#define _TR_I64_KEY(x) ((unsigned long long)(x) ^ 0x8000000000000000ULL)
+_TR_PDQ(_tr_pdq_i64, long long, _TR_LT)
+_TR_PDQ(_tr_pdq_str, char*, _TR_STR_LT)
+_TR_PDQ(_tr_pdq_TrStr, TrStr, _TR_TRSTR_LT)
+_TR_RADIX(_tr_radix_i64, long long, _TR_I64_KEY)
+
+/* (key, index) pairs for sort_by_key: distinct indices make pdqsort stable. */
+typedef struct { long long key, idx; } _TrSortKey;
+#define _TR_KEY_LT(x, y) ((x).key < (y).key || ((x).key == (y).key && (x).idx < (y).idx))
+#define _TR_KEY_KEY(x) _TR_I64_KEY((x).key)
+_TR_PDQ(_tr_pdq_key, _TrSortKey, _TR_KEY_LT)
+_TR_RADIX(_tr_radix_key, _TrSortKey, _TR_KEY_KEY)
+
+typedef struct { long long* a; long long* tmp; long long n; int to_tmp; } _TrSortChunk;
+typedef struct { const long long* x; long long nx; const long long* y; long long ny; long long* out; } _TrSortMerge;
+
+static void* _tr_sort_chunk_job(void* arg) {
+    _TrSortChunk* c = (_TrSortChunk*)arg;
+    _tr_radix_i64(c->a, c->tmp, c->n);
+    if (c->to_tmp) memcpy(c->tmp, c->a, (size_t)c->n * sizeof(long long));
+    return NULL;
+}
+static void* _tr_sort_merge_job(void* arg) {
+    _TrSortMerge* m = (_TrSortMerge*)arg;
+    const long long* x = m->x; const long long* y = m->y;
+    const long long* xe = x + m->nx; const long long* ye = y + m->ny;
+    long long* o = m->out;
+    while (x < xe && y < ye) { int t = *y < *x; *o++ = t ? *y : *x; y += t; x += !t; }
+    if (x < xe) memcpy(o, x, (size_t)(xe - x) * sizeof(long long));
+    if (y < ye) memcpy(o, y, (size_t)(ye - y) * sizeof(long long));
+    return NULL;
+}
+/* How many of the first i merged elements of x (nx) and y (ny) come from x. */
+static long long _tr_sort_corank(long long i, const long long* x, long long nx, const long long* y, long long ny) {
+    long long lo = i > ny ? i - ny : 0, hi = i < nx ? i : nx;
+    while (lo < hi) {
+        long long j = lo + (hi - lo) / 2;
+        if (x[j] <= y[i - j - 1]) lo = j + 1; else hi = j;
+    }
+    return lo;
+}
+/* nch (a power of two) chunks sorted in parallel, then log2(nch) rounds of
+   pairwise merges between a and tmp, each round nch jobs. The chunks start
+   in whichever buffer makes the last round land in a. */
+static void _tr_sort_i64_par(long long* a, long long* tmp, long long n, long long nch) {
+    _TrThreadPool* pool = _tr_iter_pool();
+    long long rounds = 0;
+    for (long long c = nch; c > 1; c >>= 1) rounds++;
+    _TrSortChunk cs[64];
+    _TrSortMerge ms[64];
+    for (long long k = 0; k < nch; k++) {
+        long long lo = n * k / nch, hi = n * (k + 1) / nch;
+        cs[k].a = a + lo; cs[k].tmp = tmp + lo; cs[k].n = hi - lo; cs[k].to_tmp = (int)(rounds & 1);
+        _tr_threadpool_spawn(pool, _tr_sort_chunk_job, &cs[k]);
+    }
+    _tr_threadpool_wait(pool);
+    long long* src = (rounds & 1) ? tmp : a;
+    long long* dst = (rounds & 1) ? a : tmp;
+    for (long long w = 1; w < nch; w *= 2) {
+        long long jobs = 0;
+        for (long long g = 0; g < nch; g += 2 * w) {
+            long long lo = n * g / nch, mid = n * (g + w) / nch, hi = n * (g + 2 * w) / nch;
+            const long long* x = src + lo; long long nx = mid - lo;
+            const long long* y = src + mid; long long ny = hi - mid;
+            long long parts = 2 * w, j0 = 0;
+            for (long long q = 0; q < parts; q++) {
+                long long i1 = (nx + ny) * (q + 1) / parts;
+                long long i0 = (nx + ny) * q / parts;
+                long long j1 = q + 1 == parts ? nx : _tr_sort_corank(i1, x, nx, y, ny);
+                _TrSortMerge* m = &ms[jobs++];
+                m->x = x + j0; m->nx = j1 - j0;
+                m->y = y + (i0 - j0); m->ny = (i1 - j1) - (i0 - j0);
+                m->out = dst + lo + i0;
+                _tr_threadpool_spawn(pool, _tr_sort_merge_job, m);
+                j0 = j1;
+            }
+        }
+        _tr_threadpool_wait(pool);
+        long long* t = src; src = dst; dst = t;
+    }
+}
+/* Reverse n elements of esz bytes in place (descending sorts). */
+static inline void _tr_sort_reverse(void* data, long long n, size_t esz) {
+    char* a = (char*)data;
+    char t[16];
+    for (long long i = 0, j = n - 1; i < j; i++, j--) {
+        memcpy(t, a + (size_t)i * esz, esz);
+        memcpy(a + (size_t)i * esz, a + (size_t)j * esz, esz);
+        memcpy(a + (size_t)j * esz, t, esz);
+    }
+}
+/* Ascending sort of n long longs. */
+static void _tr_sort_i64(long long* a, long long n) {
+    if (n < _TR_SORT_RADIX_MIN) { _tr_pdq_i64(a, n); return; }
+    /* Already in order, or in reverse order: one pass, no scratch. */
+    long long up = 1, down = 1;
+    while (up < n && a[up - 1] <= a[up]) up++;
+    if (up == n) return;
+    if (up == 1) {
+        while (down < n && a[down - 1] >= a[down]) down++;
+        if (down == n) { _tr_sort_reverse(a, n, sizeof(long long)); return; }
+    }
+    long long* tmp = (long long*)malloc((size_t)n * sizeof(long long));
+    if (!tmp) { _tr_pdq_i64(a, n); return; }
+    long long nch = 1;
+    if (n >= _TR_SORT_PAR_MIN) {
+        long long cores = _tr_threadpool_auto_n();
+        while (nch * 2 <= cores && nch * 2 <= 64 && n / (nch * 2) >= _TR_SORT_PAR_CHUNK) nch *= 2;
+    }
+    if (nch > 1) _tr_sort_i64_par(a, tmp, n, nch);
+    else         _tr_radix_i64(a, tmp, n);
+    free(tmp);
+}
+/* Doubles <-> long longs with the same order (an involution). */
+static inline void _tr_sort_f64_bits(double* d, long long n) {
+    for (long long i = 0; i < n; i++) {
+        long long b;
+        memcpy(&b, &d[i], 8);
+        b ^= (long long)((unsigned long long)(b >> 63) >> 1);
+        memcpy(&d[i], &b, 8);
+    }
+}
+static void _tr_sort_f64(double* a, long long n) {
+    if (n < 2) return;
+    _tr_sort_f64_bits(a, n);
+    _tr_sort_i64((long long*)(void*)a, n);
+    _tr_sort_f64_bits(a, n);
+}
+/* Reorder n elements of esz bytes so that element i moves to where
+   keys[i] ranks; equal keys keep their order. */
+static void _tr_sort_by_keys(void* data, long long n, size_t esz, const long long* keys) {
+    if (n < 2) return;
+    _TrSortKey* ks = (_TrSortKey*)malloc((size_t)n * 2 * sizeof(_TrSortKey));
+    char* out = (char*)malloc((size_t)n * esz);
+    if (!ks || !out) { free(ks); free(out); return; }
+    for (long long i = 0; i < n; i++) { ks[i].key = keys[i]; ks[i].idx = i; }
+    if (n < _TR_SORT_RADIX_MIN) _tr_pdq_key(ks, n);
+    else                        _tr_radix_key(ks, ks + n, n);
+    const char* in = (const char*)data;
+    for (long long i = 0; i < n; i++) memcpy(out + (size_t)i * esz, in + (size_t)ks[i].idx * esz, esz);
+    memcpy(data, out, (size_t)n * esz);
+    free(out);
+    free(ks);
+}
+
+#define _TR_BY_LT_i64(x, y)   (((long long (*)(long long, long long))fn)((x), (y)) < 0)
+#define _TR_BY_LT_f64(x, y)   (((long long (*)(double, double))fn)((x), (y)) < 0)
+#define _TR_BY_LT_str(x, y)   (((long long (*)(char*, char*))fn)((x), (y)) < 0)
+#define _TR_BY_LT_TrStr(x, y) (((long long (*)(TrStr, TrStr))fn)((x), (y)) < 0)
+#define _TR_BY_LT_ptr(x, y)   (((long long (*)(void*, void*))fn)((x), (y)) < 0)
+#define _TR_DUNDER_LT(x, y)   (((bool (*)(void*, void*))fn)((x), (y)))
+#define _TR_DUNDER_GT(x, y)   (((bool (*)(void*, void*))fn)((y), (x)))
+_TR_MSORT(_tr_msort_by_i64,   long long, _TR_BY_LT_i64)
+_TR_MSORT(_tr_msort_by_f64,   double,    _TR_BY_LT_f64)
+_TR_MSORT(_tr_msort_by_str,   char*,     _TR_BY_LT_str)
+_TR_MSORT(_tr_msort_by_TrStr, TrStr,     _TR_BY_LT_TrStr)
+_TR_MSORT(_tr_msort_by_ptr,   void*,     _TR_BY_LT_ptr)
+_TR_MSORT(_tr_msort_lt_ptr,   void*,     _TR_DUNDER_LT)
+_TR_MSORT(_tr_msort_gt_ptr,   void*,     _TR_DUNDER_GT)
+
+/* l.sort_by(cmp) (cmp(a, b) < 0: a first; stable) and l.sort_by_key(f)
+   (ascending f(x), computed once per element; stable) for every list. */
+#define _TR_LIST_SORT_BY(SFX, T)                                                        \
+static void _tr_list_sort_by_##SFX(List_##SFX* l, void* fn) {                          \
+    if (!l || l->len < 2) return;                                                       \
+    T* tmp = (T*)malloc(l->len * sizeof(T));                                            \
+    if (!tmp) return;                                                                   \
+    _tr_msort_by_##SFX(l->data, (long long)l->len, fn, tmp);                            \
+    free(tmp);                                                                          \
+}                                                                                       \
+static void _tr_list_sort_by_key_##SFX(List_##SFX* l, void* fn) {                      \
+    if (!l || l->len < 2) return;                                                       \
+    long long* keys = (long long*)malloc(l->len * sizeof(long long));                   \
+    if (!keys) return;                                                                  \
+    for (size_t i = 0; i < l->len; i++) keys[i] = ((long long (*)(T))fn)(l->data[i]);   \
+    _tr_sort_by_keys(l->data, (long long)l->len, sizeof(T), keys);                      \
+    free(keys);                                                                         \
+}
+_TR_LIST_SORT_BY(i64, long long)
+_TR_LIST_SORT_BY(f64, double)
+_TR_LIST_SORT_BY(str, char*)
+_TR_LIST_SORT_BY(TrStr, TrStr)
+_TR_LIST_SORT_BY(ptr, void*)
+
+static void _tr_list_sort_i64(List_i64* l, int dir) {
+    if (!l || l->len < 2) return;
+    _tr_sort_i64(l->data, (long long)l->len);
+    if (dir < 0) _tr_sort_reverse(l->data, (long long)l->len, sizeof(long long));
+}
+static void _tr_list_sort_f64(List_f64* l, int dir) {
+    if (!l || l->len < 2) return;
+    _tr_sort_f64(l->data, (long long)l->len);
+    if (dir < 0) _tr_sort_reverse(l->data, (long long)l->len, sizeof(double));
+}
+static void _tr_list_sort_str(List_str* l, int dir) {
+    if (!l || l->len < 2) return;
+    _tr_pdq_str(l->data, (long long)l->len);
+    if (dir < 0) _tr_sort_reverse(l->data, (long long)l->len, sizeof(char*));
+}
+static void _tr_list_sort_TrStr(List_TrStr* l, int dir) {
+    if (!l || l->len < 2) return;
+    _tr_pdq_TrStr(l->data, (long long)l->len);
+    if (dir < 0) _tr_sort_reverse(l->data, (long long)l->len, sizeof(TrStr));
+}
+/* Objects have no order of their own: sort() on a class with __lt__ goes
+   to _tr_list_sort_lt_ptr, anything else is left as it is. */
+static void _tr_list_sort_ptr(List_ptr* l, int dir) { (void)l; (void)dir; }
+static void _tr_list_sort_lt_ptr(List_ptr* l, void* fn, int dir) {
+    if (!l || l->len < 2) return;
+    void** tmp = (void**)malloc(l->len * sizeof(void*));
+    if (!tmp) return;
+    if (dir < 0) _tr_msort_gt_ptr(l->data, (long long)l->len, fn, tmp);
+    else         _tr_msort_lt_ptr(l->data, (long long)l->len, fn, tmp);
+    free(tmp);
+}
+
 /* ── v0.0.5: List sort / aggregate / functional helpers ──────────────────────
  * All List_T typedefs are defined above.                                  */
-static int _tr_cmp_str_asc (const void* a, const void* b) { return strcmp(*(char**)a, *(char**)b); }
-static int _tr_cmp_str_desc(const void* a, const void* b) { return strcmp(*(char**)b, *(char**)a); }
-static int _tr_cmp_i64_asc (const void* a, const void* b) { int64_t x=*(int64_t*)a,y=*(int64_t*)b; return (x>y)-(x<y); }
-static int _tr_cmp_i64_desc(const void* a, const void* b) { int64_t x=*(int64_t*)a,y=*(int64_t*)b; return (x<y)-(x>y); }
-static int _tr_cmp_f64_asc (const void* a, const void* b) { double x=*(double*)a,y=*(double*)b; return (x>y)-(x<y); }
-static int _tr_cmp_f64_desc(const void* a, const void* b) { double x=*(double*)a,y=*(double*)b; return (x<y)-(x>y); }
-static void _tr_list_sort_str(List_str* l, int dir) { if(l&&l->len>1) qsort(l->data,(size_t)l->len,sizeof(char*),dir>0?_tr_cmp_str_asc:_tr_cmp_str_desc); }
-static int _tr_cmp_trstr_asc (const void* a, const void* b) { return strcmp(((const TrStr*)a)->data, ((const TrStr*)b)->data); }
-static int _tr_cmp_trstr_desc(const void* a, const void* b) { return strcmp(((const TrStr*)b)->data, ((const TrStr*)a)->data); }
-static void _tr_list_sort_TrStr(List_TrStr* l, int dir) { if(l&&l->len>1) qsort(l->data,(size_t)l->len,sizeof(TrStr),dir>0?_tr_cmp_trstr_asc:_tr_cmp_trstr_desc); }
-static void _tr_list_sort_i64(List_i64* l, int dir) { if(l&&l->len>1) qsort(l->data,(size_t)l->len,sizeof(int64_t),dir>0?_tr_cmp_i64_asc:_tr_cmp_i64_desc); }
-static void _tr_list_sort_f64(List_f64* l, int dir) { if(l&&l->len>1) qsort(l->data,(size_t)l->len,sizeof(double),dir>0?_tr_cmp_f64_asc:_tr_cmp_f64_desc); }
-static void _tr_list_sort_ptr(List_ptr* l, int dir) { (void)l; (void)dir; }
 static int64_t _tr_list_sum_i64(List_i64* l) { int64_t s=0; if(l) for(int64_t i=0;i<(int64_t)l->len;i++) s+=l->data[i]; return s; }
 static double  _tr_list_sum_f64(List_f64* l) { double  s=0; if(l) for(int64_t i=0;i<(int64_t)l->len;i++) s+=l->data[i]; return s; }
 static int64_t _tr_list_min_i64(List_i64* l) { if(!l||l->len==0) return 0LL; int64_t m=l->data[0]; for(int64_t i=1;i<(int64_t)l->len;i++) if(l->data[i]<m) m=l->data[i]; return m; }
@@ -2,7 +2,8 @@
 # Differential oracle: native ≡ c. For every program in tests/native/*.tr, compile it BOTH
 # ways — the C backend (--backend c -> gcc executable) and the native backend
 # (--backend native -> x86-64/ELF object -> link with runtime.o) — run each, and assert the
-# two produce byte-identical stdout. This proves the from-scratch machine-code backend
+# two produce byte-identical stdout. The native program is also linked by the compiler's
+# built-in linker and must print exactly what the system-linked one does. This proves the from-scratch machine-code backend
 # matches the reference C backend on every feature the corpus exercises, and guards every
 # future native slice against silent divergence. See project_native_backend.
 #
@@ -49,6 +50,16 @@ for src in tests/native/*.tr; do
     fi
     out_nat="$("build/nat_$name" 2>&1)"
 
+    # 2b) Same program through the built-in linker (no -o .o: executable written straight
+    # into the prelinked runtime image) — must match the system-linked binary.
+    if ! "$TAURAROC" "$src" --backend native --rebuild -o "build/bl_$name" >/tmp/nat_bl.log 2>&1; then
+        echo "  ✗ $name: built-in link failed"; sed -n '1,8p' /tmp/nat_bl.log; fail=$((fail+1)); continue
+    fi
+    out_bl="$("build/bl_$name" 2>&1)"
+    if [ "$out_bl" != "$out_nat" ]; then
+        echo "  ✗ $name: built-in linker output differs from the system-linked binary"; fail=$((fail+1)); continue
+    fi
+
     # 3) Differential assertion.
     if [ "$out_c" = "$out_nat" ]; then
         echo "  ✓ $name: native ≡ c ($(printf '%s' "$out_c" | wc -l | tr -d ' ') lines match)"
@@ -1,8 +1,9 @@
 #!/usr/bin/env bash
 # Native backend LINK + RUN proof (Linux x86-64). Compiles a trivial Tauraro program with
 # --backend native to an ELF64 object (NO C source, NO gcc for the user code), links it
-# with runtime.o + crt + libc via cc, runs it, and asserts the output. Proves the
-# taumir(LIR) -> x86-64 -> ELF -> link pipeline end to end. See project_native_backend.
+# with runtime.o + crt + libc via cc, runs it, and asserts the output; then links it with
+# the compiler's built-in linker (full, then an incremental relink after an edit). Proves
+# the taumir(LIR) -> x86-64 -> ELF -> link pipeline end to end. See project_native_backend.
 set -u
 ROOT="$(cd "$(dirname "$0")/.." && pwd)"; cd "$ROOT"
 TAURAROC="${TAURAROC:-./tauraroc}"; [ -x "$TAURAROC" ] || TAURAROC="./tauraroc.exe"
@@ -69,9 +70,20 @@ fi
 out="$(build/native_p42 2>&1)"
 echo "--- output ---"; echo "$out" | sed 's/^/    /'
 expected=$'hello native\n55\n4\n30\n100\ndone'
-if [ "$out" = "$expected" ]; then
-    echo "NATIVE RUN OK ✅ — a Tauraro program (string vars+concat, recursion, loops, List[int]) compiled straight to x86-64/ELF (no C) ran correctly"
-    exit 0
-else
-    echo "FAIL: expected 'hello native/55/4/30/100/done', got '$out'"; exit 1
-fi
+[ "$out" = "$expected" ] || { echo "FAIL: expected 'hello native/55/4/30/100/done', got '$out'"; exit 1; }
+
+# 5) built-in linker: no -o .o -> the compiler writes the executable itself into a copy of
+# the prelinked runtime image (no cc/ld), then an edit relinks incrementally in place.
+rm -f build/native_p42_bl build/native_p42_bl.tlmap
+"$TAURAROC" /tmp/native_p42.tr --backend native -o build/native_p42_bl --verbose 2>&1 | grep -E '^\[5/5\]' | sed 's/^/    /'
+out="$(build/native_p42_bl 2>&1)"
+[ "$out" = "$expected" ] || { echo "FAIL: built-in link: expected 'hello native/55/4/30/100/done', got '$out'"; exit 1; }
+sed 's/return fib(n - 1) + fib(n - 2)/return fib(n - 2) + fib(n - 1)/; s/print("done")/print("done again")/' /tmp/native_p42.tr > /tmp/native_p42_edit.tr
+log="$("$TAURAROC" /tmp/native_p42_edit.tr --backend native -o build/native_p42_bl --verbose 2>&1 | grep -E '^\[5/5\]')"
+echo "$log" | sed 's/^/    /'
+case "$log" in *incremental*) : ;; *) echo "FAIL: the edit did not relink incrementally"; exit 1 ;; esac
+out="$(build/native_p42_bl 2>&1)"
+[ "$out" = $'hello native\n55\n4\n30\n100\ndone again' ] || { echo "FAIL: incremental relink: got '$out'"; exit 1; }
+
+echo "NATIVE RUN OK ✅ — a Tauraro program (string vars+concat, recursion, loops, List[int]) compiled straight to x86-64/ELF (no C) ran correctly, system-linked and built-in-linked (full + incremental)"
+exit 0
@@ -1,6 +1,7 @@
 #!/usr/bin/env bash
-# reactor_stress.sh — build + run the reactor keep-alive stress test, and (on
-# Linux, if strace is present) count the epoll_ctl syscalls it makes.
+# reactor_stress.sh — build + run the reactor stress tests (tests/reactor/*.tr),
+# and (on Linux, if strace is present) count the epoll_ctl syscalls the
+# keep-alive test makes.
 #
 # This is the safety gate + measurement harness for reactor changes (notably the
 # persistent-epoll-registration optimization): correctness is asserted by the
@@ -9,7 +10,7 @@
 #   scripts/reactor_stress.sh              # correctness only
 #   scripts/reactor_stress.sh --count      # + epoll_ctl syscall count (Linux)
 #
-# Exit 0 iff the test prints "REACTOR-STRESS OK" and no "FAILED".
+# Exit 0 iff every test prints "REACTOR-STRESS OK" and none prints "FAILED".
 
 set -uo pipefail
 
@@ -45,14 +46,27 @@ if [ "$COUNT" -eq 1 ] && [ "$(uname)" = "Linux" ] && command -v strace >/dev/nul
     echo "----- epoll_ctl syscalls -----"
     grep -E "epoll_ctl|syscall" strace.out | tail -3 || true
     rm -f strace.out
-else
+    if echo "$out" | grep -q "REACTOR-STRESS OK" && ! echo "$out" | grep -q "FAILED"; then
+        echo "reactor_stress: PASS"
+        exit 0
+    fi
+    echo "reactor_stress: FAIL"
+    exit 1
+fi
+
+FAILS=0
+for TEST in tests/reactor/*.tr; do
+    echo "==> $TEST"
     out="$(run_once)"
     echo "$out"
-fi
+    if ! echo "$out" | grep -q "REACTOR-STRESS OK" || echo "$out" | grep -q "FAILED"; then
+        FAILS=$((FAILS + 1))
+    fi
+done
 
-if echo "$out" | grep -q "REACTOR-STRESS OK" && ! echo "$out" | grep -q "FAILED"; then
+if [ "$FAILS" -eq 0 ]; then
     echo "reactor_stress: PASS"
     exit 0
 fi
-echo "reactor_stress: FAIL"
+echo "reactor_stress: FAIL ($FAILS test(s))"
 exit 1